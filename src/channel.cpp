@@ -6,7 +6,6 @@
 
 #include <lslutils/conversion.h>
 #include <wx/log.h>
-#include <wx/regex.h>
 
 #include "gui/chatpanel.h"
 #include "gui/ui.h"
@@ -17,11 +16,13 @@
 #include "utils/tasutil.h"
 #include "utils/version.h"
 
+//! time between two kicks sent to ChanServ
+static const int KICK_INTERVAL = 500;
+
 Channel::Channel(IServer& serv)
     : panel(nullptr)
     , m_serv(serv)
-    , m_do_ban_regex(false)
-    , m_do_unban_regex(false)
+    , m_kick_timer(*this)
 {
 }
 
@@ -133,6 +134,29 @@ void Channel::OnChannelJoin(User& who)
 	panel->OnChannelJoin(who);
 }
 
+void Channel::OnChannelJoinMany(const std::vector<User*>& who)
+{
+	std::vector<std::string> nicks;
+	nicks.reserve(who.size());
+	for (User* user : who) {
+		UserList::AddUser(*user);
+		nicks.push_back(user->GetNick());
+	}
+	// all members are checked in one pass
+	std::vector<BanRules::Hit> banned;
+	m_ban_rules.CheckAll(nicks, banned);
+	for (const BanRules::Hit& hit : banned) {
+		if (nicks[hit.index] != "ChanServ") {
+			QueueKick(nicks[hit.index], hit.verdict == BanRules::BANNED_PATTERN);
+		}
+	}
+	if (panel == nullptr) {
+		wxLogError(_T("OnChannelJoinMany: ud->panel NULL"));
+		return;
+	}
+	panel->OnChannelJoinMany(who);
+}
+
 void Channel::SetTopic(const std::string& topic, const std::string& who)
 {
 	m_topic = topic;
@@ -168,15 +192,9 @@ void Channel::CheckBanned(const std::string& name)
 {
 	if (name == "ChanServ")
 		return;
-	if (m_banned_users.count(name) > 0) {
-		m_serv.SayPrivate("ChanServ", "!kick #" + GetName() + std::string(" ") + name);
-	}
-	if (m_do_ban_regex && m_ban_regex.IsValid()) {
-		if (m_ban_regex.Matches(TowxString(name)) && !(m_do_unban_regex && m_unban_regex.IsValid() && m_unban_regex.Matches(TowxString(name)))) {
-			m_serv.SayPrivate("ChanServ", "!kick #" + GetName() + std::string(" ") + name);
-			if (!m_ban_regex_msg.empty())
-				m_serv.SayPrivate(name, m_ban_regex_msg);
-		}
+	const BanRules::Verdict verdict = m_ban_rules.Check(name);
+	if (verdict != BanRules::NOT_BANNED) {
+		QueueKick(name, verdict == BanRules::BANNED_PATTERN);
 	}
 }
 
@@ -184,13 +202,41 @@ bool Channel::IsBanned(const std::string& name)
 {
 	if (name == "ChanServ")
 		return false;
-	if (m_banned_users.count(name) > 0)
-		return true;
-	if (m_do_ban_regex && m_ban_regex.IsValid()) {
-		if (m_ban_regex.Matches(TowxString(name)) && !(m_do_unban_regex && m_unban_regex.IsValid() && m_unban_regex.Matches(TowxString(name))))
-			return true;
+	return m_ban_rules.Check(name) != BanRules::NOT_BANNED;
+}
+
+void Channel::QueueKick(const std::string& nick, bool sendmessage)
+{
+	for (const Kick& kick : m_kicks) {
+		if (kick.nick == nick)
+			return;
 	}
-	return false;
+	m_kicks.push_back(Kick{nick, sendmessage});
+	if (!m_kick_timer.IsRunning()) {
+		// the first one is sent right away, the timer delays the following ones
+		SendKick();
+		m_kick_timer.Start(KICK_INTERVAL);
+	}
+}
+
+void Channel::SendKick()
+{
+	if (m_kicks.empty())
+		return;
+	const Kick kick = m_kicks.front();
+	m_kicks.pop_front();
+	m_serv.SayPrivate("ChanServ", "!kick #" + GetName() + std::string(" ") + kick.nick);
+	if (kick.sendmessage && !m_ban_regex_msg.empty())
+		m_serv.SayPrivate(kick.nick, m_ban_regex_msg);
+}
+
+void Channel::KickTimer::Notify()
+{
+	if (m_channel.m_kicks.empty()) {
+		Stop();
+		return;
+	}
+	m_channel.SendKick();
 }
 
 
@@ -225,37 +271,21 @@ bool Channel::ExecuteSayCommand(const std::string& in)
 		DoAction("is using " + GetSpringlobbyAgent());
 		return true;
 	} else if (subcmd == _T("/userban")) {
-		m_banned_users.insert(params);
-		m_serv.SayPrivate("ChanServ", stdprintf("!kick #%s %s", GetName().c_str(), params.c_str()));
+		m_ban_rules.BanNick(params);
+		QueueKick(params, false);
 		return true;
 	} else if (subcmd == _T("/userunban")) {
-		m_banned_users.erase(params);
+		m_ban_rules.UnbanNick(params);
 		return true;
 	} else if (subcmd == _T("/banregex")) {
 		ui().OnChannelMessage(*this, "/banregex " + params);
-		m_do_ban_regex = !params.empty();
-		if (m_do_ban_regex) {
-#ifdef wxHAS_REGEX_ADVANCED
-			m_ban_regex.Compile(params, wxRE_ADVANCED);
-#else
-			m_ban_regex.Compile(params, wxRE_EXTENDED);
-#endif
-			if (!m_ban_regex.IsValid())
-				ui().OnChannelMessage(*this, "Invalid regular expression");
-		}
+		if (!m_ban_rules.SetBanPattern(params))
+			ui().OnChannelMessage(*this, "Invalid regular expression");
 		return true;
 	} else if (subcmd == _T("/unbanregex")) {
 		ui().OnChannelMessage(*this, "/unbanregex " + params);
-		m_do_unban_regex = !params.empty();
-		if (m_do_unban_regex) {
-#ifdef wxHAS_REGEX_ADVANCED
-			m_unban_regex.Compile(params, wxRE_ADVANCED);
-#else
-			m_unban_regex.Compile(params, wxRE_EXTENDED);
-#endif
-			if (!m_unban_regex.IsValid())
-				ui().OnChannelMessage(*this, "Invalid regular expression");
-		}
+		if (!m_ban_rules.SetUnbanPattern(params))
+			ui().OnChannelMessage(*this, "Invalid regular expression");
 		return true;
 	} else if (subcmd == _T("/checkban")) {
 		if (IsBanned(params)) {
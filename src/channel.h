@@ -4,8 +4,11 @@
 #define SPRINGLOBBY_HEADERGUARD_CHANNEL_H
 
 #include "userlist.h"
+#include <deque>
 #include <set>
-#include <wx/regex.h>
+#include <vector>
+#include <wx/timer.h>
+#include "utils/banrules.h"
 #include "utils/mixins.h"
 
 class IServer;
@@ -47,6 +50,7 @@ public:
 	void Joined(User& who);
 
 	void OnChannelJoin(User& who);
+	void OnChannelJoinMany(const std::vector<User*>& who);
 
 	void SetTopic(const std::string& topic, const std::string& who);
 	std::string GetTopic();
@@ -62,16 +66,30 @@ public:
 private:
 	IServer& m_serv;
 
-	std::set<std::string> m_banned_users;
-
-	bool m_do_ban_regex;
-	wxRegEx m_ban_regex;
-
-	bool m_do_unban_regex;
-	wxRegEx m_unban_regex;
-
+	BanRules m_ban_rules;
 	std::string m_ban_regex_msg;
 
+	//! sends the queued kicks one by one, so they don't flood the connection
+	class KickTimer : public wxTimer
+	{
+	public:
+		explicit KickTimer(Channel& channel)
+		    : m_channel(channel)
+		{
+		}
+		void Notify() override;
+
+	private:
+		Channel& m_channel;
+	};
+
+	struct Kick {
+		std::string nick;
+		bool sendmessage; //!< tell the user the ban regex message
+	};
+	std::deque<Kick> m_kicks;
+	KickTimer m_kick_timer;
+
 	std::string m_topic;
 	std::string m_topic_nick;
 	std::string m_name;
@@ -80,6 +98,9 @@ private:
 
 	void AddUser(User& user);
 	void RemoveUser(const std::string& nick);
+
+	void QueueKick(const std::string& nick, bool sendmessage);
+	void SendKick();
 };
 
 #endif // SPRINGLOBBY_HEADERGUARD_CHANNEL_H
@@ -12,18 +12,34 @@
 #include <wx/intl.h>
 #include <wx/log.h>
 #include <wx/string.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
 #include <stdexcept>
 
 #include "settings.h"
+#include "utils/chatlogindex.h"
+#include "utils/compressedlog.h"
 #include "utils/conversion.h"
+#include "utils/logwriter.h"
 #include "utils/platform.h"
 #include "utils/slconfig.h"
 #include "utils/slpaths.h"
+#include "utils/tailreader.h"
+#include "utils/utf8file.h"
 
 #ifndef TEST
 SLCONFIG("/ChatLog/chatlog_enable", true, "Log chat messages");
 #endif
 
+//! logs larger than this are compressed into an archive
+static const wxULongLong ROTATE_SIZE = 2 * 1024 * 1024;
+//! logs are archived after this many days too, unless they're tiny
+static const int ROTATE_DAYS = 30;
+static const wxULongLong ROTATE_MIN_SIZE = 64 * 1024;
+//! archives are named <log>.<date><CompressedLog::EXTENSION>
+static const wxString ARCHIVE_DATE_FORMAT = _T("%Y%m%d-%H%M%S");
+
 ChatLog::ChatLog()
     : m_active(false)
 {
@@ -32,7 +48,6 @@ ChatLog::ChatLog()
 ChatLog::ChatLog(const wxString& logname)
     : m_logname(logname)
     , m_active(false)
-    , m_logfile()
 {
 	wxLogMessage(_T( "ChatLog::ChatLog( %s )" ), logname.c_str());
 	if (LogEnabled()) {
@@ -55,7 +70,7 @@ bool ChatLog::SetLogFile(const wxString& logname)
 
 	m_logname.Replace(wxT(":"), wxT("_"));
 	if (logname != m_logname) {
-		if (m_logfile.IsOpened()) {
+		if (m_active) {
 			CloseSession();
 		}
 		m_logname = logname;
@@ -72,14 +87,13 @@ ChatLog::~ChatLog()
 
 void ChatLog::CloseSession()
 {
-	if (!m_logfile.IsOpened()) {
+	if (!m_active) {
 		return;
 	}
 
 	AddMessage(_T("### ") + wxString::Format(_("Session Closed at %s"), GetDateTimeString()));
-	m_logfile.Flush();
+	LogWriter::Instance()->Close(m_logpath);
 	m_active = false;
-	m_logfile.Close();
 }
 
 bool ChatLog::AddMessage(const wxString& text)
@@ -90,10 +104,11 @@ bool ChatLog::AddMessage(const wxString& text)
 	if (!m_active) { //logging is enabled, logfile should be writeable
 		return false;
 	}
-	const bool res = m_logfile.Write(text + wxTextBuffer::GetEOL(), wxConvUTF8);
+	const bool res = LogWriter::Instance()->Append(m_logpath, STD_STRING(text + wxTextBuffer::GetEOL()));
 	if (!res) {
 		wxLogWarning(_T("Couldn't write to %s"), m_logname.c_str());
-		m_logfile.Close();
+		LogWriter::Instance()->Close(m_logpath);
+		m_active = false;
 	}
 	return res;
 }
@@ -123,19 +138,30 @@ bool ChatLog::OpenLogFile()
 		return false;
 	}
 
+	// the last lines might still be queued
+	LogWriter::Instance()->Flush(STD_STRING(logFilePath));
+#ifndef TEST
+	LoadIndex();
+#endif
+
+	wxFile logfile;
 	if (!wxFile::Exists(logFilePath)) {
-		m_logfile.Create(logFilePath);
+		logfile.Create(logFilePath);
 	} else {
-		m_logfile.Open(logFilePath, wxFile::read_write);
+		logfile.Open(logFilePath, wxFile::read);
 	}
 
-	if (!m_logfile.IsOpened()) {
+	if (!logfile.IsOpened()) {
 		wxLogWarning(_T( "Can't open log file %s" ), logFilePath.c_str());
 		m_active = false;
 		return false;
 	}
 
+	logfile.Close();
+	// read before rotating, the archive only shows up once it was compressed in the background
 	FillLastLineArray();
+	RotateLogFile();
+	m_logpath = STD_STRING(logFilePath);
 	m_active = true;
 
 	return AddMessage(_T("### ") + wxString::Format(_("Session started at %s"), GetDateTimeString()));
@@ -157,150 +183,271 @@ wxString ChatLog::GetCurrentLogfilePath() const
 #endif
 }
 
+//! -1 until the setting was read
+static int s_log_enabled = -1;
+
 bool ChatLog::LogEnabled()
 {
 #ifdef TEST
 	return true;
 #else
-	return cfg().ReadBool(_T("/ChatLog/chatlog_enable"));
+	if (s_log_enabled < 0) {
+		s_log_enabled = cfg().ReadBool(_T("/ChatLog/chatlog_enable")) ? 1 : 0;
+	}
+	return s_log_enabled == 1;
 #endif
 }
 
-/* read block at possition offset from file */
-static inline ssize_t readblock(wxFile& fd, void* buffer, size_t size, off_t offset)
+void ChatLog::ReloadSettings()
+{
+	s_log_enabled = -1;
+}
+
+void ChatLog::FillLastLineArray()
 {
-	assert(offset >= 0);
-	if (offset < 0) {
-		return -1;
+	m_last_lines.Clear();
+
+#ifdef TEST
+	const size_t num_lines = 6;
+#else
+	const size_t num_lines = sett().GetAutoloadedChatlogLinesCount();
+#endif
+
+	std::vector<std::string> lines;
+	const MappedFile logfile(STD_STRING(GetCurrentLogfilePath()));
+	if (!logfile.IsOk()) {
+		wxLogError(_T("%s: failed to open log file."), __PRETTY_FUNCTION__);
+		return;
+	}
+	const std::vector<LineSpan> spans = FindTailLines(logfile.Data(), logfile.Size(), num_lines);
+	for (size_t i = 0; i < spans.size(); i++) {
+		lines.push_back(std::string(logfile.Data() + spans[i].offset, spans[i].length));
 	}
 
-	if (fd.Seek(offset) != offset) {
-		return -1;
+	// continue with the archives if the log was rotated recently
+	const wxArrayString archives = GetArchivePaths();
+	for (size_t i = archives.size(); (i > 0) && (lines.size() < num_lines); i--) {
+		const std::vector<std::string> older = CompressedLog(STD_STRING(archives[i - 1])).ReadTailLines(num_lines - lines.size());
+		lines.insert(lines.begin(), older.begin(), older.end());
 	}
 
-	return fd.Read(buffer, size);
+	m_last_lines.Alloc(lines.size());
+	for (size_t i = 0; i < lines.size(); i++) {
+		m_last_lines.Add(wxString::FromUTF8(lines[i].data(), lines[i].size()));
+	}
+	wxLogMessage(_T("ChatLog::FillLastLineArray: Loaded %lu lines from %s."), lines.size(), GetCurrentLogfilePath().c_str());
 }
 
+//! the files named <log>.<date><extension> next to the log, oldest first
+static wxArrayString FindArchives(const wxFileName& current, const wxString& extension)
+{
+	const wxString prefix = current.GetName() + _T(".");
+	wxArrayString files;
+	wxArrayString archives;
+	if (!wxDir::Exists(current.GetPath())) {
+		return archives;
+	}
+	wxDir::GetAllFiles(current.GetPath(), &files, prefix + _T("*") + extension, wxDIR_FILES);
+	for (size_t i = 0; i < files.size(); i++) {
+		// skip logs of channels with a longer name, like chan.x for chan
+		const wxString name = wxFileName(files[i]).GetFullName();
+		const wxString date = name.Mid(prefix.length(), name.length() - prefix.length() - extension.length());
+		wxDateTime time;
+		wxString::const_iterator end;
+		if (time.ParseFormat(date, ARCHIVE_DATE_FORMAT, &end) && (end == date.end())) {
+			archives.Add(files[i]);
+		}
+	}
+	// the dates sort by time
+	archives.Sort();
+	return archives;
+}
 
-/** Calculate the next read position for find_tail_sequences (below) */
-static inline off_t next_read_position(off_t last_read_position, size_t read_size, size_t read_overlap)
+wxArrayString ChatLog::GetArchivePaths() const
 {
-	return std::max(static_cast<long signed int>(last_read_position - read_size - read_overlap), (long signed int)0);
+	return FindArchives(wxFileName(GetCurrentLogfilePath()), CompressedLog::EXTENSION);
 }
 
-/** Find an arbitrary number of delimited strings at the end of a file.  This
- * function provides the core of our last-lines-loader implementation.
- *
- * @param fd File descriptor to operate on.  This must be opened for reading.
- *
- * @param bytes Delimiter sequence.
- *
- * @param bytes_length Number of significant bytes in @p bytes.
- *
- * @param count Number of tail sequences to find.
+//! suffix of a log moved away for compression, until it's done
+static const wxString PENDING_EXTENSION = _T(".log");
+
+/** Compress pending into archive on the LogWriter thread, compressing megabytes
+ * takes a while.
  *
- * @param out Destination string array.
+ * @param log where pending was renamed from, empty if this retries an earlier
+ * rotation
  */
-static size_t find_tail_sequences(wxFile& fd, const char* bytes, size_t bytes_length, size_t count, wxArrayString& out)
+static void PostArchive(const std::string& log, const std::string& pending, const std::string& archive)
 {
-	size_t count_added(0);
-
-	/* We overlap the file reads a little to avoid splitting (and thus missing) the
-	   delimiter sequence.  */
-	const size_t read_overlap = bytes_length - 1;
-	const size_t read_size = BUFSIZ;
-
-	const off_t log_length = fd.SeekEnd();
-	bool have_last_pos = false;
-	char buf[read_size];
-	off_t last_found_pos = 0;
-	off_t last_read_position = log_length + read_overlap;
-
-	/* We read `read_size'-byte blocks of the file, starting at the end and working backwards. */
-	while (count_added < count && last_read_position > 0) {
-		const off_t read_position = next_read_position(last_read_position, read_size, read_overlap);
-		const size_t bytes_read = readblock(fd, buf, std::min(static_cast<off_t>(read_size), last_read_position - read_position), read_position);
-
-		/* In each block, we search for `bytes', starting at the end.  */
-		for (ssize_t i = bytes_read - read_overlap - 1; i >= 0; i--) {
-			if (strncmp((buf + i), bytes, bytes_length) == 0) {
-				const off_t this_found_pos = read_position + i;
-
-				if (have_last_pos) {
-					const size_t line_length = last_found_pos - this_found_pos - bytes_length;
-
-					if (line_length > 0) {
-						char* source = NULL;
-
-						if (last_found_pos >= read_position + (off_t)bytes_read) {
-							source = new char[line_length + 1];
-							memset(source, 0, line_length + 1);
-
-							if (readblock(fd, source, line_length, this_found_pos + bytes_length) < (ssize_t)line_length) {
-								wxLogWarning(_T("ChatLog::find_tail_sequences: Read-byte count less than expected"));
-							}
-						} else {
-							source = buf + i + bytes_length;
-						}
-						source[line_length] = 0;
-						wxString tmp = wxString::FromUTF8(source);
-						out.Insert(tmp, 0);
-						if (last_found_pos >= read_position + (off_t)bytes_read)
-							delete[] source;
-
-						count_added++;
-						if (count_added >= count)
-							break;
-					}
-				}
-				last_found_pos = this_found_pos;
-				have_last_pos = true;
-				i -= bytes_length - 1;
-			}
+	LogWriter::Instance()->Post([log, pending, archive]() {
+		ChatLogIndex* index = NULL;
+#ifndef TEST
+		index = ChatLog::GetIndex();
+#endif
+		if ((index != NULL) && !log.empty()) {
+			index->RenameLog(log, pending);
+		}
+		if (Utf8ModTime(pending) < 0) {
+			// posted twice, when another tab opened the same log
+			return;
 		}
+		// an archive exists already if only removing the pending log failed
+		const std::string tmp = archive + ".tmp";
+		if ((Utf8ModTime(archive) < 0) && (!CompressedLog::Compress(pending, tmp) || !Utf8Rename(tmp, archive))) {
+			// the uncompressed log stays and is searchable, the next rotation tries again
+			wxLogWarning(_T("Can't compress log file %s"), TowxString(pending).c_str());
+			Utf8Remove(tmp);
+			return;
+		}
+		if (index != NULL) {
+			index->RenameLog(pending, archive);
+		}
+		Utf8Remove(pending);
+		wxLogMessage(_T("Archived log file to %s"), TowxString(archive).c_str());
+	});
+}
 
-		last_read_position = read_position;
+void ChatLog::RotateLogFile()
+{
+	const wxString path = GetCurrentLogfilePath();
+	// logs an earlier compression failed for
+	const wxArrayString leftovers = FindArchives(wxFileName(path), CompressedLog::EXTENSION + PENDING_EXTENSION);
+	for (size_t i = 0; i < leftovers.size(); i++) {
+		const wxString& pending = leftovers[i];
+		PostArchive(std::string(), STD_STRING(pending), STD_STRING(pending.Left(pending.length() - PENDING_EXTENSION.length())));
+	}
+	if (!wxFileName::FileExists(path)) {
+		return;
+	}
+	const wxULongLong size = wxFileName::GetSize(path);
+	bool rotate = (size != wxInvalidSize) && (size >= ROTATE_SIZE);
+	if (!rotate && (size != wxInvalidSize) && (size >= ROTATE_MIN_SIZE)) {
+		const wxDateTime modified = wxFileName(path).GetModificationTime();
+		rotate = modified.IsValid() && ((wxDateTime::Now() - modified).GetDays() >= ROTATE_DAYS);
+	}
+	if (!rotate) {
+		return;
 	}
 
-	return count_added;
+	const wxFileName current(path);
+	const wxString archive = current.GetPathWithSep() + current.GetName() + _T(".") + wxDateTime::Now().Format(ARCHIVE_DATE_FORMAT) + CompressedLog::EXTENSION;
+	const wxString pending = archive + PENDING_EXTENSION;
+	// move the log away first, the session appends to a new one while compressing
+	if (wxFileName::FileExists(archive) || wxFileName::FileExists(pending) || !wxRenameFile(path, pending, false)) {
+		return;
+	}
+	PostArchive(STD_STRING(path), STD_STRING(pending), STD_STRING(archive));
 }
 
+#ifndef TEST
+//! GetIndex() runs on the LogWriter thread too
+static boost::mutex s_index_mutex;
+static ChatLogIndex* s_index = NULL;
+//! LoadIndex() was called, gui thread only
+static bool s_index_requested = false;
+static boost::thread* s_update_thread = NULL;
+static std::atomic<bool> s_update_running(false);
+static std::atomic<bool> s_update_stop(false);
+static std::atomic<size_t> s_update_done(0);
+static std::atomic<size_t> s_update_total(0);
+
+//! all logs of all servers
+static std::vector<std::string> GetLogFiles()
+{
+	std::vector<std::string> res;
+	wxArrayString files;
+	const wxString root = TowxString(SlPaths::GetChatLogLoc());
+	wxDir::GetAllFiles(root, &files, _T("*.txt"));
+	wxDir::GetAllFiles(root, &files, wxString(_T("*")) + CompressedLog::EXTENSION);
+	for (size_t i = 0; i < files.size(); i++) {
+		res.push_back(STD_STRING(files[i]));
+	}
+	return res;
+}
 
-void ChatLog::FillLastLineArray()
+ChatLogIndex* ChatLog::GetIndex()
 {
-	m_last_lines.Clear();
+	boost::lock_guard<boost::mutex> lock(s_index_mutex);
+	if (s_index != NULL) {
+		return s_index;
+	}
+	const std::string root = SlPaths::GetChatLogLoc();
+	const std::string indexdir = root + ".index";
+	if (root.empty() || !SlPaths::mkDir(indexdir)) {
+		wxLogWarning(_T("can't create chat log index folder: %s"), TowxString(indexdir).c_str());
+		return NULL;
+	}
+	s_index = new ChatLogIndex(root, indexdir);
+	ChatLogIndex* index = s_index;
+	LogWriter::Instance()->SetCommitHook([index](const std::string& path, uint64_t offset, const std::string& text) {
+		index->AddText(path, offset, text);
+	});
+	return s_index;
+}
 
-	if (!m_logfile.IsOpened()) {
-		wxLogError(_T("%s: failed to open log file."), __PRETTY_FUNCTION__);
+void ChatLog::LoadIndex()
+{
+	if (s_index_requested) {
 		return;
 	}
+	s_index_requested = true;
+	// loading the manifest and mapping the segments reads from disk, keep it off the gui thread
+	LogWriter::Instance()->Post([]() { GetIndex(); });
+}
 
-	if (m_logfile.Length() <= 0) {
+void ChatLog::UpdateIndex()
+{
+	if (s_update_thread != NULL) {
 		return;
 	}
+	s_update_done = 0;
+	s_update_total = 0;
+	s_update_running = true;
+	// loading the index and catching up take seconds for large logs, searches meanwhile see the logs done so far.
+	// Lines still queued in the LogWriter are indexed by its commit hook once written.
+	s_update_thread = new boost::thread([]() {
+		ChatLogIndex* index = GetIndex();
+		if (index != NULL) {
+			const std::vector<std::string> files = GetLogFiles();
+			s_update_total = files.size();
+			index->Update(files, [](size_t done, size_t /*total*/) {
+				s_update_done = done;
+				return !s_update_stop;
+			});
+		}
+		s_update_running = false;
+	});
+}
 
-#ifdef TEST
-	const size_t num_lines = 6;
-#else
-	const size_t num_lines = sett().GetAutoloadedChatlogLinesCount();
-#endif
-
-	m_last_lines.Alloc(num_lines);
-
-	const wxChar* wc_EOL(wxTextBuffer::GetEOL());
-	const size_t eol_num_chars(wxStrlen(wc_EOL));
-#ifndef WIN32
-	char* eol(static_cast<char*>(alloca(eol_num_chars)));
-#else
-	char* eol(new char[eol_num_chars]);
-#endif
-	wxConvUTF8.WC2MB(eol, wc_EOL, eol_num_chars);
+bool ChatLog::IsIndexUpdating(size_t& done, size_t& total)
+{
+	done = s_update_done;
+	total = s_update_total;
+	return s_update_running;
+}
 
-	const size_t lines_added = find_tail_sequences(m_logfile, eol, eol_num_chars, num_lines, m_last_lines);
-	wxLogMessage(_T("ChatLog::FillLastLineArray: Loaded %lu lines from %s."), lines_added, GetCurrentLogfilePath().c_str());
+bool ChatLog::RebuildIndex()
+{
+	ChatLogIndex* index = GetIndex();
+	if (index == NULL) {
+		return false;
+	}
+	LogWriter::Instance()->Flush();
+	return index->Rebuild(GetLogFiles());
+}
 
-#ifdef WIN32
-	delete[] eol;
-#endif
-	m_logfile.SeekEnd();
+void ChatLog::ReleaseIndex()
+{
+	if (s_update_thread != NULL) {
+		s_update_stop = true;
+		s_update_thread->join();
+		delete s_update_thread;
+		s_update_thread = NULL;
+	}
+	// the LogWriter is gone, nothing calls the commit hook anymore
+	boost::lock_guard<boost::mutex> lock(s_index_mutex);
+	delete s_index;
+	s_index = NULL;
+	s_index_requested = false;
 }
+#endif
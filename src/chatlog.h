@@ -6,6 +6,9 @@
 #include <wx/string.h>
 #include <wx/file.h>
 #include <wx/arrstr.h>
+#include <string>
+
+class ChatLogIndex;
 
 /** Handles chat-log operations for a single chat room on a server.
  */
@@ -28,7 +31,8 @@ public:
 	~ChatLog();
 
 	/** Append a time-stamped message to the log file.  Retrieves a
-	 * time-stamp string from LogTime.
+	 * time-stamp string from LogTime.  The message is written by the
+	 * LogWriter thread, together with other pending messages.
 	 *
 	 * @note This does nothing, successfully, if chat logging is
 	 * disabled.
@@ -36,7 +40,7 @@ public:
 	 * @param text Message text to log.
 	 *
 	 * @return @c false if an error was encountered while writing to
-	 * the log file, and @c true otherwise.
+	 * the log file before, and @c true otherwise.
 	 *
 	 * @see LogEnabled LogTime
 	 */
@@ -47,7 +51,43 @@ public:
 	 * @return @c true if chat logging is enabled, and @c false if it
 	 * is not.
 	 */
-	bool LogEnabled();
+	static bool LogEnabled();
+
+	/** Re-read the chat log settings, call after changing them.
+	 */
+	static void ReloadSettings();
+
+	/** Get the full-text index of all chat logs, it is kept up to date
+	 * by the LogWriter.
+	 *
+	 * @return @c NULL if the index directory can't be created.
+	 */
+	static ChatLogIndex* GetIndex();
+
+	/** Create and load the index on the LogWriter thread, once per
+	 * session.
+	 */
+	static void LoadIndex();
+
+	/** Index what was logged while the index wasn't running, on a
+	 * background thread. Runs once per session, the LogWriter keeps the
+	 * index up to date afterwards.
+	 */
+	static void UpdateIndex();
+
+	/** @return @c true while UpdateIndex() runs, with the number of logs
+	 * done so far and the total.
+	 */
+	static bool IsIndexUpdating(size_t& done, size_t& total);
+
+	/** Drop the index and index all chat logs again.
+	 */
+	static bool RebuildIndex();
+
+	/** Stop a running update, commit and close the index, call after
+	 * LogWriter::Release.
+	 */
+	static void ReleaseIndex();
 
 	const wxArrayString& GetLastLines() const;
 
@@ -75,10 +115,23 @@ private:
 	bool CreateCurrentLogFolder();
 	bool OpenLogFile();
 
+	/** Compress the log file into an archive next to it when it got too
+	 * large or wasn't written for ROTATE_DAYS, the log starts over empty.
+	 * The compression runs on the LogWriter thread, logs it failed for
+	 * are compressed again by the next call.
+	 */
+	void RotateLogFile();
+
+	/** Get the paths of the compressed archives of the current log file.
+	 *
+	 * @return the paths, oldest first.
+	 */
+	wxArrayString GetArchivePaths() const;
+
 	wxString m_logname;
 
 	bool m_active;
-	wxFile m_logfile;
+	std::string m_logpath; //!< utf-8 path the LogWriter appends to
 
 	wxArrayString m_last_lines;
 
@@ -2,41 +2,123 @@
 #include "flagimages.h"
 
 #include <wx/bitmap.h>
+#include <wx/image.h>
 #include <wx/imaglist.h>
 #include <wx/log.h>
-#include <map>
+#include <string.h>
 
 #include "flagimagedata.h"
 
-typedef std::map<std::string, int> NameToPosMap;
-static NameToPosMap m_name_to_pos;
+//! all embedded flags are 16x16
+static const int FLAG_SIZE = 16;
+
+//! two letter country codes map to 26 * 26 slots without collisions
+static const int FLAG_SLOTS = 26 * 26;
+
+static int FlagSlot(const std::string& flag)
+{
+	if ((flag.size() != 2) || (flag[0] < 'A') || (flag[0] > 'Z') || (flag[1] < 'A') || (flag[1] > 'Z'))
+		return -1;
+	return (flag[0] - 'A') * 26 + (flag[1] - 'A');
+}
+
+class FlagTable
+{
+public:
+	FlagTable()
+	    : count(0)
+	{
+		for (int i = 0; i < FLAG_SLOTS; i++) {
+			slots[i] = FLAG_NONE;
+		}
+		for (; flag_str[count] != NULL; count++) {
+			//Just in case (these two arrays must have same size!)
+			wxASSERT(flag_xpm[count] != NULL);
+			const int slot = FlagSlot(flag_str[count]);
+			if (slot >= 0) {
+				slots[slot] = count;
+			}
+		}
+		wxASSERT(flag_xpm[count] == NULL);
+	}
+
+	int Find(const std::string& flag) const
+	{
+		const int slot = FlagSlot(flag);
+		if (slot >= 0)
+			return slots[slot];
+		// the few non country flags
+		for (int i = 0; i < count; i++) {
+			if (strcmp(flag_str[i], flag.c_str()) == 0)
+				return i;
+		}
+		return FLAG_NONE;
+	}
+
+	short slots[FLAG_SLOTS];
+	int count;
+};
+
+static const FlagTable& GetFlagTable()
+{
+	static const FlagTable table;
+	return table;
+}
+
+//! codes which have no flag on purpose
+static bool IsSpecialFlag(const std::string& flag)
+{
+	return (flag.empty()) ||
+	       (flag == "??") || // unknown
+	       (flag == "XX") || // not sure where this come from, very likely from incomplete bootstrap at login
+	       (flag == "A1") || // anonymous proxy
+	       (flag == "A2") || // satellite provider
+	       (flag == "O1");   // other country
+}
+
+int FindFlagIndex(const std::string& flag)
+{
+	if (IsSpecialFlag(flag))
+		return FLAG_NONE;
+	return GetFlagTable().Find(flag);
+}
 
 int GetFlagIndex(const std::string& flag)
 {
-	if ((flag.empty()) ||
-	    (flag == "??") || // unknown
-	    (flag == "XX") || // not sure where this come from, very likely from incomplete bootstrap at login
-	    (flag == "A1") || // anonymous proxy
-	    (flag == "A2") || // satellite provider
-	    (flag == "O1"))   // other country
+	if (IsSpecialFlag(flag))
 		return FLAG_NONE;
+	const int index = GetFlagTable().Find(flag);
+	if (index == FLAG_NONE)
+		wxLogMessage(_T( "%s flag not found!" ), flag.c_str());
+	return index;
+}
 
-	NameToPosMap::const_iterator itor = m_name_to_pos.find(flag);
-	if (itor != m_name_to_pos.end())
-		return itor->second;
+int GetFlagCount()
+{
+	return GetFlagTable().count;
+}
 
-	wxLogMessage(_T( "%s flag not found!" ), flag.c_str());
-	return FLAG_NONE;
+const char* const* GetFlagXpm(int index)
+{
+	wxASSERT((index >= 0) && (index < GetFlagCount()));
+	return flag_xpm[index];
 }
 
 int AddFlagImages(wxImageList& imgs)
 {
-	int poszero = 0;
-	for (int i = 0; flag_xpm[i]; ++i) {
-		const int index = imgs.Add(wxBitmap(const_cast<const char**>(flag_xpm[i])));
-		if (i == 0)
-			poszero = index;
-		m_name_to_pos[flag_str[i]] = i;
+	// one atlas strip is split by the image list, instead of creating a bitmap per flag
+	const int count = GetFlagCount();
+	wxImage atlas(FLAG_SIZE * count, FLAG_SIZE);
+	atlas.SetAlpha();
+	memset(atlas.GetAlpha(), 0, FLAG_SIZE * count * FLAG_SIZE);
+	for (int i = 0; i < count; ++i) {
+		wxImage flag(flag_xpm[i]);
+		if (!flag.HasAlpha())
+			flag.InitAlpha();
+		atlas.Paste(flag, i * FLAG_SIZE, 0);
 	}
+	const int poszero = imgs.GetImageCount();
+	imgs.Add(wxBitmap(atlas));
+	wxASSERT(imgs.GetImageCount() == poszero + count);
 	return poszero;
 }
@@ -7,7 +7,13 @@
 
 class wxImageList;
 
+//! index into the embedded flags or FLAG_NONE, a constant time lookup
 int GetFlagIndex(const std::string& flag);
+//! like GetFlagIndex, without logging unknown flags, for lookups on every repaint
+int FindFlagIndex(const std::string& flag);
+int GetFlagCount();
+const char* const* GetFlagXpm(int index);
+//! adds all flags in flag index order and returns the image list index of the first one
 int AddFlagImages(wxImageList& imgs);
 
 enum {
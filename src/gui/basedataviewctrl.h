@@ -22,6 +22,7 @@ public:
 	virtual void Resort();
 
 	virtual bool AddItem(const DataType&, bool resortIsNeeded = true);
+	virtual size_t AddItems(const std::vector<const DataType*>&, bool resortIsNeeded = true);
 	virtual bool RemoveItem(const DataType&);
 	virtual bool RefreshItem(const DataType&);
 	virtual bool ContainsItem(const DataType&);
@@ -327,6 +328,23 @@ inline bool BaseDataViewCtrl<DataType>::AddItem(const DataType& item, bool resor
 	return result;
 }
 
+template <class DataType>
+inline size_t BaseDataViewCtrl<DataType>::AddItems(const std::vector<const DataType*>& items, bool resortIsNeeded)
+{
+	wxDataViewItem selectedItem = GetSelection();
+
+	const size_t added = m_DataModel->AddItems(items);
+
+	if ((added > 0) && resortIsNeeded) {
+		Resort();
+	}
+
+	/*Preserve selection*/
+	Select(selectedItem);
+
+	return added;
+}
+
 template <class DataType>
 inline bool BaseDataViewCtrl<DataType>::RemoveItem(const DataType& item)
 {
@@ -6,6 +6,7 @@
 #include <wx/dataview.h>
 #include <climits>
 #include <set>
+#include <vector>
 #include "log.h"
 #define DEFAULT_COLUMN UINT_MAX
 
@@ -36,6 +37,7 @@ public:
 public:
 	//Custom methods
 	bool AddItem(const DataType&);
+	size_t AddItems(const std::vector<const DataType*>&);
 	bool RemoveItem(const DataType&);
 	bool ContainsItem(const DataType&) const;
 	void Clear();
@@ -118,6 +120,23 @@ bool BaseDataViewModel<DataType>::AddItem(const DataType& data)
 	return true;
 }
 
+//! adds all items not yet in the model and informs the view once
+template <class DataType>
+size_t BaseDataViewModel<DataType>::AddItems(const std::vector<const DataType*>& data)
+{
+	wxDataViewItemArray items;
+	items.reserve(data.size());
+	for (const DataType* dataItem : data) {
+		if (m_ModelData.insert(dataItem).second) {
+			items.Add(wxDataViewItem(const_cast<DataType*>(dataItem)));
+		}
+	}
+	if (!items.IsEmpty()) {
+		ItemsAdded(wxDataViewItem(), items);
+	}
+	return items.GetCount();
+}
+
 template <class DataType>
 bool BaseDataViewModel<DataType>::RemoveItem(const DataType& data)
 {
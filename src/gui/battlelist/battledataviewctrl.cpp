@@ -29,7 +29,7 @@ BattleDataViewCtrl::BattleDataViewCtrl(const wxString& dataViewName, wxWindow* p
 	BattleDataViewModel* m_BattleDataModel = new BattleDataViewModel();
 	AssociateModel(m_BattleDataModel);
 
-	const IconsCollection& ici = *IconsCollection::Instance();
+	IconsCollection& ici = *IconsCollection::Instance();
 	const wxDataViewCellMode& cm = wxDATAVIEW_CELL_INERT;
 	const int gds = wxDVC_DEFAULT_MINWIDTH; // graphical default size
 	const int asds = wxCOL_WIDTH_AUTOSIZE;  // autosize default size
@@ -39,9 +39,9 @@ BattleDataViewCtrl::BattleDataViewCtrl(const wxString& dataViewName, wxWindow* p
 	AppendBitmapColumn(wxEmptyString,   STATUS,      cm, gds, wxALIGN_CENTER, flags);
 	AppendBitmapColumn(wxEmptyString,   COUNTRY,     cm, gds, wxALIGN_CENTER, flags);
 	AppendBitmapColumn(wxEmptyString,   RANK,        cm, gds, wxALIGN_CENTER, flags_hidden);
-	AppendTextColumn(ici.BMP_BROOM,     PLAYERS,     cm, gds, wxALIGN_NOT, flags);
+	AppendTextColumn(ici.BMP_BROOM.Get(),     PLAYERS,     cm, gds, wxALIGN_NOT, flags);
 	AppendTextColumn(_("Max"),          MAXIMUM,     cm, asds, wxALIGN_NOT, flags);
-	AppendTextColumn(ici.BMP_SPECTATOR, SPECTATORS,  cm, gds,  wxALIGN_NOT, flags);
+	AppendTextColumn(ici.BMP_SPECTATOR.Get(), SPECTATORS,  cm, gds,  wxALIGN_NOT, flags);
 	AppendTextColumn(_("Running"),      RUNNING,     cm, asds, wxALIGN_NOT, flags_hidden);
 	AppendTextColumn(_("Battle Name"),  DESCRIPTION, cm, asds, wxALIGN_NOT, flags);
 	AppendIconTextColumn(_("Game"),     GAME,        cm, asds, wxALIGN_NOT, flags);
@@ -33,7 +33,7 @@ void BattleDataViewModel::GetValue(wxVariant& variant,
 			case STATUS:
 			case COUNTRY:
 			case RANK:
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 				break;
 
 			case MAP:
@@ -0,0 +1,161 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#include "chatlogsearchdialog.h"
+
+#include <wx/button.h>
+#include <wx/sizer.h>
+#include <wx/stattext.h>
+#include <wx/textctrl.h>
+#include <wx/thread.h>
+#include <assert.h>
+#include <boost/thread/thread.hpp>
+#include <vector>
+
+#include "chatlog.h"
+#include "utils/chatlogindex.h"
+#include "utils/conversion.h"
+#include "utils/logwriter.h"
+
+static const size_t MAX_RESULTS = 200;
+static const size_t CONTEXT_LINES = 2;
+static const int STATUS_INTERVAL_MS = 500;
+
+static const wxEventType SearchedEvt = wxNewEventType();
+
+BEGIN_EVENT_TABLE(ChatLogSearchDialog, wxDialog)
+EVT_BUTTON(ID_SEARCH, ChatLogSearchDialog::OnSearch)
+EVT_TEXT_ENTER(ID_QUERY, ChatLogSearchDialog::OnSearch)
+EVT_TIMER(ID_TIMER, ChatLogSearchDialog::OnTimer)
+EVT_COMMAND(wxID_ANY, SearchedEvt, ChatLogSearchDialog::OnSearched)
+END_EVENT_TABLE()
+
+ChatLogSearchDialog::ChatLogSearchDialog(wxWindow* parent)
+    : wxDialog(parent, wxID_ANY, _("Search chat logs"), wxDefaultPosition, wxSize(720, 500), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER | wxMAXIMIZE_BOX | wxCLOSE_BOX)
+    , m_timer(this, ID_TIMER)
+    , m_search_requested(false)
+    , m_search_thread(NULL)
+{
+	wxBoxSizer* main_sizer = new wxBoxSizer(wxVERTICAL);
+	wxBoxSizer* query_sizer = new wxBoxSizer(wxHORIZONTAL);
+
+	m_query = new wxTextCtrl(this, ID_QUERY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+	query_sizer->Add(m_query, 1, wxALL | wxEXPAND, 5);
+	query_sizer->Add(new wxButton(this, ID_SEARCH, _("Search")), 0, wxALL, 5);
+	main_sizer->Add(query_sizer, 0, wxEXPAND, 0);
+
+	m_status = new wxStaticText(this, wxID_ANY, wxEmptyString);
+	main_sizer->Add(m_status, 0, wxLEFT | wxRIGHT | wxEXPAND, 5);
+
+	m_results = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+				   wxTE_MULTILINE | wxTE_READONLY | wxTE_RICH | wxTE_AUTO_URL | wxTE_DONTWRAP);
+	main_sizer->Add(m_results, 1, wxALL | wxEXPAND, 5);
+	SetSizer(main_sizer);
+	Layout();
+
+	// index what was logged by older versions or while the index was broken
+	ChatLog::UpdateIndex();
+	if (UpdateStatus()) {
+		m_timer.Start(STATUS_INTERVAL_MS);
+	}
+	m_query->SetFocus();
+}
+
+ChatLogSearchDialog::~ChatLogSearchDialog()
+{
+	m_timer.Stop();
+	if (m_search_thread != NULL) {
+		m_search_thread->join();
+		delete m_search_thread;
+	}
+}
+
+bool ChatLogSearchDialog::UpdateStatus()
+{
+	size_t done, total;
+	if (!ChatLog::IsIndexUpdating(done, total)) {
+		m_status->SetLabel(wxEmptyString);
+		return false;
+	}
+	m_status->SetLabel(wxString::Format(_("Indexing older chat logs (%d of %d), results may be incomplete."), (int)done, (int)total));
+	return true;
+}
+
+void ChatLogSearchDialog::OnTimer(wxTimerEvent& /*event*/)
+{
+	if (UpdateStatus()) {
+		return;
+	}
+	m_timer.Stop();
+	// the shown results might miss logs indexed meanwhile
+	if (!m_last_query.empty()) {
+		Search(m_last_query);
+	}
+}
+
+void ChatLogSearchDialog::OnSearch(wxCommandEvent& /*event*/)
+{
+	Search(m_query->GetValue());
+}
+
+void ChatLogSearchDialog::Search(const wxString& query)
+{
+	m_last_query = query;
+	m_search_wanted = query;
+	m_search_requested = true;
+	if (m_search_thread == NULL) {
+		StartSearch();
+	}
+}
+
+void ChatLogSearchDialog::StartSearch()
+{
+	if (!m_search_requested) {
+		return;
+	}
+	m_search_requested = false;
+	m_search_result.clear();
+	const std::string query = STD_STRING(m_search_wanted);
+	LogWriter* writer = LogWriter::Instance();
+	// waiting for the queued lines and reading the logs takes a while, keep it off the gui thread
+	m_search_thread = new boost::thread([this, writer, query]() {
+		ChatLogIndex* index = ChatLog::GetIndex();
+		if (index != NULL) {
+			// the newest lines might still be queued
+			writer->Flush();
+			m_search_result = index->Search(query, MAX_RESULTS, CONTEXT_LINES);
+		}
+		wxCommandEvent notice(SearchedEvt);
+		wxPostEvent(this, notice);
+	});
+}
+
+void ChatLogSearchDialog::OnSearched(wxCommandEvent& /*unused*/)
+{
+	assert(wxThread::IsMain());
+	m_search_thread->join();
+	delete m_search_thread;
+	m_search_thread = NULL;
+	// a newer query is waiting, these results are outdated
+	if (m_search_requested) {
+		StartSearch();
+		return;
+	}
+
+	const std::vector<ChatLogIndex::Match>& matches = m_search_result;
+	wxString text;
+	for (size_t i = 0; i < matches.size(); i++) {
+		const ChatLogIndex::Match& match = matches[i];
+		text += _T("--- ") + wxString::FromUTF8(match.file.c_str()) + _T("\n");
+		for (size_t n = 0; n < match.before.size(); n++) {
+			text += _T("    ") + wxString::FromUTF8(match.before[n].c_str()) + _T("\n");
+		}
+		text += _T(">>> ") + wxString::FromUTF8(match.line.c_str()) + _T("\n");
+		for (size_t n = 0; n < match.after.size(); n++) {
+			text += _T("    ") + wxString::FromUTF8(match.after[n].c_str()) + _T("\n");
+		}
+	}
+	if (matches.empty()) {
+		text = _("No matches found.");
+	}
+	m_results->SetValue(text);
+	m_results->ShowPosition(0);
+}
@@ -0,0 +1,56 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_CHATLOGSEARCHDIALOG_H
+#define SPRINGLOBBY_HEADERGUARD_CHATLOGSEARCHDIALOG_H
+
+#include <wx/dialog.h>
+#include <wx/timer.h>
+#include <vector>
+#include "utils/chatlogindex.h"
+namespace boost
+{
+class thread;
+}
+
+class wxStaticText;
+class wxTextCtrl;
+class wxCommandEvent;
+
+//! searches the chat logs of all channels and servers
+class ChatLogSearchDialog : public wxDialog
+{
+public:
+	explicit ChatLogSearchDialog(wxWindow* parent);
+	~ChatLogSearchDialog();
+
+private:
+	void OnSearch(wxCommandEvent& event);
+	void OnTimer(wxTimerEvent& event);
+	//! searches on m_search_thread, or once the running search is done
+	void Search(const wxString& query);
+	void StartSearch();
+	//! shows the matches found by m_search_thread
+	void OnSearched(wxCommandEvent& event);
+	//! shows the progress of the index update, false once it's done
+	bool UpdateStatus();
+
+	wxTextCtrl* m_query;
+	wxStaticText* m_status;
+	wxTextCtrl* m_results;
+	wxTimer m_timer;
+	wxString m_last_query; //!< searched again with the complete index
+	wxString m_search_wanted;
+	bool m_search_requested;
+	boost::thread* m_search_thread;
+	std::vector<ChatLogIndex::Match> m_search_result; //!< written by m_search_thread
+
+	enum {
+		ID_QUERY = wxID_HIGHEST,
+		ID_SEARCH,
+		ID_TIMER
+	};
+
+	DECLARE_EVENT_TABLE()
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_CHATLOGSEARCHDIALOG_H
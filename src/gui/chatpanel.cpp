@@ -12,12 +12,15 @@
 #include <wx/intl.h>
 #include <wx/splitter.h>
 #include <wx/stattext.h>
+#include <wx/textbuf.h>
 #include <wx/tokenzr.h>
 #include <wx/wupdlock.h>
+#include <algorithm>
 
 #include "aui/auimanager.h"
 #include "channel.h"
 #include "chatpanelmenu.h"
+#include "gui/chatview.h"
 #include "gui/controls.h"
 #include "gui/customdialogs.h"
 #include "gui/hosting/votepanel.h"
@@ -36,6 +39,7 @@
 #include "utils/conversion.h"
 #include "utils/curlhelper.h" //has to be first include, as else it warns about winsock2.h should be included first
 #include "utils/globalevents.h"
+#include "utils/ircformat.h"
 #include "utils/slconfig.h"
 #include "utils/uievents.h"
 #include "utils/version.h"
@@ -54,6 +58,8 @@ END_EVENT_TABLE()
 
 SLCONFIG("/Channel/bridgebot", (const wxString&)_T("TIZBOT"), "Name of the Bridgebot (which forwards traffic between #sy and irc channels)");
 SLCONFIG("/GUI/ShowPromotions", true, "Show promotion messages as popup");
+SLCONFIG("/Chat/HighlightIgnoreCase", false, "Match words to highlight case insensitive");
+SLCONFIG("/Chat/HighlightWholeWords", false, "Only highlight whole words, not parts of longer words");
 
 /// table for irc colors
 static wxColor m_irc_colors[16] = {
@@ -286,8 +292,7 @@ void ChatPanel::CreateControls()
 
 	// Creating ui elements
 
-	m_chatlog_text = new wxTextCtrl(m_chat_panel, CHAT_LOG, wxEmptyString, wxDefaultPosition, wxDefaultSize,
-					wxTE_MULTILINE | wxTE_READONLY | wxTE_RICH | wxTE_AUTO_URL);
+	m_chatlog_text = new ChatView(m_chat_panel, CHAT_LOG);
 	m_chan_opts_button = NULL;
 	if (m_type == CPT_Channel) {
 		m_chatlog_text->SetToolTip(_("right click for options (like autojoin)"));
@@ -297,7 +302,7 @@ void ChatPanel::CreateControls()
 	if (m_type == CPT_User && (m_user != NULL)) {
 		ico = IconsCollection::Instance()->GetUserBattleStateBmp(m_user->GetStatus());
 	} else {
-		ico = IconsCollection::Instance()->BMP_CHANNEL_OPTIONS;
+		ico = IconsCollection::Instance()->BMP_CHANNEL_OPTIONS.Get();
 	}
 	m_chan_opts_button = new wxBitmapButton(m_chat_panel, CHAT_CHAN_OPTS, ico, wxDefaultPosition, wxSize(CONTROL_HEIGHT, CONTROL_HEIGHT));
 
@@ -331,8 +336,9 @@ void ChatPanel::CreateControls()
 		m_splitter->SetSashPosition(s.GetWidth() - MINIMUM_PANE_SIZE, true);
 	}
 
-	m_chatlog_text->ShowPosition(m_chatlog_text->GetLastPosition());
 	m_chatlog_text->SetBackgroundColour(sett().GetChatColorBackground());
+	m_chatlog_text->SetFont(sett().GetChatFont());
+	m_chatlog_text->SetMaxLines(std::max(0, sett().GetChatHistoryLenght()));
 	m_say_text->SetBackgroundColour(sett().GetChatColorBackground());
 	m_say_text->SetForegroundColour(sett().GetChatColorNormal());
 
@@ -371,19 +377,21 @@ const User& ChatPanel::GetMe() const
 	return serverSelector().GetServer().GetMe();
 }
 
-void ChatPanel::OutputLine(const wxString& message, const wxColour& col, bool showtime)
+void ChatPanel::OutputLine(const wxString& message, const wxColour& col, bool showtime, bool highlight)
 {
 
 	if (!m_chatlog_text)
 		return;
 
+	const ChatSettings& chat = sett().GetChatSettings();
 	ChatLine newline;
 	newline.chat = message;
-	newline.chatstyle = wxTextAttr(col, sett().GetChatColorBackground());
+	newline.chatstyle = wxTextAttr(col, chat.background);
+	newline.highlight = highlight;
 	if (showtime) {
 		wxDateTime now = wxDateTime::Now();
 		newline.time = _T( "[" ) + now.Format(_T( "%H:%M:%S" )) + _T( "]" );
-		newline.timestyle = wxTextAttr(sett().GetChatColorTime(), sett().GetChatColorBackground());
+		newline.timestyle = wxTextAttr(chat.time, chat.background);
 		m_chat_log.AddMessage(newline.time + _T(" ") + message);
 	} else {
 		newline.time.clear();
@@ -396,115 +404,118 @@ void ChatPanel::OutputLine(const wxString& message, const wxColour& col, bool sh
 	}
 }
 
-static size_t FirstSpecialChar(const wxString& str)
+void ChatPanel::OutputLines(const wxArrayString& messages, const wxColour& col)
 {
-	for (size_t pos = 0; pos < str.Len(); pos++) {
-		if (!str.GetChar(pos).IsAscii()) {
-			continue;
-		}
-		const unsigned char uc = str.GetChar(pos);
-		if (uc == 0x1f || uc == 0x1d || uc == 0x03 || uc == 0x02 || uc == 0x016 || uc == 0x0F) { //get all text until first irc color is found
-			return pos;
+	if (!m_chatlog_text || messages.IsEmpty())
+		return;
+
+	const ChatSettings& chat = sett().GetChatSettings();
+	ChatLine newline;
+	newline.chatstyle = wxTextAttr(col, chat.background);
+	newline.highlight = false;
+	newline.time = _T( "[" ) + wxDateTime::Now().Format(_T( "%H:%M:%S" )) + _T( "]" );
+	newline.timestyle = wxTextAttr(chat.time, chat.background);
+
+	wxString log;
+	for (size_t i = 0; i < messages.size(); i++) {
+		if (i > 0)
+			log += wxTextBuffer::GetEOL();
+		log += newline.time + _T(" ") + messages[i];
+	}
+	m_chat_log.AddMessage(log);
+
+	if (!m_disable_append) {
+		m_chatlog_text->BeginAppend();
+	}
+	for (size_t i = 0; i < messages.size(); i++) {
+		newline.chat = messages[i];
+		if (m_disable_append) {
+			m_buffer.push_back(newline);
+		} else {
+			OutputLine(newline);
 		}
 	}
-	return -1;
+	if (!m_disable_append) {
+		m_chatlog_text->EndAppend();
+	}
 }
 
-void ChatPanel::OutputLine(const ChatLine& line)
+static wxColour GetIrcColor(int index, const wxColour& defaultcolor)
 {
-	const int numOfLines = m_chatlog_text->GetNumberOfLines();
-	const int maxlength = sett().GetChatHistoryLenght();
+	if ((index < 0) || (index >= int(sizeof(m_irc_colors) / sizeof(m_irc_colors[0])))) {
+		return defaultcolor;
+	}
+	return m_irc_colors[index];
+}
 
-	// crop lines from history that exceeds limit
-	if ((maxlength > 0) && (numOfLines > maxlength)) {
-		int end_line = 0;
-		for (int i = 0; i < numOfLines - maxlength; i++) {
-			end_line += m_chatlog_text->GetLineLength(i) + 1;
-		}
-		if (end_line > 0) {
-			m_chatlog_text->Remove(0, end_line);
+//! appends the irc formatted message to text, control codes are stripped and converted to spans
+static void AppendIrcFormatted(wxString& text, std::vector<ChatView::Span>& spans, const wxString& message, const wxTextAttr& style)
+{
+	std::vector<IrcFormat::Span> ircspans;
+	IrcFormat::Tokenize(message.wc_str(), message.length(), ircspans);
+
+	text.reserve(text.length() + message.length());
+	for (size_t i = 0; i < ircspans.size(); i++) {
+		const IrcFormat::Span& ircspan = ircspans[i];
+		wxColour fg = GetIrcColor(ircspan.fg, style.GetTextColour());
+		wxColour bg = GetIrcColor(ircspan.bg, wxNullColour);
+		if (ircspan.flags & IrcFormat::FLAG_REVERSE) {
+			const wxColour tmp = fg;
+			fg = bg.IsOk() ? bg : style.GetBackgroundColour();
+			bg = tmp;
 		}
+		int viewstyle = ChatView::STYLE_NORMAL;
+		if (ircspan.flags & IrcFormat::FLAG_BOLD)
+			viewstyle |= ChatView::STYLE_BOLD;
+		if (ircspan.flags & IrcFormat::FLAG_ITALIC)
+			viewstyle |= ChatView::STYLE_ITALIC;
+		if (ircspan.flags & IrcFormat::FLAG_UNDERLINE)
+			viewstyle |= ChatView::STYLE_UNDERLINE;
+		spans.push_back(ChatView::Span(text.length(), ircspan.length, fg, viewstyle, bg));
+		text.append(message, ircspan.offset, ircspan.length);
 	}
+}
+
+void ChatPanel::OutputLine(const ChatLine& line)
+{
+	wxString text;
+	std::vector<ChatView::Span> spans;
 
 	if (!line.time.empty()) {
-		m_chatlog_text->SetDefaultStyle(line.timestyle);
-		m_chatlog_text->AppendText(line.time + _T(" "));
+		text = line.time + _T(" ");
+		spans.push_back(ChatView::Span(0, text.length(), line.timestyle.GetTextColour()));
+	}
+
+	if (sett().GetChatSettings().useirccolors) {
+		AppendIrcFormatted(text, spans, line.chat, line.chatstyle);
 	} else {
-		m_chatlog_text->SetDefaultStyle(line.chatstyle);
-	}
-
-#ifndef __WXOSX_COCOA__
-	if (sett().GetUseIrcColors()) {
-		wxString m1(line.chat);
-		wxString m2;
-		wxString m3;
-		wxTextAttr at(line.chatstyle);
-		int color = 0;
-		bool bold = false;
-		wxColor curcolor(line.chatstyle.GetTextColour());
-		const wxFont oldfont = sett().GetChatFont();
-		const wxColor oldcolor(line.chatstyle.GetTextColour());
-
-		while (m1.Len() > 0) {
-			const size_t firstspec = FirstSpecialChar(m1);
-			if (firstspec > 0) {	   //unformated text found, add as whole
-				wxFont font = oldfont; //isn't needed any more in wx3.0
-				at = line.chatstyle;
-				if (bold)
-					font.SetWeight(wxFONTWEIGHT_BOLD);
-				at.SetFont(font);
-				at.SetTextColour(curcolor);
-				m_chatlog_text->SetDefaultStyle(at);
-				m_chatlog_text->AppendText(m1.Mid(0, firstspec));
-				m1 = m1.Mid(firstspec);
-				if (m1.Len() <= 0) { //no chars left, abort
-					break;
-				}
-			}
-			const unsigned char uc = m1.GetChar(0);
-			switch (uc) {      //  http://en.wikichip.org/wiki/irc/colors
-				case 0x1f: //underline
-					break;
-				case 0x1d: //italics
-					break;
-				case 0x03: {
-					if (m1.Len() > 2 && (m1.GetChar(2) >= 48 && m1.GetChar(2) <= 58)) {
-						color = (int(m1.GetChar(1)) - 48) * 10 + (int(m1.GetChar(2)) - 48);
-						m1 = m1.Mid(2); //next chars
-					} else {
-						color = int(m1.GetChar(1)) - 48;
-						m1 = m1.Mid(1); //next char
-					}
+		spans.push_back(ChatView::Span(text.length(), line.chat.length(), line.chatstyle.GetTextColour()));
+		text += line.chat;
+	}
 
-					wxColor dummy(0, 0, 0);
-					if ((color > -1) && (color < long((sizeof(m_irc_colors) / sizeof(dummy))))) {
-						curcolor = m_irc_colors[color];
-					}
-					break;
-				}
-				case 0x02: //bold
-					bold = !bold;
-					break;
-				case 0x16: //reverse;
-					break;
-				case 0x0F: //reset formating
-					bold = false;
-					curcolor = oldcolor;
-					break;
+	std::vector<ChatView::Range> marks;
+	if (line.highlight) {
+		// matched again on the formatting stripped text, so offsets fit
+		const size_t chatstart = line.time.empty() ? 0 : line.time.length() + 1;
+		const std::wstring wide = text.ToStdWstring();
+		std::vector<HighlightMatcher::Match> matches;
+		m_highlight_matcher.FindAll(wide.c_str() + chatstart, wide.size() - chatstart, matches);
+		std::vector<std::pair<size_t, size_t> > bounds;
+		for (size_t i = 0; i < matches.size(); i++) {
+			bounds.push_back(std::make_pair(chatstart + matches[i].offset, chatstart + matches[i].offset + matches[i].length));
+		}
+		// matches may overlap, merge them
+		std::sort(bounds.begin(), bounds.end());
+		for (size_t i = 0; i < bounds.size(); i++) {
+			if (!marks.empty() && (bounds[i].first <= marks.back().start + marks.back().length)) {
+				marks.back().length = std::max(marks.back().start + marks.back().length, bounds[i].second) - marks.back().start;
+			} else {
+				marks.push_back(ChatView::Range(bounds[i].first, bounds[i].second - bounds[i].first));
 			}
-			m1 = m1.Mid(1); //next char!
 		}
-		m_chatlog_text->AppendText(_T("\n"));
-	} else
-#endif
-	{
-		m_chatlog_text->SetDefaultStyle(line.chatstyle);
-		m_chatlog_text->AppendText(line.chat + _T( "\n" ));
 	}
 
-
-	m_chatlog_text->ScrollLines(1);
-	m_chatlog_text->ShowPosition(m_chatlog_text->GetLastPosition());
+	m_chatlog_text->AppendLine(text, spans, marks);
 }
 
 
@@ -513,8 +524,10 @@ void ChatPanel::OnLinkEvent(wxTextUrlEvent& event)
 	if (!event.GetMouseEvent().LeftDown())
 		return;
 
-	wxString url = m_chatlog_text->GetRange(event.GetURLStart(), event.GetURLEnd());
-	OpenWebBrowser(url);
+	const wxString url = m_chatlog_text->GetUrlAt(event.GetMouseEvent().GetPosition());
+	if (!url.empty()) {
+		OpenWebBrowser(url);
+	}
 }
 
 void ChatPanel::OnChanOpts(wxCommandEvent& /*unused*/)
@@ -573,11 +586,13 @@ void ChatPanel::Said(const wxString& who, const wxString& message)
 		m_active_users.insert(who);
 	}
 
+	const ChatSettings& chat = sett().GetChatSettings();
 	wxString me = TowxString(GetMe().GetNick());
 	wxColour col;
 	bool req_user = false;
+	bool highlight = false;
 	if (who.Upper() == me.Upper()) {
-		col = sett().GetChatColorMine();
+		col = chat.mine;
 	} else {
 		// change the image of the tab to show new events
 		SetIconHighlight(highlight_say);
@@ -585,10 +600,11 @@ void ChatPanel::Said(const wxString& who, const wxString& message)
 			req_user = true;
 		//process logic for custom word highlights
 		if (ContainsWordToHighlight(message)) {
-			req_user = sett().GetRequestAttOnHighlight();
-			col = sett().GetChatColorHighlight();
+			highlight = true;
+			req_user = chat.reqattonhighlight;
+			col = chat.highlight;
 		} else
-			col = sett().GetChatColorNormal();
+			col = chat.normal;
 	}
 
 	if ((who == cfg().ReadString(_T("/Channel/bridgebot"))) && (message.StartsWith(_T( "<" ))) && (message.Find(_T( ">" )) != wxNOT_FOUND)) {
@@ -596,9 +612,9 @@ void ChatPanel::Said(const wxString& who, const wxString& message)
 		wxString message2;
 		who2 = message.BeforeFirst('>').AfterFirst('<');
 		message2 = message.AfterFirst('>');
-		OutputLine(_T( "<" ) + who2 + _T( "> " ) + message2, col);
+		OutputLine(_T( "<" ) + who2 + _T( "> " ) + message2, col, true, highlight);
 	} else {
-		OutputLine(_T( "<" ) + who + _T( "> " ) + message, col);
+		OutputLine(_T( "<" ) + who + _T( "> " ) + message, col, true, highlight);
 	}
 
 
@@ -615,13 +631,21 @@ void ChatPanel::Said(const wxString& who, const wxString& message)
 
 bool ChatPanel::ContainsWordToHighlight(const wxString& message) const
 {
-	//get list of words to highlight
-	wxArrayString words = sett().GetHighlightedWords();
-	for (unsigned int i = 0; i < words.GetCount(); i++) {
-		if (message.Find(words[i]) != wxNOT_FOUND)
-			return true;
+	if (m_highlight_matcher.IsEmpty())
+		return false;
+	const std::wstring wide = message.ToStdWstring();
+	return m_highlight_matcher.Contains(wide.c_str(), wide.size());
+}
+
+//! rebuilds the matcher for the words to highlight, has to be called when the settings change
+void ChatPanel::UpdateHighlightMatcher()
+{
+	const wxArrayString words = sett().GetHighlightedWords();
+	std::vector<std::wstring> wide;
+	for (size_t i = 0; i < words.GetCount(); i++) {
+		wide.push_back(words[i].ToStdWstring());
 	}
-	return false;
+	m_highlight_matcher.SetWords(wide, cfg().ReadBool(_T("/Chat/HighlightIgnoreCase")), cfg().ReadBool(_T("/Chat/HighlightWholeWords")));
 }
 
 /**
@@ -751,6 +775,27 @@ void ChatPanel::OnChannelJoin(User& who)
 	textcompletiondatabase.Insert_Mapping(TowxString(who.GetNick()), TowxString(who.GetNick()));
 }
 
+void ChatPanel::OnChannelJoinMany(const std::vector<User*>& who)
+{
+	if (m_show_nick_list && (m_nicklist != nullptr)) {
+		m_nicklist->AddUsers(who);
+		UpdateUserCountLabel();
+	}
+	wxArrayString nicks;
+	wxArrayString lines;
+	nicks.Alloc(who.size());
+	const wxString chattype = GetChatTypeStr();
+	for (User* user : who) {
+		const wxString nick = TowxString(user->GetNick());
+		if (m_display_joinitem) {
+			lines.Add(_T( "** " ) + wxString::Format(_("%s joined %s."), nick.c_str(), chattype.c_str()));
+		}
+		nicks.Add(nick);
+	}
+	OutputLines(lines, sett().GetChatColorJoinPart());
+	textcompletiondatabase.Insert_Mappings(nicks);
+}
+
 void ChatPanel::Parted(User& who, const wxString& message)
 {
 	//    assert( m_type == CPT_Channel || m_type == CPT_Server || m_type == CPT_Battle || m_type == CPT_User );
@@ -882,7 +927,7 @@ void ChatPanel::SetUser(User* usr)
 		if (m_user != NULL) {
 			m_user->panel = nullptr;
 			if (m_chan_opts_button != NULL) {
-				m_chan_opts_button->SetBitmapLabel(IconsCollection::Instance()->BMP_EMPTY);
+				m_chan_opts_button->SetBitmapLabel(IconsCollection::Instance()->BMP_EMPTY.Get());
 			}
 		}
 	} else {
@@ -946,7 +991,7 @@ bool ChatPanel::Say(const wxString& message) //FIXME: remove all parsing / token
 		}
 
 		if (line == _T( "/clear" )) {
-			m_chatlog_text->SetValue(wxEmptyString);
+			m_chatlog_text->Clear();
 			return true;
 		}
 
@@ -1066,41 +1111,10 @@ void ChatPanel::FocusInputBox()
 	m_say_text->SetFocus();
 }
 
-wxString ChatPanel::FindUrl(const long pos) const
-{
-	if (pos < 0) {
-		return wxEmptyString;
-	}
-	long last = m_chatlog_text->GetLastPosition();
-
-	long start = pos;
-	while (start > 0 && m_chatlog_text->GetRange(start - 1, start) != _T(" "))
-		start--;
-
-	long end = pos;
-	//the last bit prevents topic links from being copied with next line's timestamp appended
-	//checking for newline isn't possible, cause links may well span multiple lines
-	while (end < last && m_chatlog_text->GetRange(end, end + 1) != _T(" ") && m_chatlog_text->GetRange(end, end + 1) != _T("["))
-		end++;
-
-	wxString ret = m_chatlog_text->GetRange(start, end);
-	//! \todo there's prolly some smarter way to capture a more flexible range of url types
-	if (ret.StartsWith(_T("http://")) || ret.StartsWith(_T("https://")) || ret.StartsWith(_T("ftp://")))
-		return ret;
-	else
-		return wxEmptyString;
-}
-
 void ChatPanel::OnMouseDown(wxMouseEvent& event)
 {
 	slLogDebugFunc("");
-	wxTextCoord row;
-	wxTextCoord col;
-	wxTextCtrlHitTestResult ht = m_chatlog_text->HitTest(event.GetPosition(), &col, &row);
-	if (ht != wxTE_HT_UNKNOWN) {
-		long pos = m_chatlog_text->XYToPosition(col, row);
-		m_url_at_pos = FindUrl(pos);
-	}
+	m_url_at_pos = m_chatlog_text->GetUrlAt(event.GetPosition());
 	CreatePopup();
 	if (m_popup_menu != NULL) {
 		PopupMenu(m_popup_menu->GetMenu());
@@ -1200,6 +1214,8 @@ void ChatPanel::SetBattle(IBattle* battle)
 
 void ChatPanel::OnLogin(wxCommandEvent& /*data*/)
 {
+	// own nick might have been added to the highlighted words
+	UpdateHighlightMatcher();
 	switch (m_type) {
 		case CPT_Channel:
 			if (m_channel) {
@@ -1227,9 +1243,12 @@ void ChatPanel::SetLogFile(const wxString& name)
 	wxArrayString lines = m_chat_log.GetLastLines();
 	const size_t num_lines = sett().GetAutoloadedChatlogLinesCount();
 	const size_t start = std::max<size_t>(0, lines.Count() - num_lines);
+	// the scrollbar is updated once for the whole history
+	m_chatlog_text->BeginAppend();
 	for (size_t i = start; i < lines.Count(); ++i) {
 		OutputLine(lines[i], sett().GetChatColorServer(), false);
 	}
+	m_chatlog_text->EndAppend();
 }
 
 void ChatPanel::SetVotePanel(VotePanel* votePanel)
@@ -1289,8 +1308,13 @@ void ChatPanel::ReadSettings()
 	//Hide bots by default
 	m_ShowPlayersOnlyFlag = true;
 
+	UpdateHighlightMatcher();
+
 	if (m_chatlog_text != nullptr) {
 		m_chatlog_text->SetBackgroundColour(sett().GetChatColorBackground());
+		m_chatlog_text->SetFont(sett().GetChatFont());
+		m_chatlog_text->SetMaxLines(std::max(0, sett().GetChatHistoryLenght()));
+		m_chatlog_text->Refresh();
 	}
 	if (m_say_text != nullptr) {
 		m_say_text->SetBackgroundColour(sett().GetChatColorBackground());
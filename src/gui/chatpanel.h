@@ -11,12 +11,14 @@
 #include "chatlog.h"
 #include "utils/mixins.h"
 #include "utils/TextCompletionDatabase.h"
+#include "utils/highlightmatcher.h"
 class wxCommandEvent;
 class wxSizeEvent;
 class wxBoxSizer;
 class wxSplitterWindow;
 class wxTextCtrl;
 class wxTextCtrlHist;
+class ChatView;
 class wxTextUrlEvent;
 class wxComboBox;
 class wxButton;
@@ -50,6 +52,7 @@ struct ChatLine {
 	wxString time;
 	wxTextAttr timestyle;
 	wxTextAttr chatstyle;
+	bool highlight; //!< mark highlighted words
 };
 
 /*! @brief wxPanel that contains a chat.
@@ -83,6 +86,7 @@ public:
 	void SetTopic(const wxString& who, const wxString& message);
 	void UserStatusUpdated(User& who);
 	void OnChannelJoin(User& who);
+	void OnChannelJoinMany(const std::vector<User*>& who);
 
 	const Channel* GetChannel() const;
 	void SetChannel(Channel* chan);
@@ -153,7 +157,9 @@ private:
 
 	void OnLogin(wxCommandEvent& data);
 
-	void OutputLine(const wxString& message, const wxColour& col, bool showtime = true);
+	void OutputLine(const wxString& message, const wxColour& col, bool showtime = true, bool highlight = false);
+	//! outputs many lines with the same colour and time, logs them in one write
+	void OutputLines(const wxArrayString& messages, const wxColour& col);
 	void OutputError(const wxString& message);
 
 	void OutputLine(const ChatLine& line);
@@ -161,9 +167,8 @@ private:
 	void UpdateUserCountLabel();
 
 	void SetIconHighlight(HighlightType highlight);
-	wxString FindUrl(const long pos) const;
-
 	bool ContainsWordToHighlight(const wxString& message) const;
+	void UpdateHighlightMatcher();
 
 	void LogTime();
 	void CreateControls();
@@ -189,7 +194,7 @@ private:
 	wxPanel* m_nick_panel;		    //!< Panel containing the nicklist.
 	wxTextCtrl* m_nick_filter;	  //!< Textcontrol for filtering nicklist
 	wxCheckBox* m_showPlayerOnlyCheck;  //!< CheckBox for showing only live players (not bots)
-	wxTextCtrl* m_chatlog_text;	 //!< The chat log textcontrol.
+	ChatView* m_chatlog_text;	   //!< The chat log view.
 	wxTextCtrlHist* m_say_text;	 //!< The say textcontrol.
 	wxBitmapButton* m_chan_opts_button; //!< The channel options button.
 
@@ -221,6 +226,8 @@ private:
 	static const int m_groupMenu_baseID = 6798;
 	TextCompletionDatabase textcompletiondatabase;
 
+	HighlightMatcher m_highlight_matcher;
+
 	std::vector<ChatLine> m_buffer;
 	std::set<wxString> m_active_users; //users who spoke
 	bool m_disable_append;		   //disable text appending
@@ -6,6 +6,7 @@
 #include "battlelist/battlelisttab.h"
 #include "channel.h"
 #include "chatpanel.h"
+#include "chatview.h"
 #include "gui/customdialogs.h"
 #include "iserver.h"
 #include "mainwindow.h"
@@ -686,7 +687,7 @@ void ChatPanelMenu::OnChatMenuOpenLog(wxCommandEvent&)
 
 void ChatPanelMenu::OnChannelClearContents(wxCommandEvent& /*unused*/)
 {
-	m_chatpanel->m_chatlog_text->SetValue(wxEmptyString);
+	m_chatpanel->m_chatlog_text->Clear();
 }
 
 void ChatPanelMenu::OnUserMenuAddToGroup(wxCommandEvent& event)
@@ -827,7 +828,7 @@ void ChatPanelMenu::OnMenuItem(wxCommandEvent& event)
 	else if (event.GetId() == GROUP_ID_REMOVE)
 		OnUserMenuDeleteFromGroup(event);
 	else if (event.GetId() == wxID_COPY)
-		m_chatpanel->m_chatlog_text->OnCopy(event);
+		m_chatpanel->m_chatlog_text->Copy();
 	else
 		OnUserMenuAddToGroup(event);
 }
@@ -0,0 +1,685 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "chatview.h"
+
+#include <wx/clipbrd.h>
+#include <wx/dataobj.h>
+#include <wx/dcbuffer.h>
+#include <wx/dcclient.h>
+#include <wx/settings.h>
+#include <wx/textctrl.h>
+#include <algorithm>
+
+BEGIN_EVENT_TABLE(ChatView, wxWindow)
+EVT_PAINT(ChatView::OnPaint)
+EVT_SIZE(ChatView::OnSize)
+EVT_SCROLLWIN(ChatView::OnScroll)
+EVT_MOUSEWHEEL(ChatView::OnMouseWheel)
+EVT_LEFT_DOWN(ChatView::OnLeftDown)
+EVT_LEFT_UP(ChatView::OnLeftUp)
+EVT_MOTION(ChatView::OnMouseMove)
+EVT_MOUSE_CAPTURE_LOST(ChatView::OnMouseCaptureLost)
+EVT_KEY_DOWN(ChatView::OnKeyDown)
+END_EVENT_TABLE()
+
+static void FindUrls(const wxString& text, std::vector<ChatView::Range>& urls)
+{
+	static const wxString prefixes[] = {_T("http://"), _T("https://"), _T("ftp://")};
+	size_t pos = 0;
+	while (pos < text.length()) {
+		size_t start = wxString::npos;
+		for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+			start = std::min(start, text.find(prefixes[i], pos));
+		}
+		if (start == wxString::npos)
+			return;
+		size_t end = start;
+		while ((end < text.length()) && !wxIsspace(text[end])) {
+			end++;
+		}
+		urls.push_back(ChatView::Range(start, end - start));
+		pos = end;
+	}
+}
+
+//! splits spans at the boundaries of the sorted, non overlapping ranges and adds style to the parts inside
+static void SplitSpans(const std::vector<ChatView::Span>& spans, const std::vector<ChatView::Range>& ranges, int style, std::vector<ChatView::Span>& out)
+{
+	out.clear();
+	for (size_t s = 0; s < spans.size(); s++) {
+		const ChatView::Span& span = spans[s];
+		const size_t span_end = span.start + span.length;
+		size_t pos = span.start;
+		for (size_t i = 0; (i < ranges.size()) && (pos < span_end); i++) {
+			const size_t range_end = ranges[i].start + ranges[i].length;
+			if (range_end <= pos)
+				continue;
+			if (ranges[i].start >= span_end)
+				break;
+			if (ranges[i].start > pos) {
+				out.push_back(ChatView::Span(pos, ranges[i].start - pos, span.colour, span.style, span.background));
+				pos = ranges[i].start;
+			}
+			const size_t end = std::min(range_end, span_end);
+			out.push_back(ChatView::Span(pos, end - pos, span.colour, span.style | style, span.background));
+			pos = end;
+		}
+		if (pos < span_end) {
+			out.push_back(ChatView::Span(pos, span_end - pos, span.colour, span.style, span.background));
+		}
+	}
+}
+
+ChatView::ChatView(wxWindow* parent, wxWindowID id)
+    : wxWindow(parent, id, wxDefaultPosition, wxDefaultSize, wxVSCROLL | wxWANTS_CHARS | wxFULL_REPAINT_ON_RESIZE)
+    , m_next_seq(0)
+    , m_follow(true)
+    , m_top_seq(0)
+    , m_append_batch(0)
+    , m_top_trimmed(false)
+    , m_selecting(false)
+    , m_line_height(1)
+    , m_layout_generation(0)
+{
+	SetBackgroundStyle(wxBG_STYLE_PAINT);
+	SetCursor(wxCursor(wxCURSOR_IBEAM));
+	UpdateFonts();
+	UpdateScrollbar();
+}
+
+ChatView::~ChatView()
+{
+	if (HasCapture()) {
+		ReleaseMouse();
+	}
+}
+
+void ChatView::AppendLine(const wxString& text, const std::vector<Span>& spans, const std::vector<Range>& marks)
+{
+	Line line;
+	line.text = text;
+
+	std::vector<Span> styled;
+	if (spans.empty()) {
+		styled.push_back(Span(0, text.length(), GetForegroundColour()));
+	} else {
+		styled = spans;
+	}
+	if (!marks.empty()) {
+		std::vector<Span> marked;
+		SplitSpans(styled, marks, STYLE_BOLD, marked);
+		styled.swap(marked);
+	}
+	// urls are drawn underlined
+	FindUrls(text, line.urls);
+	SplitSpans(styled, line.urls, STYLE_UNDERLINE, line.spans);
+
+	m_lines.push_back(std::move(line));
+	m_next_seq++;
+
+	if (!m_follow && (m_top_seq < GetFirstSeq())) {
+		m_top_seq = GetFirstSeq();
+		m_top_trimmed = true;
+	}
+	if (m_append_batch > 0)
+		return;
+	UpdateScrollbar();
+	if (m_follow || m_top_trimmed) {
+		m_top_trimmed = false;
+		Refresh(false);
+	}
+}
+
+void ChatView::BeginAppend()
+{
+	m_append_batch++;
+}
+
+void ChatView::EndAppend()
+{
+	wxASSERT(m_append_batch > 0);
+	if (--m_append_batch > 0)
+		return;
+	UpdateScrollbar();
+	if (m_follow || m_top_trimmed) {
+		m_top_trimmed = false;
+		Refresh(false);
+	}
+}
+
+void ChatView::Clear()
+{
+	m_lines.clear();
+	m_follow = true;
+	m_top_seq = m_next_seq;
+	m_sel_anchor = m_sel_cursor = TextPos();
+	m_visible.clear();
+	UpdateScrollbar();
+	Refresh(false);
+}
+
+void ChatView::SetMaxLines(size_t maxlines)
+{
+	if (maxlines == m_lines.GetCapacity())
+		return;
+	m_lines.SetCapacity(maxlines);
+	if (!m_follow && (m_top_seq < GetFirstSeq())) {
+		m_top_seq = GetFirstSeq();
+	}
+	UpdateScrollbar();
+	Refresh(false);
+}
+
+size_t ChatView::GetNumberOfLines() const
+{
+	return m_lines.size();
+}
+
+bool ChatView::SetFont(const wxFont& font)
+{
+	if (!wxWindow::SetFont(font))
+		return false;
+	UpdateFonts();
+	UpdateScrollbar();
+	Refresh(false);
+	return true;
+}
+
+unsigned long long ChatView::GetFirstSeq() const
+{
+	return m_next_seq - m_lines.size();
+}
+
+ChatView::Line* ChatView::GetLine(unsigned long long seq)
+{
+	if ((seq < GetFirstSeq()) || (seq >= m_next_seq))
+		return nullptr;
+	return &m_lines[seq - GetFirstSeq()];
+}
+
+const ChatView::Line* ChatView::GetLine(unsigned long long seq) const
+{
+	if ((seq < GetFirstSeq()) || (seq >= m_next_seq))
+		return nullptr;
+	return &m_lines[seq - GetFirstSeq()];
+}
+
+void ChatView::UpdateFonts()
+{
+	const wxFont base = GetFont();
+	wxClientDC dc(this);
+	m_line_height = 1;
+	for (int style = 0; style <= STYLE_MASK; style++) {
+		wxFont font = base;
+		if (style & STYLE_BOLD)
+			font.SetWeight(wxFONTWEIGHT_BOLD);
+		if (style & STYLE_ITALIC)
+			font.SetStyle(wxFONTSTYLE_ITALIC);
+		if (style & STYLE_UNDERLINE)
+			font.SetUnderlined(true);
+		m_fonts[style] = font;
+		dc.SetFont(font);
+		m_line_height = std::max(m_line_height, dc.GetCharHeight());
+	}
+	// all cached layouts are invalid now
+	m_layout_generation++;
+}
+
+const wxFont& ChatView::GetStyleFont(int style) const
+{
+	return m_fonts[style & STYLE_MASK];
+}
+
+void ChatView::EnsureLayout(Line& line, wxDC& dc, int width) const
+{
+	if ((line.layout_width == width) && (line.layout_generation == m_layout_generation))
+		return;
+	line.layout_width = width;
+	line.layout_generation = m_layout_generation;
+	line.pieces.clear();
+
+	const int avail = std::max(width - 2 * MARGIN, 1);
+	int row = 0;
+	int x = 0;
+	for (size_t s = 0; s < line.spans.size(); s++) {
+		const Span& span = line.spans[s];
+		if (span.length == 0)
+			continue;
+		dc.SetFont(GetStyleFont(span.style));
+		const wxString chunk = line.text.Mid(span.start, span.length);
+		wxArrayInt extents;
+		dc.GetPartialTextExtents(chunk, extents);
+
+		size_t begin = 0;
+		while (begin < chunk.length()) {
+			const int base = (begin > 0) ? extents[begin - 1] : 0;
+			size_t end = begin;
+			while ((end < chunk.length()) && (x + extents[end] - base <= avail)) {
+				end++;
+			}
+			if (end < chunk.length()) {
+				// prefer wrapping after a space
+				size_t brk = end;
+				while ((brk > begin) && (chunk[brk - 1] != ' ')) {
+					brk--;
+				}
+				if (brk > begin) {
+					end = brk;
+				} else if ((x == 0) && (end == begin)) { // not even a single char fits
+					end = begin + 1;
+				}
+			}
+			if (end > begin) {
+				line.pieces.push_back(Piece(span.start + begin, end - begin, s, row, x));
+				x += extents[end - 1] - base;
+			}
+			if (end < chunk.length()) {
+				row++;
+				x = 0;
+			}
+			begin = end;
+		}
+	}
+	line.rows = row + 1;
+}
+
+void ChatView::GetSelection(TextPos& from, TextPos& to) const
+{
+	if (m_sel_cursor < m_sel_anchor) {
+		from = m_sel_cursor;
+		to = m_sel_anchor;
+	} else {
+		from = m_sel_anchor;
+		to = m_sel_cursor;
+	}
+}
+
+void ChatView::DrawText(wxDC& dc, const wxString& text, const Span& span, int x, int y, bool selected) const
+{
+	if (selected || span.background.IsOk()) {
+		const wxSize size = dc.GetTextExtent(text);
+		dc.SetPen(*wxTRANSPARENT_PEN);
+		dc.SetBrush(wxBrush(selected ? wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT) : span.background));
+		dc.DrawRectangle(x, y, size.x, m_line_height);
+	}
+	if (selected) {
+		dc.SetTextForeground(wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHTTEXT));
+	} else {
+		dc.SetTextForeground(span.colour);
+	}
+	dc.DrawText(text, x, y);
+}
+
+void ChatView::DrawLine(wxDC& dc, const Line& line, unsigned long long seq, int y) const
+{
+	TextPos sel_from;
+	TextPos sel_to;
+	GetSelection(sel_from, sel_to);
+
+	for (size_t i = 0; i < line.pieces.size(); i++) {
+		const Piece& piece = line.pieces[i];
+		const Span& span = line.spans[piece.span];
+		const int row_y = y + piece.row * m_line_height;
+		int x = MARGIN + piece.x;
+		dc.SetFont(GetStyleFont(span.style));
+
+		// selected part of this piece, relative to piece.start
+		size_t from = piece.length;
+		size_t to = piece.length;
+		if ((sel_from < sel_to) && !(TextPos(seq, piece.start + piece.length) < sel_from) && (TextPos(seq, piece.start) < sel_to)) {
+			from = (sel_from.seq < seq) ? 0 : std::max(sel_from.offset, piece.start) - piece.start;
+			to = (sel_to.seq > seq) ? piece.length : std::min(sel_to.offset, piece.start + piece.length) - piece.start;
+		}
+		if (from >= to) {
+			DrawText(dc, line.text.Mid(piece.start, piece.length), span, x, row_y, false);
+			continue;
+		}
+		const wxString head = line.text.Mid(piece.start, from);
+		const wxString selected = line.text.Mid(piece.start + from, to - from);
+		const wxString tail = line.text.Mid(piece.start + to, piece.length - to);
+		if (!head.empty()) {
+			DrawText(dc, head, span, x, row_y, false);
+			x += dc.GetTextExtent(head).x;
+		}
+		DrawText(dc, selected, span, x, row_y, true);
+		x += dc.GetTextExtent(selected).x;
+		if (!tail.empty()) {
+			DrawText(dc, tail, span, x, row_y, false);
+		}
+	}
+}
+
+void ChatView::OnPaint(wxPaintEvent& /*event*/)
+{
+	wxAutoBufferedPaintDC dc(this);
+	dc.SetBackground(wxBrush(GetBackgroundColour()));
+	dc.Clear();
+	dc.SetBackgroundMode(wxTRANSPARENT);
+
+	m_visible.clear();
+	if (m_lines.empty())
+		return;
+
+	const wxSize size = GetClientSize();
+	if (m_follow) {
+		// anchor the newest line at the bottom and fill upwards
+		int y = size.y - MARGIN;
+		for (size_t i = m_lines.size(); (i > 0) && (y > 0); i--) {
+			Line& line = m_lines[i - 1];
+			EnsureLayout(line, dc, size.x);
+			y -= line.rows * m_line_height;
+			m_visible.push_back(VisibleLine(GetFirstSeq() + i - 1, y));
+		}
+		std::reverse(m_visible.begin(), m_visible.end());
+	} else {
+		int y = MARGIN;
+		for (size_t i = m_top_seq - GetFirstSeq(); (i < m_lines.size()) && (y < size.y); i++) {
+			Line& line = m_lines[i];
+			EnsureLayout(line, dc, size.x);
+			m_visible.push_back(VisibleLine(GetFirstSeq() + i, y));
+			y += line.rows * m_line_height;
+		}
+	}
+
+	for (size_t i = 0; i < m_visible.size(); i++) {
+		DrawLine(dc, *GetLine(m_visible[i].seq), m_visible[i].seq, m_visible[i].y);
+	}
+}
+
+void ChatView::OnSize(wxSizeEvent& event)
+{
+	UpdateScrollbar();
+	Refresh(false);
+	event.Skip();
+}
+
+int ChatView::GetPageLines() const
+{
+	return std::max(1, GetClientSize().y / m_line_height);
+}
+
+long ChatView::GetTopIndex() const
+{
+	if (m_follow) {
+		return std::max<long>(0, (long)m_lines.size() - GetPageLines());
+	}
+	return (long)(m_top_seq - GetFirstSeq());
+}
+
+void ChatView::ScrollToIndex(long index)
+{
+	const long max_top = std::max<long>(0, (long)m_lines.size() - GetPageLines());
+	if (index >= max_top) {
+		m_follow = true;
+	} else {
+		m_follow = false;
+		m_top_seq = GetFirstSeq() + std::max<long>(0, index);
+	}
+	UpdateScrollbar();
+	Refresh(false);
+}
+
+void ChatView::ScrollToEnd()
+{
+	ScrollToIndex((long)m_lines.size());
+}
+
+void ChatView::UpdateScrollbar()
+{
+	// one scroll unit per chat line, wrapped rows aren't taken into account
+	const int page = GetPageLines();
+	const int range = (int)m_lines.size();
+	SetScrollbar(wxVERTICAL, (int)GetTopIndex(), page, range);
+}
+
+void ChatView::OnScroll(wxScrollWinEvent& event)
+{
+	if (event.GetOrientation() != wxVERTICAL) {
+		event.Skip();
+		return;
+	}
+	const wxEventType type = event.GetEventType();
+	long index = GetTopIndex();
+	if (type == wxEVT_SCROLLWIN_TOP) {
+		index = 0;
+	} else if (type == wxEVT_SCROLLWIN_BOTTOM) {
+		index = (long)m_lines.size();
+	} else if (type == wxEVT_SCROLLWIN_LINEUP) {
+		index--;
+	} else if (type == wxEVT_SCROLLWIN_LINEDOWN) {
+		index++;
+	} else if (type == wxEVT_SCROLLWIN_PAGEUP) {
+		index -= GetPageLines();
+	} else if (type == wxEVT_SCROLLWIN_PAGEDOWN) {
+		index += GetPageLines();
+	} else {
+		index = event.GetPosition();
+	}
+	ScrollToIndex(index);
+}
+
+void ChatView::OnMouseWheel(wxMouseEvent& event)
+{
+	if (event.GetWheelDelta() == 0)
+		return;
+	const int lines = -event.GetWheelRotation() / event.GetWheelDelta() * event.GetLinesPerAction();
+	ScrollToIndex(GetTopIndex() + lines);
+}
+
+bool ChatView::HitTestText(const wxPoint& pos, TextPos& result) const
+{
+	if (m_visible.empty())
+		return false;
+
+	// above / below the visible lines: clamp to the first / last char
+	if (pos.y < m_visible.front().y) {
+		result = TextPos(m_visible.front().seq, 0);
+		return true;
+	}
+	for (size_t i = 0; i < m_visible.size(); i++) {
+		const VisibleLine& visible = m_visible[i];
+		const Line* line = GetLine(visible.seq);
+		if (line == nullptr)
+			continue;
+		if (pos.y >= visible.y + line->rows * m_line_height)
+			continue;
+
+		const int row = (pos.y - visible.y) / m_line_height;
+		const int x = pos.x - MARGIN;
+		result = TextPos(visible.seq, 0);
+		for (size_t p = 0; p < line->pieces.size(); p++) {
+			const Piece& piece = line->pieces[p];
+			if (piece.row < row) {
+				result.offset = piece.start + piece.length;
+				continue;
+			}
+			if ((piece.row > row) || (x < piece.x))
+				break;
+			wxClientDC dc(const_cast<ChatView*>(this));
+			dc.SetFont(GetStyleFont(line->spans[piece.span].style));
+			wxArrayInt extents;
+			dc.GetPartialTextExtents(line->text.Mid(piece.start, piece.length), extents);
+			size_t offset = 0;
+			while ((offset < piece.length) && (piece.x + extents[offset] <= x)) {
+				offset++;
+			}
+			result.offset = piece.start + offset;
+			if (offset < piece.length)
+				break;
+		}
+		return true;
+	}
+	const Line* last = GetLine(m_visible.back().seq);
+	result = TextPos(m_visible.back().seq, (last != nullptr) ? last->text.length() : 0);
+	return true;
+}
+
+const ChatView::Line* ChatView::FindUrlAt(const wxPoint& pos, Range& url) const
+{
+	TextPos hit;
+	if (!HitTestText(pos, hit))
+		return nullptr;
+	const Line* line = GetLine(hit.seq);
+	if (line == nullptr)
+		return nullptr;
+	for (size_t i = 0; i < line->urls.size(); i++) {
+		const Range& range = line->urls[i];
+		if ((hit.offset >= range.start) && (hit.offset < range.start + range.length)) {
+			url = range;
+			return line;
+		}
+	}
+	return nullptr;
+}
+
+wxString ChatView::GetUrlAt(const wxPoint& pos) const
+{
+	Range url(0, 0);
+	const Line* line = FindUrlAt(pos, url);
+	if (line == nullptr)
+		return wxEmptyString;
+	return line->text.Mid(url.start, url.length);
+}
+
+bool ChatView::HasSelection() const
+{
+	return !(m_sel_anchor == m_sel_cursor);
+}
+
+wxString ChatView::GetSelectedText() const
+{
+	TextPos from;
+	TextPos to;
+	GetSelection(from, to);
+	wxString text;
+	for (unsigned long long seq = std::max(from.seq, GetFirstSeq()); seq <= to.seq; seq++) {
+		const Line* line = GetLine(seq);
+		if (line == nullptr)
+			break;
+		const size_t start = (seq == from.seq) ? from.offset : 0;
+		const size_t end = (seq == to.seq) ? to.offset : line->text.length();
+		if (seq != std::max(from.seq, GetFirstSeq())) {
+			text += _T("\n");
+		}
+		if (end > start) {
+			text += line->text.Mid(start, end - start);
+		}
+	}
+	return text;
+}
+
+void ChatView::SelectAll()
+{
+	if (m_lines.empty())
+		return;
+	m_sel_anchor = TextPos(GetFirstSeq(), 0);
+	m_sel_cursor = TextPos(m_next_seq - 1, m_lines.back().text.length());
+	Refresh(false);
+}
+
+void ChatView::Copy()
+{
+	if (!HasSelection())
+		return;
+	if (wxTheClipboard->Open()) {
+		wxTheClipboard->SetData(new wxTextDataObject(GetSelectedText()));
+		wxTheClipboard->Close();
+	}
+}
+
+void ChatView::OnLeftDown(wxMouseEvent& event)
+{
+	SetFocus();
+	TextPos hit;
+	if (!HitTestText(event.GetPosition(), hit)) {
+		event.Skip();
+		return;
+	}
+
+	Range url(0, 0);
+	if (FindUrlAt(event.GetPosition(), url) != nullptr) {
+		// offsets within the clicked line
+		wxTextUrlEvent urlevent(GetId(), event, (long)url.start, (long)(url.start + url.length));
+		urlevent.SetEventObject(this);
+		HandleWindowEvent(urlevent);
+	}
+
+	if (event.ShiftDown() && HasSelection()) {
+		m_sel_cursor = hit;
+	} else {
+		m_sel_anchor = m_sel_cursor = hit;
+	}
+	m_selecting = true;
+	if (!HasCapture()) {
+		CaptureMouse();
+	}
+	Refresh(false);
+}
+
+void ChatView::OnLeftUp(wxMouseEvent& /*event*/)
+{
+	m_selecting = false;
+	if (HasCapture()) {
+		ReleaseMouse();
+	}
+}
+
+void ChatView::OnMouseMove(wxMouseEvent& event)
+{
+	if (!m_selecting || !event.LeftIsDown()) {
+		event.Skip();
+		return;
+	}
+	// dragging out of the window scrolls
+	if (event.GetPosition().y < 0) {
+		ScrollToIndex(GetTopIndex() - 1);
+	} else if (event.GetPosition().y > GetClientSize().y) {
+		ScrollToIndex(GetTopIndex() + 1);
+	}
+	TextPos hit;
+	if (HitTestText(event.GetPosition(), hit) && !(hit == m_sel_cursor)) {
+		m_sel_cursor = hit;
+		Refresh(false);
+	}
+}
+
+void ChatView::OnMouseCaptureLost(wxMouseCaptureLostEvent& /*event*/)
+{
+	m_selecting = false;
+}
+
+void ChatView::OnKeyDown(wxKeyEvent& event)
+{
+	if (event.GetModifiers() == wxMOD_CMD) {
+		switch (event.GetKeyCode()) {
+			case 'C':
+			case WXK_INSERT:
+				Copy();
+				return;
+			case 'A':
+				SelectAll();
+				return;
+			case WXK_HOME:
+				ScrollToIndex(0);
+				return;
+			case WXK_END:
+				ScrollToEnd();
+				return;
+		}
+	}
+	switch (event.GetKeyCode()) {
+		case WXK_PAGEUP:
+			ScrollToIndex(GetTopIndex() - GetPageLines());
+			return;
+		case WXK_PAGEDOWN:
+			ScrollToIndex(GetTopIndex() + GetPageLines());
+			return;
+		case WXK_UP:
+			ScrollToIndex(GetTopIndex() - 1);
+			return;
+		case WXK_DOWN:
+			ScrollToIndex(GetTopIndex() + 1);
+			return;
+	}
+	event.Skip();
+}
@@ -0,0 +1,231 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_CHATVIEW_H
+#define SPRINGLOBBY_HEADERGUARD_CHATVIEW_H
+
+#include <wx/colour.h>
+#include <wx/font.h>
+#include <wx/window.h>
+#include <vector>
+
+#include "utils/ringbuffer.h"
+
+class wxDC;
+class wxPaintEvent;
+class wxSizeEvent;
+class wxMouseEvent;
+class wxScrollWinEvent;
+class wxKeyEvent;
+class wxMouseCaptureLostEvent;
+
+/** @brief owner drawn, read-only chat history
+ *
+ * Lines are stored pre-tokenized (text + style spans + url ranges) in a ring
+ * buffer, so appending and trimming the history are O(1). Only the lines
+ * currently visible are laid out and painted.
+ *
+ * Clicking an url sends a wxEVT_TEXT_URL event, like a wxTextCtrl created
+ * with wxTE_AUTO_URL does.
+ */
+class ChatView : public wxWindow
+{
+public:
+	enum SpanStyle {
+		STYLE_NORMAL = 0,
+		STYLE_BOLD = 1,
+		STYLE_ITALIC = 2,
+		STYLE_UNDERLINE = 4,
+		STYLE_MASK = 7
+	};
+
+	//! a run of equally formatted characters of a line
+	struct Span {
+		Span()
+		    : start(0)
+		    , length(0)
+		    , style(STYLE_NORMAL)
+		{
+		}
+		Span(size_t _start, size_t _length, const wxColour& _colour, int _style = STYLE_NORMAL, const wxColour& _background = wxNullColour)
+		    : start(_start)
+		    , length(_length)
+		    , colour(_colour)
+		    , background(_background)
+		    , style(_style)
+		{
+		}
+		size_t start;
+		size_t length;
+		wxColour colour;
+		wxColour background; //!< wxNullColour = transparent
+		int style;
+	};
+
+	struct Range {
+		Range(size_t _start, size_t _length)
+		    : start(_start)
+		    , length(_length)
+		{
+		}
+		size_t start;
+		size_t length;
+	};
+
+	ChatView(wxWindow* parent, wxWindowID id);
+	~ChatView();
+
+	/** appends a line
+	 * @param spans formatting of the text, sorted and not overlapping
+	 * @param marks ranges drawn emphasized, e.g. highlighted words, sorted and not overlapping
+	 */
+	void AppendLine(const wxString& text, const std::vector<Span>& spans, const std::vector<Range>& marks = std::vector<Range>());
+	//! lines appended until EndAppend() update the scrollbar and repaint only once
+	void BeginAppend();
+	void EndAppend();
+	void Clear();
+
+	//! @param maxlines number of lines kept, 0 = unlimited
+	void SetMaxLines(size_t maxlines);
+	size_t GetNumberOfLines() const;
+
+	virtual bool SetFont(const wxFont& font);
+
+	//! @returns the url at the given client position or an empty string
+	wxString GetUrlAt(const wxPoint& pos) const;
+
+	bool HasSelection() const;
+	wxString GetSelectedText() const;
+	void SelectAll();
+	//! copies the current selection to the clipboard
+	void Copy();
+
+	void ScrollToEnd();
+
+private:
+	//! part of a span placed on a single row after wrapping
+	struct Piece {
+		Piece(size_t _start, size_t _length, size_t _span, int _row, int _x)
+		    : start(_start)
+		    , length(_length)
+		    , span(_span)
+		    , row(_row)
+		    , x(_x)
+		{
+		}
+		size_t start;
+		size_t length;
+		size_t span;
+		int row;
+		int x;
+	};
+
+	struct Line {
+		Line()
+		    : layout_width(-1)
+		    , layout_generation(0)
+		    , rows(1)
+		{
+		}
+		wxString text;
+		std::vector<Span> spans;
+		std::vector<Range> urls;
+
+		// layout cache, valid as long as width and generation match
+		int layout_width;
+		unsigned int layout_generation;
+		int rows;
+		std::vector<Piece> pieces;
+	};
+
+	//! position of a character, lines are identified by their sequence number
+	struct TextPos {
+		TextPos()
+		    : seq(0)
+		    , offset(0)
+		{
+		}
+		TextPos(unsigned long long _seq, size_t _offset)
+		    : seq(_seq)
+		    , offset(_offset)
+		{
+		}
+		bool operator<(const TextPos& other) const
+		{
+			return (seq < other.seq) || ((seq == other.seq) && (offset < other.offset));
+		}
+		bool operator==(const TextPos& other) const
+		{
+			return (seq == other.seq) && (offset == other.offset);
+		}
+		unsigned long long seq;
+		size_t offset;
+	};
+
+	struct VisibleLine {
+		VisibleLine(unsigned long long _seq, int _y)
+		    : seq(_seq)
+		    , y(_y)
+		{
+		}
+		unsigned long long seq;
+		int y;
+	};
+
+	void OnPaint(wxPaintEvent& event);
+	void OnSize(wxSizeEvent& event);
+	void OnScroll(wxScrollWinEvent& event);
+	void OnMouseWheel(wxMouseEvent& event);
+	void OnLeftDown(wxMouseEvent& event);
+	void OnLeftUp(wxMouseEvent& event);
+	void OnMouseMove(wxMouseEvent& event);
+	void OnMouseCaptureLost(wxMouseCaptureLostEvent& event);
+	void OnKeyDown(wxKeyEvent& event);
+
+	unsigned long long GetFirstSeq() const;
+	Line* GetLine(unsigned long long seq);
+	const Line* GetLine(unsigned long long seq) const;
+
+	void UpdateFonts();
+	const wxFont& GetStyleFont(int style) const;
+	void EnsureLayout(Line& line, wxDC& dc, int width) const;
+	void DrawLine(wxDC& dc, const Line& line, unsigned long long seq, int y) const;
+	void DrawText(wxDC& dc, const wxString& text, const Span& span, int x, int y, bool selected) const;
+
+	bool HitTestText(const wxPoint& pos, TextPos& result) const;
+	//! the line and the range of the url at pos, NULL if there is none
+	const Line* FindUrlAt(const wxPoint& pos, Range& url) const;
+	void GetSelection(TextPos& from, TextPos& to) const;
+
+	int GetPageLines() const;
+	long GetTopIndex() const;
+	void ScrollToIndex(long index);
+	void UpdateScrollbar();
+
+	RingBuffer<Line> m_lines;
+	//! sequence number the next appended line gets
+	unsigned long long m_next_seq;
+
+	//! stick to the newest line, m_top_seq is ignored then
+	bool m_follow;
+	unsigned long long m_top_seq;
+	//! nesting depth of BeginAppend()
+	int m_append_batch;
+	//! trimming moved m_top_seq while appending, the shown lines changed
+	bool m_top_trimmed;
+
+	bool m_selecting;
+	TextPos m_sel_anchor;
+	TextPos m_sel_cursor;
+
+	wxFont m_fonts[STYLE_MASK + 1];
+	int m_line_height;
+	unsigned int m_layout_generation;
+
+	std::vector<VisibleLine> m_visible;
+
+	static const int MARGIN = 3;
+
+	DECLARE_EVENT_TABLE()
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_CHATVIEW_H
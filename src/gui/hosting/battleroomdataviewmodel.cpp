@@ -37,7 +37,7 @@ void BattleroomDataViewModel::GetValue(wxVariant& variant,
 			case COLOUR:
 			case COUNTRY:
 			case RANK:
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 				break;
 
 			case NICKNAME:
@@ -59,9 +59,9 @@ void BattleroomDataViewModel::GetValue(wxVariant& variant,
 	switch (col) {
 		case STATUS:
 			if (isBot) {
-				variant = wxVariant(iconsCollection->BMP_BOT);
+				variant = wxVariant(iconsCollection->BMP_BOT.Get());
 			} else if (isBridged) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				if (GetBattle()->IsFounder(*user)) {
 					variant = wxVariant(iconsCollection->GetHostBmp(isSpectator));
@@ -73,7 +73,7 @@ void BattleroomDataViewModel::GetValue(wxVariant& variant,
 
 		case INGAME:
 			if (isBridged) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				variant = wxVariant(iconsCollection->GetUserListStateIcon(user->GetStatus(), false /*channel operator?*/, (user->GetBattle() != nullptr) /*in broom?*/));
 			}
@@ -81,7 +81,7 @@ void BattleroomDataViewModel::GetValue(wxVariant& variant,
 
 		case FACTION:
 			if (isSpectator) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				variant = wxVariant(iconsCollection->GetFractionBmp(GetBattle()->GetHostGameName(), user->BattleStatus().side));
 			}
@@ -89,7 +89,7 @@ void BattleroomDataViewModel::GetValue(wxVariant& variant,
 
 		case COLOUR:
 			if (isSpectator) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				//TODO: implement!
 				variant = wxVariant(iconsCollection->GetColourBmp(user->GetColor()));
@@ -98,7 +98,7 @@ void BattleroomDataViewModel::GetValue(wxVariant& variant,
 
 		case COUNTRY:
 			if (isBot || isBridged) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				variant = wxVariant(iconsCollection->GetFlagBmp(wxString(user->GetCountry())));
 			}
@@ -106,7 +106,7 @@ void BattleroomDataViewModel::GetValue(wxVariant& variant,
 
 		case RANK:
 			if (isBot || isBridged) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				variant = wxVariant(iconsCollection->GetRankBmp(user->GetRank()));
 			}
@@ -5,6 +5,7 @@
 //
 #include "battleroomtab.h"
 
+#include <lslutils/conversion.h>
 #include <wx/bmpcbox.h>
 #include <wx/button.h>
 #include <wx/checkbox.h>
@@ -314,13 +315,13 @@ BattleRoomTab::BattleRoomTab(wxWindow* parent, IBattle* battle)
 	m_player_sett_sizer->Add(m_ready_chk, 0, wxEXPAND | wxALL, 2);
 	m_player_sett_sizer->Add(m_autolaunch_chk, 0, wxEXPAND | wxALL, 2);
 	m_player_sett_sizer->AddStretchSpacer();
-	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_SPECTATOR)), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
+	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_SPECTATOR.Get())), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
 	m_player_sett_sizer->Add(m_specs_setup_lbl, 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
-	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_PLAYER)), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
+	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_PLAYER.Get())), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
 	m_player_sett_sizer->Add(m_players_setup_lbl, 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
-	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_STARTED_GAME)), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
+	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_STARTED_GAME.Get())), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
 	m_player_sett_sizer->Add(m_ally_setup_lbl, 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
-	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_NREADY)), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
+	m_player_sett_sizer->Add((new wxGenericStaticBitmap(m_player_panel, wxID_ANY, IconsCollection::Instance()->BMP_NREADY.Get())), 0, (wxALIGN_CENTER_VERTICAL) | wxALL, 2);
 	m_player_sett_sizer->Add(m_ok_count_lbl, 0, wxALIGN_CENTER_VERTICAL, 2);
 
 	m_players_sizer->Add(m_players, 1, wxEXPAND);
@@ -449,6 +450,21 @@ void BattleRoomTab::UpdateBattleInfo()
 	UpdateMapInfoSummary();
 }
 
+void BattleRoomTab::UpdateBattleInfo(const std::vector<wxString>& Tags)
+{
+	for (const wxString& tag : Tags) {
+		UpdateBattleInfo(tag);
+	}
+}
+
+//! light for options at their default value, bold for changed ones
+static const wxFont& GetOptionFont(bool isdefault)
+{
+	static const wxFont defaultfont(8, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_LIGHT);
+	static const wxFont changedfont(8, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
+	return isdefault ? defaultfont : changedfont;
+}
+
 void BattleRoomTab::UpdateBattleInfo(const wxString& Tag)
 {
 	if (!m_battle)
@@ -472,19 +488,33 @@ void BattleRoomTab::UpdateBattleInfo(const wxString& Tag)
 	LSL::Enum::GameOption type = (LSL::Enum::GameOption)FromwxString(Tag.BeforeFirst('_'));
 	wxString key = Tag.AfterFirst('_');
 	if ((type == LSL::Enum::MapOption) || (type == LSL::Enum::ModOption) || (type == LSL::Enum::EngineOption)) {
-		LSL::Enum::OptionType DataType = m_battle->CustomBattleOptions().GetSingleOptionType(STD_STRING(key));
-		wxString value = TowxString(m_battle->CustomBattleOptions().getSingleValue(STD_STRING(key), (LSL::Enum::GameOption)type));
-		if (TowxString(m_battle->CustomBattleOptions().getDefaultValue(STD_STRING(key), type)) == value) {
-			m_opts_list->SetItemFont(index, wxFont(8, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_LIGHT));
-		} else {
-			m_opts_list->SetItemFont(index, wxFont(8, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD));
+		LSL::OptionsWrapper& options = m_battle->CustomBattleOptions();
+		const std::string optkey = STD_STRING(key);
+		const std::string rawvalue = options.getSingleValue(optkey, type);
+		const bool isdefault = options.getDefaultValue(optkey, type) == rawvalue;
+		wxString value;
+		switch (options.GetSingleOptionType(optkey)) {
+			case LSL::Enum::opt_bool:
+				value = bool2yn(LSL::Util::FromIntString(rawvalue)); // convert from 0/1 to literal Yes/No
+				break;
+			case LSL::Enum::opt_list:
+				value = TowxString(options.GetNameListOptValue(optkey, type)); // get the key full name not short key
+				break;
+			default:
+				value = TowxString(rawvalue);
+		}
+
+		const std::map<wxString, OptionRowState>::iterator state = m_opt_row_state.find(Tag);
+		const bool known = state != m_opt_row_state.end();
+		if (!known || (state->second.isdefault != isdefault)) {
+			m_opts_list->SetItemFont(index, GetOptionFont(isdefault));
 		}
-		if (DataType == LSL::Enum::opt_bool) {
-			value = bool2yn(FromwxString(value)); // convert from 0/1 to literal Yes/No
-		} else if (DataType == LSL::Enum::opt_list) {
-			value = TowxString(m_battle->CustomBattleOptions().GetNameListOptValue(STD_STRING(key), type)); // get the key full name not short key
+		if (!known || (state->second.value != value)) {
+			m_opts_list->SetItem(index, 1, value);
 		}
-		m_opts_list->SetItem(index, 1, value);
+		OptionRowState& row = m_opt_row_state[Tag];
+		row.value = value;
+		row.isdefault = isdefault;
 	} else // if ( type == OptionsWrapper::PrivateOptions )
 	{
 		if (key == _T( "mapname" )) // the map has been changed
@@ -1060,6 +1090,7 @@ long BattleRoomTab::AddMMOptionsToList(long pos, LSL::Enum::GameOption optFlag)
 		m_opts_list->InsertItem(pos, TowxString(it->second.first));
 		wxString tag = wxString::Format(_T( "%d_%s" ), optFlag, TowxString(it->first).c_str());
 		m_opt_list_map[tag] = pos;
+		m_opt_row_state.erase(tag); // a new row
 		UpdateBattleInfo(tag);
 		pos++;
 	}
@@ -1305,6 +1336,7 @@ void BattleRoomTab::RegenerateOptionsList()
 	m_opts_list->DeleteAllItems();
 	m_opts_list->InsertItem(pos, _("Size"));
 	m_opt_list_map.clear();
+	m_opt_row_state.clear();
 	m_opt_list_map[_("Size")] = pos;
 	pos++;
 	m_opts_list->InsertItem(pos, _("Windspeed"));
@@ -5,6 +5,7 @@
 
 #include <lslunitsync/optionswrapper.h>
 #include <map>
+#include <vector>
 #include <wx/panel.h>
 
 #include "utils/uievents.h"
@@ -51,6 +52,7 @@ public:
 	ChatPanel& GetChatPanel();
 
 	void UpdateBattleInfo(const wxString& Tag);
+	void UpdateBattleInfo(const std::vector<wxString>& Tags);
 
 
 	void OnBattleActionEvent(UiEvents::UiEventData data);
@@ -147,6 +149,13 @@ private:
 
 	OptionListMap m_opt_list_map;
 
+	//! what an option row currently shows, rows are only touched when it changes
+	struct OptionRowState {
+		wxString value;
+		bool isdefault;
+	};
+	std::map<wxString, OptionRowState> m_opt_row_state;
+
 	wxBoxSizer* m_players_sizer;
 	wxBoxSizer* m_player_sett_sizer;
 	wxBoxSizer* m_info_sizer;
@@ -87,14 +87,37 @@ ChatPanel* MainJoinBattleTab::GetActiveChatPanel()
 	return NULL;
 }
 
+//! restrictions change with the "restrictions" row or with a full update, which has no tag
+static bool AffectsRestrictions(const wxString& Tag)
+{
+	return Tag.empty() || (Tag.AfterFirst('_') == _T("restrictions"));
+}
+
 void MainJoinBattleTab::UpdateCurrentBattle(const wxString& Tag)
 {
 	GetBattleRoomTab().UpdateBattleInfo(Tag);
 	GetBattleMapTab().Update(Tag);
-	GetOptionsTab().ReloadRestrictions();
+	if (AffectsRestrictions(Tag)) {
+		GetOptionsTab().ReloadRestrictions();
+	}
 	GetMMOptionsTab().UpdateOptControls(Tag);
 }
 
+void MainJoinBattleTab::UpdateCurrentBattle(const std::vector<wxString>& Tags)
+{
+	GetBattleRoomTab().UpdateBattleInfo(Tags);
+	bool restrictions = false;
+	for (const wxString& tag : Tags) {
+		GetBattleMapTab().Update(tag);
+		GetMMOptionsTab().UpdateOptControls(tag);
+		restrictions = restrictions || AffectsRestrictions(tag);
+	}
+	// reloading lists all units of the game, only once per batch
+	if (restrictions) {
+		GetOptionsTab().ReloadRestrictions();
+	}
+}
+
 void MainJoinBattleTab::JoinBattle(IBattle& battle)
 {
 	m_mm_opts_tab->SetBattle(&battle);
@@ -4,6 +4,7 @@
 #define SPRINGLOBBY_HEADERGUARD_MAINJOINBATTLETAB_H
 
 #include <wx/scrolwin.h>
+#include <vector>
 #include "battleroommmoptionstab.h"
 class IBattle;
 class User;
@@ -25,6 +26,7 @@ public:
 	void HostBattle(IBattle& battle);
 	void JoinBattle(IBattle& battle);
 	void UpdateCurrentBattle(const wxString& Tag);
+	void UpdateCurrentBattle(const std::vector<wxString>& Tags);
 	void LeaveCurrentBattle(bool called_from_join = false);
 	void OnDisconnected()
 	{
@@ -8,22 +8,64 @@
 #include <wx/image.h>
 #include <map>
 
-#include "flagimagedata.h"
+#include "flagimages.h"
 #include "ibattle.h"
 #include "log.h"
 #include "lslunitsync/image.h"
 #include "lslunitsync/unitsync.h"
 #include "user.h"
 #include "utils/conversion.h"
+#include "utils/globalevents.h"
 #include "utils/lslconversion.h"
 
+LazyBitmap LazyBitmap::Xpm(const char* const* data)
+{
+	return LazyBitmap([=] { return IconsCollection::CreateBitmap(data); });
+}
+
+static std::vector<std::string> LoadSides(const std::string& gameName)
+{
+	if (!LSL::usync().GameExists(gameName)) {
+		wxLogWarning("Game %s not found, no side icons!", gameName.c_str());
+		// game doesn't exist, dl needed?!
+		return std::vector<std::string>();
+	}
+	const auto sides = LSL::usync().GetSides(gameName);
+	//This can happen whenever in time, so must be caught in release build too
+	if (sides.empty()) {
+		wxLogWarning("IconsCollection: game %s has no sides", gameName.c_str());
+	}
+	return sides;
+}
+
+static wxBitmap LoadSideIcon(const std::string& gameName, const std::string& sideName)
+{
+	try {
+		const LSL::UnitsyncImage img = LSL::usync().GetSidePicture(gameName, sideName);
+		return img.wxbitmap();
+	} catch (...) {
+		//unitsync can fail!
+		ASSERT_LOGIC(false, "LSL::usync().GetSidePicture() failed!");
+	}
+	return wxBitmap();
+}
+
 IconsCollection::IconsCollection()
+    : m_sides(LoadSides, LoadSideIcon)
+    , m_countryFlagBmps(GetFlagCount())
 {
-	loadCountryFlags();
+	SUBSCRIBE_GLOBAL_EVENT(GlobalEventManager::OnUnitsyncReloaded, IconsCollection::OnUnitsyncReloaded);
 }
 
 IconsCollection::~IconsCollection()
 {
+	GlobalEventManager::Instance()->UnSubscribeAll(this);
+}
+
+void IconsCollection::OnUnitsyncReloaded(wxCommandEvent& /*data*/)
+{
+	// games and their sides might have changed
+	m_sides.Clear();
 }
 
 IconsCollection* IconsCollection::Instance()
@@ -43,22 +85,6 @@ void IconsCollection::Release()
 
 IconsCollection* IconsCollection::m_Instance = nullptr;
 
-//Create collection populated with flags images
-void IconsCollection::loadCountryFlags()
-{
-	int flagIndex = 0;
-	m_countryFlagBmps.clear();
-	for (flagIndex = 0; flag_str[flagIndex] != NULL; flagIndex++) {
-		//Just in case (these two arrays must have same size!)
-		wxASSERT(flag_xpm[flagIndex] != NULL);
-		//Load flag image and store it in collection
-		m_countryFlagBmps[flag_str[flagIndex]] = IconsCollection::CreateBitmap(flag_xpm[flagIndex]);
-	}
-
-	//Just in case (these two arrays must have same size!)
-	wxASSERT((flag_str[flagIndex] == NULL) && (flag_xpm[flagIndex] == NULL));
-}
-
 wxBitmap& IconsCollection::GetHostBmp(bool isSpec)
 {
 	if (isSpec) {
@@ -149,28 +175,19 @@ wxBitmap& IconsCollection::GetUserListStateIcon(const UserStatus& us, bool chano
 	return BMP_NOSTATE;
 }
 
-//Get flag image from collection
+//Get flag image from collection, flags are decoded when first shown
 wxBitmap& IconsCollection::GetFlagBmp(const wxString& country)
 {
-	//Check for some predefined values
-	if ((country.empty()) ||
-	    (country == "??") || // unknown
-	    (country == "XX") || // not sure where this come from, very likely from incomplete bootstrap at login
-	    (country == "A1") || // anonymous proxy
-	    (country == "A2") || // satellite provider
-	    (country == "O1"))   // other country
-		return BMP_UNK_FLAG;
-
-	//Search for flag by country's name
-	std::map<wxString, wxBitmap>::iterator itor = m_countryFlagBmps.find(country);
-	//Return flag image if found
-	if (itor != m_countryFlagBmps.end()) {
-		return itor->second;
-		//Return empty image otherwise
-	} else {
-		//Just return nothing. I think there is no need for triggering assert
+	// unknown flags fall back silently, this is called for every repaint of a row
+	const int index = FindFlagIndex(STD_STRING(country));
+	if (index == FLAG_NONE) {
 		return BMP_UNK_FLAG;
 	}
+	wxBitmap& flag = m_countryFlagBmps[index];
+	if (!flag.IsOk()) {
+		flag = IconsCollection::CreateBitmap(GetFlagXpm(index));
+	}
+	return flag;
 }
 
 wxBitmap& IconsCollection::GetRankBmp(unsigned int rank, bool showLowest)
@@ -211,62 +228,34 @@ wxBitmap& IconsCollection::GetBattleStatusBmp(const IBattle& battle) const
 
 wxBitmap& IconsCollection::GetColourBmp(const LSL::lslColor& colour)
 {
-
-	const wxString key = lslTowxColour(colour).GetAsString(wxC2S_HTML_SYNTAX).AfterFirst('#');
+	const uint32_t key = ((uint32_t)colour.Red() << 16) | ((uint32_t)colour.Green() << 8) | (uint32_t)colour.Blue();
 
 	//Search needed colour in collection (cache) and return it if found
-	std::map<wxString, wxBitmap>::iterator itor = m_playerColorBmps.find(key);
+	std::unordered_map<uint32_t, wxBitmap>::iterator itor = m_playerColorBmps.find(key);
 	if (itor != m_playerColorBmps.end()) {
 		return itor->second;
-		//Or add new colour to collection
-	} else {
-		m_playerColorBmps[key] = getColourIcon(lslTowxColour(colour));
-		return m_playerColorBmps[key];
 	}
+	//Or add new colour to collection
+	wxBitmap& bmp = m_playerColorBmps[key];
+	bmp = getColourIcon(lslTowxColour(colour));
+	return bmp;
 }
 
 wxBitmap& IconsCollection::GetFractionBmp(const std::string& gameName, size_t fractionId)
 {
-
-	if (gameName.empty() || !LSL::usync().GameExists(gameName)) {
+	if (gameName.empty()) {
 		wxLogWarning("SideIcon %zu for game %s not found!", fractionId, gameName.c_str());
-		// game doesn't exist, dl needed?!
-		return BMP_EMPTY;
-	}
-
-	const auto sides = LSL::usync().GetSides(gameName);
-
-	//This can happen whenever in time, so must be caught in release build too
-	if (sides.empty()) {
-		wxLogWarning("IconsCollection::GetFractionBmp(): sides.empty()");
-		return BMP_EMPTY;
-	}
-
-	if (fractionId >= sides.size()) {
-		wxLogWarning("Invalid side requested: %s:%d", gameName.c_str(), (int)fractionId);
 		return BMP_EMPTY;
 	}
 
-	std::string sideName;
-
-	sideName = sides[fractionId];
-
-	const std::string cacheString = gameName + "_" + sideName;
-
-	//Check if image already in cache
-	if (m_cachedFractionBmps.find(cacheString) != m_cachedFractionBmps.end()) {
-		return m_cachedFractionBmps[cacheString];
-		//Create one and add to cache
-	} else {
-		try {
-			const LSL::UnitsyncImage img = LSL::usync().GetSidePicture(gameName, sideName);
-			m_cachedFractionBmps[cacheString] = img.wxbitmap();
-		} catch (...) {
-			//unitsync can fail!
-			ASSERT_LOGIC(false, "LSL::usync().GetSidePicture() failed!");
+	wxBitmap* bmp = m_sides.GetIcon(gameName, fractionId);
+	if (bmp == nullptr) {
+		if (!m_sides.GetSides(gameName).empty()) {
+			wxLogWarning("Invalid side requested: %s:%d", gameName.c_str(), (int)fractionId);
 		}
-		return m_cachedFractionBmps[cacheString];
+		return BMP_EMPTY;
 	}
+	return *bmp;
 }
 
 /* Used to create transparent bitmaps under Windows 7 and Windows XP */
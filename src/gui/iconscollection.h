@@ -4,9 +4,14 @@
 #define SRC_GUI_ICONSCOLLECTION_H_
 
 #include <wx/bitmap.h>
+#include <wx/event.h>
 #include <wx/icon.h>
 #include <wx/image.h>
+#include <stdint.h>
+#include <functional>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include "images/admin.png.h"
 #include "images/admin_away.png.h"
 #include "images/admin_broom.png.h"
@@ -40,6 +45,7 @@
 */
 
 #include "gui/uiutils.h"
+#include "utils/sidecache.h"
 #include "images/channel_options.xpm"
 #include "images/closed_full_game.png.h"
 #include "images/closed_full_pw_game.png.h"
@@ -72,21 +78,58 @@ namespace LSL
 class lslColor;
 }
 
-class IconsCollection
+/** @brief bitmap which is decoded from the embedded image data on first use
+ *
+ * Not thread safe, only use it from the gui thread.
+ */
+class LazyBitmap
+{
+public:
+	typedef std::function<wxBitmap()> Loader;
+
+	explicit LazyBitmap(const Loader& loader)
+	    : m_loader(loader)
+	    , m_loaded(false)
+	{
+	}
+
+	static LazyBitmap Png(const unsigned char* data, int size)
+	{
+		return LazyBitmap([=] { return charArr2wxBitmap(data, size); });
+	}
+	static LazyBitmap Xpm(const char* const* data);
+
+	wxBitmap& Get()
+	{
+		if (!m_loaded) {
+			m_bitmap = m_loader();
+			m_loaded = true;
+		}
+		return m_bitmap;
+	}
+	operator wxBitmap&()
+	{
+		return Get();
+	}
+
+private:
+	Loader m_loader;
+	wxBitmap m_bitmap;
+	bool m_loaded;
+};
+
+class IconsCollection : public wxEvtHandler
 {
 private:
 	IconsCollection();
 	virtual ~IconsCollection();
+	void OnUnitsyncReloaded(wxCommandEvent& data);
 
 public:
 	static IconsCollection* Instance();
 	static void Release();
 	static wxBitmap CreateBitmap(const char* const*); /* Used to create transparent bitmaps under Windows 7 and Windows XP */
 
-private:
-	void loadCountryFlags();
-
-public:
 	wxBitmap& GetHostBmp(bool isSpec);
 	wxBitmap& GetReadyBmp(bool isSpec, bool isReady, unsigned int inSync, bool isBot);
 	wxBitmap& GetUserListStateIcon(const UserStatus& us, bool chanop, bool inbroom);
@@ -100,11 +143,11 @@ public:
 
 private:
 	static IconsCollection* m_Instance;
-	std::map<std::string, wxBitmap> m_cachedFractionBmps;
-	std::map<wxString, wxBitmap> m_countryFlagBmps;
-	std::map<wxString, wxBitmap> m_playerColorBmps;
+	SideCache<wxBitmap> m_sides;
+	std::vector<wxBitmap> m_countryFlagBmps; //!< indexed like the flag data, decoded on first use
+	std::unordered_map<uint32_t, wxBitmap> m_playerColorBmps; //!< keyed by 0xRRGGBB
 
-	wxBitmap* battleStatuses[16] = {
+	LazyBitmap* battleStatuses[16] = {
 	    /* -                                 */ &BMP_OPEN_GAME,
 	    /* passworded                        */ &BMP_OPEN_PW_GAME,
 	    /* full                              */ &BMP_OPEN_FULL_GAME,
@@ -128,83 +171,83 @@ public:
 	wxIcon ICON_NEXISTS = wxIcon(nexists_xpm);
 
 public:
-	wxBitmap BMP_ADMIN = charArr2wxBitmap(admin_png, sizeof(admin_png));
-	wxBitmap BMP_ADMIN_AWAY = charArr2wxBitmap(admin_away_png, sizeof(admin_away_png));
-	wxBitmap BMP_ADMIN_BROOM = charArr2wxBitmap(admin_broom_png, sizeof(admin_broom_png));
-	wxBitmap BMP_ADMIN_INGAME = charArr2wxBitmap(admin_ingame_png, sizeof(admin_ingame_png));
-
-	wxBitmap BMP_PLAYER = IconsCollection::CreateBitmap(player_xpm);
-
-	wxBitmap BMP_BOT = IconsCollection::CreateBitmap(bot_xpm);
-	wxBitmap BMP_BOT_BROOM = charArr2wxBitmap(bot_broom_png, sizeof(bot_broom_png));
-	wxBitmap BMP_BOT_INGAME = charArr2wxBitmap(bot_ingame_png, sizeof(bot_ingame_png));
-	wxBitmap BMP_BOT_AWAY = IconsCollection::CreateBitmap(bot_away_xpm);
-
-	wxBitmap BMP_NOSTATE = IconsCollection::CreateBitmap(empty_xpm);
-	wxBitmap BMP_AWAY = charArr2wxBitmap(away_png, sizeof(away_png));
-	wxBitmap BMP_BROOM = charArr2wxBitmap(broom_png, sizeof(broom_png));
-	wxBitmap BMP_INGAME = charArr2wxBitmap(ingame_png, sizeof(ingame_png));
-
-	wxBitmap BMP_OP = IconsCollection::CreateBitmap(chanop_xpm);
-	wxBitmap BMP_OP_AWAY = IconsCollection::CreateBitmap(chanop_away_xpm);
-	wxBitmap BMP_OP_BROOM = IconsCollection::CreateBitmap(chanop_broom_xpm);
-	wxBitmap BMP_OP_INGAME = IconsCollection::CreateBitmap(chanop_ingame_xpm);
-
-	wxBitmap BMP_UP = IconsCollection::CreateBitmap(up_xpm);
-	wxBitmap BMP_DOWN = IconsCollection::CreateBitmap(down_xpm);
-
-	wxBitmap BMP_RANK_NONE = IconsCollection::CreateBitmap(empty_xpm);
-	wxBitmap BMP_RANK_UNKNOWN = IconsCollection::CreateBitmap(rank_unknown_xpm);
-	wxBitmap BMP_RANK1 = IconsCollection::CreateBitmap(rank0_xpm);
-	wxBitmap BMP_RANK2 = IconsCollection::CreateBitmap(rank1_xpm);
-	wxBitmap BMP_RANK3 = IconsCollection::CreateBitmap(rank2_xpm);
-	wxBitmap BMP_RANK4 = IconsCollection::CreateBitmap(rank3_xpm);
-	wxBitmap BMP_RANK5 = IconsCollection::CreateBitmap(rank4_xpm);
-	wxBitmap BMP_RANK6 = IconsCollection::CreateBitmap(rank5_xpm);
-	wxBitmap BMP_RANK7 = IconsCollection::CreateBitmap(rank6_xpm);
-	wxBitmap BMP_RANK8 = IconsCollection::CreateBitmap(rank7_xpm);
-
-	wxBitmap BMP_GAME_UNKNOWN = IconsCollection::CreateBitmap(empty_xpm);
-	wxBitmap BMP_OPEN_GAME = charArr2wxBitmap(open_game_png, sizeof(open_game_png));
-	wxBitmap BMP_OPEN_PW_GAME = charArr2wxBitmap(open_pw_game_png, sizeof(open_pw_game_png));
-	wxBitmap BMP_OPEN_FULL_PW_GAME = charArr2wxBitmap(open_full_pw_game_png, sizeof(open_full_pw_game_png));
-	wxBitmap BMP_OPEN_FULL_GAME = charArr2wxBitmap(open_full_game_png, sizeof(open_full_game_png));
-	wxBitmap BMP_CLOSED_GAME = charArr2wxBitmap(closed_game_png, sizeof(closed_game_png));
-	wxBitmap BMP_CLOSED_PW_GAME = charArr2wxBitmap(closed_pw_game_png, sizeof(closed_pw_game_png));
-	wxBitmap BMP_CLOSED_FULL_PW_GAME = charArr2wxBitmap(closed_full_pw_game_png, sizeof(closed_full_pw_game_png));
-	wxBitmap BMP_CLOSED_FULL_GAME = charArr2wxBitmap(closed_full_game_png, sizeof(closed_full_game_png));
-	wxBitmap BMP_STARTED_GAME = BMP_INGAME;
-	wxBitmap BMP_STARTED_GAME_LOCKED = BMP_INGAME;
-	wxBitmap BMP_STARTED_PW_GAME = charArr2wxBitmap(ingame_pw_png, sizeof(ingame_pw_png));
-
-	wxBitmap BMP_NREADY = charArr2wxBitmap(closed_game_png, sizeof(closed_game_png));
-	wxBitmap BMP_READY = charArr2wxBitmap(open_game_png, sizeof(open_game_png));
-	wxBitmap BMP_READY_UNSYNC = BlendBitmaps(BMP_READY, charArr2wxBitmap(warning_small_png, sizeof(warning_small_png)));
-	wxBitmap BMP_NREADY_UNSYNC = BlendBitmaps(BMP_NREADY, charArr2wxBitmap(warning_small_png, sizeof(warning_small_png)));
-	wxBitmap BMP_READY_QSYNC = IconsCollection::CreateBitmap(ready_q_xpm);
-	wxBitmap BMP_NREADY_QSYNC = IconsCollection::CreateBitmap(nready_q_xpm);
-
-	wxBitmap BMP_NEXISTS = IconsCollection::CreateBitmap(nexists_xpm);
-	wxBitmap BMP_EXISTS = IconsCollection::CreateBitmap(exists_xpm);
-
-	wxBitmap BMP_SPECTATOR = charArr2wxBitmap(spectator_png, sizeof(spectator_png));
-	wxBitmap BMP_SPECTATOR_UNSYNC = charArr2wxBitmapWithBlending(spectator_png, sizeof(spectator_png), warning_small_png, sizeof(warning_small_png));
-	wxBitmap BMP_HOST = IconsCollection::CreateBitmap(host_xpm);
-	wxBitmap BMP_HOST_SPECTATOR = IconsCollection::CreateBitmap(host_spectator_xpm);
-
-	wxBitmap BMP_SIDEPIC_0 = IconsCollection::CreateBitmap(empty_xpm);
-	wxBitmap BMP_SIDEPIC_1 = IconsCollection::CreateBitmap(empty_xpm);
-
-	wxBitmap BMP_UNK_FLAG = IconsCollection::CreateBitmap(unknown_flag_xpm);
-	wxBitmap BMP_FLAGS_BASE = IconsCollection::CreateBitmap(empty_xpm);
-
-	wxBitmap BMP_WARNING_OVERLAY = IconsCollection::CreateBitmap(empty_xpm);
-
-	wxBitmap BMP_CHANNEL_OPTIONS = IconsCollection::CreateBitmap(channel_options_xpm);
-
-	wxBitmap BMP_EMPTY = IconsCollection::CreateBitmap(empty_xpm);
-
-	wxBitmap BMP_SPRINGLOBBY = IconsCollection::CreateBitmap(springlobby_xpm);
+	LazyBitmap BMP_ADMIN = LazyBitmap::Png(admin_png, sizeof(admin_png));
+	LazyBitmap BMP_ADMIN_AWAY = LazyBitmap::Png(admin_away_png, sizeof(admin_away_png));
+	LazyBitmap BMP_ADMIN_BROOM = LazyBitmap::Png(admin_broom_png, sizeof(admin_broom_png));
+	LazyBitmap BMP_ADMIN_INGAME = LazyBitmap::Png(admin_ingame_png, sizeof(admin_ingame_png));
+
+	LazyBitmap BMP_PLAYER = LazyBitmap::Xpm(player_xpm);
+
+	LazyBitmap BMP_BOT = LazyBitmap::Xpm(bot_xpm);
+	LazyBitmap BMP_BOT_BROOM = LazyBitmap::Png(bot_broom_png, sizeof(bot_broom_png));
+	LazyBitmap BMP_BOT_INGAME = LazyBitmap::Png(bot_ingame_png, sizeof(bot_ingame_png));
+	LazyBitmap BMP_BOT_AWAY = LazyBitmap::Xpm(bot_away_xpm);
+
+	LazyBitmap BMP_NOSTATE = LazyBitmap::Xpm(empty_xpm);
+	LazyBitmap BMP_AWAY = LazyBitmap::Png(away_png, sizeof(away_png));
+	LazyBitmap BMP_BROOM = LazyBitmap::Png(broom_png, sizeof(broom_png));
+	LazyBitmap BMP_INGAME = LazyBitmap::Png(ingame_png, sizeof(ingame_png));
+
+	LazyBitmap BMP_OP = LazyBitmap::Xpm(chanop_xpm);
+	LazyBitmap BMP_OP_AWAY = LazyBitmap::Xpm(chanop_away_xpm);
+	LazyBitmap BMP_OP_BROOM = LazyBitmap::Xpm(chanop_broom_xpm);
+	LazyBitmap BMP_OP_INGAME = LazyBitmap::Xpm(chanop_ingame_xpm);
+
+	LazyBitmap BMP_UP = LazyBitmap::Xpm(up_xpm);
+	LazyBitmap BMP_DOWN = LazyBitmap::Xpm(down_xpm);
+
+	LazyBitmap BMP_RANK_NONE = LazyBitmap::Xpm(empty_xpm);
+	LazyBitmap BMP_RANK_UNKNOWN = LazyBitmap::Xpm(rank_unknown_xpm);
+	LazyBitmap BMP_RANK1 = LazyBitmap::Xpm(rank0_xpm);
+	LazyBitmap BMP_RANK2 = LazyBitmap::Xpm(rank1_xpm);
+	LazyBitmap BMP_RANK3 = LazyBitmap::Xpm(rank2_xpm);
+	LazyBitmap BMP_RANK4 = LazyBitmap::Xpm(rank3_xpm);
+	LazyBitmap BMP_RANK5 = LazyBitmap::Xpm(rank4_xpm);
+	LazyBitmap BMP_RANK6 = LazyBitmap::Xpm(rank5_xpm);
+	LazyBitmap BMP_RANK7 = LazyBitmap::Xpm(rank6_xpm);
+	LazyBitmap BMP_RANK8 = LazyBitmap::Xpm(rank7_xpm);
+
+	LazyBitmap BMP_GAME_UNKNOWN = LazyBitmap::Xpm(empty_xpm);
+	LazyBitmap BMP_OPEN_GAME = LazyBitmap::Png(open_game_png, sizeof(open_game_png));
+	LazyBitmap BMP_OPEN_PW_GAME = LazyBitmap::Png(open_pw_game_png, sizeof(open_pw_game_png));
+	LazyBitmap BMP_OPEN_FULL_PW_GAME = LazyBitmap::Png(open_full_pw_game_png, sizeof(open_full_pw_game_png));
+	LazyBitmap BMP_OPEN_FULL_GAME = LazyBitmap::Png(open_full_game_png, sizeof(open_full_game_png));
+	LazyBitmap BMP_CLOSED_GAME = LazyBitmap::Png(closed_game_png, sizeof(closed_game_png));
+	LazyBitmap BMP_CLOSED_PW_GAME = LazyBitmap::Png(closed_pw_game_png, sizeof(closed_pw_game_png));
+	LazyBitmap BMP_CLOSED_FULL_PW_GAME = LazyBitmap::Png(closed_full_pw_game_png, sizeof(closed_full_pw_game_png));
+	LazyBitmap BMP_CLOSED_FULL_GAME = LazyBitmap::Png(closed_full_game_png, sizeof(closed_full_game_png));
+	LazyBitmap BMP_STARTED_GAME = LazyBitmap([this] { return BMP_INGAME.Get(); });
+	LazyBitmap BMP_STARTED_GAME_LOCKED = LazyBitmap([this] { return BMP_INGAME.Get(); });
+	LazyBitmap BMP_STARTED_PW_GAME = LazyBitmap::Png(ingame_pw_png, sizeof(ingame_pw_png));
+
+	LazyBitmap BMP_NREADY = LazyBitmap::Png(closed_game_png, sizeof(closed_game_png));
+	LazyBitmap BMP_READY = LazyBitmap::Png(open_game_png, sizeof(open_game_png));
+	LazyBitmap BMP_READY_UNSYNC = LazyBitmap([this] { return BlendBitmaps(BMP_READY.Get(), charArr2wxBitmap(warning_small_png, sizeof(warning_small_png))); });
+	LazyBitmap BMP_NREADY_UNSYNC = LazyBitmap([this] { return BlendBitmaps(BMP_NREADY.Get(), charArr2wxBitmap(warning_small_png, sizeof(warning_small_png))); });
+	LazyBitmap BMP_READY_QSYNC = LazyBitmap::Xpm(ready_q_xpm);
+	LazyBitmap BMP_NREADY_QSYNC = LazyBitmap::Xpm(nready_q_xpm);
+
+	LazyBitmap BMP_NEXISTS = LazyBitmap::Xpm(nexists_xpm);
+	LazyBitmap BMP_EXISTS = LazyBitmap::Xpm(exists_xpm);
+
+	LazyBitmap BMP_SPECTATOR = LazyBitmap::Png(spectator_png, sizeof(spectator_png));
+	LazyBitmap BMP_SPECTATOR_UNSYNC = LazyBitmap([] { return charArr2wxBitmapWithBlending(spectator_png, sizeof(spectator_png), warning_small_png, sizeof(warning_small_png)); });
+	LazyBitmap BMP_HOST = LazyBitmap::Xpm(host_xpm);
+	LazyBitmap BMP_HOST_SPECTATOR = LazyBitmap::Xpm(host_spectator_xpm);
+
+	LazyBitmap BMP_SIDEPIC_0 = LazyBitmap::Xpm(empty_xpm);
+	LazyBitmap BMP_SIDEPIC_1 = LazyBitmap::Xpm(empty_xpm);
+
+	LazyBitmap BMP_UNK_FLAG = LazyBitmap::Xpm(unknown_flag_xpm);
+	LazyBitmap BMP_FLAGS_BASE = LazyBitmap::Xpm(empty_xpm);
+
+	LazyBitmap BMP_WARNING_OVERLAY = LazyBitmap::Xpm(empty_xpm);
+
+	LazyBitmap BMP_CHANNEL_OPTIONS = LazyBitmap::Xpm(channel_options_xpm);
+
+	LazyBitmap BMP_EMPTY = LazyBitmap::Xpm(empty_xpm);
+
+	LazyBitmap BMP_SPRINGLOBBY = LazyBitmap::Xpm(springlobby_xpm);
 };
 
 #endif /* SRC_GUI_ICONSCOLLECTION_H_ */
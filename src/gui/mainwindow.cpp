@@ -31,6 +31,7 @@
 #include "battlelist/battlelisttab.h"
 #include "channel/autojoinchanneldialog.h"
 #include "channel/channelchooserdialog.h"
+#include "chatlogsearchdialog.h"
 #include "chatpanel.h"
 #include "downloader/prdownloader.h"
 #include "gui/controls.h"
@@ -98,6 +99,7 @@ EVT_MENU(MENU_RESET_LAYOUT, MainWindow::OnMenuResetLayout)
 EVT_MENU(MENU_AUTOJOIN_CHANNELS, MainWindow::OnMenuAutojoinChannels)
 EVT_MENU(MENU_SELECT_LOCALE, MainWindow::OnMenuSelectLocale)
 EVT_MENU(MENU_CHANNELCHOOSER, MainWindow::OnShowChannelChooser)
+EVT_MENU(MENU_CHATLOG_SEARCH, MainWindow::OnMenuChatLogSearch)
 EVT_MENU(MENU_SHOWWRITEABLEDIR, MainWindow::OnShowWriteableDir)
 EVT_MENU(MENU_PREFERENCES, MainWindow::OnMenuPreferences)
 EVT_MENU(MENU_GENERAL_HELP, MainWindow::OnMenuFirstStart)
@@ -131,7 +133,7 @@ MainWindow::MainWindow()
 	m_tab_names.Add(_("Downloads"));
 
 	wxIcon mainIcon = wxIcon();
-	mainIcon.CopyFromBitmap(IconsCollection::Instance()->BMP_SPRINGLOBBY);
+	mainIcon.CopyFromBitmap(IconsCollection::Instance()->BMP_SPRINGLOBBY.Get());
 	SetIcon(mainIcon);
 
 	GetAui().manager = new wxAuiManager(this);
@@ -162,6 +164,7 @@ MainWindow::MainWindow()
 	m_menuTools->Append(MENU_JOIN, _("&Join channel..."));
 	m_menuTools->Append(MENU_CHANNELCHOOSER, _("Channel &list"));
 	m_menuTools->Append(MENU_CHAT, _("Open private &chat..."));
+	m_menuTools->Append(MENU_CHATLOG_SEARCH, _("&Search chat logs..."));
 	m_menuTools->Append(MENU_SHOWWRITEABLEDIR, _("&Open Spring DataDir"));
 	m_menuTools->AppendSeparator();
 	m_menuTools->Append(MENU_DOWNLOAD, _("&Download Archives"));
@@ -721,6 +724,11 @@ void MainWindow::OnMenuPathInfo(wxCommandEvent& /*event*/)
 	InfoDialog(this).ShowModal();
 }
 
+void MainWindow::OnMenuChatLogSearch(wxCommandEvent& /*event*/)
+{
+	ChatLogSearchDialog(this).ShowModal();
+}
+
 void MainWindow::OnMenuDownload(wxCommandEvent& /*event*/)
 {
 	wxString lines;
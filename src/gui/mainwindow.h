@@ -81,6 +81,7 @@ public:
 	void OnShowSettingsPP(wxCommandEvent& event);
 	void OnMenuSelectLocale(wxCommandEvent& event);
 	void OnShowChannelChooser(wxCommandEvent& event);
+	void OnMenuChatLogSearch(wxCommandEvent& event);
 	void OnShowWriteableDir(wxCommandEvent& event);
 	void forceSettingsFrameClose();
 	void OnChannelList(const wxString& channel, const int& numusers, const wxString& topic);
@@ -175,7 +176,8 @@ private:
 		MENU_SHOWWRITEABLEDIR,
 		MENU_PREFERENCES,
 		MENU_GENERAL_HELP,
-		MENU_PATHINFO
+		MENU_PATHINFO,
+		MENU_CHATLOG_SEARCH
 	};
 
 	wxArrayString m_tab_names;
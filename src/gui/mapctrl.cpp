@@ -9,12 +9,14 @@
 #include <wx/app.h>
 #include <wx/bitmap.h>
 #include <wx/dcclient.h>
+#include <wx/dcmemory.h>
 #include <wx/image.h>
 #include <wx/intl.h>
 #include <wx/log.h>
 #include <wx/panel.h>
 #include <wx/toplevel.h>
 #include <cmath>
+#include <cstring>
 #include <functional>
 #include <stdexcept>
 
@@ -22,6 +24,7 @@
 #include "hosting/addbotdialog.h"
 #include "ibattle.h"
 #include "iconscollection.h"
+#include "maplayercache.h"
 #include "images/close.xpm"
 #include "images/close_hi.xpm"
 #include "images/download_map.xpm"
@@ -41,6 +44,7 @@
 #include "user.h"
 #include "utils/conversion.h"
 #include "utils/lslconversion.h"
+#include "utils/summedareatable.h"
 
 const int USER_BOX_EXPANDED_HEIGHT = 70;
 const int USER_BOX_EXPANDED_WIDTH = 75;
@@ -86,21 +90,8 @@ END_EVENT_TABLE()
 const int boxsize = 8;
 const int minboxsize = 40;
 
-static inline void WriteInt24(unsigned char* p, int i)
-{
-	p[0] = i & 0xFF;
-	p[1] = (i >> 8) & 0xFF;
-	p[2] = (i >> 16) & 0xFF;
-}
-
-static inline int ReadInt24(const unsigned char* p)
-{
-	return p[0] | (p[1] << 8) | (p[2] << 16);
-}
-
 MapCtrl::MapCtrl(wxWindow* parent, int size, IBattle* battle, bool readonly, bool draw_start_types, bool singleplayer)
     : wxPanel(parent, -1, wxDefaultPosition, wxSize(size, size), wxSIMPLE_BORDER | wxFULL_REPAINT_ON_RESIZE)
-    , m_async(std::bind(&MapCtrl::OnGetMapImageAsyncCompleted, this, std::placeholders::_1))
     , m_minimap(0)
     , m_metalmap(0)
     , m_heightmap(0)
@@ -130,7 +121,7 @@ MapCtrl::MapCtrl(wxWindow* parent, int size, IBattle* battle, bool readonly, boo
     , m_dl_img(NULL)
     , m_user_expanded(NULL)
     , m_current_infomap(IM_Minimap)
-    , m_mutex()
+    , m_background_infomap(IM_Count)
 {
 	SetBackgroundStyle(wxBG_STYLE_CUSTOM);
 	SetBackgroundColour(*wxLIGHT_GREY);
@@ -142,8 +133,7 @@ MapCtrl::MapCtrl(wxWindow* parent, int size, IBattle* battle, bool readonly, boo
 
 MapCtrl::~MapCtrl()
 {
-	m_mutex.Lock();
-	m_async.Disconnect();
+	MapLayerCache::RemoveListener(this);
 	FreeMinimap();
 	delete m_close_img;
 	delete m_close_hi_img;
@@ -155,7 +145,6 @@ MapCtrl::~MapCtrl()
 	delete m_dl_img;
 	delete m_player_img;
 	delete m_bot_img;
-	m_mutex.Unlock();
 }
 
 
@@ -216,43 +205,6 @@ wxRect MapCtrl::GetStartRect(const BattleStartRect& sr) const
 }
 
 
-void MapCtrl::Accumulate(wxImage& image) const
-{
-	if (!image.IsOk())
-		return;
-
-	// Even tho GetData() returns a non-const pointer,
-	// it does not unshare the reference counted data,
-	// so we have to make a copy of the image..
-	image = image.Copy();
-
-	const int w = image.GetWidth();
-	const int h = image.GetHeight();
-	unsigned char* data = image.GetData();
-
-	// sum in vertical direction
-	unsigned char* p = data;
-	for (int x = 0; x < w; ++x, p += 3) {
-		WriteInt24(p, p[0] + p[1] + p[2]);
-	}
-	for (int y = 1; y < h; ++y) {
-		const unsigned char* prev = data + 3 * ((y - 1) * w);
-		unsigned char* curr = data + 3 * (y * w);
-		for (int x = 0; x < w; ++x, prev += 3, curr += 3) {
-			WriteInt24(curr, ReadInt24(prev) + curr[0] + curr[1] + curr[2]);
-		}
-	}
-
-	// sum in horizontal direction
-	for (int x = 1; x < w; ++x) {
-		for (int y = 0; y < h; ++y) {
-			p = data + 3 * (y * w + x);
-			WriteInt24(p, ReadInt24(p) + ReadInt24(p - 3));
-		}
-	}
-}
-
-
 double MapCtrl::GetStartRectMetalFraction(int index) const
 {
 	BattleStartRect sr = m_battle->GetStartRect(index);
@@ -266,27 +218,21 @@ double MapCtrl::GetStartRectMetalFraction(const BattleStartRect& sr) const
 {
 	// todo: this really is *logic*, not rendering code, so it
 	// should go in some other layer sometime (SpringUnitSync?).
-	if (!m_metalmap_cumulative.IsOk())
+	if (!m_layers.metal)
+		return 0.0;
+	const SummedAreaTable& metal = *m_layers.metal;
+	const uint32_t total = metal.Total();
+	if (total == 0)
 		return 0.0;
 
-	int x1, y1, x2, y2, w, h;
-
-	w = m_metalmap_cumulative.GetWidth();
-	h = m_metalmap_cumulative.GetHeight();
-	x1 = std::max(0, std::min(w - 1, int((sr.left * w / 200.0) + 0.5)));
-	y1 = std::max(0, std::min(h - 1, int((sr.top * h / 200.0) + 0.5)));
-	x2 = std::max(0, std::min(w - 1, int((sr.right * w / 200.0) + 0.5)));
-	y2 = std::max(0, std::min(h - 1, int((sr.bottom * h / 200.0) + 0.5)));
-
-	const unsigned char* metalmap = m_metalmap_cumulative.GetData();
-	const int lefttop = ReadInt24(&metalmap[3 * (y1 * w + x1)]);
-	const int righttop = ReadInt24(&metalmap[3 * (y1 * w + x2)]);
-	const int leftbot = ReadInt24(&metalmap[3 * (y2 * w + x1)]);
-	const int rightbot = ReadInt24(&metalmap[3 * (y2 * w + x2)]);
-	// in 2d cumulative distribution total is value at bottom right corner
-	const int total = ReadInt24(&metalmap[3 * (w * h - 1)]);
+	const int w = metal.GetWidth();
+	const int h = metal.GetHeight();
+	const int x1 = int((sr.left * w / 200.0) + 0.5);
+	const int y1 = int((sr.top * h / 200.0) + 0.5);
+	const int x2 = int((sr.right * w / 200.0) + 0.5);
+	const int y2 = int((sr.bottom * h / 200.0) + 0.5);
 
-	return (double)(lefttop + rightbot - righttop - leftbot) / total;
+	return (double)metal.Sum(x1, y1, x2, y2) / total;
 }
 
 
@@ -340,11 +286,22 @@ void MapCtrl::SetMouseOverRect(int index)
 	m_mover_rect = index;
 	_SetCursor();
 
-	if ((index != oldindex) || (m_rect_area != m_last_rect_area))
-		UpdateMinimap();
+	if ((index == oldindex) && (m_rect_area == m_last_rect_area))
+		return;
 	m_last_rect_area = m_rect_area;
 
-	Refresh();
+	if (ReloadMinimap()) {
+		Refresh();
+		return;
+	}
+	// only the start rects which lost or gained the hover state changed
+	wxRect dirty;
+	if (oldindex >= 0)
+		dirty.Union(GetStartRect(oldindex));
+	if (index >= 0)
+		dirty.Union(GetStartRect(index));
+	if (!dirty.IsEmpty())
+		RefreshRect(dirty, false);
 }
 
 
@@ -465,15 +422,15 @@ int MapCtrl::LoadMinimap()
 			return -2;
 		}
 
-		// start chain of asynchronous map image fetches
-		// first minimap, then metalmap and heightmap
-		m_async.GetMapImageAsync(map, LSL::IMAGE_MAP, w, h);
-
 		m_mapname = map;
 		m_lastsize = wxSize(w, h);
+
+		// cached layers are shown at once, missing ones arrive as REFRESH_EVENT
+		// this ensures metalmap and heightmap aren't loaded in battlelist
+		m_layers = MapLayerCache::Instance()->Request(map, m_draw_start_types, this);
+		UpdateLayers();
 	} catch (...) {
 		FreeMinimap();
-		m_mutex.Unlock();
 		return -3;
 	}
 	return 0;
@@ -486,37 +443,48 @@ void MapCtrl::FreeMinimap()
 	m_minimap = 0;
 	delete m_metalmap;
 	m_metalmap = 0;
+	m_layers = MapLayerCache::Layers();
 	delete m_heightmap;
 	m_heightmap = 0;
 	m_mapname = "";
+	m_background = wxNullBitmap;
 }
 
 
-void MapCtrl::UpdateMinimap()
+bool MapCtrl::ReloadMinimap()
 {
-	assert(wxThread::IsMain());
-	_SetCursor();
 	if (m_battle == nullptr)
-		return;
+		return false;
 	int w, h;
 	GetClientSize(&w, &h);
 
-	m_mutex.Lock();
 	const bool just_resize = (m_lastsize != wxSize(-1, -1) && m_lastsize != wxSize(w, h));
-	if ((m_mapname != m_battle->GetHostMapName()) || just_resize) {
-		FreeMinimap();
-		int loaded_ok = LoadMinimap();
-
-		if (!just_resize && loaded_ok == 0) // if a new map is loaded, reset start positions
-		{
-			const long longval = LSL::Util::FromIntString(m_battle->CustomBattleOptions()
-									  .getSingleValue("startpostype", LSL::Enum::EngineOption));
-			if (longval == IBattle::ST_Pick)
-				RelocateUsers();
-		}
+	if ((m_mapname == m_battle->GetHostMapName()) && !just_resize)
+		return false;
+
+	FreeMinimap();
+	m_overlays.clear();
+	int loaded_ok = LoadMinimap();
+
+	if (!just_resize && loaded_ok == 0) // if a new map is loaded, reset start positions
+	{
+		const long longval = LSL::Util::FromIntString(m_battle->CustomBattleOptions()
+								  .getSingleValue("startpostype", LSL::Enum::EngineOption));
+		if (longval == IBattle::ST_Pick)
+			RelocateUsers();
 	}
+	return true;
+}
+
+
+void MapCtrl::UpdateMinimap()
+{
+	assert(wxThread::IsMain());
+	_SetCursor();
+	if (m_battle == nullptr)
+		return;
+	ReloadMinimap();
 	Refresh();
-	m_mutex.Unlock();
 }
 
 
@@ -562,25 +530,7 @@ void MapCtrl::DrawStartRect(wxDC& dc, int index, wxRect& sr, const wxColour& col
 		return;
 
 	dc.SetBrush(wxBrush(*wxLIGHT_GREY, wxTRANSPARENT));
-
-	wxImage img(sr.width, sr.height);
-	wxColour light;
-	light.Set(((col.Red() + 100) > 200) ? 200 : (col.Red() + 100), ((col.Green() + 100) > 200) ? 200 : (col.Green() + 100), ((col.Blue() + 100) > 200) ? 200 : (col.Blue() + 100));
-	img.SetRGB(wxRect(0, 0, sr.width, sr.height), light.Red(), light.Green(), light.Blue());
-	img.InitAlpha();
-	unsigned char* alpha = img.GetAlpha();
-	for (int y = 0; y < sr.height; y++) {
-		int a;
-		if ((y % 3) == 0)
-			a = alphalevel;
-		else
-			a = ((alphalevel - 40) < 0) ? 0 : (alphalevel - 40);
-		for (int x = 0; x < sr.width; x++) {
-			alpha[(y * sr.width) + x] = a;
-		}
-	}
-	wxBitmap bmpimg(img);
-	dc.DrawBitmap(bmpimg, sr.x, sr.y, false);
+	dc.DrawBitmap(GetStartRectOverlay(sr.GetSize(), col, alphalevel), sr.x, sr.y, false);
 
 	/*  wxFont f( 12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL|wxFONTFLAG_ANTIALIASED, wxFONTWEIGHT_LIGHT );
       dc.SetFont( f );*/
@@ -633,6 +583,31 @@ void MapCtrl::DrawStartRect(wxDC& dc, int index, wxRect& sr, const wxColour& col
 }
 
 
+const wxBitmap& MapCtrl::GetStartRectOverlay(const wxSize& size, const wxColour& col, int alphalevel)
+{
+	const OverlayKey key(size.GetWidth(), size.GetHeight(), col.GetRGB(), alphalevel);
+	std::map<OverlayKey, wxBitmap>::const_iterator it = m_overlays.find(key);
+	if (it != m_overlays.end())
+		return it->second;
+
+	// resizing a rect creates a new size on every mouse move, keep the cache bounded
+	if (m_overlays.size() >= MAX_OVERLAYS)
+		m_overlays.clear();
+
+	wxImage img(size.GetWidth(), size.GetHeight());
+	wxColour light;
+	light.Set(((col.Red() + 100) > 200) ? 200 : (col.Red() + 100), ((col.Green() + 100) > 200) ? 200 : (col.Green() + 100), ((col.Blue() + 100) > 200) ? 200 : (col.Blue() + 100));
+	img.SetRGB(wxRect(0, 0, size.GetWidth(), size.GetHeight()), light.Red(), light.Green(), light.Blue());
+	img.InitAlpha();
+	unsigned char* alpha = img.GetAlpha();
+	const unsigned char dim = ((alphalevel - 40) < 0) ? 0 : (alphalevel - 40);
+	for (int y = 0; y < size.GetHeight(); y++) {
+		memset(alpha + y * size.GetWidth(), ((y % 3) == 0) ? alphalevel : dim, size.GetWidth());
+	}
+	return m_overlays[key] = wxBitmap(img);
+}
+
+
 wxRect MapCtrl::GetRefreshRect() const
 {
 	int width, height;
@@ -732,20 +707,18 @@ void MapCtrl::DrawBackground(wxDC& dc)
 		}
 	} else {
 
-		wxRect r = GetMinimapRect();
-
-		// Draw background where the minimap is not drawn(to avoid flickering).
-		if (r.y > 0) {
-			dc.DrawRectangle(0, 0, width, (height - r.height) / 2);
-			dc.DrawRectangle(0, r.y + r.height, width, (height - r.height) / 2 + 1);
+		// compose the border and the current info map once, paints just blit it
+		if (!m_background.IsOk() || (m_background.GetSize() != wxSize(width, height)) || (m_background_infomap != m_current_infomap)) {
+			m_background = wxBitmap(width, height);
+			m_background_infomap = m_current_infomap;
+			wxMemoryDC mdc(m_background);
+			mdc.SetPen(dc.GetPen());
+			mdc.SetBrush(dc.GetBrush());
+			mdc.DrawRectangle(0, 0, width, height);
+			const wxRect r = GetMinimapRect();
+			mdc.DrawBitmap(*img, r.x, r.y, false);
 		}
-		if (r.x > 0) {
-			dc.DrawRectangle(0, 0, (width - r.width) / 2, height);
-			dc.DrawRectangle(r.x + r.width, 0, (width - r.width) / 2 + 1, height);
-		}
-
-		// Draw minimap
-		dc.DrawBitmap(*img, r.x, r.y, false);
+		dc.DrawBitmap(m_background, 0, 0, false);
 	}
 }
 
@@ -756,6 +729,9 @@ void MapCtrl::DrawStartRects(wxDC& dc)
 		wxRect sr = GetStartRect(i);
 		if (sr.IsEmpty())
 			continue;
+		// only called while painting, skip the rects which aren't damaged
+		if (GetUpdateRegion().Contains(sr) == wxOutRegion)
+			continue;
 		wxColour col;
 		if (i == m_battle->GetMe().BattleStatus().ally) {
 			col.Set(0, 200, 0);
@@ -1536,49 +1512,29 @@ void MapCtrl::OnMouseWheel(wxMouseEvent& event)
 }
 
 
-void MapCtrl::OnGetMapImageAsyncCompleted(const std::string& mapname)
+void MapCtrl::UpdateLayers()
 {
-	m_mutex.Lock();
-	wxLogDebug(wxString::Format(_T("Map loaded (async) complete: %s"), TowxString(mapname).c_str()));
-	if (!m_async.Connected()) { //was closed, abort
-		m_mutex.Unlock();
-		return;
-	}
-
-	if (m_mapname.empty() || mapname.empty() || mapname != m_mapname) { //selected doesn't match fetched map, abort
-		m_mutex.Unlock();
-		return;
-	}
-
-	const int w = m_lastsize.GetWidth();
-	const int h = m_lastsize.GetHeight();
-
-	if (m_minimap == NULL) {
-		m_minimap = new wxBitmap(LSL::usync().GetScaledMapImage(mapname, LSL::IMAGE_MAP, w, h).wxbitmap());
-		// this ensures metalmap and heightmap aren't loaded in battlelist
-		if (m_draw_start_types) {
-			m_async.GetMapImageAsync(mapname, LSL::IMAGE_MAP, w, h);
-		}
-	} else if (m_metalmap == NULL) {
-		m_metalmap = new wxBitmap(LSL::usync().GetScaledMapImage(mapname, LSL::IMAGE_METALMAP, w, h).wxbitmap());
-		// singleplayer mode doesn't allow startboxes anyway
-		m_metalmap_cumulative = LSL::usync().GetScaledMapImage(mapname, LSL::IMAGE_METALMAP, w, h).wximage();
-		Accumulate(m_metalmap_cumulative);
-		m_async.GetMapImageAsync(mapname, LSL::IMAGE_HEIGHTMAP, w, h);
-	} else if (m_heightmap == NULL) {
-		m_heightmap = new wxBitmap(LSL::usync().GetScaledMapImage(mapname, LSL::IMAGE_HEIGHTMAP, w, h).wxbitmap());
+	wxBitmap** bitmaps[MapLayerCache::LAYER_COUNT] = {&m_minimap, &m_metalmap, &m_heightmap};
+	for (int i = 0; i < MapLayerCache::LAYER_COUNT; i++) {
+		if ((*bitmaps[i] != NULL) || !m_layers.images[i])
+			continue;
+		*bitmaps[i] = new wxBitmap(MapLayerCache::Rescale(*m_layers.images[i], m_lastsize.GetWidth(), m_lastsize.GetHeight()));
+		m_background = wxNullBitmap;
 	}
-
-	// never ever call a gui function here, it will crash! (in 1/100 cases)
-	wxCommandEvent evt(REFRESH_EVENT, GetId());
-	evt.SetEventObject(this);
-	wxPostEvent(this, evt);
-
-	m_mutex.Unlock();
 }
 
-void MapCtrl::OnRefresh(wxCommandEvent& /*event*/)
+void MapCtrl::OnRefresh(wxCommandEvent& event)
 {
 	assert(wxThread::IsMain());
+	// a layer of a map was loaded in the background
+	if (m_mapname.empty() || (STD_STRING(event.GetString()) != m_mapname))
+		return;
+	if (event.GetInt() == 0) {
+		// failed, requesting it again now would retry in a loop
+		Refresh();
+		return;
+	}
+	m_layers = MapLayerCache::Instance()->Request(m_mapname, m_draw_start_types, this);
+	UpdateLayers();
 	Refresh();
 }
@@ -4,11 +4,15 @@
 #define SPRINGLOBBY_HEADERGUARD_MAPCTRL_H
 
 #include <lslunitsync/unitsync.h>
+#include <wx/bitmap.h>
 #include <wx/image.h>
 #include <wx/panel.h>
 #include <wx/string.h>
 #include <wx/thread.h>
+#include <map>
+
 #include "ibattle.h"
+#include "maplayercache.h"
 class wxPanel;
 class wxBitmap;
 class wxDC;
@@ -78,8 +82,6 @@ public:
 	void OnRightUp(wxMouseEvent& event);
 	void OnMouseWheel(wxMouseEvent& event);
 
-	void OnGetMapImageAsyncCompleted(const std::string& mapname);
-
 	void OnRefresh(wxCommandEvent& event);
 
 	void SetReadOnly(bool readonly)
@@ -91,6 +93,10 @@ public:
 private:
 	int LoadMinimap();
 	void FreeMinimap();
+	//! loads the minimap if the map or the size changed, returns true if it did
+	bool ReloadMinimap();
+	//! creates the bitmaps of the cached layers which arrived, scaled to m_lastsize
+	void UpdateLayers();
 
 	BattleStartRect GetBattleRect(int x1, int y1, int x2, int y2, int ally = -1) const;
 
@@ -111,7 +117,6 @@ private:
 
 	wxRect GetStartRect(int index) const;
 	wxRect GetStartRect(const BattleStartRect& sr) const;
-	void Accumulate(wxImage& image) const;
 	double GetStartRectMetalFraction(int index) const;
 	double GetStartRectMetalFraction(const BattleStartRect& sr) const;
 
@@ -178,17 +183,17 @@ private:
 	void DrawStartRects(wxDC& dc);
 	void DrawStartPositions(wxDC& dc);
 	void DrawStartRect(wxDC& dc, int index, wxRect& sr, const wxColour& col, bool mouseover, int alphalevel = 70, bool forceInsideMinimap = true);
+	//! striped, translucent fill of a start rect, cached per size, colour and alpha
+	const wxBitmap& GetStartRectOverlay(const wxSize& size, const wxColour& col, int alphalevel);
 
 	void SetMouseOverRect(int index);
 
 	void _SetCursor();
 
-	LSL::UnitSyncAsyncOps m_async;
-
 	wxBitmap* m_minimap;
 	wxBitmap* m_metalmap;
 	wxBitmap* m_heightmap;
-	wxImage m_metalmap_cumulative;
+	MapLayerCache::Layers m_layers;
 
 	IBattle* m_battle;
 
@@ -238,7 +243,34 @@ private:
 		IM_Count // must be last one
 	} m_current_infomap;
 
-	wxMutex m_mutex;
+	InfoMap m_background_infomap;
+	wxBitmap m_background; //!< border and current info map, composed for m_background_infomap
+
+	struct OverlayKey {
+		OverlayKey(int _width, int _height, unsigned int _rgb, int _alpha)
+		    : width(_width)
+		    , height(_height)
+		    , rgb(_rgb)
+		    , alpha(_alpha)
+		{
+		}
+		bool operator<(const OverlayKey& other) const
+		{
+			if (width != other.width)
+				return width < other.width;
+			if (height != other.height)
+				return height < other.height;
+			if (rgb != other.rgb)
+				return rgb < other.rgb;
+			return alpha < other.alpha;
+		}
+		int width;
+		int height;
+		unsigned int rgb;
+		int alpha;
+	};
+	static const size_t MAX_OVERLAYS = 64;
+	std::map<OverlayKey, wxBitmap> m_overlays;
 
 	DECLARE_EVENT_TABLE()
 };
@@ -5,11 +5,17 @@
 #include <lslunitsync/image.h>
 #include <lslutils/misc.h>
 #include <wx/dcbuffer.h>
+#include <wx/dir.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
 #include <wx/geometry.h>
 #include <wx/log.h>
 #include <wx/settings.h>
+#include <wx/textfile.h>
 #include <algorithm>
 #include <functional>
+#include <utility>
+#include <vector>
 
 #include "images/map_select_1.png.h"
 #include "images/map_select_2.png.h"
@@ -17,6 +23,7 @@
 #include "settings.h"
 #include "uiutils.h"
 #include "utils/conversion.h"
+#include "utils/slpaths.h"
 
 /// Size of the map previews.  This should be same as size of map previews in
 /// battle list and as prefetch size in SpringUnitSync for performance reasons.
@@ -25,6 +32,43 @@ const int MINIMAP_SIZE = 98;
 /// Margin between the map previews, in pixels.
 const int MINIMAP_MARGIN = 1;
 
+/// Max. number of cached minimaps decoded per paint, the rest follows with the next one.
+const int MAX_CACHE_LOADS_PER_PAINT = 32;
+
+/// Max. number of composited minimaps kept on disk, about 20KB each.
+const size_t MAX_CACHED_MINIMAPS = 2000;
+
+/// Directory of the minimap cache, empty if it can't be created.
+static std::string GetMinimapCacheDir()
+{
+	const std::string cachedir = SlPaths::GetCachePath();
+	if (cachedir.empty())
+		return std::string();
+	const std::string dir = cachedir + "minimaps";
+	if (!wxFileName::DirExists(TowxString(dir)) && !SlPaths::mkDir(dir))
+		return std::string();
+	return dir + (char)wxFileName::GetPathSeparator();
+}
+
+/// Path of the composited minimap of the map archive with the given checksum,
+/// empty if the cache dir can't be created.
+static wxString GetCachedMinimapPath(const std::string& hash)
+{
+	const std::string dir = GetMinimapCacheDir();
+	if (dir.empty() || hash.empty())
+		return wxEmptyString;
+	return TowxString(stdprintf("%s%s_%d.png", dir.c_str(), hash.c_str(), MINIMAP_SIZE));
+}
+
+/// Path of the "<hash> <map name>" index of the cached minimaps.
+static wxString GetHashIndexPath()
+{
+	const std::string dir = GetMinimapCacheDir();
+	if (dir.empty())
+		return wxEmptyString;
+	return TowxString(dir + "hashes.txt");
+}
+
 BEGIN_EVENT_TABLE(MapGridCtrl, wxPanel)
 EVT_PAINT(MapGridCtrl::OnPaint)
 EVT_SIZE(MapGridCtrl::OnResize)
@@ -47,12 +91,16 @@ MapGridCtrl::MapGridCtrl(wxWindow* parent, wxSize size, wxWindowID id)
     , m_async_image(std::bind(&MapGridCtrl::OnGetMapImageAsyncCompleted, this, std::placeholders::_1))
     , m_async_ex(std::bind(&MapGridCtrl::OnGetMapExAsyncCompleted, this, std::placeholders::_1))
     , m_async_ops_count(0)
+    , m_paint_generation(1)
+    , m_cache_loads(0)
+    , m_loading_completed(false)
     , m_selection_follows_mouse(sett().GetMapSelectorFollowsMouse())
     , m_size(0, 0)
     , m_pos(0, 0)
     , m_in_mouse_drag(false)
     , m_mouseover_map(NULL)
     , m_selected_map(NULL)
+    , m_cached_hashes_changed(false)
 {
 	SetBackgroundStyle(wxBG_STYLE_CUSTOM);
 	SetBackgroundColour(*wxLIGHT_GREY);
@@ -69,6 +117,8 @@ MapGridCtrl::MapGridCtrl(wxWindow* parent, wxSize size, wxWindowID id)
 	ASSERT_EXCEPTION(m_img_foreground.HasAlpha(), _T("map_select_2_png must have an alpha channel"));
 
 	m_img_minimap_loading = wxBitmap(BlendImage(m_img_foreground, m_img_background, false));
+
+	LoadHashIndex();
 }
 
 
@@ -84,6 +134,76 @@ MapGridCtrl::~MapGridCtrl()
 	m_grid.clear();
 	m_maps.clear();
 	//m_mutex.Unlock();
+	SaveHashIndex();
+}
+
+
+void MapGridCtrl::LoadHashIndex()
+{
+	const wxString path = GetHashIndexPath();
+	if (path.empty() || !wxFileName::FileExists(path))
+		return;
+	wxLogNull noerrors; // a broken index only costs the cache hits before the infos are fetched
+	wxTextFile file(path);
+	if (!file.Open())
+		return;
+	for (wxString line = file.GetFirstLine(); !file.Eof(); line = file.GetNextLine()) {
+		const wxString hash = line.BeforeFirst(_T(' '));
+		const wxString name = line.AfterFirst(_T(' '));
+		if (!hash.empty() && !name.empty())
+			m_cached_hashes[name] = STD_STRING(hash);
+	}
+}
+
+
+void MapGridCtrl::PruneMinimapCache()
+{
+	const std::string dir = GetMinimapCacheDir();
+	if (dir.empty())
+		return;
+	wxLogNull noerrors;
+	wxArrayString files;
+	wxDir::GetAllFiles(TowxString(dir), &files, _T("*.png"), wxDIR_FILES);
+	if (files.size() > MAX_CACHED_MINIMAPS) {
+		// loading a minimap touches it, the least recently used ones go first
+		std::vector<std::pair<time_t, wxString> > byage;
+		for (const wxString& file : files) {
+			byage.push_back(std::make_pair(wxFileModificationTime(file), file));
+		}
+		std::sort(byage.begin(), byage.end());
+		for (size_t i = 0; i < byage.size() - MAX_CACHED_MINIMAPS; i++) {
+			wxRemoveFile(byage[i].second);
+		}
+	}
+	// the index only keeps the maps which have a cached minimap
+	for (auto it = m_cached_hashes.begin(); it != m_cached_hashes.end();) {
+		if (wxFileName::FileExists(GetCachedMinimapPath(it->second))) {
+			++it;
+		} else {
+			it = m_cached_hashes.erase(it);
+		}
+	}
+}
+
+
+void MapGridCtrl::SaveHashIndex()
+{
+	if (!m_cached_hashes_changed)
+		return;
+	// new minimaps were cached
+	PruneMinimapCache();
+	const wxString path = GetHashIndexPath();
+	if (path.empty())
+		return;
+	wxLogNull noerrors;
+	wxTextFile file(path);
+	if (!(wxFileName::FileExists(path) ? file.Open() : file.Create()))
+		return;
+	file.Clear();
+	for (const auto& entry : m_cached_hashes) {
+		file.AddLine(TowxString(entry.second) + _T(" ") + entry.first);
+	}
+	file.Write();
 }
 
 
@@ -268,9 +388,14 @@ void MapGridCtrl::AddMap(const wxString& mapname)
 	if (m_maps.find(mapname) == m_maps.end()) {
 		MapData m;
 		m.name = mapname.mb_str();
+		// the real hash needs an info fetch, until then look the minimap up by the last known one
+		const auto cached = m_cached_hashes.find(mapname);
+		if (cached != m_cached_hashes.end())
+			m.cache_hash = cached->second;
 		m_maps[mapname] = m;
 		m_pending_mapinfos.push_back(&m_maps[mapname]);
 		m_pending_mapimages.push_back(&m_maps[mapname]);
+		m_loading_completed = false;
 		UpdateAsyncFetches();
 	}
 
@@ -336,33 +461,96 @@ MapGridCtrl::MapData* MapGridCtrl::GetMaxPriorityMap(std::list<MapData*>& maps)
 
 void MapGridCtrl::UpdateAsyncFetches()
 {
+	// keep the queue short, so a scroll re-prioritizes the fetches quickly
 	if (m_async_ops_count > 2)
 		return;
 	if (!m_pending_mapinfos.empty()) {
 		m_async_ops_count++;
 		const MapData* m = GetMaxPriorityMap(m_pending_mapinfos);
 		m_async_ex.GetMapImageAsync(m->name, LSL::IMAGE_MAP_THUMB, MINIMAP_SIZE, MINIMAP_SIZE);
-	} else if (!m_pending_mapimages.empty()) {
+		return;
+	}
+	// visible maps come first, the others are loaded in the background
+	int cache_loads = 0;
+	while (!m_pending_mapimages.empty()) {
 		MapData* m = GetMaxPriorityMap(m_pending_mapimages);
-		if (m->state != MapState_NoMinimap) //FIXME: this shouldn never happen
+		if (m->state != MapState_NoMinimap) // already loaded from the cache
+			continue;
+		if (!m->cache_hash.empty() && !m->cache_checked) {
+			if (cache_loads >= MAX_CACHE_LOADS_PER_PAINT) {
+				// continue with the next refresh, so the gui isn't blocked
+				m_pending_mapimages.push_back(m);
+				wxCommandEvent evt(REFRESH_EVENT, GetId());
+				evt.SetEventObject(this);
+				wxPostEvent(this, evt);
+				return;
+			}
+			cache_loads++;
+			m->cache_checked = true;
+			if (LoadCachedMinimap(*m))
+				continue;
+		}
+		// unitsync can't cancel fetches once they're queued, so one for a map
+		// that wasn't drawn by the last paint is only started when nothing else
+		// runs. A scroll then waits for at most this one.
+		if ((m->priority != m_paint_generation) && (m_async_ops_count > 0)) {
+			m_pending_mapimages.push_back(m);
 			return;
+		}
 		m_async_ops_count++;
 
 		m->state = MapState_GetMinimap;
 		m_async_image.GetMapImageAsync(m->name, LSL::IMAGE_MAP_THUMB, MINIMAP_SIZE, MINIMAP_SIZE);
-	} else {
-		wxCommandEvent evt(LoadingCompletedEvt, GetId());
-		evt.SetEventObject(this);
-		wxPostEvent(this, evt);
+		return;
+	}
+	if (m_loading_completed || (m_async_ops_count > 0))
+		return;
+	{
+		wxMutexLocker lock(m_mutex);
+		if (!m_fetched.empty()) // applied with the next refresh, which calls this again
+			return;
 	}
+	m_loading_completed = true;
+	wxCommandEvent evt(LoadingCompletedEvt, GetId());
+	evt.SetEventObject(this);
+	wxPostEvent(this, evt);
+}
+
+
+bool MapGridCtrl::LoadCachedMinimap(MapData& map)
+{
+	const wxString path = GetCachedMinimapPath(map.cache_hash);
+	if (path.empty() || !wxFileName::FileExists(path))
+		return false;
+	wxLogNull noerrors; // a broken file is simply fetched again
+	wxImage minimap;
+	if (!minimap.LoadFile(path, wxBITMAP_TYPE_PNG))
+		return false;
+	map.minimap = wxBitmap(minimap);
+	map.state = MapState_GotMinimap;
+	// the least recently used minimaps are pruned, see PruneMinimapCache
+	wxFileName(path).Touch();
+	return true;
 }
 
 
 void MapGridCtrl::DrawMap(wxDC& dc, MapData& map, int x, int y)
 {
+	map.priority = m_paint_generation;
+	if ((map.state == MapState_NoMinimap) && !map.cache_hash.empty() && !map.cache_checked) {
+		if (m_cache_loads < MAX_CACHE_LOADS_PER_PAINT) {
+			m_cache_loads++;
+			map.cache_checked = true;
+			LoadCachedMinimap(map);
+		} else if (m_cache_loads == MAX_CACHE_LOADS_PER_PAINT) {
+			m_cache_loads++; // request only one more paint
+			wxCommandEvent evt(REFRESH_EVENT, GetId());
+			evt.SetEventObject(this);
+			wxPostEvent(this, evt);
+		}
+	}
 	switch (map.state) {
 		case MapState_NoMinimap:
-			map.priority = 1;
 			UpdateAsyncFetches();
 			[[fallthrough]];
 		// fall through, both when starting fetch and when waiting
@@ -409,6 +597,9 @@ void MapGridCtrl::OnPaint(wxPaintEvent& /*unused*/)
 	wxAutoBufferedPaintDC dc(this);
 
 	DrawBackground(dc);
+	// maps drawn in this paint get the highest fetch priority
+	m_paint_generation++;
+	m_cache_loads = 0;
 
 	if (m_maps.empty())
 		return;
@@ -526,13 +717,21 @@ void MapGridCtrl::SelectMap(MapData* map)
 
 void MapGridCtrl::OnGetMapImageAsyncCompleted(const std::string& _mapname)
 {
-	m_mutex.Lock();
-	// if mapname is empty, some error occurred in LSL::usync().GetMinimap...
-	if (!m_async_ex.Connected() || !m_async_image.Connected() || _mapname.empty()) {
-		m_mutex.Unlock();
+	// runs on the unitsync thread: m_maps belongs to the gui thread, results go through m_fetched
+	if (_mapname.empty()) {
+		// some error occurred in LSL::usync().GetMinimap...
+		OnFetchFailed();
 		return;
 	}
-	const wxString mapname = TowxString(_mapname);
+	{
+		wxMutexLocker lock(m_mutex);
+		if (!m_async_ex.Connected() || !m_async_image.Connected())
+			return;
+	}
+	FetchedMap result;
+	result.name = TowxString(_mapname);
+	result.is_info = false;
+	result.map.hash = LSL::usync().GetMap(_mapname).hash;
 	wxImage minimap(LSL::usync().GetScaledMapImage(_mapname, LSL::IMAGE_MAP_THUMB, MINIMAP_SIZE, MINIMAP_SIZE).wximage());
 
 	const int w = minimap.GetWidth();
@@ -545,37 +744,118 @@ void MapGridCtrl::OnGetMapImageAsyncCompleted(const std::string& _mapname)
 	minimap = BlendImage(minimap, background, false);
 	minimap = BlendImage(foreground, minimap, false);
 
-	// set the minimap in all MapMaps
-	m_maps[mapname].minimap = wxBitmap(minimap);
-	m_maps[mapname].state = MapState_GotMinimap;
-	if (m_async_ops_count > 0) //WTF, why is this needed?
-		m_async_ops_count--;
+	// next time the dialog is opened, the final image is loaded from disk
+	const wxString cachepath = GetCachedMinimapPath(result.map.hash);
+	if (!cachepath.empty() && minimap.IsOk()) {
+		wxLogNull noerrors;
+		const wxString tmppath = cachepath + _T(".tmp");
+		if (minimap.SaveFile(tmppath, wxBITMAP_TYPE_PNG) && !wxRenameFile(tmppath, cachepath, true)) {
+			wxRemoveFile(tmppath);
+		}
+	}
+
+	wxMutexLocker lock(m_mutex);
+	if (!m_async_ex.Connected() || !m_async_image.Connected())
+		return;
+	m_fetched.push_back(result);
+	m_fetched.back().minimap = minimap;
+	// wxImage isn't refcounted atomically, drop this thread's references while holding the lock
+	minimap = wxNullImage;
 
 	// never ever call a gui function here, it will crash! (in 1/100 cases)
 	wxCommandEvent evt(REFRESH_EVENT, GetId());
 	evt.SetEventObject(this);
 	wxPostEvent(this, evt);
-	m_mutex.Unlock();
 }
 
 
 void MapGridCtrl::OnGetMapExAsyncCompleted(const std::string& _mapname)
 {
-	m_mutex.Lock();
-	// if mapname is empty, some error occurred in LSL::usync().GetMapEx...
-	if (!m_async_ex.Connected() || !m_async_image.Connected() || _mapname.empty()) {
-		m_mutex.Unlock();
+	if (_mapname.empty()) {
+		// some error occurred in LSL::usync().GetMapEx...
+		OnFetchFailed();
 		return;
 	}
-	const wxString mapname = TowxString(_mapname);
-	LSL::UnitsyncMap m = LSL::usync().GetMap(_mapname);
-	m_maps[mapname].hash = m.hash;
-	m_maps[mapname].info = m.info;
-	m_async_ops_count--;
-	m_mutex.Unlock();
+	{
+		wxMutexLocker lock(m_mutex);
+		if (!m_async_ex.Connected() || !m_async_image.Connected())
+			return;
+	}
+	FetchedMap result;
+	result.name = TowxString(_mapname);
+	result.is_info = true;
+	result.map = LSL::usync().GetMap(_mapname);
+
+	wxMutexLocker lock(m_mutex);
+	if (!m_async_ex.Connected() || !m_async_image.Connected())
+		return;
+	m_fetched.push_back(result);
+
+	// the hash is known now, visible maps may be in the minimap cache
+	wxCommandEvent evt(REFRESH_EVENT, GetId());
+	evt.SetEventObject(this);
+	wxPostEvent(this, evt);
+}
+
+
+void MapGridCtrl::OnFetchFailed()
+{
+	wxMutexLocker lock(m_mutex);
+	if (!m_async_ex.Connected() || !m_async_image.Connected())
+		return;
+	// an empty result, so the fetch is counted as done
+	FetchedMap result;
+	result.is_info = false;
+	m_fetched.push_back(result);
+	wxCommandEvent evt(REFRESH_EVENT, GetId());
+	evt.SetEventObject(this);
+	wxPostEvent(this, evt);
+}
+
+
+void MapGridCtrl::ApplyFetchedMaps()
+{
+	assert(wxThread::IsMain());
+	std::vector<FetchedMap> fetched;
+	{
+		wxMutexLocker lock(m_mutex);
+		fetched.swap(m_fetched);
+	}
+	for (const FetchedMap& result : fetched) {
+		if (m_async_ops_count > 0)
+			m_async_ops_count--;
+		MapMap::iterator it = m_maps.find(result.name);
+		if (it == m_maps.end())
+			continue;
+		MapData& map = it->second;
+		if (!result.map.hash.empty() && (m_cached_hashes[result.name] != result.map.hash)) {
+			m_cached_hashes[result.name] = result.map.hash;
+			m_cached_hashes_changed = true;
+		}
+		if (!result.is_info) {
+			map.minimap = wxBitmap(result.minimap);
+			map.state = MapState_GotMinimap;
+			map.cache_hash = result.map.hash;
+			continue;
+		}
+		map.hash = result.map.hash;
+		map.info = result.map.info;
+		if (map.cache_hash == map.hash)
+			continue;
+		// the indexed hash was outdated, the map archive changed since the minimap was cached
+		map.cache_hash = map.hash;
+		map.cache_checked = false;
+		if (map.state == MapState_GotMinimap) {
+			map.minimap = wxNullBitmap;
+			map.state = MapState_NoMinimap;
+			m_pending_mapimages.push_back(&map);
+		}
+	}
 }
 
 void MapGridCtrl::OnRefresh(wxCommandEvent& /*event*/)
 {
+	ApplyFetchedMaps();
+	UpdateAsyncFetches();
 	Refresh();
 }
@@ -85,6 +85,7 @@ private:
 		MapData()
 		    : state(MapState_NoMinimap)
 		    , priority(0)
+		    , cache_checked(false)
 		{
 		}
 		void operator=(const LSL::UnitsyncMap& other)
@@ -94,7 +95,17 @@ private:
 
 		wxBitmap minimap;
 		MapState state;
-		unsigned priority; //the higher the earlier data will be fetched, is increased by Draw()
+		unsigned priority; //the paint which drew this map last, the higher the earlier data will be fetched
+		bool cache_checked; //the minimap cache was already looked up
+		std::string cache_hash; //key of the cached minimap, taken from the hash index until the info is fetched
+	};
+
+	//! result of an async fetch, handed from the unitsync thread to the gui thread
+	struct FetchedMap {
+		wxString name;
+		bool is_info; //info and hash, otherwise a composited minimap
+		LSL::UnitsyncMap map;
+		wxImage minimap;
 	};
 
 	typedef std::map<wxString, MapData> MapMap;
@@ -144,6 +155,8 @@ private:
 private:
 	void OnGetMapImageAsyncCompleted(const std::string& _mapname);
 	void OnGetMapExAsyncCompleted(const std::string& _mapname);
+	//! unitsync thread, a fetch returned no map
+	void OnFetchFailed();
 	void UpdateGridSize();
 	void UpdateAsyncFetches();
 	void FetchMapInfo(const wxString& mapname);
@@ -151,6 +164,14 @@ private:
 	void DrawMap(wxDC& dc, MapData& map, int x, int y);
 	void DrawBackground(wxDC& dc);
 	void SetMinimap(MapData& mapdata, const wxBitmap& minimap);
+	//! loads the composited minimap from the disk cache, keyed by the map's hash
+	bool LoadCachedMinimap(MapData& map);
+	//! applies the results of finished async fetches, gui thread only
+	void ApplyFetchedMaps();
+	void LoadHashIndex();
+	void SaveHashIndex();
+	//! removes the least recently used minimaps beyond MAX_CACHED_MINIMAPS and their index entries
+	void PruneMinimapCache();
 	void SelectMap(MapData* map);
 	bool IsInGrid(const wxString& mapname);
 	MapData* GetMaxPriorityMap(std::list<MapData*>& maps);
@@ -159,6 +180,10 @@ private:
 	LSL::UnitSyncAsyncOps m_async_ex;
 
 	int m_async_ops_count;
+	/// increased by every paint, maps with this priority are visible
+	unsigned m_paint_generation;
+	int m_cache_loads;
+	bool m_loading_completed;
 
 	const bool m_selection_follows_mouse;
 
@@ -189,6 +214,12 @@ private:
 	wxImage m_img_foreground;
 	/// this is displayed for maps whose minimap has not yet been loaded
 	wxBitmap m_img_minimap_loading;
+	/// map name -> hash of the cached minimaps, lets the cache work before the map infos are fetched
+	std::map<wxString, std::string> m_cached_hashes;
+	bool m_cached_hashes_changed;
+
+	/// finished fetches waiting for the gui thread, guarded by m_mutex
+	std::vector<FetchedMap> m_fetched;
 	wxMutex m_mutex;
 
 	DECLARE_EVENT_TABLE()
@@ -0,0 +1,218 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define HAVE_WX
+#include "maplayercache.h"
+
+#include <lslunitsync/image.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "uiutils.h"
+#include "utils/conversion.h"
+#include "utils/globalevents.h"
+#include "utils/summedareatable.h"
+
+/// Bounding box of the cached layers, the minimap's full resolution.
+static const int LAYER_SIZE = 1024;
+
+/// Number of maps whose layers are kept (about 9MB each).
+static const size_t MAX_MAPS = 4;
+
+static const LSL::ImageType LAYER_TYPES[MapLayerCache::LAYER_COUNT] = {
+    LSL::IMAGE_MAP,
+    LSL::IMAGE_METALMAP,
+    LSL::IMAGE_HEIGHTMAP,
+};
+
+MapLayerCache* MapLayerCache::m_Instance = nullptr;
+
+MapLayerCache* MapLayerCache::Instance()
+{
+	if (m_Instance == nullptr) {
+		m_Instance = new MapLayerCache();
+	}
+	return m_Instance;
+}
+
+void MapLayerCache::Release()
+{
+	if (m_Instance != nullptr) {
+		delete m_Instance;
+		m_Instance = nullptr;
+	}
+}
+
+MapLayerCache::MapLayerCache()
+    : m_lifetime(std::make_shared<Lifetime>(this))
+    , m_async_minimap(std::bind(&MapLayerCache::OnLayerLoaded, m_lifetime, LAYER_MINIMAP, std::placeholders::_1))
+    , m_async_metalmap(std::bind(&MapLayerCache::OnLayerLoaded, m_lifetime, LAYER_METALMAP, std::placeholders::_1))
+    , m_async_heightmap(std::bind(&MapLayerCache::OnLayerLoaded, m_lifetime, LAYER_HEIGHTMAP, std::placeholders::_1))
+    , m_usecount(0)
+{
+	SUBSCRIBE_GLOBAL_EVENT(GlobalEventManager::OnUnitsyncReloaded, MapLayerCache::OnUnitsyncReloaded);
+}
+
+MapLayerCache::~MapLayerCache()
+{
+	GlobalEventManager::Instance()->UnSubscribeAll(this);
+	{
+		// waits for a callback that is storing a layer right now, later ones see NULL
+		wxMutexLocker lifetimelock(m_lifetime->mutex);
+		m_lifetime->cache = nullptr;
+	}
+	wxMutexLocker lock(m_mutex);
+	m_async_minimap.Disconnect();
+	m_async_metalmap.Disconnect();
+	m_async_heightmap.Disconnect();
+	m_listeners.clear();
+	m_maps.clear();
+}
+
+void MapLayerCache::StartFetch(Layer layer, const std::string& mapname)
+{
+	switch (layer) {
+		case LAYER_MINIMAP:
+			m_async_minimap.GetMapImageAsync(mapname, LAYER_TYPES[layer], LAYER_SIZE, LAYER_SIZE);
+			break;
+		case LAYER_METALMAP:
+			m_async_metalmap.GetMapImageAsync(mapname, LAYER_TYPES[layer], LAYER_SIZE, LAYER_SIZE);
+			break;
+		case LAYER_HEIGHTMAP:
+			m_async_heightmap.GetMapImageAsync(mapname, LAYER_TYPES[layer], LAYER_SIZE, LAYER_SIZE);
+			break;
+		default:
+			break;
+	}
+}
+
+MapLayerCache::Layers MapLayerCache::Request(const std::string& mapname, bool alllayers, wxEvtHandler* listener)
+{
+	assert(wxThread::IsMain());
+	wxMutexLocker lock(m_mutex);
+	if (listener != nullptr) {
+		m_listeners[listener] = mapname;
+	}
+	if (mapname.empty())
+		return Layers();
+
+	Entry& entry = m_maps[mapname];
+	entry.lastuse = ++m_usecount;
+	// the jobs don't depend on each other, unitsync gets all of them at once
+	const int count = alllayers ? LAYER_COUNT : LAYER_MINIMAP + 1;
+	for (int i = 0; i < count; i++) {
+		if (!entry.requested[i]) {
+			entry.requested[i] = true;
+			StartFetch((Layer)i, mapname);
+		}
+	}
+	const Layers layers = entry.layers;
+	EvictOldMaps();
+	return layers;
+}
+
+void MapLayerCache::RemoveListener(wxEvtHandler* listener)
+{
+	if (m_Instance == nullptr)
+		return;
+	wxMutexLocker lock(m_Instance->m_mutex);
+	m_Instance->m_listeners.erase(listener);
+}
+
+void MapLayerCache::Clear()
+{
+	wxMutexLocker lock(m_mutex);
+	m_maps.clear();
+}
+
+void MapLayerCache::EvictOldMaps()
+{
+	while (m_maps.size() > MAX_MAPS) {
+		std::map<std::string, Entry>::iterator oldest = m_maps.begin();
+		for (std::map<std::string, Entry>::iterator it = m_maps.begin(); it != m_maps.end(); ++it) {
+			if (it->second.lastuse < oldest->second.lastuse)
+				oldest = it;
+		}
+		// layers still shown by a control are kept alive by its shared pointers
+		m_maps.erase(oldest);
+	}
+}
+
+void MapLayerCache::OnLayerLoaded(std::shared_ptr<Lifetime> lifetime, Layer layer, const std::string& mapname)
+{
+	// runs in the unitsync thread, if mapname is empty some error occurred
+	if (mapname.empty())
+		return;
+	{
+		wxMutexLocker lock(lifetime->mutex);
+		if (lifetime->cache == nullptr)
+			return;
+	}
+
+	std::shared_ptr<wxImage> image = std::make_shared<wxImage>(LSL::usync().GetScaledMapImage(mapname, LAYER_TYPES[layer], LAYER_SIZE, LAYER_SIZE).wximage());
+	std::shared_ptr<SummedAreaTable> metal;
+	if (image->IsOk() && (layer == LAYER_METALMAP)) {
+		metal = std::make_shared<SummedAreaTable>();
+		metal->Build(image->GetData(), image->GetWidth(), image->GetHeight());
+	}
+
+	wxMutexLocker lock(lifetime->mutex);
+	if (lifetime->cache == nullptr)
+		return;
+	lifetime->cache->StoreLayer(layer, mapname, image, metal);
+}
+
+void MapLayerCache::StoreLayer(Layer layer, const std::string& mapname, std::shared_ptr<wxImage> image, std::shared_ptr<SummedAreaTable> metal)
+{
+	wxMutexLocker lock(m_mutex);
+	if (!m_async_minimap.Connected() || !m_async_metalmap.Connected() || !m_async_heightmap.Connected())
+		return;
+	std::map<std::string, Entry>::iterator it = m_maps.find(mapname);
+	if (it == m_maps.end()) {
+		// evicted or cleared meanwhile, a listener still showing it requests it again
+		NotifyListeners(mapname, true);
+		return;
+	}
+	Entry& entry = it->second;
+	if (!image->IsOk()) {
+		// fetched again by the next Request, listeners stop waiting for it
+		entry.requested[layer] = false;
+		NotifyListeners(mapname, false);
+		return;
+	}
+	entry.layers.images[layer] = image;
+	if (metal) {
+		entry.layers.metal = metal;
+	}
+	NotifyListeners(mapname, true);
+}
+
+void MapLayerCache::NotifyListeners(const std::string& mapname, bool loaded)
+{
+	for (std::map<wxEvtHandler*, std::string>::const_iterator it = m_listeners.begin(); it != m_listeners.end(); ++it) {
+		if (it->second != mapname)
+			continue;
+		// never ever call a gui function here, the listener picks the layers up in its own thread
+		wxCommandEvent* evt = new wxCommandEvent(REFRESH_EVENT, wxID_ANY);
+		evt->SetString(TowxString(mapname));
+		evt->SetInt(loaded ? 1 : 0);
+		wxQueueEvent(it->first, evt);
+	}
+}
+
+void MapLayerCache::OnUnitsyncReloaded(wxCommandEvent& /*data*/)
+{
+	// maps might have been replaced, fetch them again when used
+	Clear();
+}
+
+wxImage MapLayerCache::Rescale(const wxImage& layer, int width, int height)
+{
+	if (!layer.IsOk() || (width <= 0) || (height <= 0))
+		return wxImage();
+	const double scale = std::min((double)width / layer.GetWidth(), (double)height / layer.GetHeight());
+	const int w = std::max(1, (int)std::floor(layer.GetWidth() * scale + 0.5));
+	const int h = std::max(1, (int)std::floor(layer.GetHeight() * scale + 0.5));
+	if ((w == layer.GetWidth()) && (h == layer.GetHeight()))
+		return layer.Copy();
+	return layer.Scale(w, h, (scale < 1.0) ? wxIMAGE_QUALITY_BOX_AVERAGE : wxIMAGE_QUALITY_BILINEAR);
+}
@@ -0,0 +1,104 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_MAPLAYERCACHE_H
+#define SPRINGLOBBY_HEADERGUARD_MAPLAYERCACHE_H
+
+#include <lslunitsync/unitsync.h>
+#include <wx/event.h>
+#include <wx/image.h>
+#include <wx/thread.h>
+#include <map>
+#include <memory>
+#include <string>
+
+class SummedAreaTable;
+
+/** @brief map images in a fixed, size independent resolution, shared by all MapCtrls
+ *
+ * The minimap, metal map and height map of a map are fetched from unitsync
+ * as independent jobs once and kept for the last few maps, so resizing a
+ * control or switching back to a map only rescales the cached layers.
+ * Listeners get a REFRESH_EVENT with the map name as string whenever a layer
+ * of the map they requested last arrived. Its int is 0 if the layer failed
+ * to load, it is fetched again with the next Request after that.
+ */
+class MapLayerCache : public wxEvtHandler
+{
+private:
+	MapLayerCache();
+	~MapLayerCache();
+
+public:
+	static MapLayerCache* Instance();
+	static void Release();
+
+	enum Layer {
+		LAYER_MINIMAP,
+		LAYER_METALMAP,
+		LAYER_HEIGHTMAP,
+		LAYER_COUNT
+	};
+
+	struct Layers {
+		std::shared_ptr<const wxImage> images[LAYER_COUNT];
+		//! prefix sums of the metal map, for start rect metal fractions
+		std::shared_ptr<const SummedAreaTable> metal;
+	};
+
+	/** returns the layers loaded so far and starts fetching the missing ones
+	 * @param alllayers fetch the metal and height map, too
+	 * @param listener is notified as layers arrive, until it requests another map
+	 */
+	Layers Request(const std::string& mapname, bool alllayers, wxEvtHandler* listener);
+	//! safe to call after Release(), listeners may be destroyed later
+	static void RemoveListener(wxEvtHandler* listener);
+	void Clear();
+
+	//! scales a layer to fit into width x height, keeping its aspect ratio
+	static wxImage Rescale(const wxImage& layer, int width, int height);
+
+private:
+	struct Entry {
+		Entry()
+		    : lastuse(0)
+		{
+			for (int i = 0; i < LAYER_COUNT; i++) {
+				requested[i] = false;
+			}
+		}
+		Layers layers;
+		bool requested[LAYER_COUNT];
+		unsigned lastuse;
+	};
+
+	//! shared with the unitsync callbacks, which may run after the cache was released
+	struct Lifetime {
+		Lifetime(MapLayerCache* c)
+		    : cache(c)
+		{
+		}
+		wxMutex mutex;
+		MapLayerCache* cache; //!< NULL once the cache is destroyed
+	};
+
+	static void OnLayerLoaded(std::shared_ptr<Lifetime> lifetime, Layer layer, const std::string& mapname);
+	void StoreLayer(Layer layer, const std::string& mapname, std::shared_ptr<wxImage> image, std::shared_ptr<SummedAreaTable> metal);
+	void NotifyListeners(const std::string& mapname, bool loaded);
+	void OnUnitsyncReloaded(wxCommandEvent& data);
+	void StartFetch(Layer layer, const std::string& mapname);
+	void EvictOldMaps();
+
+	static MapLayerCache* m_Instance;
+
+	std::shared_ptr<Lifetime> m_lifetime;
+	LSL::UnitSyncAsyncOps m_async_minimap;
+	LSL::UnitSyncAsyncOps m_async_metalmap;
+	LSL::UnitSyncAsyncOps m_async_heightmap;
+
+	std::map<std::string, Entry> m_maps;
+	std::map<wxEvtHandler*, std::string> m_listeners; //!< listener -> map it waits for
+	unsigned m_usecount;
+	wxMutex m_mutex;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_MAPLAYERCACHE_H
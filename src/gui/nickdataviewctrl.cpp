@@ -9,6 +9,7 @@
 #include <wx/string.h>
 #include <wx/translation.h>
 #include <utility>
+#include <vector>
 
 #include "gui/chatpanelmenu.h"
 #include "gui/mainwindow.h"
@@ -75,6 +76,17 @@ void NickDataViewCtrl::AddUser(const User& user)
 	DoUsersFilter();
 }
 
+void NickDataViewCtrl::AddUsers(const std::vector<User*>& users)
+{
+	bool added = false;
+	for (const User* user : users) {
+		added |= AddRealUser(*user);
+	}
+	if (added) {
+		DoUsersFilter();
+	}
+}
+
 void NickDataViewCtrl::RemoveUser(const User& user)
 {
 	if (!RemoveRealUser(user)) {
@@ -121,11 +133,13 @@ int NickDataViewCtrl::GetUsersCount() const
 void NickDataViewCtrl::DoUsersFilter()
 {
 
+	//Users passing the filter are added in one go, so the list is sorted only once
+	std::vector<const User*> added;
 	for (auto const item : m_real_users_list) {
 		if (checkFilteringConditions(item.second)) {
 			//User passed filter. Add him/her to the list.
 			if (!ContainsItem(*item.second)) {
-				AddItem(*item.second);
+				added.push_back(item.second);
 			}
 		} else {
 			//Remove user from the list.
@@ -134,6 +148,7 @@ void NickDataViewCtrl::DoUsersFilter()
 			}
 		}
 	}
+	AddItems(added, false);
 
 	Resort();
 	Refresh();
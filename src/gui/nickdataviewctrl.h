@@ -4,6 +4,7 @@
 #define SRC_GUI_NICKDATAVIEWCTRL_H_
 
 #include <map>
+#include <vector>
 #include "basedataviewctrl.h"
 #include "userlist.h"
 class wxWindow;
@@ -22,6 +23,7 @@ public:
 	void UserFilterShowPlayersOnly(bool);
 	void SetUsersFilterString(const wxString& fs);
 	void AddUser(const User& user);
+	void AddUsers(const std::vector<User*>& users);
 	void RemoveUser(const User& user);
 	void UserUpdated(const User& user);
 	void SetUsers(const UserList::user_map_t& userlist);
@@ -32,7 +32,7 @@ void NickDataViewModel::GetValue(wxVariant& variant, const wxDataViewItem& item,
 			case STATUS:
 			case COUNTRY:
 			case RANK:
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 				break;
 
 			case NICKNAME:
@@ -55,7 +55,7 @@ void NickDataViewModel::GetValue(wxVariant& variant, const wxDataViewItem& item,
 
 		case COUNTRY:
 			if (isBot || isBridged) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				variant = wxVariant(
 				    iconsCollection->GetFlagBmp(wxString(user->GetCountry())));
@@ -64,7 +64,7 @@ void NickDataViewModel::GetValue(wxVariant& variant, const wxDataViewItem& item,
 
 		case RANK:
 			if (isBot || isBridged) {
-				variant = wxVariant(iconsCollection->BMP_EMPTY);
+				variant = wxVariant(iconsCollection->BMP_EMPTY.Get());
 			} else {
 				variant = wxVariant(iconsCollection->GetRankBmp(user->GetRank()));
 			}
@@ -28,6 +28,7 @@
 #include <wx/tokenzr.h>
 
 #include "aui/auimanager.h"
+#include "chatlog.h"
 #include "gui/colorbutton.h"
 #include "gui/controls.h"
 #include "gui/mainwindow.h"
@@ -331,6 +332,12 @@ ChatOptionsTab::ChatOptionsTab(wxWindow* parent)
 	m_highlight_req = new wxCheckBox(this, ID_HL_REQ, _("Additionally play sound/flash titlebar "), wxDefaultPosition, wxDefaultSize, 0);
 	sbHighlightSizer->Add(m_highlight_req, 0, wxALL | wxEXPAND, 5);
 
+	m_highlight_ignorecase = new wxCheckBox(this, wxID_ANY, _("Ignore case"), wxDefaultPosition, wxDefaultSize, 0);
+	sbHighlightSizer->Add(m_highlight_ignorecase, 0, wxALL | wxEXPAND, 5);
+
+	m_highlight_wholewords = new wxCheckBox(this, wxID_ANY, _("Match whole words only"), wxDefaultPosition, wxDefaultSize, 0);
+	sbHighlightSizer->Add(m_highlight_wholewords, 0, wxALL | wxEXPAND, 5);
+
 	bBotomSizer->Add(sbHighlightSizer, 1, wxEXPAND, 5);
 
 	m_main_sizer->Add(bBotomSizer, 0, wxEXPAND | wxBOTTOM | wxRIGHT | wxLEFT, 5);
@@ -431,6 +438,8 @@ void ChatOptionsTab::DoRestore()
 		highlightstring << highlights[i] << _T( ";" );
 	m_highlight_words->SetValue(highlightstring);
 	m_highlight_req->SetValue(sett().GetRequestAttOnHighlight());
+	m_highlight_ignorecase->SetValue(cfg().ReadBool(_T("/Chat/HighlightIgnoreCase")));
+	m_highlight_wholewords->SetValue(cfg().ReadBool(_T("/Chat/HighlightWholeWords")));
 #ifndef DISABLE_SOUND
 	m_play_sounds->SetValue(sett().GetChatPMSoundNotificationEnabled());
 #endif
@@ -458,9 +467,12 @@ void ChatOptionsTab::OnApply(wxCommandEvent& /*unused*/)
 	//m_ui.mw().GetChatTab().ChangeUnreadPMColour( m_note_color->GetBackgroundColour() );
 	sett().SetHighlightedWords(wxStringTokenize(m_highlight_words->GetValue(), _T( ";" )));
 	sett().SetRequestAttOnHighlight(m_highlight_req->IsChecked());
+	cfg().Write(_T("/Chat/HighlightIgnoreCase"), m_highlight_ignorecase->IsChecked());
+	cfg().Write(_T("/Chat/HighlightWholeWords"), m_highlight_wholewords->IsChecked());
 
 	//Chat Log
 	cfg().Write(_T("/ChatLog/chatlog_enable"), m_save_logs->GetValue());
+	ChatLog::ReloadSettings();
 
 	cfg().Write(_T("/Chat/BroadcastEverywhere"), m_broadcast_check->GetValue());
 
@@ -100,6 +100,8 @@ private:
 	wxStaticText* m_hilight_words_label;
 	wxCheckBox* m_play_sounds;
 	wxCheckBox* m_highlight_req;
+	wxCheckBox* m_highlight_ignorecase;
+	wxCheckBox* m_highlight_wholewords;
 	wxCheckBox* m_broadcast_check;
 
 	wxTextCtrl* m_highlight_words;
@@ -133,7 +133,7 @@ LobbyOptionsTab::LobbyOptionsTab(wxWindow* parent)
 
 	wxStaticBoxSizer* m_complete_method_sizer = new wxStaticBoxSizer(wxVERTICAL, this, _("Tab completion method"));
 	m_complete_method_label = new wxStaticText(this, -1, _("\"Match exact\" will complete a word if there is one and only one match.\n"
-							       "\"Match nearest\" will select the (first) match that has closest Levenshtein distance"));
+							       "\"Match nearest\" will complete the first match, pressing tab again cycles through all matches"));
 	m_complete_method_old = new wxRadioButton(this, -1, _("Match exact"), wxDefaultPosition, wxDefaultSize, wxRB_GROUP);
 	m_complete_method_new = new wxRadioButton(this, -1, _("Match nearest"), wxDefaultPosition, wxDefaultSize);
 	m_complete_method_old->SetValue(sett().GetCompletionMethod() == Settings::MatchExact);
@@ -222,6 +222,8 @@ void LobbyOptionsTab::OnApply(wxCommandEvent& /*unused*/)
 	sett().SetNotificationPopupPosition(m_notif_popup_pos->GetSelection());
 	sett().SetNotificationPopupDisplayTime(m_notif_popup_time->GetValue());
 
+	// listeners of the event read the chat settings again
+	sett().InvalidateChatSettings();
 	GlobalEventManager::Instance()->Send(GlobalEventManager::ApplicationSettingsChangedEvent);
 }
 
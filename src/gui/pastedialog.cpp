@@ -27,7 +27,7 @@ PasteDialog::PasteDialog(wxWindow* parent, const wxString& message)
     : wxDialog(parent, -1, _("Flood warning"), wxDefaultPosition, wxDefaultSize, wxFRAME_FLOAT_ON_PARENT | wxDEFAULT_DIALOG_STYLE)
 {
 	wxIcon mainIcon = wxIcon();
-	mainIcon.CopyFromBitmap(IconsCollection::Instance()->BMP_SPRINGLOBBY);
+	mainIcon.CopyFromBitmap(IconsCollection::Instance()->BMP_SPRINGLOBBY.Get());
 	SetIcon(mainIcon);
 
 	//******** copied from wxsource/generic/msgdlgg.cpp with small modifications***********************************************************
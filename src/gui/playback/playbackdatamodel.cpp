@@ -41,8 +41,8 @@ int PlaybackDataModel::Compare(const wxDataViewItem& itemA, const wxDataViewItem
 			sortingResult = storedGameA->battle.GetHostMapName().compare(storedGameB->battle.GetHostMapName());
 			break;
 		case PLAYERS: {
-			unsigned numPlayersA = storedGameA->battle.GetNumUsers() - storedGameA->battle.GetSpectators();
-			unsigned numPlayersB = storedGameB->battle.GetNumUsers() - storedGameB->battle.GetSpectators();
+			unsigned numPlayersA = storedGameA->playernum;
+			unsigned numPlayersB = storedGameB->playernum;
 			sortingResult = GenericCompare(numPlayersA, numPlayersB);
 		} break;
 		case DURATION:
@@ -121,7 +121,7 @@ void PlaybackDataModel::GetValue(wxVariant& variant, const wxDataViewItem& item,
 			break;
 
 		case PLAYERS:
-			variant = wxString::Format(_T("%d"), (int)storedGame->battle.GetNumUsers() - storedGame->battle.GetSpectators());
+			variant = wxString::Format(_T("%d"), storedGame->playernum);
 			break;
 
 		case DURATION: {
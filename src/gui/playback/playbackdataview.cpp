@@ -58,6 +58,13 @@ void PlaybackDataView::AddPlayback(const StoredGame& replay, bool resortIsNeeded
 	Refresh();
 }
 
+void PlaybackDataView::AddPlaybacks(const std::vector<const StoredGame*>& replays)
+{
+	if (AddItems(replays) > 0) {
+		Refresh();
+	}
+}
+
 void PlaybackDataView::RemovePlayback(const StoredGame& replay)
 {
 	RemoveItem(replay);
@@ -19,6 +19,8 @@ public:
 	virtual ~PlaybackDataView();
 
 	void AddPlayback(const StoredGame& replay, bool resortIsNeeded = true);
+	//! adds the playbacks not listed yet and resorts once
+	void AddPlaybacks(const std::vector<const StoredGame*>& replays);
 	void RemovePlayback(const StoredGame& replay);
 	void OnContextMenu(wxDataViewEvent& event);
 	void OnDLMap(wxCommandEvent& event);
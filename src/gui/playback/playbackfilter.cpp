@@ -328,7 +328,7 @@ bool PlaybackListFilter::FilterPlayback(const StoredGame& playback)
 
 	const OfflineBattle& battle = playback.battle;
 	//Player Check
-	if ((m_filter_player_choice_value != -1) && !_IntCompare(battle.GetNumUsers() - battle.GetSpectators(), m_filter_player_choice_value, m_filter_player_mode))
+	if ((m_filter_player_choice_value != -1) && !_IntCompare(playback.playernum, m_filter_player_choice_value, m_filter_player_mode))
 		return false;
 
 	//Only Maps i have Check
@@ -10,8 +10,10 @@
 #include <wx/sizer.h>
 #include <wx/statline.h>
 #include <wx/stattext.h>
+#include <wx/textctrl.h>
 #include <wx/textdlg.h>
 #include <wx/tglbtn.h>
+#include <boost/thread/thread.hpp>
 
 #include "exception.h"
 #include "gui/chatpanel.h"
@@ -28,8 +30,17 @@
 #include "replaylist.h"
 #include "storedgame.h"
 #include "utils/conversion.h"
+#include "utils/dirwatcher.h"
 #include "utils/globalevents.h"
 #include "utils/slconfig.h"
+#include "utils/slpaths.h"
+
+//! how often the demo directory is checked for changes, in ms
+static const int WATCH_INTERVAL = 2000;
+//! same without inotify, each check lists the whole directory
+static const int POLL_INTERVAL = 15000;
+
+static const wxEventType DemoScannedEvt = wxNewEventType();
 
 BEGIN_EVENT_TABLE(PlaybackTab, wxPanel)
 EVT_BUTTON(PLAYBACK_WATCH, PlaybackTab::OnWatch)
@@ -38,14 +49,23 @@ EVT_BUTTON(PLAYBACK_DELETE, PlaybackTab::OnDelete)
 EVT_DATAVIEW_SELECTION_CHANGED(PlaybackDataView::REPLAY_DATAVIEW_ID, PlaybackTab::OnSelect)
 EVT_CHECKBOX(PLAYBACK_LIST_FILTER_ACTIV, PlaybackTab::OnFilterActiv)
 EVT_COMMAND(wxID_ANY, PlaybackLoader::PlaybacksLoadedEvt, PlaybackTab::AddAllPlaybacks)
+EVT_COMMAND(wxID_ANY, PlaybackLoader::PlaybacksBatchEvt, PlaybackTab::AddLoadedPlaybacks)
+EVT_COMMAND(wxID_ANY, DemoScannedEvt, PlaybackTab::OnDemoScanned)
 EVT_KEY_DOWN(PlaybackTab::OnChar)
+EVT_TIMER(PLAYBACK_TIMER, PlaybackTab::OnWatchTimer)
 EVT_TOGGLEORCHECK(PLAYBACK_LIST_FILTER_BUTTON, PlaybackTab::OnFilter)
 END_EVENT_TABLE()
 
 PlaybackTab::PlaybackTab(wxWindow* parent, bool replay)
     : wxPanel(parent, -1)
     , m_replay_loader(0)
+    , m_watcher(NULL)
+    , m_watch_timer(this, PLAYBACK_TIMER)
+    , m_reload_wanted(false)
     , m_isreplay(replay)
+    , m_scan_thread(NULL)
+    , m_scan_wanted(-1)
+    , m_scan_id(0)
 {
 	wxLogMessage(_T( "PlaybackTab::PlaybackTab()" ));
 
@@ -60,8 +80,10 @@ PlaybackTab::PlaybackTab(wxWindow* parent, bool replay)
 	m_game_text    = new wxStaticText(this, wxID_ANY, wxEmptyString);
 	m_engine_lbl   = new wxStaticText(this, wxID_ANY, _("Engine:"));
 	m_engine_text  = new wxStaticText(this, wxID_ANY, wxEmptyString);
+	m_winners_lbl  = new wxStaticText(this, wxID_ANY, _("Winners:"));
+	m_winners_text = new wxStaticText(this, wxID_ANY, wxEmptyString);
 
-	wxFlexGridSizer* m_data_sizer = new wxFlexGridSizer(4, 2, 0, 0);
+	wxFlexGridSizer* m_data_sizer = new wxFlexGridSizer(5, 2, 0, 0);
 	m_data_sizer->Add(m_map_lbl, 1, wxALL | wxEXPAND, 5);
 	m_data_sizer->Add(m_map_text, 1, wxALL | wxEXPAND, 5);
 	m_data_sizer->Add(m_game_lbl, 1, wxALL | wxEXPAND, 5);
@@ -70,6 +92,10 @@ PlaybackTab::PlaybackTab(wxWindow* parent, bool replay)
 	m_data_sizer->Add(m_players_text, 1, wxALL | wxEXPAND, 5);
 	m_data_sizer->Add(m_engine_lbl, 1, wxALL | wxEXPAND, 5);
 	m_data_sizer->Add(m_engine_text, 1, wxALL | wxEXPAND, 5);
+	m_data_sizer->Add(m_winners_lbl, 1, wxALL | wxEXPAND, 5);
+	m_data_sizer->Add(m_winners_text, 1, wxALL | wxEXPAND, 5);
+
+	m_chat_text = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY | wxTE_RICH);
 
 	m_players = new BattleroomDataViewCtrl("playback_battleroom_view", this, nullptr /*battle*/, true /*readonly*/, false /*show ingname status*/);
 
@@ -77,6 +103,7 @@ PlaybackTab::PlaybackTab(wxWindow* parent, bool replay)
 	m_info_sizer->Add(m_minimap, 0, wxALL, 5);
 	m_info_sizer->Add(m_data_sizer, 1, wxEXPAND | wxALL, 0);
 	m_info_sizer->Add(m_players, 2, wxALL | wxEXPAND, 0);
+	m_info_sizer->Add(m_chat_text, 2, wxALL | wxEXPAND, 0);
 
 
 	m_filter_show = new wxToggleOrCheck(this, PLAYBACK_LIST_FILTER_BUTTON, _(" Filter "), wxDefaultPosition, wxSize(-1, 28), 0);
@@ -120,24 +147,67 @@ PlaybackTab::PlaybackTab(wxWindow* parent, bool replay)
 PlaybackTab::~PlaybackTab()
 {
 	GlobalEventManager::Instance()->UnSubscribeAll(this);
+	m_watch_timer.Stop();
+	delete m_watcher;
+	if (m_scan_thread != NULL) {
+		m_scan_thread->join();
+		delete m_scan_thread;
+	}
 
 	m_minimap->SetBattle(NULL);
 	if (m_filter != 0)
 		m_filter->SaveFilterValues();
 	delete m_replay_loader;
+	// the summaries scanned since the last full batch
+	replaylist().SaveScans();
 
 	wxLogDebug("");
 }
 
-void PlaybackTab::AddAllPlaybacks(wxCommandEvent& /*unused*/)
+void PlaybackTab::AddAllPlaybacks(wxCommandEvent& event)
 {
 	assert(wxThread::IsMain());
-	const auto& replays = replaylist().GetPlaybacksMap();
+	// the last of them are still pending
+	AddLoadedPlaybacks(event);
+	m_replay_loader->Finished();
+	if (m_reload_wanted) {
+		ReloadList();
+		return;
+	}
+	// deleting was disabled while loading
+	m_delete_btn->Enable(m_replay_dataview->GetSelectedItem() != nullptr);
+}
 
-	for (auto i = replays.begin(); i != replays.end(); ++i) {
-		AddPlayback(i->second, false);
+void PlaybackTab::AddLoadedPlaybacks(wxCommandEvent& /*unused*/)
+{
+	assert(wxThread::IsMain());
+	if (m_replay_loader == nullptr)
+		return;
+	// the loader read them detached, the list is only modified here
+	std::vector<StoredGame> loaded = m_replay_loader->TakeLoaded();
+	const std::vector<size_t> ids = replaylist().InsertPlaybacks(loaded);
+	std::vector<const StoredGame*> items;
+	items.reserve(ids.size());
+
+	for (size_t id : ids) {
+		if (replaylist().PlaybackExists(id)) {
+			items.push_back(&replaylist().GetPlaybackById(id));
+		}
 	}
-	m_replay_dataview->Resort();
+	AddPlaybacks(items);
+}
+
+void PlaybackTab::AddPlaybacks(const std::vector<const StoredGame*>& replays)
+{
+	std::vector<const StoredGame*> items;
+	items.reserve(replays.size());
+
+	for (const StoredGame* replay : replays) {
+		if (!m_filter->GetActiv() || m_filter->FilterPlayback(*replay)) {
+			items.push_back(replay);
+		}
+	}
+	m_replay_dataview->AddPlaybacks(items);
 }
 
 void PlaybackTab::AddPlayback(const StoredGame& replay, bool resortIsNeeded)
@@ -219,6 +289,7 @@ void PlaybackTab::OnWatch(wxCommandEvent& /*unused*/)
 	wxString type = m_isreplay ? _("replay") : _("savegame");
 	wxLogMessage(_T( "Watching %s %d " ), type.c_str(), m_sel_replay_id);
 	StoredGame& rep = replaylist().GetPlaybackById(m_sel_replay_id);
+	replaylist().LoadDetails(rep);
 	if (ui().NeedsDownload(&rep.battle)) {
 		return;
 	}
@@ -236,6 +307,19 @@ void PlaybackTab::AskForceWatch(StoredGame& rep) const
 
 void PlaybackTab::OnDelete(wxCommandEvent& /*unused*/)
 {
+	DeleteSelected();
+}
+
+bool PlaybackTab::IsLoading() const
+{
+	return (m_replay_loader != nullptr) && m_replay_loader->IsRunning();
+}
+
+void PlaybackTab::DeleteSelected()
+{
+	// the loader thread works on the list
+	if (IsLoading())
+		return;
 	m_replay_dataview->DeletePlayback();
 	Deselect();
 }
@@ -254,11 +338,12 @@ void PlaybackTab::OnSelect(wxDataViewEvent& event)
 	} else {
 		try {
 			m_watch_btn->Enable(true);
-			m_delete_btn->Enable(true);
+			m_delete_btn->Enable(!IsLoading());
 
 			//this might seem a bit backwards, but it's currently the only way that doesn't involve casting away constness
 			int m_sel_replay_id = storedGame->id;
 			StoredGame& rep = replaylist().GetPlaybackById(m_sel_replay_id);
+			replaylist().LoadDetails(rep);
 
 			m_players_text->SetLabel(wxEmptyString);
 			m_map_text->SetLabel(TowxString(rep.battle.GetHostMapName()));
@@ -267,6 +352,11 @@ void PlaybackTab::OnSelect(wxDataViewEvent& event)
 			m_minimap->SetBattle(&(rep.battle));
 			m_minimap->UpdateMinimap();
 
+			ShowDemoSummary(rep);
+			if (!rep.demo.scanned && (rep.type == StoredGame::REPLAY)) {
+				RequestScan(rep);
+			}
+
 			m_players->Clear();
 			m_players->SetBattle((IBattle*)&rep.battle);
 			for (size_t i = 0; i < rep.battle.GetNumUsers(); ++i) {
@@ -283,6 +373,100 @@ void PlaybackTab::OnSelect(wxDataViewEvent& event)
 	}
 }
 
+void PlaybackTab::ShowDemoSummary(StoredGame& rep)
+{
+	const DemoSummary& demo = rep.demo;
+	wxString winners;
+	if (!demo.gameover) {
+		winners = demo.scanned ? _("Game didn't end") : wxString();
+	} else if (demo.winners.empty()) {
+		winners = _("Draw");
+	} else {
+		for (int ally : demo.winners) {
+			wxString names;
+			for (size_t i = 0; i < rep.battle.GetNumUsers(); ++i) {
+				const UserBattleStatus& status = rep.battle.GetUser(i).BattleStatus();
+				if (!status.spectator && (status.ally == ally)) {
+					names += (names.empty() ? _T("") : _T(", ")) + TowxString(rep.battle.GetUser(i).GetNick());
+				}
+			}
+			if (!winners.empty())
+				winners += _T("; ");
+			winners += names.empty() ? wxString::Format(_("Ally team %d"), ally + 1) : names;
+		}
+	}
+	m_winners_text->SetLabel(winners);
+
+	wxString chat;
+	for (const DemoSummary::ChatMessage& message : demo.chat) {
+		chat += wxString::Format(_T("[%02d:%02d] "), message.time / 60, message.time % 60);
+		if (message.from == DemoSummary::FROM_SERVER) {
+			chat += _T("* ");
+		} else if (!message.from_name.empty()) {
+			chat += _T("<") + TowxString(message.from_name) + _T("> ");
+		} else {
+			chat += wxString::Format(_T("<%d> "), message.from);
+		}
+		if (message.dest == DemoSummary::TO_ALLIES) {
+			chat += _("(allies) ");
+		} else if (message.dest == DemoSummary::TO_SPECTATORS) {
+			chat += _("(spectators) ");
+		} else if (message.dest < DemoSummary::TO_ALLIES) {
+			chat += _("(private) ");
+		}
+		chat += TowxString(message.text) + _T("\n");
+	}
+	m_chat_text->ChangeValue(chat);
+}
+
+void PlaybackTab::RequestScan(const StoredGame& rep)
+{
+	m_scan_wanted = rep.id;
+	if (m_scan_thread == NULL) {
+		StartScan();
+	}
+}
+
+void PlaybackTab::StartScan()
+{
+	if ((m_scan_wanted < 0) || !replaylist().PlaybackExists(m_scan_wanted)) {
+		m_scan_wanted = -1;
+		return;
+	}
+	m_scan_id = m_scan_wanted;
+	m_scan_wanted = -1;
+	m_scan_path = replaylist().GetPlaybackById(m_scan_id).battle.GetPlayBackFilePath();
+	m_scan_result = DemoSummary();
+	const std::string path = m_scan_path;
+	m_scan_thread = new boost::thread([this, path]() {
+		replaylist().ScanDemo(path, m_scan_result);
+		wxCommandEvent notice(DemoScannedEvt);
+		wxPostEvent(this, notice);
+	});
+}
+
+void PlaybackTab::OnDemoScanned(wxCommandEvent& /*unused*/)
+{
+	assert(wxThread::IsMain());
+	m_scan_thread->join();
+	delete m_scan_thread;
+	m_scan_thread = NULL;
+
+	// the list might have been reloaded meanwhile
+	if (replaylist().PlaybackExists(m_scan_id)) {
+		StoredGame& rep = replaylist().GetPlaybackById(m_scan_id);
+		if (rep.battle.GetPlayBackFilePath() == m_scan_path) {
+			rep.demo = m_scan_result;
+			// unreadable ones aren't tried again on every selection
+			rep.demo.scanned = true;
+			if (m_replay_dataview->GetSelectedItem() == &rep) {
+				ShowDemoSummary(rep);
+			}
+		}
+	}
+	StartScan();
+}
+
 void PlaybackTab::Deselect()
 {
 	m_replay_dataview->UnselectAll();
@@ -297,6 +481,8 @@ void PlaybackTab::Deselected()
 	m_map_text->SetLabel(wxEmptyString);
 	m_game_text->SetLabel(wxEmptyString);
 	m_engine_text->SetLabel(wxEmptyString);
+	m_winners_text->SetLabel(wxEmptyString);
+	m_chat_text->Clear();
 	m_minimap->SetBattle(NULL);
 	m_minimap->UpdateMinimap();
 	m_minimap->Refresh();
@@ -304,20 +490,97 @@ void PlaybackTab::Deselected()
 	m_players->SetBattle(NULL);
 }
 
+std::string PlaybackTab::GetDemoDir()
+{
+	return SlPaths::GetDataDir() + "demos";
+}
+
 void PlaybackTab::ReloadList()
 {
 	if (!LSL::usync().IsLoaded()) {
 		wxLogWarning(_("Unitsync library required"));
 		return;
 	}
+	// the loader thread reads the list, it's reloaded once it's done
+	if (IsLoading()) {
+		m_reload_wanted = true;
+		return;
+	}
+	m_reload_wanted = false;
 	Deselect();
 	m_replay_dataview->Clear();
+	m_scan_wanted = -1;
+	replaylist().RemoveAll();
 	if (m_replay_loader == nullptr) {
 		m_replay_loader = new PlaybackLoader(this, true);
 	}
+
+	// started before listing, changes made meanwhile are applied once the loader is done
+	m_watch_timer.Stop();
+	delete m_watcher;
+	m_unsettled.clear();
+	m_watch_dir = GetDemoDir();
+	const std::vector<std::string> dirs(1, m_watch_dir);
+	const std::vector<std::string> extensions = {".sdfz", ".sdf"};
+	m_watcher = new DirWatcher(dirs, extensions);
+	m_watch_timer.Start(m_watcher->IsNative() ? WATCH_INTERVAL : POLL_INTERVAL);
+
 	m_replay_loader->Run();
 }
 
+void PlaybackTab::UpdateChangedPlaybacks(bool settled)
+{
+	assert(wxThread::IsMain());
+	if ((m_watcher == NULL) || IsLoading())
+		return;
+	const std::vector<DirWatcher::Change> changes = m_watcher->Poll();
+	if (changes.empty() && m_unsettled.empty())
+		return;
+
+	const StoredGame* selected = m_replay_dataview->GetSelectedItem();
+	std::set<std::string> changed;
+	for (const DirWatcher::Change& change : changes) {
+		changed.insert(change.path);
+		if (change.type == DirWatcher::REMOVED) {
+			m_unsettled.erase(change.path);
+		} else {
+			m_unsettled.insert(change.path);
+		}
+		// modified ones are parsed again, added ones might have been listed while being written
+		const int id = replaylist().FindPlayback(change.path);
+		if (id < 0)
+			continue;
+		const StoredGame& replay = replaylist().GetPlaybackById(id);
+		if (&replay == selected) {
+			Deselect();
+		}
+		if (m_replay_dataview->ContainsItem(replay)) {
+			m_replay_dataview->RemovePlayback(replay);
+		}
+		replaylist().RemovePlayback(id);
+	}
+	if (!changes.empty()) {
+		wxLogMessage(_T("%lu replays changed on disk"), changes.size());
+	}
+
+	// a demo which changed again since the last check is still being written
+	std::set<std::string> filenames;
+	for (const std::string& path : m_unsettled) {
+		if (settled || (changed.count(path) == 0)) {
+			filenames.insert(path);
+		}
+	}
+	for (const std::string& path : filenames) {
+		m_unsettled.erase(path);
+	}
+	m_replay_loader->Add(filenames);
+}
+
+void PlaybackTab::OnWatchTimer(wxTimerEvent& /*unused*/)
+{
+	UpdateChangedPlaybacks();
+}
+
 void PlaybackTab::OnReload(wxCommandEvent& /*unused*/)
 {
 	ReloadList();
@@ -325,20 +588,29 @@ void PlaybackTab::OnReload(wxCommandEvent& /*unused*/)
 
 void PlaybackTab::OnSpringTerminated(wxCommandEvent& /*data*/)
 {
-	ReloadList();
+	// only the new replay has to be parsed, it's complete now
+	if (m_watcher != NULL) {
+		UpdateChangedPlaybacks(true);
+	} else {
+		ReloadList();
+	}
 }
 
 void PlaybackTab::OnUnitsyncReloaded(wxCommandEvent& /*data*/)
 {
-	ReloadList();
+	// the list is kept up to date by the watcher, unless the demo directory moved
+	if ((m_watcher != NULL) && (m_watch_dir == GetDemoDir())) {
+		UpdateChangedPlaybacks();
+	} else {
+		ReloadList();
+	}
 }
 
 void PlaybackTab::OnChar(wxKeyEvent& event)
 {
 	const int keyCode = event.GetKeyCode();
 	if (keyCode == WXK_DELETE) {
-		m_replay_dataview->DeletePlayback();
-		Deselect();
+		DeleteSelected();
 	} else {
 		event.Skip();
 	}
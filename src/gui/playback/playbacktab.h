@@ -4,8 +4,16 @@
 #define SPRINGLOBBY_PlaybackTab_H_INCLUDED
 
 #include <wx/scrolwin.h>
+#include <wx/timer.h>
+#include <set>
+#include <string>
 #include <vector>
 #include "gui/controls.h"
+#include "utils/demoscanner.h"
+namespace boost
+{
+class thread;
+}
 class Ui;
 class MapCtrl;
 class BattleroomListCtrl;
@@ -18,12 +26,14 @@ class wxButton;
 class wxBoxSizer;
 class wxStaticText;
 class wxStaticLine;
+class wxTextCtrl;
 class wxToggleButton;
 struct StoredGame;
 class PlaybackLoader;
 class PlaybackListFilter;
 class PlaybackDataView;
 class BattleroomDataViewCtrl;
+class DirWatcher;
 
 class PlaybackTab : public wxPanel
 {
@@ -38,13 +48,25 @@ public:
 
 	//! adds a single replay to listctrl
 	void AddPlayback(const StoredGame& Replay, bool resortIsNeeded = true);
+	//! adds the replays which pass the filter and aren't listed yet, resorts once
+	void AddPlaybacks(const std::vector<const StoredGame*>& replays);
 	void RemovePlayback(const StoredGame& Replay);
 	void UpdatePlayback(const StoredGame& Replay);
 
-	//! add all replays in m_replays to listctrl
+	//! the loader is done, adds the last replays it read
 	void AddAllPlaybacks(wxCommandEvent& evt);
+	//! lists the replays the loader read so far and adds them to the listctrl
+	void AddLoadedPlaybacks(wxCommandEvent& evt);
 	void RemoveAllPlaybacks();
+	//! parses all replays anew and starts watching the demo directory, after the running loader
 	void ReloadList();
+	/** adds, removes and parses again the replays which changed on disk
+	 *
+	 * Parsing runs on the loader thread. Files which changed again since the
+	 * last call are still being written and wait for the next one, unless
+	 * settled is true.
+	 */
+	void UpdateChangedPlaybacks(bool settled = false);
 
 	void UpdateList();
 
@@ -52,7 +74,7 @@ public:
 	void OnWatch(wxCommandEvent& event);
 	//! clears list and parses all replays anew
 	void OnReload(wxCommandEvent& event);
-	//! does nothing yet
+	//! deletes the selected replay, unless the list is being loaded
 	void OnDelete(wxCommandEvent& event);
 	//! does nothing yet
 	void OnFilter(wxCommandEvent& event);
@@ -72,9 +94,19 @@ public:
 
 private:
 	void OnChar(wxKeyEvent& event);
+	void OnWatchTimer(wxTimerEvent& event);
+	//! the loader thread reads the replay list, it mustn't be modified
+	bool IsLoading() const;
+	static std::string GetDemoDir();
+	void DeleteSelected();
 	PlaybackListFilter* m_filter;
 	PlaybackDataView* m_replay_dataview;
 	PlaybackLoader* m_replay_loader;
+	DirWatcher* m_watcher;
+	std::string m_watch_dir;
+	std::set<std::string> m_unsettled; //!< changed files, not parsed yet
+	wxTimer m_watch_timer;
+	bool m_reload_wanted; //!< ReloadList() was called while loading
 	MapCtrl* m_minimap;
 	wxStaticText* m_engine_lbl;
 	wxStaticText* m_engine_text;
@@ -84,6 +116,9 @@ private:
 	wxStaticText* m_game_text;
 	wxStaticText* m_players_lbl;
 	wxStaticText* m_players_text;
+	wxStaticText* m_winners_lbl;
+	wxStaticText* m_winners_text;
+	wxTextCtrl* m_chat_text;
 
 	wxStaticLine* m_buttons_sep;
 	wxButton* m_watch_btn;
@@ -97,6 +132,19 @@ private:
 	wxToggleOrCheck* m_filter_show;
 
 	void AskForceWatch(StoredGame& rep) const;
+	//! shows winners and chat read from the demo stream
+	void ShowDemoSummary(StoredGame& rep);
+
+	//! reads the demo stream of the replay in the background, the last request wins
+	void RequestScan(const StoredGame& rep);
+	void StartScan();
+	//! applies the summary read by m_scan_thread
+	void OnDemoScanned(wxCommandEvent& event);
+	boost::thread* m_scan_thread;
+	int m_scan_wanted; //!< id of the replay to scan next, -1 if none
+	unsigned int m_scan_id;
+	std::string m_scan_path;
+	DemoSummary m_scan_result; //!< only touched by the thread until it's joined
 
 	DECLARE_EVENT_TABLE()
 };
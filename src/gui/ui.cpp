@@ -17,6 +17,7 @@
 #include <wx/textdlg.h>
 #include <wx/utils.h>
 #include <stdexcept>
+#include <vector>
 
 #include "channel.h"
 #include "downloader/prdownloader.h"
@@ -161,9 +162,12 @@ void Ui::ReopenServerTab()
 		AddServerWindow(TowxString(m_serv->GetServerName()));
 		// re-add all users to the user list
 		const UserList& list = m_serv->GetUserList();
+		std::vector<User*> users;
+		users.reserve(list.GetNumUsers());
 		for (unsigned int i = 0; i < list.GetNumUsers(); i++) {
-			m_serv->panel->OnChannelJoin(list.GetUser(i));
+			users.push_back(&list.GetUser(i));
 		}
+		m_serv->panel->OnChannelJoinMany(users);
 	}
 }
 
@@ -583,6 +587,16 @@ void Ui::OnBattleInfoUpdated(IBattle& battle, const wxString& Tag)
 	}
 }
 
+void Ui::OnBattleInfoUpdated(IBattle& battle, const std::vector<wxString>& Tags)
+{
+	if (m_main_win == 0)
+		return;
+	mw().GetBattleListTab().UpdateBattle(battle);
+	if (mw().GetJoinTab().GetCurrentBattle() == &battle) {
+		mw().GetJoinTab().UpdateCurrentBattle(Tags);
+	}
+}
+
 void Ui::OnJoinedBattle(IBattle& battle)
 {
 	if (m_main_win == 0)
@@ -17,6 +17,7 @@ class wxEvtHandler;
 
 #include <wx/string.h>
 #include <wx/timer.h>
+#include <vector>
 #include "downloader/prdownloader.h"
 #include "utils/mixins.h"
 //! @brief UI main class
@@ -84,6 +85,8 @@ public:
 	void OnUserJoinedBattle(IBattle& battle, User& user);
 	void OnUserLeftBattle(IBattle& battle, User& user, bool isbot);
 	void OnBattleInfoUpdated(IBattle& battle, const wxString& Tag);
+	//! only the options in Tags changed
+	void OnBattleInfoUpdated(IBattle& battle, const std::vector<wxString>& Tags);
 
 	void OnJoinedBattle(IBattle& battle);
 	void OnHostedBattle(IBattle& battle);
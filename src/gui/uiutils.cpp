@@ -22,6 +22,7 @@
 #include "log.h"
 #include "settings.h"
 #include "utils/conversion.h"
+#include "utils/imageblend.h"
 
 bool AreColoursSimilar(const LSL::lslColor& col1, const LSL::lslColor& col2, int mindiff)
 {
@@ -105,7 +106,7 @@ wxImage BlendImage(const wxImage& foreground, const wxImage& background, bool bl
 
 	bool zhu = blend_alpha && background.HasAlpha();
 	if (foreground.HasAlpha()) {
-		wxImage ret(background.GetWidth(), foreground.GetHeight());
+		wxImage ret(background.GetWidth(), foreground.GetHeight(), false /*every pixel is written*/);
 		const unsigned char* background_data = background.GetData();
 		const unsigned char* foreground_data = foreground.GetData();
 		const unsigned char* background_alpha = NULL;
@@ -114,25 +115,13 @@ wxImage BlendImage(const wxImage& foreground, const wxImage& background, bool bl
 		unsigned char* result_alpha = NULL;
 		unsigned int pixel_count = background.GetWidth() * background.GetHeight();
 
+		ImageBlend::BlendRGB(foreground_data, foreground_alpha, background_data, result_data, pixel_count);
 		if (zhu) {
 			background_alpha = background.GetAlpha();
 			ret.InitAlpha();
 			result_alpha = ret.GetAlpha();
-		}
-
-		for (unsigned int i = 0, i_a = 0; i < pixel_count * 3; i += 3, i_a++) {
-			unsigned char fore_alpha = foreground_alpha[i_a];
-			float back_blend_fac = (255 - fore_alpha) / 255.0;
-			float fore_blend_fac = fore_alpha / 255.0;
-
-			result_data[i] = foreground_data[i] * fore_blend_fac + background_data[i] * back_blend_fac;
-			result_data[i + 1] = foreground_data[i + 1] * fore_blend_fac + background_data[i + 1] * back_blend_fac;
-			result_data[i + 2] = foreground_data[i + 2] * fore_blend_fac + background_data[i + 2] * back_blend_fac;
-
-			if (zhu) {
-				unsigned char back_alpha = background_alpha[i_a];
-				result_alpha[i_a] = fore_alpha * fore_blend_fac + back_alpha * back_blend_fac;
-			}
+			// the foreground alpha is blended with itself as weight
+			ImageBlend::Blend(foreground_alpha, background_alpha, foreground_alpha, result_alpha, pixel_count);
 		}
 		return ret;
 	}
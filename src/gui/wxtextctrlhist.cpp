@@ -1,13 +1,13 @@
 /* This file is part of the Springlobby (GPL v2 or later), see COPYING */
 #include "wxtextctrlhist.h"
 
-#include <wx/regex.h>
+#include <algorithm>
+
 
 #include "gui/mainchattab.h"
 #include "gui/mainwindow.h"
 #include "gui/ui.h"
 #include "settings.h"
-#include "utils/misc.h"
 #include "utils/TextCompletionDatabase.h"
 
 BEGIN_EVENT_TABLE(wxTextCtrlHist, wxTextCtrl)
@@ -15,18 +15,67 @@ EVT_TEXT_ENTER(wxID_ANY, wxTextCtrlHist::OnSendMessage)
 EVT_KEY_DOWN(wxTextCtrlHist::OnChar)
 END_EVENT_TABLE()
 
-void GetArrayStringFromHashMap(const HashMap_String_String& hm, wxArrayString& matches)
-{
-	for (HashMap_String_String::const_iterator it = hm.begin(); it != hm.end(); ++it)
-		matches.Add(it->second);
-}
-
 wxTextCtrlHist::wxTextCtrlHist(TextCompletionDatabase& textDb, wxWindow* parent, wxWindowID id, const wxString& value, const wxPoint& pos, const wxSize& size, long /*unused*/)
     : wxTextCtrl(parent, id, value, pos, size, wxTE_PROCESS_ENTER | wxTE_PROCESS_TAB)
     , textcompletiondatabase(textDb)
     , current_pos(0)
     , history_max(32)
+    , m_completion_index(0)
+    , m_completion_start(0)
+{
+}
+
+static bool IsCompletionChar(wxChar c)
+{
+	return wxIsalnum(c) || (c == '_') || (c == '[') || (c == ']');
+}
+
+void wxTextCtrlHist::ReplaceWord(long start, long end, const wxString& word)
+{
+	const wxString text = GetValue();
+	ChangeValue(text.Left(start) + word + text.Mid(end));
+	SetInsertionPoint(start + word.length());
+}
+
+void wxTextCtrlHist::CompleteWord(bool forward)
 {
+	const long cursor = GetInsertionPoint();
+
+	// tab again right after a completion cycles through the candidates
+	if (!m_completions.IsEmpty() && (GetValue() == m_completion_value) && (cursor == m_completion_start + (long)m_completions[m_completion_index].length())) {
+		const size_t count = m_completions.GetCount();
+		m_completion_index = (m_completion_index + (forward ? 1 : count - 1)) % count;
+		ReplaceWord(m_completion_start, cursor, m_completions[m_completion_index]);
+		m_completion_value = GetValue();
+		return;
+	}
+	m_completions.Clear();
+
+	const wxString text = GetValue();
+	long start = std::min(cursor, (long)text.length());
+	while ((start > 0) && IsCompletionChar(text[start - 1])) {
+		start--;
+	}
+	wxArrayString matches;
+	if ((start == cursor) || (textcompletiondatabase.GetMatches(text.Mid(start, cursor - start), matches) == 0)) {
+		wxBell();
+		return;
+	}
+
+	if (matches.GetCount() == 1) {
+		ReplaceWord(start, cursor, matches[0]);
+		return;
+	}
+	//match nearest only makes sense when there's actually more than one match
+	if (sett().GetCompletionMethod() != Settings::MatchNearest) {
+		wxBell();
+		return;
+	}
+	m_completions = matches;
+	m_completion_index = forward ? 0 : matches.GetCount() - 1;
+	m_completion_start = start;
+	ReplaceWord(start, cursor, m_completions[m_completion_index]);
+	m_completion_value = GetValue();
 }
 
 void wxTextCtrlHist::OnSendMessage(wxCommandEvent& event)
@@ -78,79 +127,7 @@ void wxTextCtrlHist::OnChar(wxKeyEvent& event)
 		if ((modifier & wxMOD_CONTROL) != 0) {
 			ui().mw().GetChatTab().AdvanceSelection((modifier & wxMOD_SHIFT) == 0);
 		} else {
-			wxString text = this->GetValue();
-			long pos_Cursor = this->GetInsertionPoint();
-			wxString selection_Begin_InsertPos = this->GetRange(0, pos_Cursor);
-			wxString selection_InsertPos_End = this->GetRange(pos_Cursor, this->GetLastPosition());
-
-			// Search for the shortest Match, starting from the Insertionpoint to the left, until we find a "\ "
-			// Special Characters according to regular Expression Syntax needs to be escaped: [,]
-			wxRegEx regex_currentWord;
-#ifdef wxHAS_REGEX_ADVANCED
-			regex_currentWord.Compile(wxT("(_|\\[|\\]|\\w)+$"), wxRE_ADVANCED);
-#else
-			regex_currentWord.Compile(wxT("(_|\\[|\\]|\\w)+$"), wxRE_EXTENDED);
-#endif
-
-			if (regex_currentWord.Matches(selection_Begin_InsertPos)) {
-				wxString currentWord = regex_currentWord.GetMatch(selection_Begin_InsertPos);
-				// std::cout << "#########: Current Word: (" << currentWord.char_str() << ")" << std::endl;
-
-				wxString selection_Begin_BeforeCurrentWord = this->GetRange(0, pos_Cursor - currentWord.length());
-				// std::cout << "#########: selection_Begin_BeforeCurrentWord: (" << selection_Begin_BeforeCurrentWord.char_str() << ")" << std::endl;
-
-				HashMap_String_String hm = textcompletiondatabase.GetMapping(currentWord);
-
-				// std::cout << "#########: Mapping-Size: (" << hm.size() << ")" << std::endl;
-
-				wxString completed_Text;
-				int new_Cursor_Pos = 0;
-				if (hm.size() == 1) {
-					completed_Text.append(selection_Begin_BeforeCurrentWord);
-					completed_Text.append(hm.begin()->second);
-					completed_Text.append(selection_InsertPos_End);
-					new_Cursor_Pos = selection_Begin_BeforeCurrentWord.length() + hm.begin()->second.length();
-				} else {
-					//match nearest only makes sense when there's actually more than one match
-					if (hm.size() > 1 && sett().GetCompletionMethod() == Settings::MatchNearest) {
-						wxArrayString matches;
-						GetArrayStringFromHashMap(hm, matches);
-						wxString newWord = GetBestMatch(matches, currentWord);
-
-						bool realCompletion = newWord.Len() >= currentWord.Len(); // otherwise we have actually less word than before :P
-						if (realCompletion)
-							currentWord = newWord;
-
-						completed_Text.append(selection_Begin_BeforeCurrentWord);
-						completed_Text.append(currentWord);
-						completed_Text.append(selection_InsertPos_End);
-						new_Cursor_Pos = selection_Begin_BeforeCurrentWord.length() + currentWord.length();
-
-						// We ring the System Bell, to signalise the User, that no Completion was applied.
-						if (!realCompletion)
-							wxBell();
-					} else {
-						completed_Text.append(selection_Begin_BeforeCurrentWord);
-						completed_Text.append(currentWord);
-						completed_Text.append(selection_InsertPos_End);
-						new_Cursor_Pos = selection_Begin_BeforeCurrentWord.length() + currentWord.length();
-						// We ring the System Bell, to signalise the User, that no Completion was applied.
-						wxBell();
-					}
-				}
-				// Replace the old Text with our completed Text
-				// or
-				// if nothing was found remove the typed TAB, so that the User stays comfortable not to remove the TAB by himself.
-				this->ChangeValue(completed_Text);
-				this->SetInsertionPoint(new_Cursor_Pos);
-			} else {
-				wxString old_Text;
-				old_Text.append(selection_Begin_InsertPos);
-				old_Text.append(selection_InsertPos_End);
-				this->ChangeValue(old_Text);
-				this->SetInsertionPoint(selection_Begin_InsertPos.length());
-				wxBell();
-			}
+			CompleteWord((modifier & wxMOD_SHIFT) == 0);
 		}
 		return;
 	}
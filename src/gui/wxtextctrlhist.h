@@ -32,6 +32,16 @@ private:
 	int current_pos;
 	int history_max;
 	wxArrayString Historical;
+
+	//! candidates of the last tab completion, cycled by pressing tab again
+	wxArrayString m_completions;
+	size_t m_completion_index;
+	long m_completion_start;
+	wxString m_completion_value;
+
+	//! completes the word left of the cursor, forward selects the cycle direction
+	void CompleteWord(bool forward);
+	void ReplaceWord(long start, long end, const wxString& word);
 	void OnSendMessage(wxCommandEvent& event);
 	void OnChar(wxKeyEvent& event);
 	DECLARE_EVENT_TABLE()
@@ -2,113 +2,75 @@
 #include "iplaybacklist.h"
 
 #include <lslutils/globalsmanager.h>
+#include <wx/filefn.h>
+#include <wx/log.h>
 
 #include "offlinebattle.h"
 #include "storedgame.h"
 #include "utils/conversion.h"
 
-int IPlaybackList::FindPlayback(const std::string& filename) const //returns id when the filename already exists in m_replays
+void IPlaybackList::ToCache(const StoredGame& playback, bool ok, PlaybackCache::Entry& entry) const
 {
-	auto playbackId = m_replays_filename_index.find(filename);
-
-	if (playbackId != m_replays_filename_index.end()) {
-		return playbackId->second;
-	}
-
-	return -1;
+	entry.ok = ok;
+	entry.battletype = playback.battle.GetBattleType();
+	entry.duration = playback.duration;
+	entry.wallclock_duration = playback.wallclock_duration;
+	entry.date = playback.date;
+	entry.players = playback.playernum;
+	entry.date_string = playback.date_string;
+	entry.gameid = playback.gameid;
+	entry.demo = playback.demo;
+	entry.map_name = playback.battle.GetHostMapName();
+	entry.map_hash = playback.battle.GetHostMapHash();
+	entry.game_name = playback.battle.GetHostGameName();
+	entry.game_hash = playback.battle.GetHostGameHash();
+	entry.engine_name = playback.battle.GetEngineName();
+	entry.engine_version = playback.battle.GetEngineVersion();
 }
 
-void IPlaybackList::LoadPlaybacks(const std::set<std::string>& filenames)
+void IPlaybackList::FromCache(const std::string& filename, const PlaybackCache::Entry& entry, StoredGame& playback) const
 {
-	for (const std::string& filename : filenames) { //add replays which doesn't exist yet
-		const int pos = FindPlayback(filename);
-		if (pos == -1) {
-			StoredGame& playback = AddPlayback(filename);
-			GetReplayInfos(filename, playback);
-		}
-	}
-
-	if (m_replays.size() > filenames.size()) {
-		std::list<unsigned int> todel;
-		for (const auto& playback : m_replays) { //remove not re-added playbacks (deleted?!)
-			if (filenames.find(playback.second.battle.GetPlayBackFilePath()) == filenames.end()) {
-				todel.push_back(playback.first);
-			}
-		}
-
-		for (unsigned int id : todel) {
-			DeletePlayback(id);
-		}
-	}
-
-	assert(m_replays.size() == filenames.size());
-	assert(m_replays_filename_index.size() == filenames.size());
+	playback.type = (entry.battletype == BT_Savegame) ? StoredGame::SAVEGAME : StoredGame::REPLAY;
+	playback.size = entry.size; //FIXME: use longlong
+	playback.duration = entry.duration;
+	playback.wallclock_duration = entry.wallclock_duration;
+	playback.date = entry.date;
+	playback.date_string = entry.date_string;
+	playback.gameid = entry.gameid;
+	playback.demo = entry.demo;
+	playback.playernum = entry.players;
+	playback.cached = entry.ok; // broken ones would fail again
+	playback.battle.SetPlayBackFilePath(filename);
+	playback.battle.SetHostMap(entry.map_name, entry.map_hash);
+	playback.battle.SetHostGame(entry.game_name, entry.game_hash);
+	playback.battle.SetBattleType((BattleType)entry.battletype);
+	playback.battle.SetEngineName(entry.engine_name);
+	playback.battle.SetEngineVersion(entry.engine_version);
 }
 
-StoredGame& IPlaybackList::AddPlayback(const std::string& filename)
+bool IPlaybackList::ParsePlayback(const std::string& filename, StoredGame& playback) const
 {
-	const size_t replays = m_replays.size();
-	if (!PlaybackExists(replays)) { //last id should be mostly free
-		m_replays[replays].id = replays;
-		m_replays_filename_index[filename] = replays;
-		return m_replays[replays];
-	}
-
-	for (size_t i = 0; i < replays; i++) { //item was deleted, try to reuse id's / fill gaps
-		if (!PlaybackExists(i)) {
-			m_replays[i].id = i;
-			m_replays_filename_index[filename] = i;
-			return m_replays[i];
-		}
-	}
-	assert(false); //should never happen
-	return m_replays[0];
+	const bool ok = PlaybackList<StoredGame>::ParsePlayback(filename, playback);
+	playback.playernum = playback.battle.GetNumUsers() - playback.battle.GetSpectators();
+	return ok;
 }
 
-void IPlaybackList::RemovePlayback(unsigned int const id)
+std::string IPlaybackList::GetFilename(const StoredGame& playback) const
 {
-	const StoredGame& rep = m_replays[id];
-	m_replays_filename_index.erase(rep.battle.GetPlayBackFilePath());
-	m_replays.erase(id);
+	return playback.battle.GetPlayBackFilePath();
 }
 
-size_t IPlaybackList::GetNumPlaybacks() const
+void IPlaybackList::OnCacheError(const std::string& cachefile) const
 {
-	return m_replays.size();
-}
-
-StoredGame& IPlaybackList::GetPlaybackById(unsigned int const id)
-{
-	auto b = m_replays.find(id);
-	if (b == m_replays.end())
-		throw std::runtime_error("PlaybackList_Iter::GetPlayback(): no such replay");
-
-	return b->second;
-}
-
-bool IPlaybackList::PlaybackExists(unsigned int const id) const
-{
-	return m_replays.find(id) != m_replays.end();
+	wxLogWarning("Couldn't write playback cache %s", cachefile.c_str());
 }
 
 bool IPlaybackList::DeletePlayback(unsigned int const id)
 {
 	const StoredGame& rep = m_replays[id];
 	if (wxRemoveFile(TowxString(rep.battle.GetPlayBackFilePath()))) {
-		m_replays_filename_index.erase(rep.battle.GetPlayBackFilePath());
-		m_replays.erase(id);
+		RemovePlayback(id);
 		return true;
 	}
 	return false;
 }
-
-void IPlaybackList::RemoveAll()
-{
-	m_replays_filename_index.clear();
-	m_replays.clear();
-}
-
-const std::map<size_t, StoredGame>& IPlaybackList::GetPlaybacksMap() const
-{
-	return m_replays;
-}
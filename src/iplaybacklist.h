@@ -3,12 +3,11 @@
 #ifndef SL_PLAYBACKLIST_H_INCLUDED
 #define SL_PLAYBACKLIST_H_INCLUDED
 
-#include <map>
-#include <set>
 #include <wx/event.h>
 #include "storedgame.h"
+#include "utils/playbacklist.h"
 
-class IPlaybackList : public wxEvtHandler
+class IPlaybackList : public wxEvtHandler, public PlaybackList<StoredGame>
 {
 public:
 	IPlaybackList()
@@ -16,28 +15,15 @@ public:
 	{
 	}
 
-	virtual void LoadPlaybacks(const std::set<std::string>& filenames);
-
-	StoredGame& AddPlayback(const std::string& filename);
-	void RemovePlayback(unsigned int const id);
-
-	StoredGame& GetPlaybackById(unsigned int const id);
-
-	bool PlaybackExists(unsigned int const id) const;
 	bool DeletePlayback(unsigned int const id);
-	size_t GetNumPlaybacks() const;
-
-	void RemoveAll();
-
-	const std::map<size_t, StoredGame>& GetPlaybacksMap() const;
-	virtual bool GetReplayInfos(const std::string& ReplayPath, StoredGame& ret) const = 0;
 
 protected:
-	std::map<size_t, StoredGame> m_replays;
-	std::map<const std::string, size_t> m_replays_filename_index;
-
-private:
-	int FindPlayback(const std::string& filename) const;
+	//! counts the players, too
+	bool ParsePlayback(const std::string& filename, StoredGame& playback) const override;
+	std::string GetFilename(const StoredGame& playback) const override;
+	void ToCache(const StoredGame& playback, bool ok, PlaybackCache::Entry& entry) const override;
+	void FromCache(const std::string& filename, const PlaybackCache::Entry& entry, StoredGame& playback) const override;
+	void OnCacheError(const std::string& cachefile) const override;
 };
 
 #endif // SL_PLAYBACKLIST_H_INCLUDED
@@ -14,11 +14,13 @@ PlaybackLoader::PlaybackLoader(PlaybackTab* parent, bool IsReplayType)
     , m_parent(parent)
     , m_thread_loader(NULL)
     , m_isreplaytype(IsReplayType)
+    , m_running(false)
 {
 	assert(m_parent != NULL);
 }
 
 const wxEventType PlaybackLoader::PlaybacksLoadedEvt = wxNewEventType();
+const wxEventType PlaybackLoader::PlaybacksBatchEvt = wxNewEventType();
 
 PlaybackLoader::~PlaybackLoader()
 {
@@ -28,11 +30,22 @@ PlaybackLoader::~PlaybackLoader()
 void PlaybackLoader::Run()
 {
 	assert(LSL::usync().IsLoaded());
+	Start(std::set<std::string>());
+}
+
+void PlaybackLoader::Add(const std::set<std::string>& filenames)
+{
+	if (!filenames.empty())
+		Start(filenames);
+}
 
-	if (m_thread_loader)
+void PlaybackLoader::Start(const std::set<std::string>& filenames)
+{
+	if (m_running)
 		return; // a thread is already running
 
-	m_thread_loader = new PlaybackLoaderThread(this, m_parent, m_isreplaytype);
+	m_running = true;
+	m_thread_loader = new PlaybackLoaderThread(this, m_parent, m_isreplaytype, filenames);
 	m_thread_loader->Create();
 	m_thread_loader->Run();
 }
@@ -41,15 +54,43 @@ void PlaybackLoader::OnComplete()
 {
 	if (m_parent == NULL)
 		return;
+	m_thread_loader = NULL; // the thread object deletes itself
 	wxCommandEvent notice(PlaybacksLoadedEvt, 1);
 	wxPostEvent(m_parent, notice);
-	m_thread_loader = NULL; // the thread object deleted itself
 }
 
-PlaybackLoader::PlaybackLoaderThread::PlaybackLoaderThread(PlaybackLoader* loader, PlaybackTab* parent, bool isreplaytype)
+void PlaybackLoader::OnLoaded(std::vector<StoredGame>& playbacks)
+{
+	if (m_parent == NULL)
+		return;
+	bool notify;
+	{
+		wxMutexLocker lock(m_mutex);
+		// the tab takes all pending playbacks on the first event
+		notify = m_loaded.empty();
+		for (StoredGame& playback : playbacks) {
+			m_loaded.push_back(std::move(playback));
+		}
+	}
+	if (notify) {
+		wxCommandEvent notice(PlaybacksBatchEvt, 1);
+		wxPostEvent(m_parent, notice);
+	}
+}
+
+std::vector<StoredGame> PlaybackLoader::TakeLoaded()
+{
+	std::vector<StoredGame> playbacks;
+	wxMutexLocker lock(m_mutex);
+	playbacks.swap(m_loaded);
+	return playbacks;
+}
+
+PlaybackLoader::PlaybackLoaderThread::PlaybackLoaderThread(PlaybackLoader* loader, PlaybackTab* parent, bool isreplaytype, const std::set<std::string>& filenames)
     : m_parent(parent)
     , m_loader(loader)
     , m_isreplaytype(isreplaytype)
+    , m_filenames(filenames)
 {
 	assert(m_parent != NULL);
 }
@@ -57,12 +98,21 @@ PlaybackLoader::PlaybackLoaderThread::PlaybackLoaderThread(PlaybackLoader* loade
 void* PlaybackLoader::PlaybackLoaderThread::Entry()
 {
 	if (m_parent) {
-		std::set<std::string> filenames;
-		if (!LSL::usync().GetPlaybackList(filenames, m_isreplaytype)) {
-			wxLogWarning("Couldn't load list of playbacks.");
-			return nullptr;
+		PlaybackLoader* loader = m_loader;
+		const IPlaybackList::LoadedHandler loaded = [loader](std::vector<StoredGame>& playbacks) {
+			loader->OnLoaded(playbacks);
+		};
+		if (m_filenames.empty()) {
+			std::set<std::string> filenames;
+			if (LSL::usync().GetPlaybackList(filenames, m_isreplaytype)) {
+				replaylist().LoadPlaybacks(filenames, loaded);
+			} else {
+				// still completes, the tab would wait for the loader otherwise
+				wxLogWarning("Couldn't load list of playbacks.");
+			}
+		} else {
+			replaylist().AddPlaybacks(m_filenames, loaded);
 		}
-		replaylist().LoadPlaybacks(filenames);
 		m_loader->OnComplete();
 	}
 
@@ -7,6 +7,9 @@
 #include <wx/thread.h>
 #include <wx/event.h>
 #include <set>
+#include <vector>
+
+#include "storedgame.h"
 
 class PlaybackTab;
 
@@ -17,28 +20,56 @@ private:
 	class PlaybackLoaderThread : public wxThread
 	{
 	public:
-		PlaybackLoaderThread(PlaybackLoader* loader, PlaybackTab* parent, bool isreplaytype);
+		//! lists and loads all playbacks if filenames is empty
+		PlaybackLoaderThread(PlaybackLoader* loader, PlaybackTab* parent, bool isreplaytype, const std::set<std::string>& filenames);
 		void* Entry();
 
 	protected:
 		PlaybackTab* m_parent;
 		PlaybackLoader* m_loader;
 		bool m_isreplaytype;
+		std::set<std::string> m_filenames;
 	};
 
 public:
+	//! the loader thread is done, see Finished
 	static const wxEventType PlaybacksLoadedEvt;
+	//! some playbacks were read, see TakeLoaded
+	static const wxEventType PlaybacksBatchEvt;
 
 	PlaybackLoader(PlaybackTab* parent, bool IsReplayType);
 	~PlaybackLoader();
 	void OnComplete();
+	//! called from the loader thread with playbacks which aren't listed yet
+	void OnLoaded(std::vector<StoredGame>& playbacks);
+	//! the playbacks read since the last call, for IPlaybackList::InsertPlaybacks
+	std::vector<StoredGame> TakeLoaded();
+	//! the tab handled PlaybacksLoadedEvt, it took the last playbacks
+	void Finished()
+	{
+		m_running = false;
+	}
+	//! loads the whole list anew
 	void Run();
+	//! parses and adds files which were created or modified since, see IPlaybackList::AddPlaybacks
+	void Add(const std::set<std::string>& filenames);
+	/** the list mustn't be modified while the loader thread runs, until the
+	 * tab inserted all playbacks it read
+	 */
+	bool IsRunning() const
+	{
+		return m_running;
+	}
 
 private:
-	std::set<std::string> m_filenames;
+	void Start(const std::set<std::string>& filenames);
+
+	wxMutex m_mutex;
+	std::vector<StoredGame> m_loaded;
 	PlaybackTab* m_parent;
 	PlaybackLoaderThread* m_thread_loader;
 	bool m_isreplaytype;
+	bool m_running; //!< gui thread only
 };
 
 #endif // SPRINGLOBBY_HEADERGUARD_PLAYBACKTHREAD
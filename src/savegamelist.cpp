@@ -3,15 +3,20 @@
 #include "savegamelist.h"
 
 #include <wx/filename.h>
-#include <fstream>
 
 #include "storedgame.h"
 #include "utils/conversion.h"
+#include "utils/savegamescript.h"
 
 SavegameList::SavegameList()
 {
 }
 
+bool SavegameList::GetReplayInfos(const std::string& SavegamePath, StoredGame& ret) const
+{
+	return GetSavegameInfos(SavegamePath, ret);
+}
+
 
 bool SavegameList::GetSavegameInfos(const std::string& SavegamePath, StoredGame& ret) const
 {
@@ -37,16 +42,8 @@ bool SavegameList::GetSavegameInfos(const std::string& SavegamePath, StoredGame&
 
 std::string SavegameList::GetScriptFromSavegame(const std::string& SavegamePath) const
 {
-	// blatantly copied from spring source
-	std::ifstream file(SavegamePath.c_str(), std::ios::in | std::ios::binary);
+	// the script is NUL terminated at the start of the savegame, which may be compressed
 	std::string script;
-	char c;
-	if (file.is_open()) {
-		do {
-			file.read(&c, sizeof(char));
-			if (c)
-				script += c;
-		} while ((c != 0) && !file.fail());
-	}
+	ReadSavegameScript(SavegamePath, script);
 	return script;
 }
@@ -14,6 +14,7 @@ private:
 	SavegameList();
 
 private:
+	bool GetReplayInfos(const std::string& SavegamePath, StoredGame& ret) const override;
 	bool GetSavegameInfos(const std::string& SavegamePath, StoredGame& ret) const;
 	std::string GetScriptFromSavegame(const std::string& SavegamePath) const;
 };
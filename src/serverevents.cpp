@@ -16,6 +16,7 @@
 #include <lslutils/globalsmanager.h>
 #include <wx/intl.h>
 #include <wx/log.h>
+#include <wx/time.h>
 #include <exception>
 #include <locale>
 #include <sstream>
@@ -460,6 +461,8 @@ void ServerEvents::OnSetBattleInfo(int battleid, const std::string& param, const
 {
 	slLogDebugFunc("%s, %s", param.c_str(), value.c_str());
 	IBattle& battle = m_serv.GetBattle(battleid);
+	const std::map<std::string, std::string>::const_iterator previous = battle.m_script_tags.find(param);
+	const bool changed = (previous == battle.m_script_tags.end()) || (previous->second != value);
 	battle.m_script_tags[param] = value;
 	const LSL::StringVector vec = LSL::Util::StringTokenize(param, "/"); //split string by slash
 
@@ -468,17 +471,25 @@ void ServerEvents::OnSetBattleInfo(int battleid, const std::string& param, const
 			if (param.find("game/mapoptions") == 0) {
 				if (!battle.CustomBattleOptions().setSingleOption(vec[2], value, LSL::Enum::MapOption)) {
 					wxLogWarning("OnSetBattleInfo: Couldn't set map option %s", vec[2].c_str());
+				} else if (changed) {
+					m_changed_options[battleid].insert(stdprintf("%d_%s", LSL::Enum::MapOption, vec[2].c_str()));
 				}
 				return;
 			}
 			if (param.find("game/modoptions/") == 0) {
 				if (!battle.CustomBattleOptions().setSingleOption(vec[2], value, LSL::Enum::ModOption)) {
 					wxLogWarning("OnSetBattleInfo: Couldn't set game option %s", vec[2].c_str());
+				} else if (changed) {
+					m_changed_options[battleid].insert(stdprintf("%d_%s", LSL::Enum::ModOption, vec[2].c_str()));
 				}
 				return;
 			}
 			if (param.find("game/restrict") == 0) {
 				OnBattleDisableUnit(battleid, vec[2], LSL::Util::FromIntString(value));
+				if (changed) {
+					// the restrictions row isn't an option tag
+					m_full_update.insert(battleid);
+				}
 				return;
 			}
 			if (param.find("game/") == 0) { //game/team0/startposx=1692.
@@ -536,7 +547,10 @@ void ServerEvents::OnSetBattleInfo(int battleid, const std::string& param, const
 				return;
 			}
 			// i.e. game/startpostype
-			battle.CustomBattleOptions().setSingleOption(vec[1], value, LSL::Enum::EngineOption);
+			// engine options like startpostype change the minimap and the lock too, refresh everything
+			if (battle.CustomBattleOptions().setSingleOption(vec[1], value, LSL::Enum::EngineOption) && changed) {
+				m_full_update.insert(battleid);
+			}
 			return;
 		}
 			/*
@@ -549,6 +563,9 @@ void ServerEvents::OnSetBattleInfo(int battleid, const std::string& param, const
 */
 	}
 	wxLogWarning("Unhandled SETSCRIPTTAGS: %s=%s", param.c_str(), value.c_str());
+	if (changed) {
+		m_full_update.insert(battleid);
+	}
 }
 
 void ServerEvents::OnUnsetBattleInfo(int /*battleid*/, const std::string& /*param*/)
@@ -568,6 +585,30 @@ void ServerEvents::OnBattleInfoUpdated(int battleid)
 	}
 }
 
+void ServerEvents::OnBattleScriptTagsUpdated(int battleid)
+{
+	slLogDebugFunc("");
+	std::vector<wxString> tags;
+	const std::map<int, std::set<std::string> >::iterator it = m_changed_options.find(battleid);
+	if (it != m_changed_options.end()) {
+		for (const std::string& tag : it->second) {
+			tags.push_back(TowxString(tag));
+		}
+		m_changed_options.erase(it);
+	}
+	const bool full = m_full_update.erase(battleid) > 0;
+	try {
+		IBattle& battle = m_serv.GetBattle(battleid);
+		if (full) {
+			ui().OnBattleInfoUpdated(battle, wxEmptyString);
+		} else {
+			ui().OnBattleInfoUpdated(battle, tags);
+		}
+	} catch (assert_exception&) {
+		wxLogWarning("Exception in OnBattleScriptTagsUpdated(%d)", battleid);
+	}
+}
+
 
 void ServerEvents::OnBattleClosed(int battleid)
 {
@@ -686,6 +727,29 @@ void ServerEvents::OnChannelJoin(const std::string& channel, const std::string&
 	}
 }
 
+//! adds all users of a CLIENTS line at once, so the nick list is updated only once
+void ServerEvents::OnChannelJoinMany(const std::string& channel, const std::vector<std::string>& who)
+{
+	slLogDebugFunc("");
+	try {
+		int battleid = m_serv.m_battles.BattleFromChannel(channel);
+		if (battleid != -1)
+			return;
+		const wxLongLong start = wxGetLocalTimeMillis();
+		std::vector<User*> users;
+		users.reserve(who.size());
+		for (const std::string& nick : who) {
+			if (m_serv.UserExists(nick)) {
+				users.push_back(&m_serv.GetUser(nick));
+			}
+		}
+		m_serv.GetChannel(channel).OnChannelJoinMany(users);
+		const wxLongLong elapsed = wxGetLocalTimeMillis() - start;
+		wxLogDebug(_T("added %d users to channel %s in %s ms"), (int)users.size(), TowxString(channel).c_str(), elapsed.ToString().c_str());
+	} catch (std::runtime_error& except) {
+	}
+}
+
 
 void ServerEvents::OnChannelPart(const std::string& channel, const std::string& who, const std::string& message)
 {
@@ -4,6 +4,8 @@
 #define SPRINGLOBBY_HEADERGUARD_SERVEREVENTS_H
 
 #include <wx/longlong.h>
+#include <set>
+#include <vector>
 #include "ibattle.h"
 
 struct UserStatus;
@@ -59,6 +61,8 @@ public:
 	void OnSetBattleInfo(int battleid, const std::string& param, const std::string& value);
 	void OnUnsetBattleInfo(int battleid, const std::string& param);
 	void OnBattleInfoUpdated(int battleid);
+	//! a batch of OnSetBattleInfo calls is done, refreshes the changed options only
+	void OnBattleScriptTagsUpdated(int battleid);
 	void OnBattleClosed(int battleid);
 
 	void OnJoinedBattle(int battleid, const std::string& hash);
@@ -82,6 +86,7 @@ public:
 
 	void OnChannelSaid(const std::string& channel, const std::string& who, const std::string& message);
 	void OnChannelJoin(const std::string& channel, const std::string& who);
+	void OnChannelJoinMany(const std::string& channel, const std::vector<std::string>& who);
 	void OnChannelPart(const std::string& channel, const std::string& who, const std::string& message);
 	void OnChannelTopic(const std::string& channel, const std::string& who, const std::string& message);
 	void OnChannelAction(const std::string& channel, const std::string& who, const std::string& action);
@@ -140,6 +145,8 @@ public:
 private:
 	IServer& m_serv;
 	std::map<std::string, MessageSpamCheck> m_spam_check;
+	std::map<int, std::set<std::string> > m_changed_options; //!< option tags changed by OnSetBattleInfo, by battle id
+	std::set<int> m_full_update; //!< battles with changed tags which aren't plain map or game options
 	std::string m_savepath;
 };
 
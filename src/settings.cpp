@@ -57,6 +57,7 @@ Settings& sett()
 }
 
 Settings::Settings()
+    : m_chat_valid(false)
 {
 }
 
@@ -755,12 +756,13 @@ wxString Settings::GetLastScriptPassword()
 void Settings::SetChatHistoryLenght(int historylines)
 {
 	cfg().Write(_T( "/Chat/HistoryLinesLenght" ), historylines);
+	InvalidateChatSettings();
 }
 
 
 int Settings::GetChatHistoryLenght()
 {
-	return cfg().Read(_T( "/Chat/HistoryLinesLenght" ), 1000l);
+	return GetChatSettings().historylength;
 }
 
 
@@ -790,130 +792,135 @@ wxColour ConvertOldRGBFormat( wxString color )
 
 wxColour Settings::GetChatColorNormal()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Normal" ), _T( "#000000" )));
+	return GetChatSettings().normal;
 }
 
 void Settings::SetChatColorNormal(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Normal" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 
 wxColour Settings::GetChatColorBackground()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Background" ), _T( "#FFFFFF" )));
+	return GetChatSettings().background;
 }
 
 void Settings::SetChatColorBackground(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Background" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorHighlight()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Highlight" ), _T( "#FF0000" )));
+	return GetChatSettings().highlight;
 }
 
 void Settings::SetChatColorHighlight(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Highlight" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorMine()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Mine" ), _T( "#8A8A8A" )));
+	return GetChatSettings().mine;
 }
 
 void Settings::SetChatColorMine(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Mine" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorNotification()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Notification" ), _T( "#FF2828" )));
+	return GetChatSettings().notification;
 }
 
 void Settings::SetChatColorNotification(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Notification" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorAction()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Action" ), _T( "#E600FF" )));
+	return GetChatSettings().action;
 }
 
 void Settings::SetChatColorAction(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Action" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorServer()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Server" ), _T( "#005080" )));
+	return GetChatSettings().server;
 }
 
 void Settings::SetChatColorServer(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Server" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorClient()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Client" ), _T( "#14C819" )));
+	return GetChatSettings().client;
 }
 
 void Settings::SetChatColorClient(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Client" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorJoinPart()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/JoinPart" ), _T( "#42CC42" )));
+	return GetChatSettings().joinpart;
 }
 
 void Settings::SetChatColorJoinPart(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/JoinPart" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorError()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Error" ), _T( "#800000" )));
+	return GetChatSettings().error;
 }
 
 void Settings::SetChatColorError(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Error" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxColour Settings::GetChatColorTime()
 {
-	return wxColour(cfg().Read(_T( "/Chat/Colour/Time" ), _T( "#64648C" )));
+	return GetChatSettings().time;
 }
 
 void Settings::SetChatColorTime(wxColour value)
 {
 	cfg().Write(_T( "/Chat/Colour/Time" ), value.GetAsString(wxC2S_CSS_SYNTAX));
+	InvalidateChatSettings();
 }
 
 wxFont Settings::GetChatFont()
 {
-	wxString info = cfg().Read(_T( "/Chat/Font" ), wxEmptyString);
-	if (info != wxEmptyString) {
-		wxFont f(info);
-		if (f.IsOk()) {
-			return f;
-		}
-	}
-	return wxFont(8, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+	return GetChatSettings().font;
 }
 
 void Settings::SetChatFont(wxFont value)
 {
 	cfg().Write(_T( "/Chat/Font" ), value.GetNativeFontInfoDesc());
+	InvalidateChatSettings();
 }
 
 
@@ -940,11 +947,12 @@ void Settings::SetAlwaysAutoScrollOnFocusLost(bool value)
 void Settings::SetUseIrcColors(bool value)
 {
 	cfg().Write(_T( "/Chat/UseIrcColors" ), value);
+	InvalidateChatSettings();
 }
 
 bool Settings::GetUseIrcColors()
 {
-	return cfg().Read(_T( "/Chat/UseIrcColors" ), true);
+	return GetChatSettings().useirccolors;
 }
 
 void Settings::setFromList(const wxArrayString& list, const wxString& path)
@@ -982,13 +990,61 @@ void Settings::ConvertLists()
 void Settings::SetRequestAttOnHighlight(const bool req)
 {
 	cfg().Write(_T( "/Chat/ReqAttOnHighlight" ), req);
+	InvalidateChatSettings();
 }
 
 bool Settings::GetRequestAttOnHighlight()
 {
-	return cfg().Read(_T( "/Chat/ReqAttOnHighlight" ), 0l);
+	return GetChatSettings().reqattonhighlight;
+}
+
+
+const ChatSettings& Settings::GetChatSettings()
+{
+	if (!m_chat_valid) {
+		ReadChatSettings();
+		m_chat_valid = true;
+	}
+	return m_chat;
+}
+
+void Settings::InvalidateChatSettings()
+{
+	m_chat_valid = false;
 }
 
+static wxColour ReadChatColor(const wxString& key, const wxString& def)
+{
+	return wxColour(cfg().Read(key, def));
+}
+
+void Settings::ReadChatSettings()
+{
+	m_chat.normal = ReadChatColor(_T( "/Chat/Colour/Normal" ), _T( "#000000" ));
+	m_chat.background = ReadChatColor(_T( "/Chat/Colour/Background" ), _T( "#FFFFFF" ));
+	m_chat.highlight = ReadChatColor(_T( "/Chat/Colour/Highlight" ), _T( "#FF0000" ));
+	m_chat.mine = ReadChatColor(_T( "/Chat/Colour/Mine" ), _T( "#8A8A8A" ));
+	m_chat.notification = ReadChatColor(_T( "/Chat/Colour/Notification" ), _T( "#FF2828" ));
+	m_chat.action = ReadChatColor(_T( "/Chat/Colour/Action" ), _T( "#E600FF" ));
+	m_chat.server = ReadChatColor(_T( "/Chat/Colour/Server" ), _T( "#005080" ));
+	m_chat.client = ReadChatColor(_T( "/Chat/Colour/Client" ), _T( "#14C819" ));
+	m_chat.joinpart = ReadChatColor(_T( "/Chat/Colour/JoinPart" ), _T( "#42CC42" ));
+	m_chat.error = ReadChatColor(_T( "/Chat/Colour/Error" ), _T( "#800000" ));
+	m_chat.time = ReadChatColor(_T( "/Chat/Colour/Time" ), _T( "#64648C" ));
+
+	m_chat.font = wxFont(8, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+	const wxString info = cfg().Read(_T( "/Chat/Font" ), wxEmptyString);
+	if (info != wxEmptyString) {
+		wxFont f(info);
+		if (f.IsOk()) {
+			m_chat.font = f;
+		}
+	}
+
+	m_chat.historylength = cfg().Read(_T( "/Chat/HistoryLinesLenght" ), 1000l);
+	m_chat.useirccolors = cfg().Read(_T( "/Chat/UseIrcColors" ), true);
+	m_chat.reqattonhighlight = cfg().Read(_T( "/Chat/ReqAttOnHighlight" ), 0l);
+}
 
 bool Settings::GetBattleLastAutoStartState()
 {
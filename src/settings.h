@@ -5,6 +5,8 @@
 
 #include <wx/string.h>
 #include <wx/intl.h>
+#include <wx/colour.h>
+#include <wx/font.h>
 
 #include <vector>
 #include <set>
@@ -38,12 +40,9 @@ const bool DEFSETT_WEB_BROWSER_USE_DEFAULT = true;
 class wxWindow;
 class wxConfigBase;
 class wxFileConfig;
-class wxFont;
 struct PlaybackListFilterValues;
 class wxFileInputStream;
 class wxFileName;
-class wxColour;
-class wxColour;
 class wxColourData;
 class wxSize;
 class wxPoint;
@@ -79,6 +78,30 @@ public:
 	static const size_t top_left = 3;
 };
 
+/** @brief parsed copy of the chat settings
+ *
+ * chat panels need these for every line they output, reading them from
+ * the config file and parsing the colour and font strings each time is
+ * far too slow for busy channels. Use Settings::GetChatSettings().
+ */
+struct ChatSettings {
+	wxColour normal;
+	wxColour background;
+	wxColour highlight;
+	wxColour mine;
+	wxColour notification;
+	wxColour action;
+	wxColour server;
+	wxColour client;
+	wxColour joinpart;
+	wxColour error;
+	wxColour time;
+	wxFont font;
+	int historylength;
+	bool useirccolors;
+	bool reqattonhighlight;
+};
+
 //! @brief Class used to store and restore application settings.
 class Settings : public SL::NonCopyable
 {
@@ -319,6 +342,14 @@ public:
 	//!\brief controls if user attention is requested when highlighting a line
 	void SetRequestAttOnHighlight(const bool req);
 	bool GetRequestAttOnHighlight();
+
+	/** @brief cached chat settings, only re-read from config after they were changed
+	 *
+	 * the chat setters above invalidate the cache themselves, call
+	 * InvalidateChatSettings() after writing /Chat/ keys through cfg() directly
+	 */
+	const ChatSettings& GetChatSettings();
+	void InvalidateChatSettings();
 	/**@}*/
 
 	/* Do these go in Chat? */
@@ -553,6 +584,11 @@ private:
 	int GetChannelJoinIndex(const wxString& name);
 	void setFromList(const wxArrayString& list, const wxString& path);
 	wxArrayString getFromList(const wxString& path);
+
+	void ReadChatSettings();
+
+	ChatSettings m_chat;
+	bool m_chat_valid;
 };
 
 Settings& sett();
@@ -39,12 +39,14 @@
 #endif
 
 #include "channel.h"
+#include "chatlog.h"
 #include "downloader/lib/src/FileSystem/FileSystem.h"
 #include "downloader/prdownloader.h"
 #include "gui/controls.h"
 #include "gui/customdialogs.h"
 #include "gui/iconscollection.h"
 #include "gui/mainwindow.h"
+#include "gui/maplayercache.h"
 #include "gui/notifications/notificationmanager.h"
 #include "gui/playback/playbacktab.h"
 #include "gui/ui.h"
@@ -55,6 +57,7 @@
 #include "sysinfo.h"
 #include "utils/conversion.h"
 #include "utils/globalevents.h"
+#include "utils/logwriter.h"
 #include "utils/platform.h"
 #include "utils/slconfig.h"
 #include "utils/slpaths.h"
@@ -75,6 +78,7 @@ SpringLobbyApp::SpringLobbyApp()
     , m_log_console(true)
     , m_log_window_show(false)
     , m_crash_handle_disable(false)
+    , m_rebuild_chatlog_index(false)
     , m_appname(GetSpringlobbyName())
 {
 #if wxUSE_UNIX
@@ -153,6 +157,17 @@ bool SpringLobbyApp::OnInit()
 	wxLogMessage("Config dir: %s", configdir.c_str());
 	SlPaths::mkDir(configdir);
 
+	if (m_rebuild_chatlog_index) {
+		wxLogMessage("Rebuilding chat log index...");
+		const bool ok = ChatLog::RebuildIndex();
+		LogWriter::Release();
+		ChatLog::ReleaseIndex();
+		if (!ok) {
+			wxLogError(_T("Couldn't rebuild the chat log index"));
+		}
+		return false;
+	}
+
 	if (cfg().ReadBool(_T("/ResetLayout"))) {
 		wxLogMessage("Resetting Layout...");
 		//we do this early on and reset the config var a little later so we can save a def. perps once mw is created
@@ -222,7 +237,10 @@ int SpringLobbyApp::OnExit()
 	sett().SaveSettings(); // to make sure that cache path gets saved before destroying unitsync
 
 	IconsCollection::Release();
+	MapLayerCache::Release();
 	ServerManager::Release();
+	LogWriter::Release(); // writes the chat logs still queued
+	ChatLog::ReleaseIndex();
 	SetEvtHandlerEnabled(false);
 	UiEvents::GetNotificationEventSender().Enable(false);
 	LSL::Util::DestroyGlobals();
@@ -261,6 +279,7 @@ void SpringLobbyApp::OnInitCmdLine(wxCmdLineParser& parser)
 	     {wxCMD_LINE_OPTION, "l", "log-verbosity", wxTRANSLATE("overrides default logging verbosity, can be:\n                                1: critical errors\n                                2: errors\n                                3: warnings (default)\n                                4: messages\n                                5: function trace"), wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL},
 	     {wxCMD_LINE_SWITCH, "ve", "version", wxTRANSLATE("print version"), wxCMD_LINE_VAL_NONE, wxCMD_LINE_PARAM_OPTIONAL},
 	     {wxCMD_LINE_OPTION, "n", "name", wxTRANSLATE("overrides default application name"), wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL},
+	     {wxCMD_LINE_SWITCH, "ri", "rebuild-chatlog-index", wxTRANSLATE("index all chat logs for searching and exit"), wxCMD_LINE_VAL_NONE, wxCMD_LINE_PARAM_OPTIONAL},
 	     {wxCMD_LINE_NONE, NULL, NULL, NULL, wxCMD_LINE_VAL_NONE, wxCMD_LINE_PARAM_OPTIONAL} //this is mandatory according to http://docs.wxwidgets.org/stable/wx_wxcmdlineparser.html
 
 	    };
@@ -276,6 +295,7 @@ bool SpringLobbyApp::OnCmdLineParsed(wxCmdLineParser& parser)
 		m_log_console = parser.Found(_T("console-logging"));
 		m_log_window_show = parser.Found(_T("gui-logging"));
 		m_crash_handle_disable = parser.Found(_T("no-crash-handler"));
+		m_rebuild_chatlog_index = parser.Found(_T("rebuild-chatlog-index"));
 		parser.Found(_T("log-verbosity"), &m_log_verbosity);
 
 		// TODO make sure this is called before settings are accessed
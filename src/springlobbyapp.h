@@ -38,6 +38,7 @@ private:
 	bool m_log_console;
 	bool m_log_window_show;
 	bool m_crash_handle_disable;
+	bool m_rebuild_chatlog_index;
 	wxString m_appname;
 
 	DECLARE_EVENT_TABLE()
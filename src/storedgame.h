@@ -4,18 +4,23 @@
 #define REPLAY_H_INCLUDED
 
 #include "offlinebattle.h"
+#include "utils/demoscanner.h"
 
 
 struct StoredGame {
 
 	int id;
-	int playernum;
+	int playernum; //!< without spectators, also known when cached
+	bool cached;   //!< only the metadata is loaded, see IPlaybackList::LoadDetails
 	bool can_watch;
-	int duration; //in seconds
+	int duration;           //in seconds
+	int wallclock_duration; //in seconds, including pauses
 	int size;     //in bytes
 	time_t date;
 	std::string date_string;
+	std::string gameid; //!< hex, see DemoHeader::GetGameId
 	OfflineBattle battle;
+	DemoSummary demo; //!< chat, winners and statistics from the demo stream
 
 	enum Type {
 		REPLAY,
@@ -25,8 +30,10 @@ struct StoredGame {
 	StoredGame(const size_t idx = 0)
 	    : id(idx)
 	    , playernum(0)
+	    , cached(false)
 	    , can_watch(false)
 	    , duration(0)
+	    , wallclock_duration(0)
 	    , size(0)
 	    , date(0)
 	    , type(REPLAY)
@@ -45,11 +52,16 @@ struct StoredGame {
 	{
 		id = moved.id;
 		playernum = moved.playernum;
+		cached = moved.cached;
 		can_watch = moved.can_watch;
 		duration = moved.duration;
+		wallclock_duration = moved.wallclock_duration;
 		size = moved.size;
 		date = moved.date;
 		date_string = moved.date_string;
+		gameid = moved.gameid;
+		demo = moved.demo;
+		type = moved.type;
 		battle.operator=((OfflineBattle &&) moved.battle);
 		return *this;
 	}
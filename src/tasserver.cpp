@@ -23,6 +23,7 @@ lsl/networking/tasserver.cpp
 #include <algorithm>
 #include <map>
 #include <stdexcept>
+#include <vector>
 
 #include "log.h"
 #include "serverevents.h"
@@ -682,9 +683,11 @@ void TASServer::ExecuteCommand(const std::string& cmd, const std::string& inpara
 		m_se->OnChannelAction(channel, nick, params);
 	} else if (cmd == "CLIENTS") {
 		channel = GetWordParam(params);
+		std::vector<std::string> nicks;
 		while (!(nick = GetWordParam(params)).empty()) {
-			m_se->OnChannelJoin(channel, nick);
+			nicks.push_back(nick);
 		}
+		m_se->OnChannelJoinMany(channel, nicks);
 	} else if (cmd == "SAYPRIVATE") {
 		nick = GetWordParam(params);
 		if (((nick == m_relay_host_bot) || (nick == m_relay_host_manager)) && LSL::Util::BeginsWith(params, "!"))
@@ -901,7 +904,7 @@ void TASServer::ExecuteCommand(const std::string& cmd, const std::string& inpara
 			const std::string value = STD_STRING(command.AfterFirst('='));
 			m_se->OnSetBattleInfo(m_battle_id, key, value);
 		}
-		m_se->OnBattleInfoUpdated(m_battle_id);
+		m_se->OnBattleScriptTagsUpdated(m_battle_id);
 		// !! Command: "SETSCRIPTTAGS" params: "game/startpostype=0	game/maxunits=1000	game/limitdgun=0	game/startmetal=1000	game/gamemode=0	game/ghostedbuildings=-1	game/startenergy=1000	game/diminishingmms=0"
 	} else if (cmd == "REMOVESCRIPTTAGS") {
 		std::string key;
@@ -0,0 +1,119 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE banrules
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "utils/banrules.h"
+
+BOOST_AUTO_TEST_CASE(literal)
+{
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("spam"), "spam");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("^\\[ABC\\].*bot$"), "[ABC]");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("ab?cdef"), "cdef");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("x+yz"), "yz");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("[a-z]+guest\\d"), "guest");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("(foo)?barbaz"), "barbaz");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("foo|bar"), "");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("a{2}"), "");
+	// the operands of char escapes aren't literal text, \x takes all hex digits
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("\\x41bc"), "");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("\\x41-bot"), "-bot");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("\\u0041bc"), "bc");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("x\\cJyz"), "yz");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("\\1234ab"), "ab");
+	// advanced syntax
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("[[:<:]]bot[[:>:]]"), "bot");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("[]a[:digit:]]x+"), "x");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("\\mbot\\M"), "bot");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("(?i)spam"), "");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("***=a.b"), "");
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("(?:ab)cd"), "cd");
+	// a quantifier applies to the whole utf-8 char
+	BOOST_CHECK_EQUAL(BanRules::GetRequiredLiteral("ab\xc3\xa9?"), "ab");
+}
+
+BOOST_AUTO_TEST_CASE(escapes)
+{
+	BanRules rules;
+	BOOST_CHECK(rules.SetBanPattern("^\\x41-bc"));
+	BOOST_CHECK_EQUAL(rules.Check("A-bc"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK_EQUAL(rules.Check("41-bc"), BanRules::NOT_BANNED);
+	BOOST_CHECK(rules.SetBanPattern("\\u0041bot"));
+	BOOST_CHECK_EQUAL(rules.Check("XAbot"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK_EQUAL(rules.Check("X0041bot"), BanRules::NOT_BANNED);
+}
+
+#ifdef wxHAS_REGEX_ADVANCED
+// patterns users saved for the wxRegEx based checks before
+BOOST_AUTO_TEST_CASE(advanced)
+{
+	BanRules rules;
+	BOOST_CHECK(rules.SetBanPattern("[[:<:]]bot[[:>:]]"));
+	BOOST_CHECK_EQUAL(rules.Check("a bot here"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK_EQUAL(rules.Check("robot"), BanRules::NOT_BANNED);
+	BOOST_CHECK(rules.SetBanPattern("\\ybot\\y"));
+	BOOST_CHECK_EQUAL(rules.Check("[bot]"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK_EQUAL(rules.Check("bots"), BanRules::NOT_BANNED);
+	BOOST_CHECK(rules.SetBanPattern("(?i)spam"));
+	BOOST_CHECK_EQUAL(rules.Check("SpamBot"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK(rules.SetBanPattern("***=a.b"));
+	BOOST_CHECK_EQUAL(rules.Check("xa.b"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK_EQUAL(rules.Check("axb"), BanRules::NOT_BANNED);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(check)
+{
+	BanRules rules;
+	BOOST_CHECK_EQUAL(rules.Check("anyone"), BanRules::NOT_BANNED);
+
+	rules.BanNick("troll");
+	BOOST_CHECK_EQUAL(rules.Check("troll"), BanRules::BANNED_NICK);
+
+	BOOST_CHECK(!rules.SetBanPattern("(unclosed"));
+	BOOST_CHECK_EQUAL(rules.Check("(unclosed"), BanRules::NOT_BANNED);
+
+	BOOST_CHECK(rules.SetBanPattern("^Guest\\d+$"));
+	BOOST_CHECK_EQUAL(rules.Check("Guest123"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK_EQUAL(rules.Check("Guest"), BanRules::NOT_BANNED);
+	BOOST_CHECK_EQUAL(rules.Check("MyGuest1"), BanRules::NOT_BANNED);
+
+	// cached verdicts are dropped when the patterns change
+	BOOST_CHECK(rules.SetUnbanPattern("1$"));
+	BOOST_CHECK_EQUAL(rules.Check("Guest123"), BanRules::BANNED_PATTERN);
+	BOOST_CHECK_EQUAL(rules.Check("Guest121"), BanRules::NOT_BANNED);
+	BOOST_CHECK(rules.SetBanPattern(""));
+	BOOST_CHECK_EQUAL(rules.Check("Guest123"), BanRules::NOT_BANNED);
+
+	rules.UnbanNick("troll");
+	BOOST_CHECK_EQUAL(rules.Check("troll"), BanRules::NOT_BANNED);
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	std::vector<std::string> nicks;
+	for (int i = 0; i < 2000; i++) {
+		nicks.push_back("[CLAN" + std::to_string(i % 40) + "]Player" + std::to_string(i));
+	}
+	nicks.push_back("SpamBot42");
+
+	BanRules rules;
+	BOOST_CHECK(rules.SetBanPattern("^Spam\\w*\\d+$"));
+	std::vector<BanRules::Hit> banned;
+	const auto start = std::chrono::steady_clock::now();
+	BOOST_CHECK_EQUAL(rules.CheckAll(nicks, banned), 1);
+	const auto first = std::chrono::steady_clock::now();
+	banned.clear();
+	BOOST_CHECK_EQUAL(rules.CheckAll(nicks, banned), 1);
+	const auto cached = std::chrono::steady_clock::now();
+	BOOST_CHECK_EQUAL(banned[0].index, nicks.size() - 1);
+	BOOST_CHECK_EQUAL(banned[0].verdict, BanRules::BANNED_PATTERN);
+	const double firstus = std::chrono::duration<double, std::micro>(first - start).count();
+	const double cachedus = std::chrono::duration<double, std::micro>(cached - first).count();
+	BOOST_TEST_MESSAGE("checked " << nicks.size() << " nicks: " << firstus << " us, cached: " << cachedus << " us");
+}
+#endif
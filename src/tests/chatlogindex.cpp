@@ -0,0 +1,324 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE chatlogindex
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include "testingstuff/tempfiles.h"
+#include "utils/chatlogindex.h"
+#include "utils/compressedlog.h"
+
+static const std::string ROOT = "chatlogindex_test/";
+static const std::string INDEX = "chatlogindex_test/.index/";
+
+static void Append(const std::string& path, const std::string& text)
+{
+	FILE* f = fopen(path.c_str(), "ab");
+	BOOST_REQUIRE(f != NULL);
+	fwrite(text.data(), 1, text.size(), f);
+	fclose(f);
+}
+
+static void SetModTime(const std::string& path, time_t time)
+{
+	struct utimbuf times;
+	times.actime = time;
+	times.modtime = time;
+	utime(path.c_str(), &times);
+}
+
+static uint64_t FileSize(const std::string& path)
+{
+	struct stat st;
+	return (stat(path.c_str(), &st) == 0) ? st.st_size : 0;
+}
+
+//! appends text the way the LogWriter reports it to the index
+static void Log(ChatLogIndex& index, const std::string& path, const std::string& text)
+{
+	const uint64_t offset = FileSize(path);
+	Append(path, text);
+	index.AddText(path, offset, text);
+}
+
+//! the log and index dirs, removed with the test's logs and index afterwards
+struct LogDirs {
+	LogDirs()
+	{
+		temp.Dir(ROOT);
+		temp.Dir(ROOT + "server");
+		temp.Dir(INDEX);
+		// the index files, also left over ones of an aborted run
+		remove(temp.File(INDEX + "manifest").c_str());
+		for (int i = 0; i < 64; i++) {
+			std::ostringstream name;
+			name << INDEX << "segment" << i << ".idx";
+			remove(temp.File(name.str()).c_str());
+		}
+	}
+	//! a log of the test, a left over one of an aborted run is removed
+	void AddLog(const std::string& path)
+	{
+		remove(temp.File(path).c_str());
+		logs.push_back(path);
+	}
+	TempFiles temp;
+	std::vector<std::string> logs;
+};
+
+BOOST_AUTO_TEST_CASE(tokenize)
+{
+	std::vector<std::string> words;
+	const std::string line = "[12:34] <Foo> Get DeltaSiegeDry from http://springrts.com/x a b";
+	ChatLogIndex::Tokenize(line.data(), line.size(), words);
+	BOOST_REQUIRE_EQUAL(words.size(), 9);
+	BOOST_CHECK_EQUAL(words[0], "12");
+	BOOST_CHECK_EQUAL(words[2], "foo");
+	BOOST_CHECK_EQUAL(words[4], "deltasiegedry");
+	BOOST_CHECK_EQUAL(words[8], "com");
+}
+
+BOOST_FIXTURE_TEST_CASE(search, LogDirs)
+{
+	AddLog(ROOT + "server/main.txt");
+	AddLog(ROOT + "server/newbies.txt");
+	{
+		ChatLogIndex index(ROOT, INDEX);
+		Log(index, logs[0], "one\r\ntwo\r\n<Alice> try DeltaSiegeDry\r\nthree\r\nfour\r\n");
+		Log(index, logs[1], "<Bob> deltasiege is fun\n<Bob> half a li");
+		Log(index, logs[1], "ne about delta\n");
+
+		std::vector<ChatLogIndex::Match> matches = index.Search("DELTASIEGE", 10, 1);
+		BOOST_REQUIRE_EQUAL(matches.size(), 2);
+		BOOST_CHECK_EQUAL(matches[0].file, "server/newbies.txt");
+		BOOST_CHECK_EQUAL(matches[0].line, "<Bob> deltasiege is fun");
+		BOOST_CHECK_EQUAL(matches[0].before.size(), 0);
+		BOOST_REQUIRE_EQUAL(matches[0].after.size(), 1);
+		BOOST_CHECK_EQUAL(matches[0].after[0], "<Bob> half a line about delta");
+		BOOST_CHECK_EQUAL(matches[1].line, "<Alice> try DeltaSiegeDry");
+		BOOST_REQUIRE_EQUAL(matches[1].before.size(), 1);
+		BOOST_CHECK_EQUAL(matches[1].before[0], "two");
+		BOOST_CHECK_EQUAL(matches[1].after[0], "three");
+
+		// all words have to match, as word prefixes
+		BOOST_CHECK_EQUAL(index.Search("bob line", 10, 0).size(), 1);
+		BOOST_CHECK_EQUAL(index.Search("alice fun", 10, 0).size(), 0);
+		BOOST_CHECK_EQUAL(index.Search("siege", 10, 0).size(), 0);
+		BOOST_CHECK_EQUAL(index.Search("delta", 1, 0).size(), 1);
+	}
+
+	// written while the index wasn't running
+	Append(logs[0], "<Carol> delta again\n");
+	{
+		ChatLogIndex index(ROOT, INDEX);
+		BOOST_CHECK_EQUAL(index.Search("delta", 10, 0).size(), 3);
+		index.Update(logs);
+		BOOST_CHECK_EQUAL(index.Search("delta", 10, 0).size(), 4);
+		BOOST_CHECK_EQUAL(index.Search("carol", 10, 0).size(), 1);
+
+		// segments are merged
+		for (size_t i = 0; i <= ChatLogIndex::MAX_SEGMENTS; i++) {
+			Log(index, logs[1], "<Dave> more delta\n");
+			BOOST_CHECK(index.Commit());
+		}
+		BOOST_CHECK(index.GetSegmentCount() <= ChatLogIndex::MAX_SEGMENTS);
+		BOOST_CHECK_EQUAL(index.Search("delta", 100, 0).size(), 13);
+
+		BOOST_CHECK(index.Rebuild(logs));
+		BOOST_CHECK_EQUAL(index.Search("delta", 100, 0).size(), 13);
+		BOOST_CHECK_EQUAL(index.GetSegmentCount(), 1);
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(compressed, LogDirs)
+{
+	AddLog(ROOT + "server/main.txt");
+	AddLog(ROOT + "server/main.20161018-120000.txtz");
+	std::string text;
+	for (int i = 0; i < 5000; i++) {
+		std::ostringstream line;
+		line << "<Alice> line " << i << " about tabula\n";
+		text += line.str();
+	}
+	{
+		ChatLogIndex index(ROOT, INDEX);
+		Log(index, logs[0], text + "<Bob> the oldest deltasiege\n");
+		BOOST_CHECK(index.Commit());
+		// rotated, the postings move along
+		BOOST_REQUIRE(CompressedLog::Compress(logs[0], logs[1]));
+		BOOST_CHECK(index.RenameLog(logs[0], logs[1]));
+		remove(logs[0].c_str());
+		Log(index, logs[0], "<Carol> a new deltasiege\n");
+
+		std::vector<ChatLogIndex::Match> matches = index.Search("deltasiege", 10, 1);
+		BOOST_REQUIRE_EQUAL(matches.size(), 2);
+		BOOST_CHECK_EQUAL(matches[0].file, "server/main.txt");
+		BOOST_CHECK_EQUAL(matches[1].file, "server/main.20161018-120000.txtz");
+		BOOST_CHECK_EQUAL(matches[1].line, "<Bob> the oldest deltasiege");
+		BOOST_REQUIRE_EQUAL(matches[1].before.size(), 1);
+		BOOST_CHECK_EQUAL(matches[1].before[0], "<Alice> line 4999 about tabula");
+		BOOST_CHECK_EQUAL(index.Search("alice 2500", 10, 0).size(), 1);
+	}
+	{
+		// archives are indexed when rebuilding
+		ChatLogIndex index(ROOT, INDEX);
+		BOOST_CHECK(index.Rebuild(logs));
+		BOOST_CHECK_EQUAL(index.Search("deltasiege", 10, 0).size(), 2);
+		BOOST_CHECK_EQUAL(index.Search("tabula", 10000, 0).size(), 5000);
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(tiered_merge, LogDirs)
+{
+	AddLog(ROOT + "server/main.txt");
+	std::string text;
+	for (int i = 0; i < 20000; i++) {
+		std::ostringstream line;
+		line << "<Alice> old line " << i << " about tabula\n";
+		text += line.str();
+	}
+	ChatLogIndex index(ROOT, INDEX);
+	Log(index, logs[0], text);
+	BOOST_CHECK(index.Commit());
+	for (int i = 0; i < 50; i++) {
+		Log(index, logs[0], "<Bob> more tabula\n");
+		BOOST_CHECK(index.Commit());
+		BOOST_CHECK(index.GetSegmentCount() <= ChatLogIndex::MAX_SEGMENTS);
+	}
+	// only the small young segments were merged, the large one was kept
+	BOOST_CHECK(FileSize(INDEX + "segment0.idx") > 0);
+	BOOST_CHECK_EQUAL(index.Search("tabula", 100000, 0).size(), 20050);
+	BOOST_CHECK_EQUAL(index.Search("bob", 100, 0).size(), 50);
+}
+
+BOOST_FIXTURE_TEST_CASE(rename_late, LogDirs)
+{
+	AddLog(ROOT + "server/main.txt");
+	AddLog(ROOT + "server/main.20161018-120000.txtz.log");
+	ChatLogIndex index(ROOT, INDEX);
+	Log(index, logs[0], "<Alice> the old deltasiege\n<Alice> and more text before rotating\n");
+	BOOST_CHECK(index.Commit());
+	// the writer thread renames the postings after the new log got its first line
+	BOOST_REQUIRE_EQUAL(rename(logs[0].c_str(), logs[1].c_str()), 0);
+	Log(index, logs[0], "<Bob> a new deltasiege\n");
+	BOOST_CHECK(index.RenameLog(logs[0], logs[1]));
+
+	std::vector<ChatLogIndex::Match> matches = index.Search("deltasiege", 10, 0);
+	BOOST_REQUIRE_EQUAL(matches.size(), 2);
+	BOOST_CHECK_EQUAL(matches[0].file, "server/main.txt");
+	BOOST_CHECK_EQUAL(matches[0].line, "<Bob> a new deltasiege");
+	BOOST_CHECK_EQUAL(matches[1].file, "server/main.20161018-120000.txtz.log");
+	BOOST_CHECK_EQUAL(matches[1].line, "<Alice> the old deltasiege");
+}
+
+BOOST_FIXTURE_TEST_CASE(newest_first, LogDirs)
+{
+	AddLog(ROOT + "server/recent.txt");
+	AddLog(ROOT + "server/old.txt");
+	Append(logs[0], "<Alice> tabula tonight\n");
+	std::string text;
+	for (int i = 0; i < 100; i++) {
+		text += "<Bob> tabula again\n";
+	}
+	Append(logs[1], text);
+	SetModTime(logs[0], 1476086400);
+	SetModTime(logs[1], 1476000000);
+	{
+		ChatLogIndex index(ROOT, INDEX);
+		std::vector<size_t> done;
+		index.Update(logs, [&done](size_t count, size_t total) {
+			BOOST_CHECK_EQUAL(total, 2);
+			done.push_back(count);
+			return true;
+		});
+		BOOST_CHECK_EQUAL(done.size(), 3);
+		BOOST_CHECK_EQUAL(done.back(), 2);
+
+		// the old log has the higher file id and more matches, the recent one still comes first
+		std::vector<ChatLogIndex::Match> matches = index.Search("tabula", 1, 0);
+		BOOST_REQUIRE_EQUAL(matches.size(), 1);
+		BOOST_CHECK_EQUAL(matches[0].file, "server/recent.txt");
+
+		// text logged now is newer than anything caught up
+		Log(index, logs[1], "<Carol> tabula now\n");
+		matches = index.Search("tabula", 2, 0);
+		BOOST_REQUIRE_EQUAL(matches.size(), 2);
+		BOOST_CHECK_EQUAL(matches[0].line, "<Carol> tabula now");
+		BOOST_CHECK_EQUAL(matches[1].file, "server/recent.txt");
+	}
+	// the times are kept in the manifest
+	ChatLogIndex index(ROOT, INDEX);
+	std::vector<ChatLogIndex::Match> matches = index.Search("tabula", 3, 0);
+	BOOST_REQUIRE_EQUAL(matches.size(), 3);
+	BOOST_CHECK_EQUAL(matches[0].line, "<Carol> tabula now");
+	BOOST_CHECK_EQUAL(matches[1].file, "server/recent.txt");
+	BOOST_CHECK_EQUAL(matches[2].line, "<Bob> tabula again");
+
+	// stopped before the first log
+	index.Rebuild(std::vector<std::string>());
+	index.Update(logs, [](size_t, size_t) { return false; });
+	BOOST_CHECK(index.Search("tabula", 10, 0).empty());
+}
+
+#ifdef BENCHMARK
+BOOST_FIXTURE_TEST_CASE(benchmark, LogDirs)
+{
+	// 30 channels with 100MB of history
+	static const int CHANNELS = 30;
+	static const size_t SIZE = 100 * 1024 * 1024;
+	static const char* nicks[] = {"Alice", "Bob", "Carol", "Dave", "Eve", "Mallory", "Trent", "Peggy"};
+	static const char* texts[] = {"anyone up for a game on", "gg wp, that was close on", "download the new version of", "who wants to play", "is there a link for", "lag again in"};
+	static const char* maps[] = {"DeltaSiegeDry", "Comet Catcher Redux", "Tabula", "SpeedMetal", "Altored Divide", "Folsom Dam"};
+
+	for (int i = 0; i < CHANNELS; i++) {
+		std::ostringstream name;
+		name << ROOT << "server/channel" << i << ".txt";
+		AddLog(name.str());
+	}
+	std::vector<std::string> chunks(CHANNELS);
+	size_t written = 0;
+	unsigned rnd = 42;
+	for (size_t n = 0; written < SIZE; n++) {
+		rnd = rnd * 1103515245 + 12345;
+		std::ostringstream line;
+		line << "[" << (n / 60) % 24 << ":" << n % 60 << "] <" << nicks[(rnd >> 8) % 8] << n % 1000 << "> " << texts[(rnd >> 12) % 6] << " " << maps[(rnd >> 16) % 6] << " " << n << "\n";
+		std::string& chunk = chunks[n % CHANNELS];
+		chunk += line.str();
+		written += line.str().size();
+		if (chunk.size() > 1024 * 1024) {
+			Append(logs[n % CHANNELS], chunk);
+			chunk.clear();
+		}
+	}
+	for (int i = 0; i < CHANNELS; i++) {
+		Append(logs[i], chunks[i]);
+	}
+
+	ChatLogIndex index(ROOT, INDEX);
+	auto start = std::chrono::steady_clock::now();
+	BOOST_CHECK(index.Rebuild(logs));
+	const double rebuild = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	BOOST_TEST_MESSAGE("indexed " << written / (1024 * 1024) << "MB in " << rebuild << " s");
+
+	static const char* queries[] = {"deltasiege", "mallory tabula", "altored divide link", "bob123", "nomatch"};
+	for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+		start = std::chrono::steady_clock::now();
+		const std::vector<ChatLogIndex::Match> matches = index.Search(queries[i], 100, 2);
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		const size_t count = matches.size();
+		const std::string query = queries[i];
+		BOOST_TEST_MESSAGE("'" << query << "': " << count << " matches in " << ms << " ms");
+		BOOST_CHECK_EQUAL(count, (query == "nomatch") ? 0 : 100);
+	}
+}
+#endif
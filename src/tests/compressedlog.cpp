@@ -0,0 +1,140 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE compressedlog
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "testingstuff/tempfiles.h"
+#include "utils/compressedlog.h"
+
+static void WriteFile(const std::string& path, const std::string& text)
+{
+	FILE* f = fopen(path.c_str(), "wb");
+	BOOST_REQUIRE(f != NULL);
+	fwrite(text.data(), 1, text.size(), f);
+	fclose(f);
+}
+
+static std::string MakeLog(size_t size)
+{
+	std::string text;
+	for (size_t n = 0; text.size() < size; n++) {
+		std::ostringstream line;
+		line << "[12:" << n % 60 << "] <Player" << n % 97 << "> message number " << n << " on DeltaSiegeDry\r\n";
+		text += line.str();
+	}
+	return text;
+}
+
+BOOST_AUTO_TEST_CASE(roundtrip)
+{
+	const std::string src = "compressedlog_test.txt";
+	const std::string dst = "compressedlog_test.txtz";
+	std::string text = MakeLog(5 * CompressedLog::BLOCK_SIZE);
+	// a line longer than a block and a last line without line ending
+	const std::string longline(CompressedLog::BLOCK_SIZE * 3 / 2, 'x');
+	const std::string last = MakeLog(1000);
+	const size_t lastlines = std::count(last.begin(), last.end(), '\n');
+	text += longline + "\n" + last + "half a line";
+	WriteFile(src, text);
+	BOOST_REQUIRE(CompressedLog::Compress(src, dst));
+
+	const CompressedLog log(dst);
+	BOOST_REQUIRE(log.IsOk());
+	BOOST_CHECK_EQUAL(log.Size(), text.size());
+	BOOST_CHECK(log.GetBlockCount() >= 7);
+
+	std::string all, block;
+	for (size_t i = 0; i < log.GetBlockCount(); i++) {
+		BOOST_CHECK_EQUAL(log.GetBlockOffset(i), all.size());
+		BOOST_REQUIRE(log.ReadBlock(i, block));
+		// blocks end after a line
+		if (i + 1 < log.GetBlockCount()) {
+			BOOST_CHECK_EQUAL(block[block.size() - 1], '\n');
+		}
+		all += block;
+	}
+	BOOST_CHECK(all == text);
+	BOOST_CHECK_EQUAL(log.FindBlock(0), 0);
+	BOOST_CHECK_EQUAL(log.FindBlock(log.GetBlockOffset(3)), 3);
+	BOOST_CHECK_EQUAL(log.FindBlock(log.GetBlockOffset(3) - 1), 2);
+	BOOST_CHECK_EQUAL(log.FindBlock(text.size()), log.GetBlockCount());
+
+	// the tail spans several blocks
+	const std::vector<std::string> tail = log.ReadTailLines(lastlines + 2);
+	BOOST_REQUIRE_EQUAL(tail.size(), lastlines + 2);
+	BOOST_CHECK(tail[1] == longline);
+	BOOST_CHECK_EQUAL(tail[2], "[12:0] <Player0> message number 0 on DeltaSiegeDry");
+	BOOST_CHECK_EQUAL(log.ReadTailLines(1)[0], tail.back());
+	remove(src.c_str());
+	remove(dst.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+	const std::string path = "compressedlog_invalid.txtz";
+	BOOST_CHECK(!CompressedLog(path).IsOk());
+	WriteFile(path, "not a compressed log, but long enough for a header");
+	BOOST_CHECK(!CompressedLog(path).IsOk());
+	remove(path.c_str());
+
+	BOOST_CHECK(CompressedLog::IsCompressed("server/chan.20161018-120000.txtz"));
+	BOOST_CHECK(!CompressedLog::IsCompressed("server/chan.txt"));
+	BOOST_CHECK(!CompressedLog::IsCompressed(".txtz"));
+
+	// an empty log has no blocks
+	WriteFile("compressedlog_empty.txt", "");
+	BOOST_REQUIRE(CompressedLog::Compress("compressedlog_empty.txt", path));
+	const CompressedLog empty(path);
+	BOOST_CHECK(empty.IsOk());
+	BOOST_CHECK_EQUAL(empty.GetBlockCount(), 0);
+	BOOST_CHECK_EQUAL(empty.ReadTailLines(10).size(), 0);
+	remove("compressedlog_empty.txt");
+	remove(path.c_str());
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	// a channel with 64MB of history, split into 2MB logs like the rotation does
+	const size_t total = 64 * 1024 * 1024;
+	const size_t rotate = 2 * 1024 * 1024;
+	const std::string text = MakeLog(total);
+	TempFiles temp;
+	WriteFile(temp.File("compressedlog_plain.txt"), text);
+
+	const std::string dst = temp.File("compressedlog_benchmark.txtz");
+	WriteFile(temp.File("compressedlog_part.txt"), text.substr(text.find('\n', text.size() - rotate) + 1));
+	auto start = std::chrono::steady_clock::now();
+	BOOST_REQUIRE(CompressedLog::Compress("compressedlog_part.txt", dst));
+	const double compress = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	const MappedFile plain("compressedlog_plain.txt");
+	const std::vector<LineSpan> lines = FindTailLines(plain.Data(), plain.Size(), 1000);
+	const double plainus = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	const CompressedLog log(dst);
+	const std::vector<std::string> tail = log.ReadTailLines(1000);
+	const double tailus = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	BOOST_CHECK_EQUAL(lines.size(), tail.size());
+
+	// random access to a line, as search does
+	std::string block;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < 100; i++) {
+		BOOST_CHECK(log.ReadBlock(log.FindBlock((i * 7919 * 1024) % log.Size()), block));
+	}
+	const double seekus = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / 100;
+
+	BOOST_TEST_MESSAGE("compressed 2MB to " << MappedFile(dst).Size() / 1024 << "KB in " << compress << " ms");
+	BOOST_TEST_MESSAGE("last 1000 lines: " << plainus << " us from the 64MB log, " << tailus << " us from the archive");
+	BOOST_TEST_MESSAGE("reading a line of the archive: " << seekus << " us");
+}
+#endif
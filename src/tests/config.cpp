@@ -3,12 +3,16 @@
 
 #include <boost/test/unit_test.hpp>
 #include <wx/app.h>
+#include <wx/colour.h>
 #include <wx/filename.h>
+#include <chrono>
 #include <wx/string.h>
 
+#include "settings.h"
 #include "testingstuff/silent_logger.h"
 #include "utils/conversion.h"
 #include "utils/slconfig.h"
+#include "utils/wxTranslationHelper.h"
 
 SLCONFIG("/test/string", "hello world!", "test string");
 SLCONFIG("/test/long", -12345l, "test long");
@@ -41,6 +45,12 @@ std::string GetConfigPath()
 }
 } // namespace SlPaths
 
+// Settings::Setup isn't called, the gui isn't linked
+wxLocale* wxTranslationHelper::GetLocale()
+{
+	return NULL;
+}
+
 BOOST_AUTO_TEST_CASE(slconfig)
 {
 
@@ -73,3 +83,61 @@ BOOST_AUTO_TEST_CASE(slconfig)
 
 	//	cfg().SaveFile();
 }
+
+BOOST_AUTO_TEST_CASE(chatsettings)
+{
+	sett().SetChatColorNormal(wxColour(1, 2, 3));
+	const ChatSettings& chat = sett().GetChatSettings();
+	BOOST_CHECK(chat.normal == wxColour(1, 2, 3));
+	BOOST_CHECK(sett().GetChatColorNormal() == wxColour(1, 2, 3));
+
+	// the setters invalidate the cache
+	sett().SetChatColorNormal(wxColour(4, 5, 6));
+	sett().SetUseIrcColors(false);
+	BOOST_CHECK(sett().GetChatSettings().normal == wxColour(4, 5, 6));
+	BOOST_CHECK(!sett().GetUseIrcColors());
+	sett().SetUseIrcColors(true);
+	BOOST_CHECK(sett().GetChatSettings().useirccolors);
+
+	// writing the config directly needs an explicit invalidation
+	BOOST_CHECK(cfg().Write(_T("/Chat/Colour/Normal"), (const wxString&)_T("#070809")));
+	BOOST_CHECK(sett().GetChatColorNormal() == wxColour(4, 5, 6));
+	sett().InvalidateChatSettings();
+	BOOST_CHECK(sett().GetChatColorNormal() == wxColour(7, 8, 9));
+}
+
+#ifdef BENCHMARK
+// per chat line settings lookups: ChatPanel::OutputLine used to read them from
+// the config for every line, Settings::GetChatSettings() now only copies them
+BOOST_AUTO_TEST_CASE(chatsettings_benchmark)
+{
+	const size_t iterations = 20000;
+
+	const auto configstart = std::chrono::steady_clock::now();
+	size_t configok = 0;
+	for (size_t i = 0; i < iterations; i++) {
+		const wxColour background(cfg().Read(_T("/Chat/Colour/Background"), _T("#FFFFFF")));
+		const wxColour time(cfg().Read(_T("/Chat/Colour/Time"), _T("#64648C")));
+		const bool useirccolors = cfg().Read(_T("/Chat/UseIrcColors"), true);
+		configok += (background.IsOk() && time.IsOk() && useirccolors) ? 1 : 0;
+	}
+	const auto configend = std::chrono::steady_clock::now();
+
+	size_t cachedok = 0;
+	const auto cachedstart = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		const ChatSettings& settings = sett().GetChatSettings();
+		const wxColour background = settings.background;
+		const wxColour time = settings.time;
+		cachedok += (background.IsOk() && time.IsOk() && settings.useirccolors) ? 1 : 0;
+	}
+	const auto cachedend = std::chrono::steady_clock::now();
+
+	BOOST_CHECK_EQUAL(configok, iterations);
+	BOOST_CHECK_EQUAL(cachedok, iterations);
+	const double configns = std::chrono::duration<double, std::nano>(configend - configstart).count();
+	const double cachedns = std::chrono::duration<double, std::nano>(cachedend - cachedstart).count();
+	BOOST_TEST_MESSAGE("config reads: " << configns / iterations << " ns/line");
+	BOOST_TEST_MESSAGE("Settings::GetChatSettings: " << cachedns / iterations << " ns/line");
+}
+#endif
@@ -0,0 +1,149 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE demoheader
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <zlib.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "testingstuff/demofixture.h"
+#include "utils/demoheader.h"
+
+//! a demo with the header of version, a script and a stream of streamsize bytes
+static std::string MakeDemo(int version, const std::string& script, size_t streamsize)
+{
+	TestDemo demo;
+	demo.version = version;
+	demo.extraHeaderSize = 8; // a newer minor version with a larger header
+	demo.script = script;
+	demo.stream = std::string(streamsize, 'x');
+	return demo.Build();
+}
+
+BOOST_AUTO_TEST_CASE(roundtrip)
+{
+	const std::string script = "[GAME]\n{\n\tMapName=DeltaSiegeDry;\n}\n";
+	const int versions[] = {4, 5};
+	for (int version : versions) {
+		for (int compress = 0; compress < 2; compress++) {
+			const std::string path = compress ? "demoheader_test.sdfz" : "demoheader_test.sdf";
+			BOOST_REQUIRE(WriteDemo(path, MakeDemo(version, script, 1000), compress));
+			DemoReader reader(path);
+			BOOST_REQUIRE(reader.IsOk());
+			DemoHeader header;
+			BOOST_REQUIRE(reader.ReadHeader(header));
+			BOOST_CHECK_EQUAL(header.version, version);
+			BOOST_CHECK_EQUAL(header.versionString, "103.0");
+			BOOST_CHECK_EQUAL(header.GetGameId(), "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+			BOOST_CHECK_EQUAL(header.unixTime, 1476792000);
+			BOOST_CHECK_EQUAL(header.gameTime, 1234);
+			BOOST_CHECK_EQUAL(header.wallclockTime, 1300);
+			BOOST_CHECK_EQUAL(header.numPlayers, 8);
+			BOOST_CHECK_EQUAL(header.teamStatPeriod, 16);
+			BOOST_CHECK_EQUAL(header.winningAllyTeam, 1);
+			const uint64_t scriptoffset = DemoHeader::GetFixedSize(version) + 8;
+			BOOST_CHECK_EQUAL(header.GetScriptOffset(), scriptoffset);
+			BOOST_CHECK_EQUAL(header.GetPlayerStatOffset(), scriptoffset + script.size() + 1000);
+			BOOST_CHECK_EQUAL(header.GetTeamStatOffset(), scriptoffset + script.size() + 1000 + 320);
+
+			std::string read;
+			BOOST_REQUIRE(reader.ReadScript(header, read));
+			BOOST_CHECK_EQUAL(read, script);
+			BOOST_CHECK_EQUAL(reader.Tell(), header.GetDemoStreamOffset());
+			// forward only
+			BOOST_CHECK(!reader.SkipTo(0));
+			BOOST_CHECK(reader.SkipTo(header.GetPlayerStatOffset()));
+			BOOST_CHECK(!reader.SkipTo(header.GetPlayerStatOffset() + 1));
+			remove(path.c_str());
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+	const std::string demo = MakeDemo(5, "[GAME]{}", 0);
+	DemoHeader header;
+	BOOST_CHECK(header.Parse(demo.data(), demo.size()));
+	BOOST_CHECK(!header.Parse(demo.data(), 100));
+
+	std::string broken = demo;
+	broken[0] = 'S';
+	BOOST_CHECK(!header.Parse(broken.data(), broken.size()));
+	broken = demo;
+	PutDemoInt(broken, 16, 6);
+	BOOST_CHECK(!header.Parse(broken.data(), broken.size()));
+	broken = demo;
+	PutDemoInt(broken, 20, 100);
+	BOOST_CHECK(!header.Parse(broken.data(), broken.size()));
+	broken = demo;
+	PutDemoInt(broken, 304, DemoHeader::MAX_SCRIPT_SIZE + 1);
+	BOOST_CHECK(!header.Parse(broken.data(), broken.size()));
+
+	// truncated
+	BOOST_REQUIRE(WriteDemo("demoheader_test.sdfz", demo.substr(0, 200)));
+	{
+		DemoReader reader("demoheader_test.sdfz");
+		BOOST_CHECK(!reader.ReadHeader(header));
+	}
+	remove("demoheader_test.sdfz");
+	DemoReader missing("demoheader_missing.sdfz");
+	BOOST_CHECK(!missing.IsOk());
+	BOOST_CHECK(!missing.ReadHeader(header));
+}
+
+#ifdef BENCHMARK
+//! the way replays were read before, seeking to each field
+static bool SeekingRead(const std::string& path, std::string& script, int& duration)
+{
+	gzFile file = gzopen(path.c_str(), "rb");
+	if (file == NULL)
+		return false;
+	int version = 0, headersize = 0, scriptsize = 0;
+	bool ok = (gzseek(file, 16, SEEK_SET) >= 0) && (gzread(file, &version, 4) == 4);
+	ok = ok && (gzseek(file, 20, SEEK_SET) >= 0) && (gzread(file, &headersize, 4) == 4);
+	ok = ok && (gzseek(file, 64 + (version < 5 ? 0 : 240), SEEK_SET) >= 0) && (gzread(file, &scriptsize, 4) == 4);
+	ok = ok && (gzseek(file, headersize, SEEK_SET) >= 0);
+	script.resize(scriptsize);
+	ok = ok && (gzread(file, &script[0], scriptsize) == scriptsize);
+	ok = ok && (gzseek(file, 312, SEEK_SET) >= 0) && (gzread(file, &duration, 4) == 4);
+	gzclose(file);
+	return ok;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	static const int COUNT = 2000;
+	std::string script = "[GAME]\n{\n";
+	for (int i = 0; i < 16; i++) {
+		std::ostringstream player;
+		player << "\t[PLAYER" << i << "]\n\t{\n\t\tName=Player" << i << ";\n\t\tCountryCode=DE;\n\t\tSpectator=0;\n\t\tTeam=" << i << ";\n\t}\n";
+		script += player.str();
+	}
+	script += "}\n";
+	const std::string path = "demoheader_bench.sdfz";
+	BOOST_REQUIRE(WriteDemo(path, MakeDemo(5, script, 256 * 1024)));
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < COUNT; i++) {
+		std::string read;
+		int duration = 0;
+		BOOST_REQUIRE(SeekingRead(path, read, duration));
+		BOOST_REQUIRE_EQUAL(duration, 1234);
+	}
+	const double seekingms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < COUNT; i++) {
+		DemoReader reader(path);
+		DemoHeader header;
+		std::string read;
+		BOOST_REQUIRE(reader.ReadHeader(header) && reader.ReadScript(header, read));
+		BOOST_REQUIRE_EQUAL(read, script);
+	}
+	const double forwardms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	BOOST_TEST_MESSAGE("read " << COUNT << " demo headers in " << seekingms << " ms seeking, in " << forwardms << " ms forward only");
+	remove(path.c_str());
+}
+#endif
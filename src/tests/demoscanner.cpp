@@ -0,0 +1,135 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE demoscanner
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "testingstuff/demofixture.h"
+#include "utils/demoheader.h"
+#include "utils/demoscanner.h"
+
+static std::string Chat(float time, int from, int dest, const std::string& text)
+{
+	std::string data;
+	data += (char)DemoScanner::NETMSG_CHAT;
+	data += (char)(text.size() + 5);
+	data += (char)from;
+	data += (char)dest;
+	return DemoPacket(time, data + text + '\0');
+}
+
+//! a version 5 demo, the stream size is 0 if the game didn't end
+static std::string MakeDemo(const std::string& stream, bool complete, int players)
+{
+	TestDemo demo;
+	demo.gameOver = complete;
+	demo.numPlayers = players;
+	demo.playerStatElemSize = 24; // a newer, larger CPlayer::Statistics
+	demo.numTeams = 0;
+	demo.stream = stream;
+	for (int i = 0; i < players; i++) {
+		demo.playerStats += DemoInt(1000 * i) + DemoInt(100 * i) + DemoInt(10 * i) + DemoInt(i) + DemoInt(2 * i) + DemoInt(0);
+	}
+	return demo.Build();
+}
+
+static bool ScanFile(const std::string& path, DemoSummary& summary)
+{
+	DemoReader reader(path);
+	DemoHeader header;
+	std::string script;
+	BOOST_REQUIRE(reader.ReadHeader(header) && reader.ReadScript(header, script));
+	return DemoScanner::Scan(reader, header, summary);
+}
+
+static const std::string PATH = "demoscanner_test.sdfz";
+
+BOOST_AUTO_TEST_CASE(scan)
+{
+	std::string stream;
+	stream += DemoPacket(0, std::string("\x06\x0a\x01" "Alice\0", 9));
+	stream += DemoPacket(0, std::string("\x02", 1)); // NETMSG_NEWFRAME
+	stream += Chat(1.5f, 1, DemoSummary::TO_EVERYONE, "gl hf");
+	stream += DemoPacket(2, std::string(100000, '\x0b')); // larger than MAX_PACKET_SIZE
+	stream += Chat(61, 2, DemoSummary::TO_ALLIES, "rush");
+	stream += DemoPacket(900, std::string("\x1e\x05\x01\x00\x02", 5));
+
+	BOOST_REQUIRE(WriteDemo(PATH, MakeDemo(stream, true, 3)));
+	DemoSummary summary;
+	BOOST_REQUIRE(ScanFile(PATH, summary));
+	BOOST_CHECK(summary.scanned);
+	BOOST_CHECK(summary.gameover);
+	BOOST_REQUIRE_EQUAL(summary.winners.size(), 2);
+	BOOST_CHECK_EQUAL(summary.winners[0], 0);
+	BOOST_CHECK_EQUAL(summary.winners[1], 2);
+	BOOST_REQUIRE_EQUAL(summary.chat.size(), 2);
+	BOOST_CHECK_EQUAL(summary.chat[0].time, 1);
+	BOOST_CHECK_EQUAL(summary.chat[0].from_name, "Alice");
+	BOOST_CHECK_EQUAL(summary.chat[0].text, "gl hf");
+	BOOST_CHECK_EQUAL(summary.chat[0].dest, DemoSummary::TO_EVERYONE);
+	BOOST_CHECK_EQUAL(summary.chat[1].time, 61);
+	BOOST_CHECK_EQUAL(summary.chat[1].from, 2);
+	BOOST_CHECK_EQUAL(summary.chat[1].from_name, "");
+	BOOST_REQUIRE_EQUAL(summary.players.size(), 3);
+	BOOST_CHECK_EQUAL(summary.players[2].mousePixels, 2000);
+	BOOST_CHECK_EQUAL(summary.players[2].keyPresses, 20);
+	BOOST_CHECK_EQUAL(summary.players[2].unitCommands, 4);
+
+	// the game crashed, the stream is read to its end
+	BOOST_REQUIRE(WriteDemo(PATH, MakeDemo(stream.substr(0, stream.size() - 13), false, 3)));
+	BOOST_CHECK(ScanFile(PATH, summary));
+	BOOST_CHECK(!summary.gameover);
+	BOOST_CHECK_EQUAL(summary.chat.size(), 2);
+	BOOST_CHECK_EQUAL(summary.players.size(), 0);
+
+	// truncated
+	const std::string demo = MakeDemo(stream, true, 3);
+	BOOST_REQUIRE(WriteDemo(PATH, demo.substr(0, demo.size() - 30)));
+	BOOST_CHECK(!ScanFile(PATH, summary));
+	BOOST_CHECK(summary.gameover);
+	BOOST_CHECK_EQUAL(summary.players.size(), 0);
+	remove(PATH.c_str());
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	// a 20 minute game: frames, commands and some chat
+	std::string stream;
+	unsigned rnd = 42;
+	for (int frame = 0; frame < 20 * 60 * 30; frame++) {
+		const float time = frame / 30.0f;
+		stream += DemoPacket(time, std::string("\x02", 1));
+		rnd = rnd * 1103515245 + 12345;
+		for (unsigned i = 0; i < (rnd >> 16) % 4; i++) {
+			std::string command(20 + (rnd >> 8) % 40, '\x0b');
+			command[4] = (char)(rnd >> 3);
+			stream += DemoPacket(time, command);
+		}
+		if (frame % 300 == 0) {
+			std::ostringstream text;
+			text << "message " << frame;
+			stream += Chat(time, frame % 8, DemoSummary::TO_EVERYONE, text.str());
+		}
+	}
+	stream += DemoPacket(1200, std::string("\x1e\x04\x01\x01", 4));
+	const std::string demo = MakeDemo(stream, true, 8);
+	BOOST_REQUIRE(WriteDemo(PATH, demo));
+
+	static const int RUNS = 20;
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < RUNS; i++) {
+		DemoSummary summary;
+		BOOST_REQUIRE(ScanFile(PATH, summary));
+		BOOST_REQUIRE_EQUAL(summary.chat.size(), 120);
+		BOOST_REQUIRE_EQUAL(summary.winners.size(), 1);
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const double mb = RUNS * demo.size() / (1024.0 * 1024.0);
+	BOOST_TEST_MESSAGE("scanned " << mb << " MB of demos in " << seconds << " s: " << mb / seconds << " MB/s");
+	remove(PATH.c_str());
+}
+#endif
@@ -0,0 +1,127 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE dirwatcher
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "testingstuff/tempfiles.h"
+#include "utils/dirwatcher.h"
+
+static const std::string ROOT = "dirwatcher_test/";
+static const std::string DEMOS = "dirwatcher_test/demos/";
+
+static void Write(const std::string& path, const std::string& text)
+{
+	FILE* f = fopen(path.c_str(), "wb");
+	BOOST_REQUIRE(f != NULL);
+	fwrite(text.data(), 1, text.size(), f);
+	fclose(f);
+}
+
+//! removes the files left over by an aborted run
+static void RemoveLeftovers()
+{
+	TempFiles leftovers;
+	leftovers.Dir(ROOT);
+	leftovers.Dir(DEMOS);
+	leftovers.Dir(DEMOS + "sub.sdfz");
+	static const char* names[] = {"a.sdfz", "b.sdfz", "c.SDFZ", "d.sdfz", "e.sdfz", "notes.txt"};
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		leftovers.File(DEMOS + names[i]);
+	}
+}
+
+//! the change of path, or -1
+static int FindChange(const std::vector<DirWatcher::Change>& changes, const std::string& path)
+{
+	int res = -1;
+	for (size_t i = 0; i < changes.size(); i++) {
+		if (changes[i].path == DEMOS + path) {
+			BOOST_CHECK_MESSAGE(res < 0, "reported twice: " << path);
+			res = changes[i].type;
+		}
+	}
+	return res;
+}
+
+static void Run(bool native)
+{
+	RemoveLeftovers();
+	std::unique_ptr<TempFiles> temp(new TempFiles());
+	temp->Dir(ROOT);
+	std::vector<std::string> dirs(1, ROOT + "demos");
+	std::vector<std::string> extensions(1, ".sdfz");
+	DirWatcher watcher(dirs, extensions, native);
+#ifdef __linux__
+	BOOST_CHECK_EQUAL(watcher.IsNative(), native);
+#endif
+	BOOST_CHECK(watcher.GetFiles().empty());
+	BOOST_CHECK(watcher.Poll().empty());
+
+	// the directory is created later
+	temp->Dir(DEMOS);
+	Write(temp->File(DEMOS + "a.sdfz"), "a");
+	std::vector<DirWatcher::Change> changes = watcher.Poll();
+	BOOST_CHECK_EQUAL(changes.size(), 1);
+	BOOST_CHECK_EQUAL(FindChange(changes, "a.sdfz"), DirWatcher::ADDED);
+
+	Write(temp->File(DEMOS + "b.sdfz"), "b");
+	Write(temp->File(DEMOS + "c.SDFZ"), "c");
+	Write(temp->File(DEMOS + "notes.txt"), "ignored");
+	temp->Dir(DEMOS + "sub.sdfz");
+	// created and written again, still reported once
+	Write(temp->File(DEMOS + "d.sdfz"), "d");
+	Write(DEMOS + "d.sdfz", "dd");
+	// created and deleted in between
+	Write(DEMOS + "e.sdfz", "e");
+	remove((DEMOS + "e.sdfz").c_str());
+	changes = watcher.Poll();
+	BOOST_CHECK_EQUAL(changes.size(), 3);
+	BOOST_CHECK_EQUAL(FindChange(changes, "b.sdfz"), DirWatcher::ADDED);
+	BOOST_CHECK_EQUAL(FindChange(changes, "c.SDFZ"), DirWatcher::ADDED);
+	BOOST_CHECK_EQUAL(FindChange(changes, "d.sdfz"), DirWatcher::ADDED);
+	BOOST_CHECK_EQUAL(watcher.GetFiles().size(), 4);
+	BOOST_CHECK(watcher.Poll().empty());
+
+	// the size changes, so polling notices it within the same second
+	Write(DEMOS + "a.sdfz", "a longer demo");
+	remove((DEMOS + "b.sdfz").c_str());
+	changes = watcher.Poll();
+	BOOST_CHECK_EQUAL(changes.size(), 2);
+	BOOST_CHECK_EQUAL(FindChange(changes, "a.sdfz"), DirWatcher::MODIFIED);
+	BOOST_CHECK_EQUAL(FindChange(changes, "b.sdfz"), DirWatcher::REMOVED);
+
+	// a new watcher lists the files without reporting them
+	DirWatcher second(dirs, extensions, native);
+	BOOST_CHECK(second.GetFiles() == watcher.GetFiles());
+	BOOST_CHECK(second.Poll().empty());
+
+	// the whole directory is removed
+	temp.reset(new TempFiles());
+	changes = watcher.Poll();
+	BOOST_CHECK_EQUAL(changes.size(), 3);
+	BOOST_CHECK_EQUAL(FindChange(changes, "a.sdfz"), DirWatcher::REMOVED);
+	BOOST_CHECK_EQUAL(FindChange(changes, "d.sdfz"), DirWatcher::REMOVED);
+	BOOST_CHECK(watcher.GetFiles().empty());
+
+	// and picked up again once it's back
+	temp->Dir(ROOT);
+	temp->Dir(DEMOS);
+	Write(temp->File(DEMOS + "a.sdfz"), "a");
+	changes = watcher.Poll();
+	BOOST_CHECK_EQUAL(changes.size(), 1);
+	BOOST_CHECK_EQUAL(FindChange(changes, "a.sdfz"), DirWatcher::ADDED);
+}
+
+BOOST_AUTO_TEST_CASE(native)
+{
+	Run(true);
+}
+
+BOOST_AUTO_TEST_CASE(polling)
+{
+	Run(false);
+}
@@ -0,0 +1,94 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE flagimages
+
+#include <boost/test/unit_test.hpp>
+#include <wx/image.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "flagimages.h"
+
+BOOST_AUTO_TEST_CASE(lookup)
+{
+	BOOST_CHECK(GetFlagCount() > 200);
+	const int de = GetFlagIndex("DE");
+	BOOST_REQUIRE(de != FLAG_NONE);
+	BOOST_CHECK(GetFlagXpm(de) != NULL);
+	BOOST_CHECK(GetFlagIndex("FR") != FLAG_NONE);
+	BOOST_CHECK(GetFlagIndex("FR") != de);
+	BOOST_CHECK_EQUAL(GetFlagIndex(""), FLAG_NONE);
+	BOOST_CHECK_EQUAL(GetFlagIndex("??"), FLAG_NONE);
+	BOOST_CHECK_EQUAL(GetFlagIndex("XX"), FLAG_NONE);
+	BOOST_CHECK_EQUAL(FindFlagIndex("DE"), de);
+	BOOST_CHECK_EQUAL(FindFlagIndex("O1"), FLAG_NONE);
+	BOOST_CHECK_EQUAL(FindFlagIndex("Q9"), FLAG_NONE);
+
+	const wxImage flag(GetFlagXpm(de));
+	BOOST_CHECK(flag.IsOk());
+	BOOST_CHECK_EQUAL(flag.GetWidth(), 16);
+	BOOST_CHECK_EQUAL(flag.GetHeight(), 16);
+}
+
+#ifdef BENCHMARK
+//! resident memory of the process in KB, 0 where it isn't known
+static long GetResidentKB()
+{
+	long resident = 0;
+#ifdef __linux__
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (f != NULL) {
+		long size = 0;
+		if (fscanf(f, "%ld %ld", &size, &resident) != 2)
+			resident = 0;
+		fclose(f);
+	}
+	resident *= sysconf(_SC_PAGESIZE) / 1024;
+#endif
+	return resident;
+}
+
+static size_t GetImageBytes(const wxImage& image)
+{
+	const size_t pixels = image.GetWidth() * image.GetHeight();
+	return pixels * 3 + (image.HasAlpha() ? pixels : 0);
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	// IconsCollection decoded every flag when it was created, now only the flags
+	// of the users and battles which are shown are decoded, on first use
+	static const int SHOWN = 20;
+	const int count = GetFlagCount();
+
+	// lazy first, freed memory isn't always returned to the system
+	long before = GetResidentKB();
+	auto start = std::chrono::steady_clock::now();
+	std::vector<wxImage> lazy;
+	size_t lazybytes = 0;
+	for (int i = 0; i < SHOWN; i++) {
+		lazy.push_back(wxImage(GetFlagXpm(i * count / SHOWN)));
+		lazybytes += GetImageBytes(lazy.back());
+	}
+	const double lazyms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	const long lazykb = GetResidentKB() - before;
+
+	before = GetResidentKB();
+	start = std::chrono::steady_clock::now();
+	std::vector<wxImage> eager;
+	size_t eagerbytes = 0;
+	for (int i = 0; i < count; i++) {
+		eager.push_back(wxImage(GetFlagXpm(i)));
+		eagerbytes += GetImageBytes(eager.back());
+	}
+	const double eagerms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	const long eagerkb = GetResidentKB() - before;
+	BOOST_CHECK_EQUAL(eager.size(), (size_t)count);
+
+	BOOST_TEST_MESSAGE("decoding all " << count << " flags at startup: " << eagerms << " ms, " << eagerbytes / 1024 << " KB of pixels, resident +" << eagerkb << " KB");
+	BOOST_TEST_MESSAGE("decoding the " << SHOWN << " shown flags on first use: " << lazyms << " ms, " << lazybytes / 1024 << " KB of pixels, resident +" << lazykb << " KB");
+}
+#endif
@@ -0,0 +1,74 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE highlightmatcher
+
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+
+#include "utils/highlightmatcher.h"
+
+static std::vector<HighlightMatcher::Match> FindAll(const HighlightMatcher& matcher, const std::wstring& str)
+{
+	std::vector<HighlightMatcher::Match> matches;
+	matcher.FindAll(str.c_str(), str.size(), matches);
+	return matches;
+}
+
+static bool Contains(const HighlightMatcher& matcher, const std::wstring& str)
+{
+	return matcher.Contains(str.c_str(), str.size());
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+	HighlightMatcher matcher;
+	BOOST_CHECK(matcher.IsEmpty());
+	BOOST_CHECK(!Contains(matcher, L"anything"));
+	matcher.SetWords(std::vector<std::wstring>(1, L""), false, false);
+	BOOST_CHECK(matcher.IsEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(overlapping)
+{
+	std::vector<std::wstring> words;
+	words.push_back(L"he");
+	words.push_back(L"she");
+	words.push_back(L"his");
+	words.push_back(L"hers");
+	HighlightMatcher matcher;
+	matcher.SetWords(words, false, false);
+
+	const std::vector<HighlightMatcher::Match> matches = FindAll(matcher, L"ushers");
+	BOOST_REQUIRE_EQUAL(matches.size(), 3);
+	BOOST_CHECK_EQUAL(matches[0].word, 1); // she
+	BOOST_CHECK_EQUAL(matches[0].offset, 1);
+	BOOST_CHECK_EQUAL(matches[1].word, 0); // he
+	BOOST_CHECK_EQUAL(matches[1].offset, 2);
+	BOOST_CHECK_EQUAL(matches[2].word, 3); // hers
+	BOOST_CHECK_EQUAL(matches[2].offset, 2);
+	BOOST_CHECK_EQUAL(matches[2].length, 4);
+	BOOST_CHECK(!Contains(matcher, L"nothing to see"));
+}
+
+BOOST_AUTO_TEST_CASE(options)
+{
+	std::vector<std::wstring> words;
+	words.push_back(L"Nick");
+	HighlightMatcher matcher;
+
+	matcher.SetWords(words, false, false);
+	BOOST_CHECK(Contains(matcher, L"hi Nickname"));
+	BOOST_CHECK(!Contains(matcher, L"hi nick"));
+
+	matcher.SetWords(words, true, false);
+	BOOST_CHECK(Contains(matcher, L"hi NICK"));
+
+	matcher.SetWords(words, true, true);
+	BOOST_CHECK(!Contains(matcher, L"hi nickname"));
+	BOOST_CHECK(!Contains(matcher, L"hi _nick"));
+	BOOST_CHECK(Contains(matcher, L"nick: hi"));
+	BOOST_CHECK(Contains(matcher, L"hi nick"));
+	const std::vector<HighlightMatcher::Match> matches = FindAll(matcher, L"nickname, nick!");
+	BOOST_REQUIRE_EQUAL(matches.size(), 1);
+	BOOST_CHECK_EQUAL(matches[0].offset, 10);
+}
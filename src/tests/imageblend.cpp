@@ -0,0 +1,114 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE imageblend
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "utils/imageblend.h"
+
+static unsigned char Reference(unsigned char fg, unsigned char bg, unsigned char alpha)
+{
+	return (fg * alpha + bg * (255 - alpha) + 128) / 255;
+}
+
+static unsigned char ReferencePremultiplied(unsigned char fg, unsigned char bg, unsigned char alpha)
+{
+	return std::min(255, fg + (bg * (255 - alpha) + 128) / 255);
+}
+
+static std::vector<unsigned char> Random(size_t size)
+{
+	std::vector<unsigned char> data(size);
+	for (size_t i = 0; i < size; ++i) {
+		data[i] = rand() & 0xFF;
+	}
+	return data;
+}
+
+BOOST_AUTO_TEST_CASE(exhaustive)
+{
+	// every fg, bg and alpha combination, in runs long enough for the vector paths
+	std::vector<unsigned char> fg(256), bg(256), alpha(256), out(256), premul(256);
+	size_t mismatches = 0;
+	for (int a = 0; a < 256; ++a) {
+		for (int f = 0; f < 256; ++f) {
+			for (int b = 0; b < 256; ++b) {
+				fg[b] = f;
+				bg[b] = b;
+				alpha[b] = a;
+			}
+			ImageBlend::Blend(&fg[0], &bg[0], &alpha[0], &out[0], out.size());
+			ImageBlend::BlendPremultiplied(&fg[0], &bg[0], &alpha[0], &premul[0], premul.size());
+			for (int b = 0; b < 256; ++b) {
+				if (out[b] != Reference(f, b, a) || premul[b] != ReferencePremultiplied(f, b, a)) {
+					mismatches++;
+				}
+			}
+		}
+	}
+	BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(rgb)
+{
+	srand(42);
+	// odd size to cover the scalar tail and the chunk boundaries
+	const size_t pixels = 1000;
+	const std::vector<unsigned char> fg = Random(3 * pixels);
+	const std::vector<unsigned char> bg = Random(3 * pixels);
+	const std::vector<unsigned char> alpha = Random(pixels);
+	std::vector<unsigned char> out(3 * pixels);
+	ImageBlend::BlendRGB(&fg[0], &alpha[0], &bg[0], &out[0], pixels);
+	for (size_t i = 0; i < 3 * pixels; ++i) {
+		BOOST_REQUIRE_EQUAL(out[i], Reference(fg[i], bg[i], alpha[i / 3]));
+	}
+
+	// blending in place
+	std::vector<unsigned char> inplace(bg);
+	ImageBlend::BlendRGBPremultiplied(&fg[0], &alpha[0], &inplace[0], &inplace[0], pixels);
+	for (size_t i = 0; i < 3 * pixels; ++i) {
+		BOOST_REQUIRE_EQUAL(inplace[i], ReferencePremultiplied(fg[i], bg[i], alpha[i / 3]));
+	}
+}
+
+#ifdef BENCHMARK
+static void Benchmark(size_t size)
+{
+	const size_t pixels = size * size;
+	const std::vector<unsigned char> fg = Random(3 * pixels);
+	const std::vector<unsigned char> bg = Random(3 * pixels);
+	const std::vector<unsigned char> alpha = Random(pixels);
+	std::vector<unsigned char> out(3 * pixels);
+	const size_t iterations = std::max<size_t>(1, 10000000 / pixels);
+
+	// the float blending BlendImage used before
+	auto start = std::chrono::steady_clock::now();
+	for (size_t n = 0; n < iterations; ++n) {
+		for (size_t i = 0; i < 3 * pixels; ++i) {
+			const float fore = alpha[i / 3] / 255.0;
+			const float back = (255 - alpha[i / 3]) / 255.0;
+			out[i] = fg[i] * fore + bg[i] * back;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double floatus = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+
+	start = std::chrono::steady_clock::now();
+	for (size_t n = 0; n < iterations; ++n) {
+		ImageBlend::BlendRGB(&fg[0], &alpha[0], &bg[0], &out[0], pixels);
+	}
+	end = std::chrono::steady_clock::now();
+	const double intus = std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+	BOOST_CHECK_EQUAL(out[0], Reference(fg[0], bg[0], alpha[0]));
+	BOOST_TEST_MESSAGE("blended " << size << "x" << size << ": float " << floatus << " us, integer " << intus << " us");
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	Benchmark(98);
+	Benchmark(1024);
+}
+#endif
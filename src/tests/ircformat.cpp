@@ -0,0 +1,144 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE ircformat
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "utils/ircformat.h"
+
+using namespace IrcFormat;
+
+static std::vector<Span> Tokenize(const std::string& str)
+{
+	std::vector<Span> spans;
+	IrcFormat::Tokenize(str.c_str(), str.size(), spans);
+	return spans;
+}
+
+static std::string Stripped(const std::string& str, const std::vector<Span>& spans)
+{
+	std::string res;
+	for (const Span& span : spans) {
+		res.append(str, span.offset, span.length);
+	}
+	return res;
+}
+
+BOOST_AUTO_TEST_CASE(plain)
+{
+	BOOST_CHECK(Tokenize("").empty());
+	const std::string str = "hello world";
+	const std::vector<Span> spans = Tokenize(str);
+	BOOST_REQUIRE_EQUAL(spans.size(), 1);
+	BOOST_CHECK_EQUAL(spans[0].offset, 0);
+	BOOST_CHECK_EQUAL(spans[0].length, str.size());
+	BOOST_CHECK_EQUAL(spans[0].fg, COLOR_DEFAULT);
+	BOOST_CHECK_EQUAL(spans[0].bg, COLOR_DEFAULT);
+	BOOST_CHECK_EQUAL(spans[0].flags, 0);
+}
+
+BOOST_AUTO_TEST_CASE(flags)
+{
+	const std::string str = "a\x02"
+				"b\x1d"
+				"c\x1f"
+				"d\x16"
+				"e\x0f"
+				"f\x02\x02g";
+	const std::vector<Span> spans = Tokenize(str);
+	BOOST_CHECK_EQUAL(Stripped(str, spans), "abcdefg");
+	BOOST_REQUIRE_EQUAL(spans.size(), 7);
+	BOOST_CHECK_EQUAL(spans[0].flags, 0);
+	BOOST_CHECK_EQUAL(spans[1].flags, FLAG_BOLD);
+	BOOST_CHECK_EQUAL(spans[2].flags, FLAG_BOLD | FLAG_ITALIC);
+	BOOST_CHECK_EQUAL(spans[3].flags, FLAG_BOLD | FLAG_ITALIC | FLAG_UNDERLINE);
+	BOOST_CHECK_EQUAL(spans[4].flags, FLAG_BOLD | FLAG_ITALIC | FLAG_UNDERLINE | FLAG_REVERSE);
+	BOOST_CHECK_EQUAL(spans[5].flags, 0);
+	BOOST_CHECK_EQUAL(spans[6].flags, 0);
+}
+
+BOOST_AUTO_TEST_CASE(colors)
+{
+	const std::string str = "\x03"
+				"4red\x03"
+				"04,12red on blue\x03"
+				"3green on blue\x03"
+				"default\x03"
+				"99,1x\x03"
+				"12,y";
+	const std::vector<Span> spans = Tokenize(str);
+	BOOST_CHECK_EQUAL(Stripped(str, spans), "redred on bluegreen on bluedefaultx,y");
+	BOOST_REQUIRE_EQUAL(spans.size(), 6);
+	BOOST_CHECK_EQUAL(spans[0].fg, 4);
+	BOOST_CHECK_EQUAL(spans[0].bg, COLOR_DEFAULT);
+	BOOST_CHECK_EQUAL(spans[1].fg, 4);
+	BOOST_CHECK_EQUAL(spans[1].bg, 12);
+	BOOST_CHECK_EQUAL(spans[2].fg, 3);
+	BOOST_CHECK_EQUAL(spans[2].bg, 12);
+	BOOST_CHECK_EQUAL(spans[3].fg, COLOR_DEFAULT);
+	BOOST_CHECK_EQUAL(spans[3].bg, COLOR_DEFAULT);
+	BOOST_CHECK_EQUAL(spans[4].fg, 99);
+	BOOST_CHECK_EQUAL(spans[4].bg, 1);
+	// comma without digit isn't a background color
+	BOOST_CHECK_EQUAL(spans[5].fg, 12);
+	BOOST_CHECK_EQUAL(spans[5].bg, 1);
+}
+
+BOOST_AUTO_TEST_CASE(truncated)
+{
+	const std::vector<Span> spans = Tokenize("abc\x03");
+	BOOST_REQUIRE_EQUAL(spans.size(), 1);
+	BOOST_CHECK_EQUAL(spans[0].length, 3);
+	BOOST_CHECK(Tokenize("\x03"
+			     "12")
+			.empty());
+	// a trailing comma is text
+	const std::vector<Span> comma = Tokenize("\x03"
+						 "1,");
+	BOOST_REQUIRE_EQUAL(comma.size(), 1);
+	BOOST_CHECK_EQUAL(comma[0].offset, 2);
+	BOOST_CHECK_EQUAL(comma[0].fg, 1);
+}
+
+BOOST_AUTO_TEST_CASE(widechar)
+{
+	const std::wstring str = L"\x02\x00e4\x03"
+				 L"5\x00fc";
+	std::vector<Span> spans;
+	BOOST_CHECK_EQUAL(IrcFormat::Tokenize(str.c_str(), str.size(), spans), 2);
+	BOOST_CHECK_EQUAL(spans[0].offset, 1);
+	BOOST_CHECK_EQUAL(spans[0].flags, FLAG_BOLD);
+	BOOST_CHECK_EQUAL(spans[1].offset, 4);
+	BOOST_CHECK_EQUAL(spans[1].fg, 5);
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	// typical colored autohost / bridge bot output
+	const std::string line = "\x02\x03"
+				 "12[\x03"
+				 "04Teh\x03"
+				 "12]\x02 \x03"
+				 "03Player\x03 \x1fjoined\x1f battle \x03"
+				 "07,01[Spring 104.0]\x0f \x03"
+				 "10map: \x03"
+				 "11DeltaSiegeDry \x16(vote)\x16 \x03"
+				 "13http://springrts.com";
+	const size_t iterations = 200000;
+	std::vector<Span> spans;
+	spans.reserve(32);
+	size_t total = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		spans.clear();
+		total += Tokenize(line.c_str(), line.size(), spans);
+	}
+	const auto end = std::chrono::steady_clock::now();
+	const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+	BOOST_CHECK_EQUAL(total, iterations * spans.size());
+	BOOST_TEST_MESSAGE("tokenized " << iterations << " lines: " << ns / iterations << " ns/line");
+}
+#endif
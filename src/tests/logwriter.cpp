@@ -0,0 +1,178 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE logwriter
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utils/logwriter.h"
+
+static std::string ReadFile(const std::string& path)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	std::stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+static std::string LogPath(int i)
+{
+	std::stringstream path;
+	path << "logwriter_test_" << i << ".txt";
+	return path.str();
+}
+
+struct LogWriterFixture {
+	~LogWriterFixture()
+	{
+		LogWriter::Release();
+	}
+};
+
+BOOST_FIXTURE_TEST_CASE(append, LogWriterFixture)
+{
+	const std::string a = LogPath(0);
+	const std::string b = LogPath(1);
+	remove(a.c_str());
+	remove(b.c_str());
+
+	LogWriter* writer = LogWriter::Instance();
+	BOOST_CHECK(writer->Append(a, "line 1\n"));
+	BOOST_CHECK(writer->Append(b, "other\n"));
+	BOOST_CHECK(writer->Append(a, "line 2\n"));
+	writer->Flush();
+	BOOST_CHECK_EQUAL(ReadFile(a), "line 1\nline 2\n");
+	BOOST_CHECK_EQUAL(ReadFile(b), "other\n");
+
+	// closing keeps queued text, reopening appends
+	BOOST_CHECK(writer->Append(a, "line 3\n"));
+	writer->Close(a);
+	BOOST_CHECK(writer->Append(a, "line 4\n"));
+	LogWriter::Release();
+	BOOST_CHECK_EQUAL(ReadFile(a), "line 1\nline 2\nline 3\nline 4\n");
+
+	remove(a.c_str());
+	remove(b.c_str());
+}
+
+BOOST_FIXTURE_TEST_CASE(flush_path, LogWriterFixture)
+{
+	const std::string a = LogPath(0);
+	const std::string b = LogPath(1);
+	remove(a.c_str());
+	remove(b.c_str());
+
+	LogWriter* writer = LogWriter::Instance();
+	// nothing pending for a file returns right away
+	writer->Flush(a);
+	BOOST_CHECK(writer->Append(a, "line 1\n"));
+	BOOST_CHECK(writer->Append(b, "other\n"));
+	writer->Flush(a);
+	BOOST_CHECK_EQUAL(ReadFile(a), "line 1\n");
+	BOOST_CHECK(writer->Append(a, "line 2\n"));
+	writer->Flush(a);
+	BOOST_CHECK_EQUAL(ReadFile(a), "line 1\nline 2\n");
+	writer->Flush(b);
+	BOOST_CHECK_EQUAL(ReadFile(b), "other\n");
+	LogWriter::Release();
+
+	remove(a.c_str());
+	remove(b.c_str());
+}
+
+BOOST_FIXTURE_TEST_CASE(failure, LogWriterFixture)
+{
+	const std::string path = "logwriter_missing_dir/test.txt";
+	LogWriter* writer = LogWriter::Instance();
+	BOOST_CHECK(writer->Append(path, "lost\n"));
+	writer->Flush();
+	BOOST_CHECK(!writer->Append(path, "lost\n"));
+}
+
+BOOST_FIXTURE_TEST_CASE(post, LogWriterFixture)
+{
+	const std::string path = LogPath(0);
+	const std::string moved = LogPath(1);
+	remove(path.c_str());
+	remove(moved.c_str());
+
+	// the task sees the text appended before it was posted
+	LogWriter* writer = LogWriter::Instance();
+	std::string seen;
+	BOOST_CHECK(writer->Append(path, "line 1\n"));
+	writer->Close(path);
+	writer->Post([&]() {
+		seen = ReadFile(path);
+		rename(path.c_str(), moved.c_str());
+	});
+	writer->Flush();
+	// tasks still queued are run before the writer stops
+	bool ran = false;
+	writer->Post([&]() { ran = true; });
+	LogWriter::Release();
+	BOOST_CHECK_EQUAL(seen, "line 1\n");
+	BOOST_CHECK_EQUAL(ReadFile(moved), "line 1\n");
+	BOOST_CHECK(ran);
+
+	remove(path.c_str());
+	remove(moved.c_str());
+}
+
+#ifdef BENCHMARK
+BOOST_FIXTURE_TEST_CASE(benchmark, LogWriterFixture)
+{
+	// 30 busy channels, one line per message
+	static const int FILES = 30;
+	static const int MESSAGES = 30000;
+	const std::string line = "[12:34:56] <SomePlayer> this is a typical chat line of moderate length\n";
+
+	std::vector<std::string> paths;
+	std::vector<FILE*> files;
+	for (int i = 0; i < FILES; i++) {
+		paths.push_back(LogPath(i));
+		remove(paths[i].c_str());
+		files.push_back(fopen(paths[i].c_str(), "ab"));
+		BOOST_REQUIRE(files.back() != NULL);
+	}
+	// the old way: one unbuffered write per message
+	auto start = std::chrono::steady_clock::now();
+	for (int n = 0; n < MESSAGES; n++) {
+		fwrite(line.data(), 1, line.size(), files[n % FILES]);
+		fflush(files[n % FILES]);
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double syncus = std::chrono::duration<double, std::micro>(end - start).count();
+	for (int i = 0; i < FILES; i++) {
+		fclose(files[i]);
+		remove(paths[i].c_str());
+	}
+
+	LogWriter* writer = LogWriter::Instance();
+	start = std::chrono::steady_clock::now();
+	for (int n = 0; n < MESSAGES; n++) {
+		writer->Append(paths[n % FILES], line);
+	}
+	end = std::chrono::steady_clock::now();
+	const double appendus = std::chrono::duration<double, std::micro>(end - start).count();
+	writer->Flush();
+	const double totalus = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	size_t written = 0;
+	for (int i = 0; i < FILES; i++) {
+		written += ReadFile(paths[i]).size();
+		remove(paths[i].c_str());
+	}
+	BOOST_CHECK_EQUAL(written, MESSAGES * line.size());
+
+	const double syncrate = MESSAGES / syncus * 1e6;
+	const double asyncrate = MESSAGES / totalus * 1e6;
+	const double syncpermsg = syncus / MESSAGES;
+	const double asyncpermsg = appendus / MESSAGES;
+	BOOST_TEST_MESSAGE("synchronous: " << syncrate << " messages/s, " << syncpermsg << " us per message on the caller");
+	BOOST_TEST_MESSAGE("LogWriter: " << asyncrate << " messages/s, " << asyncpermsg << " us per message on the caller");
+}
+#endif
@@ -0,0 +1,185 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE playbackcache
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "utils/playbackcache.h"
+
+static const std::string CACHE = "playbackcache_test.cache";
+
+static PlaybackCache::Entry MakeEntry(int i)
+{
+	PlaybackCache::Entry entry;
+	std::ostringstream num;
+	num << i;
+	entry.size = 100000 + i;
+	entry.mtime = 1476000000 + i;
+	entry.ok = (i % 10) != 0;
+	entry.battletype = 1;
+	entry.duration = 600 + i;
+	entry.wallclock_duration = 700 + i;
+	entry.date = 1476000000 + i;
+	entry.players = i % 16;
+	entry.date_string = "2016-10-18 12:00:" + num.str();
+	entry.gameid = "4f2c0e7a9b" + num.str();
+	entry.map_name = "DeltaSiegeDry";
+	entry.map_hash = "1234567" + num.str();
+	entry.game_name = "Balanced Annihilation V9.46";
+	entry.game_hash = "7654321";
+	entry.engine_name = "spring";
+	entry.engine_version = "103.0";
+	entry.demo.scanned = true;
+	entry.demo.gameover = true;
+	entry.demo.winners.push_back(i % 2);
+	DemoSummary::ChatMessage message;
+	message.time = 10;
+	message.from = 1;
+	message.dest = DemoSummary::TO_EVERYONE;
+	message.from_name = "Alice";
+	message.text = "gl hf " + num.str();
+	entry.demo.chat.push_back(message);
+	DemoSummary::PlayerStats player = {1000, 100, 10, 1, 2};
+	entry.demo.players.push_back(player);
+	return entry;
+}
+
+static std::string MakePath(int i)
+{
+	std::ostringstream path;
+	path << "/home/user/.spring/demos/20161018_1200" << i << "_DeltaSiegeDry_103.sdfz";
+	return path.str();
+}
+
+BOOST_AUTO_TEST_CASE(roundtrip)
+{
+	remove(CACHE.c_str());
+	{
+		PlaybackCache cache(CACHE);
+		BOOST_CHECK(!cache.Load());
+		for (int i = 0; i < 3; i++) {
+			cache.Store(MakePath(i), MakeEntry(i));
+		}
+		BOOST_CHECK(cache.Save());
+	}
+	{
+		PlaybackCache cache(CACHE);
+		BOOST_REQUIRE(cache.Load());
+		BOOST_CHECK_EQUAL(cache.GetCount(), 3);
+		const PlaybackCache::Entry* entry = cache.Find(MakePath(1), 100001, 1476000001);
+		BOOST_REQUIRE(entry != NULL);
+		BOOST_CHECK(entry->ok);
+		BOOST_CHECK_EQUAL(entry->duration, 601);
+		BOOST_CHECK_EQUAL(entry->wallclock_duration, 701);
+		BOOST_CHECK_EQUAL(entry->gameid, "4f2c0e7a9b1");
+		BOOST_CHECK_EQUAL(entry->players, 1);
+		BOOST_CHECK_EQUAL(entry->date_string, "2016-10-18 12:00:1");
+		BOOST_CHECK_EQUAL(entry->map_hash, "12345671");
+		BOOST_CHECK_EQUAL(entry->engine_version, "103.0");
+		BOOST_CHECK(entry->demo.scanned && entry->demo.gameover);
+		BOOST_REQUIRE_EQUAL(entry->demo.winners.size(), 1);
+		BOOST_CHECK_EQUAL(entry->demo.winners[0], 1);
+		BOOST_REQUIRE_EQUAL(entry->demo.chat.size(), 1);
+		BOOST_CHECK_EQUAL(entry->demo.chat[0].text, "gl hf 1");
+		BOOST_CHECK_EQUAL(entry->demo.chat[0].dest, DemoSummary::TO_EVERYONE);
+		BOOST_REQUIRE_EQUAL(entry->demo.players.size(), 1);
+		BOOST_CHECK_EQUAL(entry->demo.players[0].keyPresses, 10);
+		BOOST_CHECK(!cache.Find(MakePath(0), 100000, 1476000000)->ok);
+
+		// modified files are parsed again
+		BOOST_CHECK(cache.Find(MakePath(2), 100003, 1476000002) == NULL);
+		BOOST_CHECK(cache.Find(MakePath(2), 100002, 1476000003) == NULL);
+		BOOST_CHECK(cache.Find("missing.sdfz", 0, 0) == NULL);
+		// the entry of the third file wasn't used, it's dropped
+		BOOST_CHECK(cache.Save());
+	}
+	{
+		PlaybackCache cache(CACHE);
+		BOOST_REQUIRE(cache.Load());
+		BOOST_CHECK_EQUAL(cache.GetCount(), 2);
+		cache.Keep(MakePath(0));
+		BOOST_CHECK(cache.Save());
+	}
+	{
+		// added by the directory watcher, the other entries aren't looked up
+		PlaybackCache cache(CACHE);
+		BOOST_REQUIRE(cache.Load());
+		BOOST_CHECK_EQUAL(cache.GetCount(), 1);
+		cache.Store(MakePath(3), MakeEntry(3));
+		BOOST_CHECK(cache.Save(false));
+	}
+	{
+		PlaybackCache cache(CACHE);
+		BOOST_REQUIRE(cache.Load());
+		BOOST_CHECK_EQUAL(cache.GetCount(), 2);
+	}
+	remove(CACHE.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+	static const char* contents[] = {"", "SLPBCACH", "SLPBCACH\x63\0\0\0\0\0\0\0", "garbage garbage garbage"};
+	static const size_t sizes[] = {0, 8, 16, 23};
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		FILE* f = fopen(CACHE.c_str(), "wb");
+		BOOST_REQUIRE(f != NULL);
+		fwrite(contents[i], 1, sizes[i], f);
+		fclose(f);
+		PlaybackCache cache(CACHE);
+		BOOST_CHECK(!cache.Load());
+		BOOST_CHECK_EQUAL(cache.GetCount(), 0);
+	}
+
+	// truncated
+	{
+		PlaybackCache cache(CACHE);
+		cache.Store(MakePath(0), MakeEntry(0));
+		BOOST_CHECK(cache.Save());
+	}
+	FILE* f = fopen(CACHE.c_str(), "rb");
+	BOOST_REQUIRE(f != NULL);
+	char buffer[1024];
+	const size_t size = fread(buffer, 1, sizeof(buffer), f);
+	fclose(f);
+	f = fopen(CACHE.c_str(), "wb");
+	BOOST_REQUIRE(f != NULL);
+	fwrite(buffer, 1, size - 1, f);
+	fclose(f);
+	PlaybackCache cache(CACHE);
+	BOOST_CHECK(!cache.Load());
+	BOOST_CHECK_EQUAL(cache.GetCount(), 0);
+	remove(CACHE.c_str());
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	// a demo folder of a long time player
+	static const int COUNT = 20000;
+	remove(CACHE.c_str());
+	{
+		PlaybackCache cache(CACHE);
+		for (int i = 0; i < COUNT; i++) {
+			cache.Store(MakePath(i), MakeEntry(i));
+		}
+		BOOST_CHECK(cache.Save());
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	PlaybackCache cache(CACHE);
+	BOOST_REQUIRE(cache.Load());
+	int found = 0;
+	for (int i = 0; i < COUNT; i++) {
+		if (cache.Find(MakePath(i), 100000 + i, 1476000000 + i) != NULL)
+			found++;
+	}
+	BOOST_CHECK(cache.Save());
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	BOOST_TEST_MESSAGE("loaded " << found << " cached replays in " << ms << " ms");
+	BOOST_CHECK_EQUAL(found, COUNT);
+	remove(CACHE.c_str());
+}
+#endif
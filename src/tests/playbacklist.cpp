@@ -0,0 +1,222 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE playbacklist
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <atomic>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "testingstuff/tempfiles.h"
+#include "utils/playbacklist.h"
+
+static const std::string DIR = "playbacklist_test/";
+
+struct StubPlayback {
+	StubPlayback()
+	    : id(0)
+	    , cached(false)
+	    , duration(0)
+	{
+	}
+	int id;
+	bool cached;
+	std::string path;
+	int duration;
+	DemoSummary demo;
+};
+
+//! "parses" a playback by its filename, files named broken* fail
+class StubList : public PlaybackList<StubPlayback>
+{
+public:
+	explicit StubList(const std::string& cachefile = std::string())
+	    : parsed(0)
+	    , m_cachefile(cachefile)
+	{
+	}
+
+	bool GetReplayInfos(const std::string& ReplayPath, StubPlayback& ret) const override
+	{
+		parsed++;
+		ret.path = ReplayPath;
+		ret.duration = ReplayPath.size();
+		return ReplayPath.find("broken") == std::string::npos;
+	}
+
+	mutable std::atomic<int> parsed;
+
+protected:
+	std::string GetCacheFile() const override
+	{
+		return m_cachefile;
+	}
+	bool ReadDemoSummary(const std::string& /*filename*/, DemoSummary& demo) const override
+	{
+		demo.scanned = true;
+		demo.gameover = true;
+		demo.winners.push_back(1);
+		return true;
+	}
+	std::string GetFilename(const StubPlayback& playback) const override
+	{
+		return playback.path;
+	}
+	void ToCache(const StubPlayback& playback, bool ok, PlaybackCache::Entry& entry) const override
+	{
+		entry.ok = ok;
+		entry.duration = playback.duration;
+		entry.demo = playback.demo;
+	}
+	void FromCache(const std::string& filename, const PlaybackCache::Entry& entry, StubPlayback& playback) const override
+	{
+		playback.path = filename;
+		playback.duration = entry.duration;
+		playback.demo = entry.demo;
+		playback.cached = true;
+	}
+
+private:
+	std::string m_cachefile;
+};
+
+static std::set<std::string> Files(const std::vector<std::string>& names)
+{
+	return std::set<std::string>(names.begin(), names.end());
+}
+
+//! reads the playbacks and lists them afterwards, like the PlaybackTab does with the loader thread's batches
+static std::vector<size_t> Add(StubList& list, const std::vector<std::string>& names)
+{
+	std::vector<StubPlayback> loaded;
+	list.AddPlaybacks(Files(names), [&loaded](std::vector<StubPlayback>& playbacks) {
+		loaded.insert(loaded.end(), playbacks.begin(), playbacks.end());
+	});
+	return list.InsertPlaybacks(loaded);
+}
+
+BOOST_AUTO_TEST_CASE(add_remove)
+{
+	StubList list;
+	std::vector<StubPlayback> loaded;
+	const StubList::LoadedHandler handler = [&loaded](std::vector<StubPlayback>& playbacks) {
+		loaded.insert(loaded.end(), playbacks.begin(), playbacks.end());
+	};
+	list.AddPlaybacks(Files({"a.sdfz", "b.sdfz"}), handler);
+	// the list isn't modified by the loader
+	BOOST_CHECK_EQUAL(list.GetNumPlaybacks(), 0);
+	BOOST_CHECK_EQUAL(list.parsed, 2);
+	BOOST_REQUIRE_EQUAL(loaded.size(), 2);
+	std::vector<size_t> ids = list.InsertPlaybacks(loaded);
+	BOOST_CHECK_EQUAL(ids.size(), 2);
+	BOOST_CHECK_EQUAL(list.GetNumPlaybacks(), 2);
+	const int a = list.FindPlayback("a.sdfz");
+	BOOST_REQUIRE(a >= 0);
+	BOOST_CHECK_EQUAL(list.GetPlaybackById(a).id, a);
+	BOOST_CHECK_EQUAL(list.GetPlaybackById(a).path, "a.sdfz");
+	BOOST_CHECK(!list.GetPlaybackById(a).cached);
+
+	// known files are skipped
+	ids = Add(list, {"a.sdfz", "c.sdfz"});
+	BOOST_CHECK_EQUAL(list.GetNumPlaybacks(), 3);
+	BOOST_CHECK_EQUAL(list.parsed, 3);
+	BOOST_REQUIRE_EQUAL(ids.size(), 1);
+	BOOST_CHECK_EQUAL((int)ids[0], list.FindPlayback("c.sdfz"));
+	// and so are playbacks listed since they were read
+	std::vector<StubPlayback> first, second;
+	list.AddPlaybacks(Files({"e.sdfz"}), [&first](std::vector<StubPlayback>& playbacks) { first = playbacks; });
+	list.AddPlaybacks(Files({"e.sdfz"}), [&second](std::vector<StubPlayback>& playbacks) { second = playbacks; });
+	BOOST_CHECK_EQUAL(list.InsertPlaybacks(first).size(), 1);
+	BOOST_CHECK(list.InsertPlaybacks(second).empty());
+	BOOST_CHECK_EQUAL(list.GetNumPlaybacks(), 4);
+	BOOST_CHECK_EQUAL(list.parsed, 5);
+
+	// a modified file is removed first, it's parsed again under the freed id
+	list.RemovePlayback(a);
+	BOOST_CHECK_EQUAL(list.FindPlayback("a.sdfz"), -1);
+	BOOST_CHECK(!list.PlaybackExists(a));
+	Add(list, {"a.sdfz"});
+	BOOST_CHECK_EQUAL(list.FindPlayback("a.sdfz"), a);
+	BOOST_CHECK_EQUAL(list.parsed, 6);
+
+	// broken ones are listed too
+	Add(list, {"broken.sdfz"});
+	BOOST_CHECK(list.FindPlayback("broken.sdfz") >= 0);
+
+	// reloading starts over
+	list.RemoveAll();
+	loaded.clear();
+	list.LoadPlaybacks(Files({"b.sdfz", "d.sdfz"}), handler);
+	list.InsertPlaybacks(loaded);
+	BOOST_CHECK_EQUAL(list.GetNumPlaybacks(), 2);
+	BOOST_CHECK_EQUAL(list.FindPlayback("a.sdfz"), -1);
+	BOOST_CHECK(list.FindPlayback("d.sdfz") >= 0);
+	BOOST_CHECK_EQUAL(list.parsed, 9);
+}
+
+BOOST_AUTO_TEST_CASE(remove_twice)
+{
+	StubList list;
+	Add(list, {"a.sdfz", "b.sdfz"});
+	const int a = list.FindPlayback("a.sdfz");
+	BOOST_REQUIRE(a >= 0);
+	BOOST_CHECK(list.RemovePlayback(a));
+	BOOST_CHECK(!list.RemovePlayback(a));
+	BOOST_CHECK_EQUAL(list.GetNumPlaybacks(), 1);
+	// the id is freed once, so it's handed out only once
+	Add(list, {"c.sdfz", "d.sdfz"});
+	const int c = list.FindPlayback("c.sdfz");
+	const int d = list.FindPlayback("d.sdfz");
+	BOOST_REQUIRE(c >= 0 && d >= 0);
+	BOOST_CHECK_NE(c, d);
+	BOOST_CHECK_EQUAL(list.GetNumPlaybacks(), 3);
+	BOOST_CHECK_EQUAL(list.GetPlaybackById(c).path, "c.sdfz");
+	BOOST_CHECK_EQUAL(list.GetPlaybackById(d).path, "d.sdfz");
+}
+
+BOOST_AUTO_TEST_CASE(cache)
+{
+	TempFiles temp;
+	temp.Dir(DIR);
+	const std::string cachefile = temp.File(DIR + "playbacks.cache");
+	std::vector<std::string> names;
+	for (int i = 0; i < 3; i++) {
+		names.push_back(temp.File(DIR + std::string(1, 'a' + i) + ".sdfz"));
+		FILE* f = fopen(names.back().c_str(), "wb");
+		BOOST_REQUIRE(f != NULL);
+		fputs("demo", f);
+		fclose(f);
+	}
+
+	StubList first(cachefile);
+	Add(first, names);
+	BOOST_CHECK_EQUAL(first.parsed, 3);
+	DemoSummary demo;
+	BOOST_CHECK(first.ScanDemo(names[1], demo));
+	BOOST_CHECK(demo.scanned);
+	{
+		// summaries are written in batches
+		StubList peek(cachefile);
+		Add(peek, names);
+		BOOST_CHECK(!peek.GetPlaybackById(peek.FindPlayback(names[1])).demo.scanned);
+	}
+	first.SaveScans();
+
+	// unchanged files come from the cache, with the scanned summary
+	StubList second(cachefile);
+	Add(second, names);
+	BOOST_CHECK_EQUAL(second.parsed, 0);
+	StubPlayback& playback = second.GetPlaybackById(second.FindPlayback(names[1]));
+	BOOST_CHECK(playback.cached);
+	BOOST_CHECK_EQUAL(playback.duration, (int)names[1].size());
+	BOOST_CHECK(playback.demo.scanned);
+	BOOST_CHECK(!second.GetPlaybackById(second.FindPlayback(names[0])).demo.scanned);
+
+	// the details are parsed once, the cached summary is kept
+	BOOST_CHECK(second.LoadDetails(playback));
+	BOOST_CHECK(second.LoadDetails(playback));
+	BOOST_CHECK_EQUAL(second.parsed, 1);
+	BOOST_CHECK(!playback.cached);
+	BOOST_CHECK(playback.demo.scanned);
+}
@@ -0,0 +1,132 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE savegamescript
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <zlib.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include "utils/savegamescript.h"
+
+static const std::string PATH = "savegamescript_test.ssf";
+
+//! a savegame: the script, its terminator and the serialized game state
+static void WriteSavegame(const std::string& script, size_t statesize, bool compress)
+{
+	std::string data = script;
+	data += '\0';
+	for (size_t i = 0; i < statesize; i++) {
+		data += (char)(i * 7);
+	}
+	if (compress) {
+		gzFile file = gzopen(PATH.c_str(), "wb");
+		BOOST_REQUIRE(file != NULL);
+		BOOST_REQUIRE_EQUAL(gzwrite(file, data.data(), data.size()), (int)data.size());
+		gzclose(file);
+	} else {
+		FILE* file = fopen(PATH.c_str(), "wb");
+		BOOST_REQUIRE(file != NULL);
+		fwrite(data.data(), 1, data.size(), file);
+		fclose(file);
+	}
+}
+
+static std::string MakeScript(size_t size)
+{
+	std::string script = "[GAME]\n{\n";
+	while (script.size() + 2 < size) {
+		script += "\tMapName=DeltaSiegeDry;\n";
+	}
+	script.resize(size - 2);
+	return script + "}\n";
+}
+
+BOOST_AUTO_TEST_CASE(roundtrip)
+{
+	// scripts ending before, at and after the end of the first chunk
+	const size_t sizes[] = {20, 1000, SAVEGAME_CHUNK_SIZE - 1, SAVEGAME_CHUNK_SIZE, SAVEGAME_CHUNK_SIZE + 1, 3 * SAVEGAME_CHUNK_SIZE + 17};
+	for (size_t size : sizes) {
+		for (int compress = 0; compress < 2; compress++) {
+			const std::string script = MakeScript(size);
+			WriteSavegame(script, 100000, compress);
+			std::string read;
+			BOOST_REQUIRE(ReadSavegameScript(PATH, read));
+			BOOST_CHECK_EQUAL(read.size(), script.size());
+			BOOST_CHECK(read == script);
+		}
+	}
+	remove(PATH.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(invalid)
+{
+	std::string script;
+	BOOST_CHECK(!ReadSavegameScript("savegamescript_missing.ssf", script));
+
+	// no terminator, read up to the end of the file
+	FILE* file = fopen(PATH.c_str(), "wb");
+	BOOST_REQUIRE(file != NULL);
+	fwrite("[GAME]{}", 1, 8, file);
+	fclose(file);
+	BOOST_CHECK(ReadSavegameScript(PATH, script));
+	BOOST_CHECK_EQUAL(script, "[GAME]{}");
+
+	// or up to the limit
+	gzFile gzfile = gzopen(PATH.c_str(), "wb");
+	BOOST_REQUIRE(gzfile != NULL);
+	const std::string chunk(SAVEGAME_CHUNK_SIZE, 'x');
+	for (size_t size = 0; size <= SAVEGAME_MAX_SCRIPT_SIZE; size += chunk.size()) {
+		BOOST_REQUIRE_EQUAL(gzwrite(gzfile, chunk.data(), chunk.size()), (int)chunk.size());
+	}
+	gzclose(gzfile);
+	BOOST_CHECK(ReadSavegameScript(PATH, script));
+	BOOST_CHECK_EQUAL(script.size(), SAVEGAME_MAX_SCRIPT_SIZE);
+
+	// empty script
+	WriteSavegame("", 10, true);
+	BOOST_CHECK(ReadSavegameScript(PATH, script));
+	BOOST_CHECK(script.empty());
+	remove(PATH.c_str());
+}
+
+#ifdef BENCHMARK
+//! how SavegameList read scripts before
+static std::string ReadBytewise(const std::string& path)
+{
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	std::string script;
+	char c;
+	if (file.is_open()) {
+		do {
+			file.read(&c, sizeof(char));
+			if (c)
+				script += c;
+		} while ((c != 0) && !file.fail());
+	}
+	return script;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	static const int RUNS = 100;
+	const std::string script = MakeScript(20 * 1024);
+	WriteSavegame(script, 1024 * 1024, false);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < RUNS; i++) {
+		BOOST_REQUIRE(ReadBytewise(PATH) == script);
+	}
+	const double bytewisems = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < RUNS; i++) {
+		std::string read;
+		BOOST_REQUIRE(ReadSavegameScript(PATH, read) && (read == script));
+	}
+	const double chunkedms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	BOOST_TEST_MESSAGE("read " << RUNS << " savegame scripts in " << bytewisems << " ms byte by byte, in " << chunkedms << " ms in chunks");
+	remove(PATH.c_str());
+}
+#endif
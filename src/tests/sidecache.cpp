@@ -0,0 +1,115 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE sidecache
+
+#include <boost/test/unit_test.hpp>
+#include <stdint.h>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/sidecache.h"
+
+static int sidesloads = 0;
+static int iconloads = 0;
+
+static std::vector<std::string> LoadSides(const std::string& game)
+{
+	sidesloads++;
+	std::vector<std::string> sides;
+	if (game == "missing")
+		return sides;
+	sides.push_back("arm");
+	sides.push_back("core");
+	sides.push_back("chicken");
+	return sides;
+}
+
+static std::string LoadIcon(const std::string& game, const std::string& side)
+{
+	iconloads++;
+	return game + "/" + side;
+}
+
+BOOST_AUTO_TEST_CASE(caching)
+{
+	sidesloads = iconloads = 0;
+	SideCache<std::string> cache(LoadSides, LoadIcon);
+
+	BOOST_REQUIRE(cache.GetIcon("ba", 1) != nullptr);
+	BOOST_CHECK_EQUAL(*cache.GetIcon("ba", 1), "ba/core");
+	BOOST_CHECK_EQUAL(*cache.GetIcon("ba", 0), "ba/arm");
+	BOOST_CHECK(cache.GetIcon("ba", 3) == nullptr);
+	BOOST_CHECK_EQUAL(cache.GetSides("ba").size(), 3);
+	BOOST_CHECK_EQUAL(sidesloads, 1);
+	BOOST_CHECK_EQUAL(iconloads, 2);
+
+	BOOST_CHECK(cache.GetIcon("missing", 0) == nullptr);
+	BOOST_CHECK(cache.GetIcon("missing", 0) == nullptr);
+	BOOST_CHECK_EQUAL(sidesloads, 2);
+
+	cache.Clear();
+	BOOST_CHECK_EQUAL(*cache.GetIcon("ba", 1), "ba/core");
+	BOOST_CHECK_EQUAL(sidesloads, 3);
+	BOOST_CHECK_EQUAL(iconloads, 3);
+}
+
+#ifdef BENCHMARK
+static std::string HtmlColour(uint32_t rgb)
+{
+	char buf[8];
+	snprintf(buf, sizeof(buf), "%06X", rgb);
+	return buf;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	// repaint all rows of a 32 player battle room, each row looks up a side icon and a colour
+	static const int PLAYERS = 32;
+	static const int PAINTS = 10000;
+	std::vector<uint32_t> colours;
+	for (int i = 0; i < PLAYERS; i++) {
+		colours.push_back(i * 0x070B0D);
+	}
+
+	// what the battle room did before: fetch the side list for every row and key colours by string
+	sidesloads = iconloads = 0;
+	std::map<std::string, std::string> sideicons;
+	std::map<std::string, int> colourbmps;
+	size_t found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int n = 0; n < PAINTS; n++) {
+		for (int i = 0; i < PLAYERS; i++) {
+			const std::vector<std::string> sides = LoadSides("ba");
+			const std::string key = "ba_" + sides[i % sides.size()];
+			if (sideicons.find(key) == sideicons.end())
+				sideicons[key] = LoadIcon("ba", sides[i % sides.size()]);
+			found += sideicons[key].size();
+			found += colourbmps[HtmlColour(colours[i])];
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double beforeus = std::chrono::duration<double, std::micro>(end - start).count() / PAINTS;
+
+	sidesloads = iconloads = 0;
+	SideCache<std::string> cache(LoadSides, LoadIcon);
+	std::unordered_map<uint32_t, int> packedbmps;
+	size_t cachedfound = 0;
+	start = std::chrono::steady_clock::now();
+	for (int n = 0; n < PAINTS; n++) {
+		for (int i = 0; i < PLAYERS; i++) {
+			cachedfound += cache.GetIcon("ba", i % 3)->size();
+			cachedfound += packedbmps[colours[i]];
+		}
+	}
+	end = std::chrono::steady_clock::now();
+	const double afterus = std::chrono::duration<double, std::micro>(end - start).count() / PAINTS;
+
+	BOOST_CHECK_EQUAL(found, cachedfound);
+	BOOST_CHECK_EQUAL(sidesloads, 1);
+	BOOST_CHECK_EQUAL(iconloads, 3);
+	BOOST_TEST_MESSAGE("painting " << PLAYERS << " players: " << beforeus << " us before, " << afterus << " us cached");
+}
+#endif
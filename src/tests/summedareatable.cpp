@@ -0,0 +1,86 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE summedareatable
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "utils/summedareatable.h"
+
+static uint32_t NaiveSum(const std::vector<unsigned char>& data, int w, int x1, int y1, int x2, int y2)
+{
+	uint32_t sum = 0;
+	for (int y = y1; y < y2; ++y) {
+		for (int x = x1; x < x2; ++x) {
+			const unsigned char* p = &data[3 * (y * w + x)];
+			sum += p[0] + p[1] + p[2];
+		}
+	}
+	return sum;
+}
+
+static std::vector<unsigned char> RandomImage(int w, int h)
+{
+	std::vector<unsigned char> data(3 * w * h);
+	srand(42);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = rand() & 0xFF;
+	}
+	return data;
+}
+
+BOOST_AUTO_TEST_CASE(empty)
+{
+	SummedAreaTable sat;
+	BOOST_CHECK(!sat.IsOk());
+	BOOST_CHECK_EQUAL(sat.Total(), 0);
+	BOOST_CHECK_EQUAL(sat.Sum(0, 0, 10, 10), 0);
+	sat.Build(NULL, 10, 10);
+	BOOST_CHECK(!sat.IsOk());
+}
+
+BOOST_AUTO_TEST_CASE(rectangles)
+{
+	const int w = 37;
+	const int h = 23;
+	const std::vector<unsigned char> data = RandomImage(w, h);
+	SummedAreaTable sat;
+	sat.Build(&data[0], w, h);
+	BOOST_REQUIRE(sat.IsOk());
+	BOOST_CHECK_EQUAL(sat.Total(), NaiveSum(data, w, 0, 0, w, h));
+	BOOST_CHECK_EQUAL(sat.Sum(0, 0, w, h), sat.Total());
+	BOOST_CHECK_EQUAL(sat.Sum(3, 4, 17, 20), NaiveSum(data, w, 3, 4, 17, 20));
+	BOOST_CHECK_EQUAL(sat.Sum(5, 5, 6, 6), NaiveSum(data, w, 5, 5, 6, 6));
+	BOOST_CHECK_EQUAL(sat.Sum(5, 5, 5, 9), 0);
+	BOOST_CHECK_EQUAL(sat.Sum(9, 9, 5, 5), 0);
+	// out of range coordinates are clamped
+	BOOST_CHECK_EQUAL(sat.Sum(-10, -10, 1000, 1000), sat.Total());
+	BOOST_CHECK_EQUAL(sat.Sum(-10, 2, 8, 1000), NaiveSum(data, w, 0, 2, 8, h));
+}
+
+BOOST_AUTO_TEST_CASE(nooverflow)
+{
+	// a saturated 1024x1024 metal map doesn't fit into the old 24 bit sums
+	const int size = 1024;
+	const std::vector<unsigned char> data(3 * size * size, 0xFF);
+	SummedAreaTable sat;
+	sat.Build(&data[0], size, size);
+	BOOST_CHECK_EQUAL(sat.Total(), 765u * size * size);
+	BOOST_CHECK_EQUAL(sat.Sum(0, 0, size / 2, size), 765u * size * size / 2);
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	const int size = 1024;
+	const std::vector<unsigned char> data = RandomImage(size, size);
+	SummedAreaTable sat;
+	const auto start = std::chrono::steady_clock::now();
+	sat.Build(&data[0], size, size);
+	const auto end = std::chrono::steady_clock::now();
+	const double us = std::chrono::duration<double, std::micro>(end - start).count();
+	BOOST_CHECK_EQUAL(sat.Total(), NaiveSum(data, size, 0, 0, size, size));
+	BOOST_TEST_MESSAGE("built " << size << "x" << size << " table: " << us << " us");
+}
+#endif
@@ -0,0 +1,108 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE tailreader
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "testingstuff/tempfiles.h"
+#include "utils/tailreader.h"
+
+static std::vector<std::string> Tail(const std::string& data, size_t count)
+{
+	std::vector<std::string> res;
+	const std::vector<LineSpan> lines = FindTailLines(data.data(), data.size(), count);
+	for (size_t i = 0; i < lines.size(); i++) {
+		res.push_back(data.substr(lines[i].offset, lines[i].length));
+	}
+	return res;
+}
+
+static std::string Join(const std::vector<std::string>& lines)
+{
+	std::string res;
+	for (size_t i = 0; i < lines.size(); i++) {
+		res += lines[i] + "|";
+	}
+	return res;
+}
+
+BOOST_AUTO_TEST_CASE(endings)
+{
+	BOOST_CHECK_EQUAL(Join(Tail("one\ntwo\nthree\n", 2)), "two|three|");
+	BOOST_CHECK_EQUAL(Join(Tail("one\r\ntwo\r\nthree\r\n", 2)), "two|three|");
+	BOOST_CHECK_EQUAL(Join(Tail("one\r\ntwo\nthree\r\n", 5)), "one|two|three|");
+	// a lone \r is part of the line
+	BOOST_CHECK_EQUAL(Join(Tail("a\rb\n", 5)), "a\rb|");
+	// empty lines don't count
+	BOOST_CHECK_EQUAL(Join(Tail("one\n\n\r\ntwo\n\n", 2)), "one|two|");
+}
+
+BOOST_AUTO_TEST_CASE(partial)
+{
+	BOOST_CHECK_EQUAL(Join(Tail("one\ntwo\nhalf a li", 5)), "one|two|");
+	BOOST_CHECK_EQUAL(Join(Tail("one\r\ntwo\r", 5)), "one|");
+	BOOST_CHECK_EQUAL(Join(Tail("no line ending", 5)), "");
+	BOOST_CHECK_EQUAL(Join(Tail("", 5)), "");
+	BOOST_CHECK_EQUAL(Join(Tail("\n", 5)), "");
+	BOOST_CHECK_EQUAL(Join(Tail("one\ntwo\n", 0)), "");
+}
+
+BOOST_AUTO_TEST_CASE(mapping)
+{
+	const std::string path = "tailreader_test.txt";
+	FILE* f = fopen(path.c_str(), "wb");
+	BOOST_REQUIRE(f != NULL);
+	fclose(f);
+	{
+		const MappedFile empty(path);
+		BOOST_CHECK(empty.IsOk());
+		BOOST_CHECK_EQUAL(empty.Size(), 0);
+	}
+	f = fopen(path.c_str(), "wb");
+	fputs("first\nsecond\n", f);
+	fclose(f);
+	{
+		const MappedFile file(path);
+		BOOST_REQUIRE(file.IsOk());
+		BOOST_CHECK_EQUAL(std::string(file.Data(), file.Size()), "first\nsecond\n");
+	}
+	remove(path.c_str());
+	BOOST_CHECK(!MappedFile(path).IsOk());
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	// a 200MB log, loading the last lines shown when opening a channel
+	TempFiles temp;
+	const std::string path = temp.File("tailreader_benchmark.txt");
+	const std::string line = "[2016-01-01 12:34] <SomePlayer> this is a typical chat line of moderate length\n";
+	const size_t size = 200 * 1024 * 1024;
+	FILE* f = fopen(path.c_str(), "wb");
+	BOOST_REQUIRE(f != NULL);
+	std::string block;
+	while (block.size() < 1024 * 1024) {
+		block += line;
+	}
+	for (size_t written = 0; written < size; written += block.size()) {
+		fwrite(block.data(), 1, block.size(), f);
+	}
+	fclose(f);
+
+	static const size_t counts[] = {100, 1000, 100000};
+	for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		const auto start = std::chrono::steady_clock::now();
+		const MappedFile file(path);
+		BOOST_REQUIRE(file.IsOk());
+		const std::vector<LineSpan> lines = FindTailLines(file.Data(), file.Size(), counts[i]);
+		const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		BOOST_CHECK_EQUAL(lines.size(), counts[i]);
+		BOOST_CHECK_EQUAL(std::string(file.Data() + lines.back().offset, lines.back().length + 1), line);
+		const size_t count = counts[i];
+		BOOST_TEST_MESSAGE("last " << count << " lines of " << file.Size() / (1024 * 1024) << "MB: " << us << " us");
+	}
+}
+#endif
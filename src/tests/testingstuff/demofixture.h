@@ -0,0 +1,127 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_DEMOFIXTURE_H
+#define SPRINGLOBBY_HEADERGUARD_DEMOFIXTURE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+#include <string>
+
+#include "utils/demoheader.h"
+
+//! writes value little endian at offset, which has to exist in data
+inline void PutDemoInt(std::string& data, size_t offset, uint32_t value)
+{
+	for (int i = 0; i < 4; i++) {
+		data[offset + i] = (char)((value >> (8 * i)) & 0xFF);
+	}
+}
+
+inline std::string DemoInt(uint32_t value)
+{
+	std::string data(4, '\0');
+	PutDemoInt(data, 0, value);
+	return data;
+}
+
+//! a packet of the demo stream with its chunk header
+inline std::string DemoPacket(float time, const std::string& data)
+{
+	uint32_t timebits;
+	memcpy(&timebits, &time, sizeof(timebits));
+	return DemoInt(timebits) + DemoInt(data.size()) + data;
+}
+
+/** @brief builds demo files in the layout described in utils/demoheader.h
+ *
+ * The tests only set the fields they check, the sizes are derived from the
+ * script, the stream and the statistics.
+ */
+struct TestDemo {
+	TestDemo()
+	    : version(5)
+	    , extraHeaderSize(0)
+	    , versionString("103.0")
+	    , unixTime(1476792000)
+	    , gameTime(1234)
+	    , wallclockTime(1300)
+	    , maxPlayerNum(10)
+	    , numPlayers(8)
+	    , playerStatElemSize(40)
+	    , numTeams(4)
+	    , teamStatElemSize(100)
+	    , teamStatPeriod(16)
+	    , winningAllyTeam(1)
+	    , gameOver(true)
+	    , script("[GAME]\n{\n}\n")
+	{
+	}
+
+	int version;
+	size_t extraHeaderSize; //!< appended to the fields, as by a newer minor version
+	std::string versionString;
+	uint64_t unixTime;
+	int gameTime;
+	int wallclockTime;
+	int maxPlayerNum;
+	int numPlayers;
+	int playerStatElemSize;
+	int numTeams;
+	int teamStatElemSize;
+	int teamStatPeriod;
+	int winningAllyTeam;
+	//! spring writes the stream and statistics sizes only when the game ended
+	bool gameOver;
+	std::string script;
+	std::string stream;
+	std::string playerStats; //!< appended after the stream if the game ended
+
+	//! the file contents, the game id is f0f1..ff
+	std::string Build() const
+	{
+		std::string data(DemoHeader::GetFixedSize(version) + extraHeaderSize, '\0');
+		memcpy(&data[0], "spring demofile", 15);
+		PutDemoInt(data, 16, version);
+		PutDemoInt(data, 20, data.size());
+		memcpy(&data[24], versionString.data(), versionString.size());
+		size_t pos = 24 + ((version < 5) ? 16 : 256);
+		for (int i = 0; i < 16; i++) {
+			data[pos++] = (char)(0xF0 + i);
+		}
+		PutDemoInt(data, pos, (uint32_t)unixTime);
+		PutDemoInt(data, pos + 4, (uint32_t)(unixTime >> 32));
+		pos += 8;
+		const uint32_t fields[] = {(uint32_t)script.size(), gameOver ? (uint32_t)stream.size() : 0, (uint32_t)gameTime, (uint32_t)wallclockTime, (uint32_t)maxPlayerNum, (uint32_t)numPlayers,
+					   gameOver ? (uint32_t)(numPlayers * playerStatElemSize) : 0, (uint32_t)playerStatElemSize, (uint32_t)numTeams,
+					   gameOver ? (uint32_t)(numTeams * teamStatElemSize) : 0, (uint32_t)teamStatElemSize, (uint32_t)teamStatPeriod, (uint32_t)winningAllyTeam};
+		for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+			PutDemoInt(data, pos, fields[i]);
+			pos += 4;
+		}
+		data += script + stream;
+		if (gameOver)
+			data += playerStats;
+		return data;
+	}
+};
+
+//! writes data to path, gzip compressed like .sdfz demos if compress is set
+inline bool WriteDemo(const std::string& path, const std::string& data, bool compress = true)
+{
+	if (compress) {
+		gzFile file = gzopen(path.c_str(), "wb");
+		if (file == NULL)
+			return false;
+		const bool ok = gzwrite(file, data.data(), data.size()) == (int)data.size();
+		return (gzclose(file) == Z_OK) && ok;
+	}
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == NULL)
+		return false;
+	const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	return (fclose(file) == 0) && ok;
+}
+
+#endif // SPRINGLOBBY_HEADERGUARD_DEMOFIXTURE_H
@@ -0,0 +1,58 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_TEMPFILES_H
+#define SPRINGLOBBY_HEADERGUARD_TEMPFILES_H
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+//! removes the registered files and directories when leaving the scope, also after a failed BOOST_REQUIRE
+class TempFiles
+{
+public:
+	~TempFiles()
+	{
+		for (size_t i = 0; i < m_files.size(); i++) {
+			remove(m_files[i].c_str());
+		}
+		// nested directories are created after their parents
+		for (size_t i = m_dirs.size(); i > 0; i--) {
+#ifdef _WIN32
+			_rmdir(m_dirs[i - 1].c_str());
+#else
+			rmdir(m_dirs[i - 1].c_str());
+#endif
+		}
+	}
+
+	std::string File(const std::string& path)
+	{
+		m_files.push_back(path);
+		return path;
+	}
+
+	//! creates the directory, it is removed once it's empty
+	std::string Dir(const std::string& path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+		m_dirs.push_back(path);
+		return path;
+	}
+
+private:
+	std::vector<std::string> m_files;
+	std::vector<std::string> m_dirs;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_TEMPFILES_H
@@ -0,0 +1,102 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE textcompletion
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+
+#include "utils/TextCompletionDatabase.h"
+
+BOOST_AUTO_TEST_CASE(prefix)
+{
+	TextCompletionDatabase db;
+	db.Insert_Mapping(_T("glhf"), _T("Good luck, have Fun!"));
+	db.Insert_Mapping(_T("kaot"), _T("Have Fun!"));
+	db.Insert_Mapping(_T("kaot_H"), _T("Der Kaot aus der Hoelle."));
+	db.Insert_Mapping(_T("Zeus"), _T("Zeus"));
+	db.Insert_Mapping(_T("[ABC]zero"), _T("[ABC]zero"));
+	db.Insert_Mapping(_T("zed"), _T("zed"));
+	db.Insert_Mapping(_T("zed"), _T("ignored"));
+	BOOST_CHECK_EQUAL(db.Size(), 6);
+
+	wxArrayString matches;
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("KAO"), matches), 2);
+	BOOST_CHECK(matches[0] == _T("Have Fun!"));
+	BOOST_CHECK(matches[1] == _T("Der Kaot aus der Hoelle."));
+
+	// case insensitive order, independent of insertion order
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("z"), matches), 2);
+	BOOST_CHECK(matches[0] == _T("zed"));
+	BOOST_CHECK(matches[1] == _T("Zeus"));
+
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("[abc]"), matches), 1);
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("xyz"), matches), 0);
+
+	// no prefix matches, substrings are matched then
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("LHF"), matches), 1);
+	BOOST_CHECK(matches[0] == _T("Good luck, have Fun!"));
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("aot"), matches), 2);
+	// a prefix match hides substring matches
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("ze"), matches), 2);
+
+	db.Delete_Mapping(_T("Zeus"));
+	db.Delete_Mapping(_T("unknown"));
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("ze"), matches), 1);
+	BOOST_CHECK_EQUAL(db.Size(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(bulk)
+{
+	TextCompletionDatabase db;
+	db.Insert_Mapping(_T("bob"), _T("Bob the builder"));
+	wxArrayString nicks;
+	nicks.Add(_T("zed"));
+	nicks.Add(_T("Alice"));
+	nicks.Add(_T("bob"));
+	nicks.Add(_T("[ABC]zero"));
+	nicks.Add(_T("alice"));
+	db.Insert_Mappings(nicks);
+	BOOST_CHECK_EQUAL(db.Size(), 5);
+
+	wxArrayString matches;
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("b"), matches), 1);
+	// existing mappings are kept
+	BOOST_CHECK(matches[0] == _T("Bob the builder"));
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("ALI"), matches), 2);
+	matches.Clear();
+	BOOST_CHECK_EQUAL(db.GetMatches(_T("[abc]z"), matches), 1);
+	BOOST_CHECK(matches[0] == _T("[ABC]zero"));
+}
+
+#ifdef BENCHMARK
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	TextCompletionDatabase db;
+	const int users = 5000;
+	for (int i = 0; i < users; i++) {
+		const wxString nick = wxString::Format(_T("[CLAN%d]Player%d"), i % 50, i);
+		db.Insert_Mapping(nick, nick);
+	}
+	BOOST_CHECK_EQUAL(db.Size(), users);
+
+	const size_t iterations = 1000;
+	size_t found = 0;
+	wxArrayString matches;
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		matches.Clear();
+		found += db.GetMatches(_T("[clan1]player1"), matches);
+	}
+	const auto end = std::chrono::steady_clock::now();
+	// [CLAN1]Player1, [CLAN1]Player101, [CLAN1]Player151 and 20 of [CLAN1]Player1xxx
+	BOOST_CHECK_EQUAL(found, iterations * 23);
+	const double us = std::chrono::duration<double, std::micro>(end - start).count();
+	BOOST_TEST_MESSAGE("completion with " << users << " users: " << us / iterations << " us/lookup");
+}
+#endif
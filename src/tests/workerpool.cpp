@@ -0,0 +1,137 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+#define BOOST_TEST_MODULE workerpool
+
+#include <boost/test/unit_test.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "testingstuff/demofixture.h"
+#include "testingstuff/tempfiles.h"
+#include "utils/demoheader.h"
+#include "utils/workerpool.h"
+
+BOOST_AUTO_TEST_CASE(run)
+{
+	static const size_t COUNT = 1000;
+	std::vector<int> runs(COUNT, 0);
+	std::vector<int> reported(COUNT, 0);
+	size_t batches = 0;
+	WorkerPool::Run(COUNT, 4, 64, [&runs](size_t index) { runs[index]++; }, [&](const std::vector<size_t>& indexes) {
+			batches++;
+			for (size_t index : indexes) {
+				// only finished jobs are reported
+				BOOST_CHECK_EQUAL(runs[index], 1);
+				reported[index]++;
+			}
+		});
+	for (size_t i = 0; i < COUNT; i++) {
+		BOOST_CHECK_EQUAL(runs[i], 1);
+		BOOST_CHECK_EQUAL(reported[i], 1);
+	}
+	BOOST_CHECK(batches > 0);
+
+	// nothing to do
+	WorkerPool::Run(0, 4, 64, [](size_t) { BOOST_ERROR("no jobs"); }, [](const std::vector<size_t>&) { BOOST_ERROR("no batches"); });
+}
+
+#ifdef BENCHMARK
+static const std::string DIR = "workerpool_test/";
+
+//! a version 5 demo of a short game with 16 players, the stream is skipped when listing
+static bool WriteReplay(const std::string& path, int num)
+{
+	std::ostringstream script;
+	script << "[GAME]\n{\n\tMapName=DeltaSiegeDry;\n\tGameType=Balanced Annihilation V9.46;\n\tNumPlayers=16;\n";
+	for (int i = 0; i < 16; i++) {
+		script << "\t[PLAYER" << i << "]\n\t{\n\t\tName=Player" << num << "_" << i << ";\n\t\tCountryCode=DE;\n\t\tSpectator=" << (i > 11) << ";\n\t\tTeam=" << i << ";\n\t}\n";
+		script << "\t[TEAM" << i << "]\n\t{\n\t\tTeamLeader=" << i << ";\n\t\tAllyTeam=" << i % 2 << ";\n\t\tRGBColor=0.5 0.5 0.5;\n\t\tSide=ARM;\n\t}\n";
+	}
+	script << "}\n";
+
+	// frames and commands of 5 minutes
+	std::string stream;
+	unsigned rnd = num;
+	for (int frame = 0; frame < 5 * 60 * 30; frame++) {
+		const float time = frame / 30.0f;
+		stream += DemoPacket(time, std::string("\x02", 1));
+		rnd = rnd * 1103515245 + 12345;
+		for (unsigned i = 0; i < (rnd >> 16) % 4; i++) {
+			std::string command(20 + (rnd >> 8) % 40, '\x0b');
+			command[4] = (char)(rnd >> 3);
+			stream += DemoPacket(time, command);
+		}
+	}
+
+	TestDemo demo;
+	demo.gameTime = 600 + num;
+	demo.script = script.str();
+	demo.stream = stream;
+	return WriteDemo(path, demo.Build());
+}
+
+struct ParsedReplay {
+	int duration;
+	size_t players;
+};
+
+//! the reads of ReplayList::GetReplayInfos, which needs unitsync for the battle
+static bool ParseReplay(const std::string& path, ParsedReplay& replay)
+{
+	DemoReader reader(path);
+	DemoHeader header;
+	std::string script;
+	if (!reader.IsOk() || !reader.ReadHeader(header) || !reader.ReadScript(header, script) || script.empty())
+		return false;
+	replay.duration = header.gameTime;
+	replay.players = 0;
+	for (size_t pos = script.find("Spectator=0"); pos != std::string::npos; pos = script.find("Spectator=0", pos + 1)) {
+		replay.players++;
+	}
+	return true;
+}
+
+BOOST_AUTO_TEST_CASE(benchmark)
+{
+	static const int COUNT = 200;
+	TempFiles temp;
+	temp.Dir(DIR);
+	std::vector<std::string> paths;
+	for (int i = 0; i < COUNT; i++) {
+		std::ostringstream path;
+		path << DIR << "20161018_" << 100000 + i << "_DeltaSiegeDry_103.sdfz";
+		paths.push_back(temp.File(path.str()));
+		BOOST_REQUIRE(WriteReplay(paths.back(), i));
+	}
+
+	std::vector<size_t> threads = {1, 2, 4};
+	if (WorkerPool::GetDefaultThreadCount() > 4)
+		threads.push_back(WorkerPool::GetDefaultThreadCount());
+	double onethreadms = 0;
+	for (size_t count : threads) {
+		std::vector<ParsedReplay> parsed(COUNT);
+		std::vector<char> ok(COUNT, 0);
+		size_t reported = 0;
+		double firstms = 0;
+		const auto start = std::chrono::steady_clock::now();
+		WorkerPool::Run(COUNT, count, 20, [&](size_t index) { ok[index] = ParseReplay(paths[index], parsed[index]); }, [&](const std::vector<size_t>& indexes) {
+				if (reported == 0)
+					firstms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				reported += indexes.size();
+			});
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		BOOST_CHECK_EQUAL(reported, COUNT);
+		for (int i = 0; i < COUNT; i++) {
+			BOOST_CHECK(ok[i]);
+			BOOST_CHECK_EQUAL(parsed[i].duration, 600 + i);
+			BOOST_CHECK_EQUAL(parsed[i].players, 12);
+		}
+		if (count == 1)
+			onethreadms = ms;
+		BOOST_TEST_MESSAGE("parsed " << COUNT << " replays on " << count << " threads in " << ms << " ms, " << onethreadms / ms << "x, first batch after " << firstms << " ms");
+	}
+}
+#endif
@@ -4,11 +4,15 @@
 #define TEXTCOMPLETIONDATABASE_HPP
 
 // wxWidgets
-#include <wx/hashmap.h>
+#include <wx/arrstr.h>
 #include <wx/string.h>
-WX_DECLARE_STRING_HASH_MAP(wxString, HashMap_String_String);
 
+#include <map>
+#include <utility>
 
+/** case insensitive prefix lookup of abbreviations (and nicks) to their completion,
+ * falls back to matching anywhere in the abbreviation
+ */
 class TextCompletionDatabase
 {
 public:
@@ -18,11 +22,19 @@ public:
 	unsigned int Size();
 
 	void Insert_Mapping(const wxString& abbreviation, const wxString& mapping);
+	//! inserts many abbreviations mapped to themselves, e.g. the nicks of a channel
+	void Insert_Mappings(const wxArrayString& abbreviations);
 	void Delete_Mapping(const wxString& abbreviation);
-	HashMap_String_String GetMapping(wxString text);
+	size_t GetMatches(const wxString& prefix, wxArrayString& matches) const;
 
 private:
-	HashMap_String_String hm;
+	//! lower case abbreviation first, so all entries with the same prefix are adjacent
+	typedef std::pair<wxString, wxString> Key;
+	typedef std::map<Key, wxString> MappingMap;
+
+	static Key MakeKey(const wxString& abbreviation);
+
+	MappingMap m_mappings;
 };
 
 #endif // TEXTCOMPLETIONDATABASE_HPP
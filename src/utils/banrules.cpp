@@ -0,0 +1,243 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "banrules.h"
+
+#include <algorithm>
+#include <cctype>
+
+//! the cache is dropped when it grows beyond this, a channel rarely sees as many different nicks
+static const size_t MAX_CACHED_VERDICTS = 65536;
+
+BanRules::BanRules()
+{
+}
+
+void BanRules::BanNick(const std::string& nick)
+{
+	m_banned_nicks.insert(nick);
+}
+
+void BanRules::UnbanNick(const std::string& nick)
+{
+	m_banned_nicks.erase(nick);
+}
+
+bool BanRules::SetBanPattern(const std::string& pattern)
+{
+	m_verdicts.clear();
+	return m_ban.Set(pattern);
+}
+
+bool BanRules::SetUnbanPattern(const std::string& pattern)
+{
+	m_verdicts.clear();
+	return m_unban.Set(pattern);
+}
+
+bool BanRules::Pattern::Set(const std::string& pattern)
+{
+	enabled = false;
+	literal.clear();
+	if (pattern.empty())
+		return true;
+#ifdef wxHAS_REGEX_ADVANCED
+	if (!regex.Compile(wxString::FromUTF8(pattern.c_str()), wxRE_ADVANCED))
+		return false;
+#else
+	if (!regex.Compile(wxString::FromUTF8(pattern.c_str()), wxRE_EXTENDED))
+		return false;
+#endif
+	literal = GetRequiredLiteral(pattern);
+	enabled = true;
+	return true;
+}
+
+bool BanRules::Pattern::Matches(const std::string& nick) const
+{
+	if (!enabled)
+		return false;
+	if (!literal.empty() && (nick.find(literal) == std::string::npos))
+		return false;
+	return regex.Matches(wxString::FromUTF8(nick.c_str()));
+}
+
+bool BanRules::MatchesPatterns(const std::string& nick)
+{
+	if (!m_ban.enabled)
+		return false;
+	const std::unordered_map<std::string, bool>::const_iterator it = m_verdicts.find(nick);
+	if (it != m_verdicts.end())
+		return it->second;
+	const bool banned = m_ban.Matches(nick) && !m_unban.Matches(nick);
+	if (m_verdicts.size() >= MAX_CACHED_VERDICTS) {
+		m_verdicts.clear();
+	}
+	m_verdicts[nick] = banned;
+	return banned;
+}
+
+BanRules::Verdict BanRules::Check(const std::string& nick)
+{
+	if (m_banned_nicks.count(nick) > 0)
+		return BANNED_NICK;
+	if (MatchesPatterns(nick))
+		return BANNED_PATTERN;
+	return NOT_BANNED;
+}
+
+size_t BanRules::CheckAll(const std::vector<std::string>& nicks, std::vector<Hit>& banned)
+{
+	const size_t count = banned.size();
+	if (m_banned_nicks.empty() && !m_ban.enabled)
+		return 0;
+	for (size_t i = 0; i < nicks.size(); i++) {
+		Hit hit;
+		hit.verdict = Check(nicks[i]);
+		if (hit.verdict != NOT_BANNED) {
+			hit.index = i;
+			banned.push_back(hit);
+		}
+	}
+	return banned.size() - count;
+}
+
+//! @returns the number of chars after the escape letter at pos which belong to the escape
+static size_t GetEscapeOperandLength(const std::string& pattern, size_t pos)
+{
+	size_t length = 0;
+	switch (pattern[pos]) {
+		case 'x': // \xhhh..., as many hex digits as follow
+			while ((pos + length + 1 < pattern.size()) && isxdigit((unsigned char)pattern[pos + length + 1]))
+				length++;
+			return length;
+		case 'u': // \uhhhh
+			length = 4;
+			break;
+		case 'U': // \Uhhhhhhhh
+			length = 8;
+			break;
+		case 'c': // \cX, control char
+			length = 1;
+			break;
+		default:
+			// octal chars and back references, all following digits
+			if (!isdigit((unsigned char)pattern[pos]))
+				return 0;
+			while ((pos + length + 1 < pattern.size()) && isdigit((unsigned char)pattern[pos + length + 1]))
+				length++;
+			return length;
+	}
+	return std::min(length, pattern.size() - pos - 1);
+}
+
+//! @returns the position of the ']' closing the bracket expression opened at pos
+static size_t SkipBracket(const std::string& pattern, size_t pos)
+{
+	size_t i = pos + 1;
+	if ((i < pattern.size()) && (pattern[i] == '^'))
+		i++;
+	if ((i < pattern.size()) && (pattern[i] == ']')) // a leading ] is a member
+		i++;
+	while (i < pattern.size()) {
+		const char c = pattern[i];
+		if ((c == '[') && (i + 1 < pattern.size()) && ((pattern[i + 1] == ':') || (pattern[i + 1] == '.') || (pattern[i + 1] == '='))) {
+			// [:class:], [.collating element.] and [=equivalence class=]
+			const size_t end = pattern.find(std::string(1, pattern[i + 1]) + "]", i + 2);
+			if (end == std::string::npos)
+				return pattern.size();
+			i = end + 2;
+			continue;
+		}
+		if (c == ']')
+			return i;
+		if (c == '\\') // escapes are allowed in brackets of advanced patterns
+			i++;
+		i++;
+	}
+	return pattern.size();
+}
+
+std::string BanRules::GetRequiredLiteral(const std::string& pattern)
+{
+	// directors (***= and ***:) and embedded options like (?i) change the meaning of the rest
+	if ((pattern.compare(0, 3, "***") == 0) || ((pattern.compare(0, 2, "(?") == 0) && (pattern.size() > 2) && isalpha((unsigned char)pattern[2])))
+		return std::string();
+
+	// alternatives don't share a required literal
+	for (size_t i = 0; i < pattern.size(); i++) {
+		if (pattern[i] == '\\') {
+			i++;
+		} else if (pattern[i] == '|') {
+			return std::string();
+		}
+	}
+
+	// longest run of plain chars outside of groups and brackets
+	std::string best;
+	std::string run;
+	int depth = 0;
+	for (size_t i = 0; i < pattern.size(); i++) {
+		const char c = pattern[i];
+		std::string literal; // the char(s) this token matches literally
+		switch (c) {
+			case '(':
+				depth++;
+				break;
+			case ')':
+				depth--;
+				break;
+			case '[': // skip the bracket expression
+				i = SkipBracket(pattern, i);
+				break;
+			case '\\':
+				if (i + 1 < pattern.size()) {
+					i++;
+					// escaped punctuation is literal, letters and digits are classes, constraints or references
+					if (!isalnum((unsigned char)pattern[i]) && ((unsigned char)pattern[i] < 0x80)) {
+						literal = pattern[i];
+					} else {
+						// skip the operands of char escapes, \x41 is one char and doesn't contain "41"
+						i += GetEscapeOperandLength(pattern, i);
+					}
+				}
+				break;
+			case '{': // skip the repetition count
+				while ((i + 1 < pattern.size()) && (pattern[i] != '}'))
+					i++;
+				break;
+			case '.':
+			case '^':
+			case '$':
+			case '*':
+			case '+':
+			case '?':
+				break;
+			default:
+				// a quantifier applies to the whole utf-8 sequence, not to its last byte
+				if ((unsigned char)c < 0x80)
+					literal = c;
+		}
+
+		if ((depth == 0) && (c != ')') && !literal.empty()) {
+			// a following quantifier may make this char optional
+			const char next = (i + 1 < pattern.size()) ? pattern[i + 1] : '\0';
+			if ((next == '?') || (next == '*') || (next == '{')) {
+				literal.clear();
+			} else {
+				run += literal;
+				if (next == '+') { // the char is required, but may repeat
+					if (run.size() > best.size())
+						best = run;
+					run.clear();
+				}
+				continue;
+			}
+		}
+		if (run.size() > best.size())
+			best = run;
+		run.clear();
+	}
+	if (run.size() > best.size())
+		best = run;
+	return best;
+}
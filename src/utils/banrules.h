@@ -0,0 +1,86 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_BANRULES_H
+#define SPRINGLOBBY_HEADERGUARD_BANRULES_H
+
+#include <wx/regex.h>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** @brief decides which nicks are banned from a channel
+ *
+ * Nicks are banned when they were banned by name, or when they match the ban
+ * pattern but not the unban pattern. Patterns are compiled once when set, a
+ * literal which every match has to contain is used to reject most nicks with
+ * a plain substring search, and the verdict is cached per nick until the
+ * patterns change.
+ */
+class BanRules
+{
+public:
+	enum Verdict {
+		NOT_BANNED,
+		BANNED_NICK,   //!< banned by name
+		BANNED_PATTERN //!< matches the ban pattern
+	};
+
+	BanRules();
+
+	void BanNick(const std::string& nick);
+	void UnbanNick(const std::string& nick);
+
+	/** sets the (unanchored) patterns, an empty one disables it
+	 *
+	 * Patterns are compiled by wxRegEx, with the advanced (ARE) syntax where
+	 * wx supports it and the extended one otherwise.
+	 * @returns false if the pattern is invalid, it is disabled then
+	 */
+	bool SetBanPattern(const std::string& pattern);
+	bool SetUnbanPattern(const std::string& pattern);
+
+	Verdict Check(const std::string& nick);
+
+	struct Hit {
+		size_t index; //!< of the nick in the checked batch
+		Verdict verdict;
+	};
+
+	/** checks a whole batch of nicks at once
+	 * @param banned the banned nicks are appended
+	 * @returns the number of banned nicks
+	 */
+	size_t CheckAll(const std::vector<std::string>& nicks, std::vector<Hit>& banned);
+
+	/** @returns a literal which every match of pattern contains, empty if there is none
+	 *
+	 * Constructs which aren't understood give no literal, the prefilter is
+	 * skipped for them.
+	 */
+	static std::string GetRequiredLiteral(const std::string& pattern);
+
+private:
+	struct Pattern {
+		Pattern()
+		    : enabled(false)
+		{
+		}
+		bool Set(const std::string& pattern);
+		bool Matches(const std::string& nick) const;
+
+		bool enabled;
+		wxRegEx regex;
+		std::string literal;
+	};
+
+	bool MatchesPatterns(const std::string& nick);
+
+	std::set<std::string> m_banned_nicks;
+	Pattern m_ban;
+	Pattern m_unban;
+	std::unordered_map<std::string, bool> m_verdicts; //!< pattern verdicts by nick
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_BANRULES_H
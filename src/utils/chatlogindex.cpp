@@ -0,0 +1,992 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "chatlogindex.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+
+#include "compressedlog.h"
+#include "tailreader.h"
+#include "utf8file.h"
+
+const size_t ChatLogIndex::MAX_SEGMENTS;
+const uint64_t ChatLogIndex::MERGE_FACTOR;
+const size_t ChatLogIndex::MAX_MEMORY_POSTINGS;
+const size_t ChatLogIndex::MIN_WORD;
+const size_t ChatLogIndex::MAX_WORD;
+const int64_t ChatLogIndex::TIME_MARK_INTERVAL;
+
+//! a posting is the file id in the upper bits and the line offset in the lower ones
+static const int OFFSET_BITS = 40;
+static const uint64_t OFFSET_MASK = (uint64_t(1) << OFFSET_BITS) - 1;
+
+//! words a query word may expand to per segment, bounds the time of very short prefixes
+static const size_t MAX_EXPANSIONS = 4096;
+
+static const char SEGMENT_MAGIC[8] = {'S', 'L', 'I', 'D', 'X', '0', '0', '1'};
+static const size_t SEGMENT_HEADER = 24;
+static const char* MANIFEST = "manifest";
+
+static inline uint64_t MakeId(size_t fileid, uint64_t offset)
+{
+	return (uint64_t(fileid) << OFFSET_BITS) | offset;
+}
+
+static inline bool IsWordChar(unsigned char c)
+{
+	return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c >= 0x80);
+}
+
+static inline char ToLower(char c)
+{
+	return ((c >= 'A') && (c <= 'Z')) ? c - 'A' + 'a' : c;
+}
+
+static bool StartsWith(const char* str, size_t len, const std::string& prefix)
+{
+	return (len >= prefix.size()) && (memcmp(str, prefix.data(), prefix.size()) == 0);
+}
+
+static void PutVarint(std::string& out, uint64_t value)
+{
+	while (value >= 0x80) {
+		out += (char)((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	out += (char)value;
+}
+
+static bool GetVarint(const unsigned char*& pos, const unsigned char* end, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; (pos < end) && (shift < 64); shift += 7) {
+		const unsigned char c = *pos++;
+		value |= uint64_t(c & 0x7F) << shift;
+		if ((c & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+static void PutUint64(std::string& out, uint64_t value)
+{
+	for (int i = 0; i < 8; i++) {
+		out += (char)((value >> (8 * i)) & 0xFF);
+	}
+}
+
+static uint64_t GetUint64(const char* data)
+{
+	uint64_t value = 0;
+	for (int i = 7; i >= 0; i--) {
+		value = (value << 8) | (unsigned char)data[i];
+	}
+	return value;
+}
+
+/** Segment layout, integers little endian:
+ * magic[8], uint64 word count, uint64 table offset
+ * postings of all words: varint deltas of the sorted ids
+ * entries: varint length, word, varint postings offset, varint count, varint bytes
+ * table: uint64 offset of every entry, sorted by word
+ */
+class SegmentWriter
+{
+public:
+	SegmentWriter()
+	    : m_file(NULL)
+	    , m_pos(0)
+	{
+	}
+	~SegmentWriter()
+	{
+		if (m_file != NULL)
+			fclose(m_file);
+	}
+
+	bool Open(const std::string& path)
+	{
+		m_file = Utf8Open(path, "wb");
+		if (m_file == NULL)
+			return false;
+		// the header is written by Finish()
+		m_buffer.assign(SEGMENT_HEADER, '\0');
+		m_pos = 0;
+		return true;
+	}
+
+	//! ids have to be sorted and unique, words added in ascending order
+	void Add(const std::string& word, const std::vector<uint64_t>& ids)
+	{
+		const size_t start = m_buffer.size();
+		uint64_t last = 0;
+		for (size_t i = 0; i < ids.size(); i++) {
+			PutVarint(m_buffer, ids[i] - last);
+			last = ids[i];
+		}
+		std::string& entry = m_entries;
+		m_entry_offsets.push_back(entry.size());
+		PutVarint(entry, word.size());
+		entry += word;
+		PutVarint(entry, m_pos + start);
+		PutVarint(entry, ids.size());
+		PutVarint(entry, m_buffer.size() - start);
+		if (m_buffer.size() > 1024 * 1024)
+			WriteBuffer();
+	}
+
+	bool Finish()
+	{
+		if (m_file == NULL)
+			return false;
+		const uint64_t entries = m_pos + m_buffer.size();
+		m_buffer += m_entries;
+		const uint64_t table = entries + m_entries.size();
+		for (size_t i = 0; i < m_entry_offsets.size(); i++) {
+			PutUint64(m_buffer, entries + m_entry_offsets[i]);
+		}
+		WriteBuffer();
+		std::string header(SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+		PutUint64(header, m_entry_offsets.size());
+		PutUint64(header, table);
+		bool ok = !ferror(m_file) && (fseek(m_file, 0, SEEK_SET) == 0) && (fwrite(header.data(), 1, header.size(), m_file) == header.size());
+		ok = (fclose(m_file) == 0) && ok;
+		m_file = NULL;
+		return ok;
+	}
+
+private:
+	void WriteBuffer()
+	{
+		fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+		m_pos += m_buffer.size();
+		m_buffer.clear();
+	}
+
+	FILE* m_file;
+	uint64_t m_pos; //!< file position of the buffer
+	std::string m_buffer;
+	std::string m_entries;
+	std::vector<uint64_t> m_entry_offsets;
+};
+
+//! read access to a mapped segment
+class SegmentReader
+{
+public:
+	struct Entry {
+		const char* word;
+		size_t length;
+		uint64_t offset;
+		uint64_t count;
+		uint64_t bytes;
+	};
+
+	explicit SegmentReader(const MappedFile& file)
+	    : m_data(file.Data())
+	    , m_size(file.Size())
+	    , m_count(0)
+	    , m_table(0)
+	{
+		if ((m_size < SEGMENT_HEADER) || (memcmp(m_data, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0))
+			return;
+		m_count = GetUint64(m_data + 8);
+		m_table = GetUint64(m_data + 16);
+		if ((m_table < SEGMENT_HEADER) || (m_table > m_size) || (m_count > (m_size - m_table) / 8)) {
+			m_count = 0;
+			m_table = 0;
+		}
+	}
+
+	bool IsOk() const
+	{
+		return m_table != 0;
+	}
+	size_t Count() const
+	{
+		return m_count;
+	}
+
+	bool GetEntry(size_t index, Entry& entry) const
+	{
+		const uint64_t pos = GetUint64(m_data + m_table + 8 * index);
+		if (pos >= m_size)
+			return false;
+		const unsigned char* p = (const unsigned char*)m_data + pos;
+		const unsigned char* end = (const unsigned char*)m_data + m_size;
+		uint64_t length;
+		if (!GetVarint(p, end, length) || (length > (uint64_t)(end - p)))
+			return false;
+		entry.word = (const char*)p;
+		entry.length = length;
+		p += length;
+		if (!GetVarint(p, end, entry.offset) || !GetVarint(p, end, entry.count) || !GetVarint(p, end, entry.bytes))
+			return false;
+		return (entry.offset <= m_size) && (entry.bytes <= m_size - entry.offset);
+	}
+
+	//! index of the first word not less than word
+	size_t LowerBound(const std::string& word) const
+	{
+		size_t lo = 0, hi = m_count;
+		Entry entry;
+		while (lo < hi) {
+			const size_t mid = lo + (hi - lo) / 2;
+			if (!GetEntry(mid, entry))
+				return m_count;
+			const int cmp = memcmp(entry.word, word.data(), std::min(entry.length, word.size()));
+			if ((cmp < 0) || ((cmp == 0) && (entry.length < word.size()))) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+
+	void Decode(const Entry& entry, std::vector<uint64_t>& ids) const
+	{
+		const unsigned char* p = (const unsigned char*)m_data + entry.offset;
+		const unsigned char* end = p + entry.bytes;
+		uint64_t id = 0;
+		for (uint64_t i = 0; i < entry.count; i++) {
+			uint64_t delta;
+			if (!GetVarint(p, end, delta))
+				return;
+			id += delta;
+			ids.push_back(id);
+		}
+	}
+
+private:
+	const char* m_data;
+	size_t m_size;
+	size_t m_count;
+	uint64_t m_table;
+};
+
+//! text of a plain or compressed log, compressed ones are read a few blocks at a time
+class LogText
+{
+public:
+	explicit LogText(const std::string& path)
+	    : m_first(0)
+	    , m_last(0)
+	    , m_base(0)
+	{
+		if (CompressedLog::IsCompressed(path)) {
+			m_compressed.reset(new CompressedLog(path));
+		} else {
+			m_mapped.reset(new MappedFile(path));
+		}
+	}
+
+	bool IsOk() const
+	{
+		return m_compressed ? m_compressed->IsOk() : m_mapped->IsOk();
+	}
+
+	//! makes the text around offset available, with the block before and after it
+	bool Load(uint64_t offset)
+	{
+		if (!m_compressed)
+			return true;
+		const size_t block = m_compressed->FindBlock(offset);
+		if (block >= m_compressed->GetBlockCount())
+			return false;
+		const size_t first = (block > 0) ? block - 1 : 0;
+		const size_t last = std::min(block + 2, m_compressed->GetBlockCount());
+		if ((first == m_first) && (last == m_last))
+			return true;
+		m_buffer.clear();
+		std::string data;
+		for (size_t i = first; i < last; i++) {
+			if (!m_compressed->ReadBlock(i, data)) {
+				m_last = m_first;
+				return false;
+			}
+			m_buffer += data;
+		}
+		m_first = first;
+		m_last = last;
+		m_base = m_compressed->GetBlockOffset(first);
+		return true;
+	}
+
+	const char* Data() const
+	{
+		return m_compressed ? m_buffer.data() : m_mapped->Data();
+	}
+	size_t Size() const
+	{
+		return m_compressed ? m_buffer.size() : m_mapped->Size();
+	}
+	//! text offset of Data()
+	uint64_t Base() const
+	{
+		return m_base;
+	}
+
+private:
+	std::unique_ptr<MappedFile> m_mapped;
+	std::unique_ptr<CompressedLog> m_compressed;
+	std::string m_buffer;
+	size_t m_first, m_last; //!< loaded blocks
+	uint64_t m_base;
+};
+
+static void SortUnique(std::vector<uint64_t>& ids)
+{
+	std::sort(ids.begin(), ids.end());
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+ChatLogIndex::ChatLogIndex(const std::string& root, const std::string& indexdir)
+    : m_root(root)
+    , m_indexdir(indexdir)
+    , m_memory_postings(0)
+    , m_next_segment(0)
+    , m_generation(0)
+    , m_merging(false)
+{
+	if (!m_indexdir.empty() && (m_indexdir[m_indexdir.size() - 1] != '/') && (m_indexdir[m_indexdir.size() - 1] != '\\')) {
+		m_indexdir += '/';
+	}
+	boost::mutex::scoped_lock lock(m_mutex);
+	Load();
+}
+
+ChatLogIndex::~ChatLogIndex()
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	CommitLocked();
+}
+
+void ChatLogIndex::Tokenize(const char* data, size_t size, std::vector<std::string>& words)
+{
+	words.clear();
+	size_t i = 0;
+	while (i < size) {
+		while ((i < size) && !IsWordChar(data[i]))
+			i++;
+		const size_t start = i;
+		while ((i < size) && IsWordChar(data[i]))
+			i++;
+		const size_t length = i - start;
+		if (length < MIN_WORD)
+			continue;
+		std::string word(data + start, std::min(length, MAX_WORD));
+		std::transform(word.begin(), word.end(), word.begin(), ToLower);
+		words.push_back(word);
+	}
+}
+
+size_t ChatLogIndex::GetSegmentCount()
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	return m_segments.size();
+}
+
+void ChatLogIndex::Load()
+{
+	const MappedFile file(m_indexdir + MANIFEST);
+	if (!file.IsOk() || (file.Size() == 0))
+		return;
+	std::istringstream manifest(std::string(file.Data(), file.Size()));
+	std::string line;
+	if (!std::getline(manifest, line) || (line != "SLIDX 1"))
+		return;
+	while (std::getline(manifest, line)) {
+		std::istringstream fields(line);
+		std::string type;
+		fields >> type;
+		if (type == "next") {
+			fields >> m_next_segment;
+		} else if (type == "segment") {
+			Segment segment;
+			fields >> segment.name;
+			segment.file = OpenSegment(segment.name);
+			if (!segment.file) {
+				// the postings are incomplete, start over
+				ClearLocked();
+				return;
+			}
+			m_segments.push_back(segment);
+		} else if (type == "file") {
+			File file;
+			fields >> file.indexed;
+			fields.get();
+			std::getline(fields, file.path);
+			m_file_ids[file.path] = m_files.size();
+			m_files.push_back(file);
+		} else if ((type == "time") && !m_files.empty()) {
+			// belongs to the file listed before
+			TimeMark mark;
+			fields >> mark.offset >> mark.time;
+			if (fields)
+				m_files.back().times.push_back(mark);
+		}
+	}
+}
+
+std::shared_ptr<MappedFile> ChatLogIndex::OpenSegment(const std::string& name)
+{
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(m_indexdir + name);
+	if (!file->IsOk() || !SegmentReader(*file).IsOk())
+		return std::shared_ptr<MappedFile>();
+	return file;
+}
+
+bool ChatLogIndex::SaveManifest()
+{
+	const std::string path = m_indexdir + MANIFEST;
+	const std::string tmp = path + ".tmp";
+	std::ostringstream manifest;
+	manifest << "SLIDX 1\n";
+	manifest << "next " << m_next_segment << "\n";
+	for (size_t i = 0; i < m_segments.size(); i++) {
+		manifest << "segment " << m_segments[i].name << "\n";
+	}
+	for (size_t i = 0; i < m_files.size(); i++) {
+		manifest << "file " << m_files[i].indexed << " " << m_files[i].path << "\n";
+		for (size_t n = 0; n < m_files[i].times.size(); n++) {
+			manifest << "time " << m_files[i].times[n].offset << " " << m_files[i].times[n].time << "\n";
+		}
+	}
+	const std::string text = manifest.str();
+	FILE* file = Utf8Open(tmp, "wb");
+	if (file == NULL)
+		return false;
+	bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+	ok = (fclose(file) == 0) && ok;
+	return ok && Utf8Rename(tmp, path);
+}
+
+std::string ChatLogIndex::NewSegmentName()
+{
+	std::ostringstream name;
+	name << "segment" << m_next_segment++ << ".idx";
+	return name.str();
+}
+
+void ChatLogIndex::ClearLocked()
+{
+	for (size_t i = 0; i < m_segments.size(); i++) {
+		m_segments[i].file.reset();
+		Utf8Remove(m_indexdir + m_segments[i].name);
+	}
+	m_segments.clear();
+	m_generation++;
+	m_files.clear();
+	m_file_ids.clear();
+	m_memory.clear();
+	m_memory_postings = 0;
+}
+
+bool ChatLogIndex::WriteSegment(const std::string& name, const Postings& postings)
+{
+	const std::string path = m_indexdir + name;
+	SegmentWriter writer;
+	if (!writer.Open(path + ".tmp"))
+		return false;
+	std::vector<const Postings::value_type*> sorted;
+	sorted.reserve(postings.size());
+	for (Postings::const_iterator it = postings.begin(); it != postings.end(); ++it) {
+		sorted.push_back(&*it);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const Postings::value_type* a, const Postings::value_type* b) { return a->first < b->first; });
+	std::vector<uint64_t> ids;
+	for (size_t i = 0; i < sorted.size(); i++) {
+		ids = sorted[i]->second;
+		SortUnique(ids);
+		writer.Add(sorted[i]->first, ids);
+	}
+	return writer.Finish() && Utf8Rename(path + ".tmp", path);
+}
+
+bool ChatLogIndex::MergeSegments()
+{
+	// pick the segments under the lock, merge them without it
+	std::vector<Segment> merging;
+	size_t first = 0;
+	unsigned generation = 0;
+	std::string name;
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		if (m_merging || (m_segments.size() <= MAX_SEGMENTS))
+			return true;
+		// the youngest segments, and older ones not much larger than them, so
+		// the old large segments are rewritten rarely
+		first = m_segments.size() - 2;
+		uint64_t size = m_segments[first].file->Size() + m_segments[first + 1].file->Size();
+		while ((first > 0) && ((first >= MAX_SEGMENTS) || (m_segments[first - 1].file->Size() <= size * MERGE_FACTOR))) {
+			first--;
+			size += m_segments[first].file->Size();
+		}
+		merging.assign(m_segments.begin() + first, m_segments.end());
+		generation = m_generation;
+		name = NewSegmentName();
+		m_merging = true;
+	}
+
+	const std::string path = m_indexdir + name;
+	bool ok = WriteMerged(path + ".tmp", merging) && Utf8Rename(path + ".tmp", path);
+	Segment merged;
+	merged.name = name;
+	if (ok) {
+		merged.file = OpenSegment(name);
+		ok = (bool)merged.file;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_merging = false;
+		// cleared meanwhile, only commits append segments otherwise
+		if (ok && (m_generation == generation)) {
+			m_segments.erase(m_segments.begin() + first, m_segments.begin() + first + merging.size());
+			m_segments.insert(m_segments.begin() + first, merged);
+			ok = SaveManifest();
+		} else {
+			ok = false;
+		}
+	}
+	if (!ok) {
+		merged.file.reset();
+		Utf8Remove(path);
+		return false;
+	}
+	for (size_t i = 0; i < merging.size(); i++) {
+		merging[i].file.reset();
+		Utf8Remove(m_indexdir + merging[i].name);
+	}
+	return true;
+}
+
+bool ChatLogIndex::WriteMerged(const std::string& path, const std::vector<Segment>& segments)
+{
+	SegmentWriter writer;
+	if (!writer.Open(path))
+		return false;
+
+	// k-way merge of the sorted word tables
+	std::vector<SegmentReader> readers;
+	std::vector<size_t> cursors(segments.size(), 0);
+	for (size_t i = 0; i < segments.size(); i++) {
+		readers.push_back(SegmentReader(*segments[i].file));
+	}
+	std::vector<uint64_t> ids;
+	SegmentReader::Entry entry;
+	while (true) {
+		std::string word;
+		bool found = false;
+		for (size_t i = 0; i < readers.size(); i++) {
+			if ((cursors[i] < readers[i].Count()) && readers[i].GetEntry(cursors[i], entry)) {
+				const std::string current(entry.word, entry.length);
+				if (!found || (current < word)) {
+					word = current;
+					found = true;
+				}
+			}
+		}
+		if (!found)
+			break;
+		ids.clear();
+		for (size_t i = 0; i < readers.size(); i++) {
+			if ((cursors[i] < readers[i].Count()) && readers[i].GetEntry(cursors[i], entry) && (word.compare(0, std::string::npos, entry.word, entry.length) == 0)) {
+				readers[i].Decode(entry, ids);
+				cursors[i]++;
+			}
+		}
+		SortUnique(ids);
+		writer.Add(word, ids);
+	}
+	return writer.Finish();
+}
+
+bool ChatLogIndex::Commit()
+{
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		if (!CommitLocked())
+			return false;
+	}
+	return MergeSegments();
+}
+
+bool ChatLogIndex::CommitLocked()
+{
+	if (!m_memory.empty()) {
+		Segment segment;
+		segment.name = NewSegmentName();
+		if (!WriteSegment(segment.name, m_memory))
+			return false;
+		segment.file = OpenSegment(segment.name);
+		if (!segment.file)
+			return false;
+		m_segments.push_back(segment);
+		m_memory.clear();
+		m_memory_postings = 0;
+	}
+	// MergeSegments() follows once unlocked
+	return SaveManifest();
+}
+
+size_t ChatLogIndex::GetFileId(const std::string& relpath)
+{
+	std::map<std::string, size_t>::const_iterator it = m_file_ids.find(relpath);
+	if (it != m_file_ids.end())
+		return it->second;
+	File file;
+	file.path = relpath;
+	file.indexed = 0;
+	m_file_ids[relpath] = m_files.size();
+	m_files.push_back(file);
+	return m_files.size() - 1;
+}
+
+bool ChatLogIndex::RelativePath(const std::string& path, std::string& relpath) const
+{
+	if ((path.size() <= m_root.size()) || (path.compare(0, m_root.size(), m_root) != 0))
+		return false;
+	relpath = path.substr(m_root.size());
+	return true;
+}
+
+void ChatLogIndex::IndexRange(size_t fileid, uint64_t offset, const char* data, size_t size, int64_t time)
+{
+	std::vector<TimeMark>& times = m_files[fileid].times;
+	if (times.empty() || ((offset > times.back().offset) && (time >= times.back().time + TIME_MARK_INTERVAL))) {
+		TimeMark mark;
+		mark.offset = offset;
+		mark.time = time;
+		times.push_back(mark);
+	}
+	std::vector<std::string> words;
+	size_t pos = 0;
+	while (pos < size) {
+		const char* nl = (const char*)memchr(data + pos, '\n', size - pos);
+		if (nl == NULL)
+			break; // the rest is indexed once the line is complete
+		const size_t end = nl - data;
+		Tokenize(data + pos, end - pos, words);
+		const uint64_t id = MakeId(fileid, offset + pos);
+		for (size_t i = 0; i < words.size(); i++) {
+			std::vector<uint64_t>& ids = m_memory[words[i]];
+			// words repeated within the line
+			if (ids.empty() || (ids.back() != id)) {
+				ids.push_back(id);
+				m_memory_postings++;
+			}
+		}
+		pos = end + 1;
+	}
+	m_files[fileid].indexed = offset + pos;
+}
+
+void ChatLogIndex::CatchUp(size_t fileid)
+{
+	File& file = m_files[fileid];
+	if (CompressedLog::IsCompressed(file.path)) {
+		CatchUpCompressed(fileid);
+		return;
+	}
+	const MappedFile log(m_root + file.path);
+	if (!log.IsOk())
+		return;
+	if (log.Size() < file.indexed) {
+		// the log was replaced, its old postings fail verification
+		file.indexed = 0;
+		file.times.clear();
+	}
+	if (log.Size() > file.indexed) {
+		// written while the index wasn't running, at the latest when the log was modified
+		IndexRange(fileid, file.indexed, log.Data() + file.indexed, log.Size() - file.indexed, Utf8ModTime(m_root + file.path));
+	}
+}
+
+void ChatLogIndex::CatchUpCompressed(size_t fileid)
+{
+	File& file = m_files[fileid];
+	const CompressedLog log(m_root + file.path);
+	if (!log.IsOk())
+		return;
+	if (log.Size() < file.indexed) {
+		file.indexed = 0;
+		file.times.clear();
+	}
+	const int64_t time = Utf8ModTime(m_root + file.path);
+	// blocks hold whole lines, so they are indexed one by one
+	std::string data;
+	for (size_t block = log.FindBlock(file.indexed); block < log.GetBlockCount(); block++) {
+		if (!log.ReadBlock(block, data))
+			return;
+		const uint64_t offset = log.GetBlockOffset(block);
+		const size_t skip = (file.indexed > offset) ? file.indexed - offset : 0;
+		if (skip < data.size()) {
+			IndexRange(fileid, offset + skip, data.data() + skip, data.size() - skip, time);
+		}
+		if (m_memory_postings >= MAX_MEMORY_POSTINGS) {
+			CommitLocked();
+		}
+	}
+}
+
+void ChatLogIndex::AddText(const std::string& path, uint64_t offset, const std::string& data)
+{
+	std::string relpath;
+	if (!RelativePath(path, relpath))
+		return;
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		const size_t fileid = GetFileId(relpath);
+		if (offset > m_files[fileid].indexed) {
+			// text written while the index wasn't running, the file has data already
+			CatchUp(fileid);
+		}
+		const uint64_t indexed = m_files[fileid].indexed;
+		if (offset + data.size() > indexed) {
+			const size_t skip = (indexed > offset) ? indexed - offset : 0;
+			IndexRange(fileid, offset + skip, data.data() + skip, data.size() - skip, time(NULL));
+		}
+		if (m_memory_postings < MAX_MEMORY_POSTINGS)
+			return;
+		CommitLocked();
+	}
+	MergeSegments();
+}
+
+void ChatLogIndex::Update(const std::vector<std::string>& paths, const Progress& progress)
+{
+	std::string relpath;
+	for (size_t i = 0; i < paths.size(); i++) {
+		if (progress && !progress(i, paths.size()))
+			break;
+		if (!RelativePath(paths[i], relpath))
+			continue;
+		{
+			// locked per log, so AddText and searches get their turn
+			boost::mutex::scoped_lock lock(m_mutex);
+			CatchUp(GetFileId(relpath));
+			if (m_memory_postings < MAX_MEMORY_POSTINGS)
+				continue;
+			CommitLocked();
+		}
+		MergeSegments();
+	}
+	Commit();
+	if (progress)
+		progress(paths.size(), paths.size());
+}
+
+bool ChatLogIndex::Rebuild(const std::vector<std::string>& paths)
+{
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		ClearLocked();
+		if (!SaveManifest())
+			return false;
+	}
+	Update(paths);
+	return true;
+}
+
+bool ChatLogIndex::RenameLog(const std::string& from, const std::string& to)
+{
+	std::string fromrel, torel;
+	if (!RelativePath(from, fromrel) || !RelativePath(to, torel))
+		return false;
+	boost::mutex::scoped_lock lock(m_mutex);
+	if (m_file_ids.find(torel) != m_file_ids.end())
+		return false;
+	std::map<std::string, size_t>::iterator it = m_file_ids.find(fromrel);
+	uint64_t moved = 0;
+	if (it != m_file_ids.end()) {
+		const size_t fileid = it->second;
+		m_file_ids.erase(it);
+		m_file_ids[torel] = fileid;
+		m_files[fileid].path = torel;
+		moved = m_files[fileid].indexed;
+	}
+	// index what wasn't yet, all of it if the log was unknown
+	CatchUp(GetFileId(torel));
+	if (moved > 0) {
+		const MappedFile started(m_root + fromrel);
+		if (started.IsOk() && (started.Size() < moved)) {
+			// a new log at from got text before the move was reported, it was skipped as indexed already
+			CatchUp(GetFileId(fromrel));
+		}
+	}
+	// the manifest has to match the committed postings
+	if (!CommitLocked())
+		return false;
+	lock.unlock();
+	return MergeSegments();
+}
+
+void ChatLogIndex::FindPostings(const std::string& word, std::vector<uint64_t>& ids)
+{
+	// the uncommitted words are few, a scan is cheap
+	for (Postings::const_iterator it = m_memory.begin(); it != m_memory.end(); ++it) {
+		if (StartsWith(it->first.data(), it->first.size(), word))
+			ids.insert(ids.end(), it->second.begin(), it->second.end());
+	}
+	SegmentReader::Entry entry;
+	for (size_t i = 0; i < m_segments.size(); i++) {
+		const SegmentReader reader(*m_segments[i].file);
+		for (size_t n = reader.LowerBound(word), end = std::min(reader.Count(), n + MAX_EXPANSIONS); n < end; n++) {
+			if (!reader.GetEntry(n, entry) || !StartsWith(entry.word, entry.length, word))
+				break;
+			reader.Decode(entry, ids);
+		}
+	}
+	SortUnique(ids);
+}
+
+//! the line at offset without line ending, false if offset isn't the start of a line
+static bool GetLine(const char* data, size_t size, uint64_t offset, size_t& end)
+{
+	if ((offset >= size) || ((offset > 0) && (data[offset - 1] != '\n')))
+		return false;
+	const char* nl = (const char*)memchr(data + offset, '\n', size - offset);
+	end = (nl == NULL) ? size : nl - data;
+	return true;
+}
+
+static std::string LineString(const char* data, size_t begin, size_t end)
+{
+	if ((end > begin) && (data[end - 1] == '\r'))
+		end--;
+	return std::string(data + begin, end - begin);
+}
+
+int64_t ChatLogIndex::GetTime(const File& file, uint64_t offset, uint64_t& until)
+{
+	// the last mark at or before offset
+	std::vector<TimeMark>::const_iterator it = std::upper_bound(file.times.begin(), file.times.end(), offset, [](uint64_t pos, const TimeMark& mark) { return pos < mark.offset; });
+	until = (it == file.times.end()) ? UINT64_MAX : it->offset;
+	return (it == file.times.begin()) ? 0 : (it - 1)->time;
+}
+
+static std::string Lower(const std::string& str)
+{
+	std::string res(str);
+	std::transform(res.begin(), res.end(), res.begin(), ToLower);
+	return res;
+}
+
+std::vector<ChatLogIndex::Match> ChatLogIndex::Search(const std::string& query, size_t maxresults, size_t context)
+{
+	std::vector<Match> matches;
+	std::vector<std::string> words;
+	Tokenize(query.data(), query.size(), words);
+	std::sort(words.begin(), words.end());
+	words.erase(std::unique(words.begin(), words.end()), words.end());
+	if (words.empty() || (maxresults == 0))
+		return matches;
+
+	// the postings split into runs indexed at the same time, the log text is
+	// read after unlocking
+	struct Run {
+		int64_t time;
+		size_t begin;
+		size_t end; //!< one past the next id to check
+	};
+	std::vector<uint64_t> ids;
+	std::vector<Run> runs;
+	std::map<size_t, std::string> paths;
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		std::vector<std::vector<uint64_t> > lists(words.size());
+		for (size_t i = 0; i < words.size(); i++) {
+			FindPostings(words[i], lists[i]);
+			if (lists[i].empty())
+				return matches;
+		}
+		// intersect, smallest lists first
+		std::sort(lists.begin(), lists.end(), [](const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) { return a.size() < b.size(); });
+		ids.swap(lists[0]);
+		for (size_t i = 1; (i < lists.size()) && !ids.empty(); i++) {
+			std::vector<uint64_t> both;
+			std::set_intersection(ids.begin(), ids.end(), lists[i].begin(), lists[i].end(), std::back_inserter(both));
+			ids.swap(both);
+		}
+		// ids are sorted by file and offset, a run ends at the next time mark
+		for (size_t i = 0; i < ids.size();) {
+			const size_t fileid = ids[i] >> OFFSET_BITS;
+			if (fileid >= m_files.size()) {
+				i++;
+				continue;
+			}
+			uint64_t until;
+			Run run;
+			run.time = GetTime(m_files[fileid], ids[i] & OFFSET_MASK, until);
+			run.begin = i;
+			while ((i < ids.size()) && ((ids[i] >> OFFSET_BITS) == fileid) && ((ids[i] & OFFSET_MASK) < until)) {
+				i++;
+			}
+			run.end = i;
+			runs.push_back(run);
+			if (paths.find(fileid) == paths.end())
+				paths[fileid] = m_files[fileid].path;
+		}
+	}
+
+	// newest first, only as many candidates as needed are checked. Later lines
+	// of a log were indexed later, so ids break ties.
+	auto older = [&ids](const Run& a, const Run& b) {
+		return (a.time != b.time) ? (a.time < b.time) : (ids[a.end - 1] < ids[b.end - 1]);
+	};
+	std::make_heap(runs.begin(), runs.end(), older);
+	std::map<size_t, std::shared_ptr<LogText> > logs;
+	while (!runs.empty() && (matches.size() < maxresults)) {
+		std::pop_heap(runs.begin(), runs.end(), older);
+		const uint64_t id = ids[--runs.back().end];
+		if (runs.back().end > runs.back().begin) {
+			std::push_heap(runs.begin(), runs.end(), older);
+		} else {
+			runs.pop_back();
+		}
+		const size_t fileid = id >> OFFSET_BITS;
+		std::shared_ptr<LogText>& log = logs[fileid];
+		if (!log) {
+			log = std::make_shared<LogText>(m_root + paths[fileid]);
+		}
+		if (!log->IsOk() || !log->Load(id & OFFSET_MASK))
+			continue;
+		const char* data = log->Data();
+		const size_t size = log->Size();
+		const uint64_t offset = (id & OFFSET_MASK) - log->Base();
+		size_t end;
+		if (!GetLine(data, size, offset, end))
+			continue;
+		Match match;
+		match.line = LineString(data, offset, end);
+		const std::string lower = Lower(match.line);
+		bool found = true;
+		for (size_t i = 0; found && (i < words.size()); i++) {
+			found = lower.find(words[i]) != std::string::npos;
+		}
+		if (!found)
+			continue; // stale posting
+
+		match.file = paths[fileid];
+		match.offset = id & OFFSET_MASK;
+		std::vector<LineSpan> before = FindTailLines(data, offset, context);
+		for (size_t i = 0; i < before.size(); i++) {
+			match.before.push_back(LineString(data, before[i].offset, before[i].offset + before[i].length));
+		}
+		size_t pos = end + 1;
+		while ((match.after.size() < context) && (pos < size) && GetLine(data, size, pos, end)) {
+			const std::string line = LineString(data, pos, end);
+			if (!line.empty())
+				match.after.push_back(line);
+			pos = end + 1;
+		}
+		matches.push_back(match);
+	}
+	return matches;
+}
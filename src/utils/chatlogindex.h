@@ -0,0 +1,152 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_CHATLOGINDEX_H
+#define SPRINGLOBBY_HEADERGUARD_CHATLOGINDEX_H
+
+#include <boost/thread/mutex.hpp>
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MappedFile;
+
+/** @brief inverted index over the words of the chat logs
+ *
+ * Lines are split into lower case words of letters and digits. For every
+ * word the index keeps the (file, line offset) postings of the lines
+ * containing it. New text is collected in memory and written as an
+ * immutable segment by Commit(). With more than MAX_SEGMENTS segments the
+ * youngest ones are merged, together with older ones up to MERGE_FACTOR times
+ * their size, so segment sizes grow by tiers and the large old segments are
+ * rewritten rarely. Merges run without holding the lock. A manifest in the
+ * index directory lists the segments and how far each log file was indexed,
+ * so Update() can index what was appended while the index wasn't running.
+ *
+ * Logs with the CompressedLog extension are read through CompressedLog.
+ *
+ * Queries match lines containing words starting with every query word.
+ * Matches are verified against the log files, so stale postings of
+ * rewritten logs are skipped. The index remembers when text was indexed,
+ * in steps of TIME_MARK_INTERVAL, so matches of all logs come newest first.
+ * Text indexed by Update() is dated by the log's modification time.
+ * All methods are thread safe.
+ */
+class ChatLogIndex
+{
+public:
+	static const size_t MAX_SEGMENTS = 8;
+	static const uint64_t MERGE_FACTOR = 2;
+	//! postings kept in memory before they are committed automatically
+	static const size_t MAX_MEMORY_POSTINGS = 1000000;
+	//! words shorter than this aren't indexed
+	static const size_t MIN_WORD = 2;
+	//! longer words are indexed by their prefix
+	static const size_t MAX_WORD = 48;
+	//! seconds between the times remembered for a log
+	static const int64_t TIME_MARK_INTERVAL = 600;
+
+	//! called with the number of logs done and the total, returns false to stop
+	typedef std::function<bool(size_t done, size_t total)> Progress;
+
+	/**
+	 * @param root directory of the logs, files are indexed relative to it
+	 * @param indexdir existing directory the index is stored in
+	 */
+	ChatLogIndex(const std::string& root, const std::string& indexdir);
+	//! commits the postings still in memory
+	~ChatLogIndex();
+
+	struct Match {
+		std::string file; //!< relative to the log root
+		uint64_t offset;  //!< of the matching line
+		std::vector<std::string> before;
+		std::string line;
+		std::vector<std::string> after;
+	};
+
+	/** indexes the complete lines of text appended to a log
+	 * @param path of the log, files outside of the root are ignored
+	 * @param offset file position data was written to
+	 */
+	void AddText(const std::string& path, uint64_t offset, const std::string& data);
+	/** indexes what was appended to the logs since they were indexed last
+	 * Logs are indexed one by one, searches in between see the ones done.
+	 */
+	void Update(const std::vector<std::string>& paths, const Progress& progress = Progress());
+	//! drops the whole index and indexes the logs again
+	bool Rebuild(const std::vector<std::string>& paths);
+	/** keeps the postings of a log that was moved, e.g. into a compressed
+	 * archive with the same text offsets, and indexes the rest of it
+	 *
+	 * The move may be reported after a new log at from was written to.
+	 */
+	bool RenameLog(const std::string& from, const std::string& to);
+	//! writes the in memory postings to a new segment
+	bool Commit();
+
+	/** finds the newest lines containing all words of the query, newest first
+	 * @param context number of lines returned before and after each match
+	 */
+	std::vector<Match> Search(const std::string& query, size_t maxresults, size_t context);
+
+	//! splits text into lower case words, as they are indexed
+	static void Tokenize(const char* data, size_t size, std::vector<std::string>& words);
+
+	size_t GetSegmentCount();
+
+private:
+	struct TimeMark {
+		uint64_t offset; //!< the text from here on was indexed at time
+		int64_t time;
+	};
+	struct File {
+		std::string path; //!< relative to the root
+		uint64_t indexed; //!< bytes of complete lines indexed
+		std::vector<TimeMark> times; //!< ascending
+	};
+	struct Segment {
+		std::string name;
+		std::shared_ptr<MappedFile> file;
+	};
+	typedef std::unordered_map<std::string, std::vector<uint64_t> > Postings;
+
+	void Load();
+	bool SaveManifest();
+	bool WriteSegment(const std::string& name, const Postings& postings);
+	//! merges segments if there are too many, call unlocked
+	bool MergeSegments();
+	static bool WriteMerged(const std::string& path, const std::vector<Segment>& segments);
+	std::shared_ptr<MappedFile> OpenSegment(const std::string& name);
+	void ClearLocked();
+	bool CommitLocked();
+
+	size_t GetFileId(const std::string& relpath);
+	bool RelativePath(const std::string& path, std::string& relpath) const;
+	void IndexRange(size_t fileid, uint64_t offset, const char* data, size_t size, int64_t time);
+	void CatchUp(size_t fileid);
+	void CatchUpCompressed(size_t fileid);
+	void FindPostings(const std::string& word, std::vector<uint64_t>& ids);
+	/** time the text at offset was indexed, 0 if unknown
+	 * @param until set to the offset of the next mark, UINT64_MAX after the last one
+	 */
+	static int64_t GetTime(const File& file, uint64_t offset, uint64_t& until);
+	std::string NewSegmentName();
+
+	std::string m_root;
+	std::string m_indexdir;
+	std::vector<File> m_files;
+	std::map<std::string, size_t> m_file_ids;
+	std::vector<Segment> m_segments;
+	Postings m_memory; //!< not yet committed
+	size_t m_memory_postings;
+	unsigned m_next_segment;
+	unsigned m_generation; //!< counts ClearLocked() calls, merges of cleared segments are dropped
+	bool m_merging;
+	boost::mutex m_mutex;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_CHATLOGINDEX_H
@@ -0,0 +1,182 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "compressedlog.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+
+#include "utf8file.h"
+
+const size_t CompressedLog::BLOCK_SIZE;
+const char* CompressedLog::EXTENSION = ".txtz";
+
+/** Layout, integers little endian:
+ * magic[8], uint64 text size, uint64 block count, uint64 table offset
+ * blocks: zlib streams
+ * table: uint64 text offset and uint64 file offset of every block
+ * The compressed size of a block ends where the next one starts, or the table.
+ */
+static const char LOG_MAGIC[8] = {'S', 'L', 'L', 'O', 'G', 'Z', '0', '1'};
+static const size_t LOG_HEADER = 32;
+static const size_t TABLE_ENTRY = 16;
+
+static void PutUint64(std::string& out, uint64_t value)
+{
+	for (int i = 0; i < 8; i++) {
+		out += (char)((value >> (8 * i)) & 0xFF);
+	}
+}
+
+static uint64_t GetUint64(const char* data)
+{
+	uint64_t value = 0;
+	for (int i = 7; i >= 0; i--) {
+		value = (value << 8) | (unsigned char)data[i];
+	}
+	return value;
+}
+
+CompressedLog::CompressedLog(const std::string& path)
+    : m_file(path)
+    , m_ok(false)
+    , m_size(0)
+    , m_count(0)
+    , m_table(NULL)
+{
+	const char* data = m_file.Data();
+	const size_t size = m_file.Size();
+	if (!m_file.IsOk() || (size < LOG_HEADER) || (memcmp(data, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0))
+		return;
+	const uint64_t count = GetUint64(data + 16);
+	const uint64_t table = GetUint64(data + 24);
+	if ((table < LOG_HEADER) || (table > size) || (count > (size - table) / TABLE_ENTRY))
+		return;
+	m_size = GetUint64(data + 8);
+	m_count = count;
+	m_table = data + table;
+	// offsets have to be ascending and inside the file
+	uint64_t text = 0, file = LOG_HEADER;
+	for (size_t i = 0; i < m_count; i++) {
+		const uint64_t textpos = GetUint64(m_table + i * TABLE_ENTRY);
+		const uint64_t filepos = GetUint64(m_table + i * TABLE_ENTRY + 8);
+		if ((textpos < text) || (textpos > m_size) || (filepos < file) || (filepos > table))
+			return;
+		text = textpos;
+		file = filepos;
+	}
+	m_ok = true;
+}
+
+uint64_t CompressedLog::GetBlockOffset(size_t block) const
+{
+	if (block >= m_count)
+		return m_size;
+	return GetUint64(m_table + block * TABLE_ENTRY);
+}
+
+size_t CompressedLog::FindBlock(uint64_t offset) const
+{
+	if (offset >= m_size)
+		return m_count;
+	// last block starting at or before offset
+	size_t lo = 0, hi = m_count;
+	while (hi - lo > 1) {
+		const size_t mid = lo + (hi - lo) / 2;
+		if (GetBlockOffset(mid) <= offset) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+bool CompressedLog::ReadBlock(size_t block, std::string& data) const
+{
+	data.clear();
+	if (!m_ok || (block >= m_count))
+		return false;
+	const uint64_t begin = GetUint64(m_table + block * TABLE_ENTRY + 8);
+	const uint64_t end = (block + 1 < m_count) ? GetUint64(m_table + (block + 1) * TABLE_ENTRY + 8) : m_table - m_file.Data();
+	uLongf length = GetBlockOffset(block + 1) - GetBlockOffset(block);
+	if (length == 0)
+		return true;
+	data.resize(length);
+	if ((uncompress((Bytef*)&data[0], &length, (const Bytef*)m_file.Data() + begin, end - begin) != Z_OK) || (length != data.size())) {
+		data.clear();
+		return false;
+	}
+	return true;
+}
+
+std::vector<std::string> CompressedLog::ReadTailLines(size_t count) const
+{
+	std::vector<std::string> lines;
+	std::string data;
+	// blocks hold whole lines, so each one can be scanned on its own
+	for (size_t block = m_count; (block > 0) && (lines.size() < count); block--) {
+		if (!ReadBlock(block - 1, data))
+			break;
+		const std::vector<LineSpan> spans = FindTailLines(data.data(), data.size(), count - lines.size());
+		for (size_t i = spans.size(); i > 0; i--) {
+			lines.push_back(data.substr(spans[i - 1].offset, spans[i - 1].length));
+		}
+	}
+	std::reverse(lines.begin(), lines.end());
+	return lines;
+}
+
+bool CompressedLog::Compress(const std::string& src, const std::string& dst)
+{
+	const MappedFile log(src);
+	if (!log.IsOk())
+		return false;
+	FILE* out = Utf8Open(dst, "wb");
+	if (out == NULL)
+		return false;
+
+	const char* data = log.Data();
+	const size_t size = log.Size();
+	std::string header(LOG_HEADER, '\0');
+	std::string table;
+	std::vector<Bytef> buffer;
+	bool ok = fwrite(header.data(), 1, header.size(), out) == header.size();
+	uint64_t filepos = LOG_HEADER;
+	size_t count = 0;
+	for (size_t pos = 0; ok && (pos < size); count++) {
+		// end the block after the last complete line that fits, or the first one if none does
+		size_t end = std::min(pos + BLOCK_SIZE, size);
+		if (end < size) {
+			const char* nl = FindLast(data + pos, end - pos, '\n');
+			if (nl == NULL)
+				nl = (const char*)memchr(data + end, '\n', size - end);
+			end = (nl == NULL) ? size : (nl - data) + 1;
+		}
+		uLongf length = compressBound(end - pos);
+		buffer.resize(length);
+		ok = (compress2(&buffer[0], &length, (const Bytef*)data + pos, end - pos, Z_BEST_COMPRESSION) == Z_OK) && (fwrite(&buffer[0], 1, length, out) == length);
+		PutUint64(table, pos);
+		PutUint64(table, filepos);
+		filepos += length;
+		pos = end;
+	}
+	ok = ok && (fwrite(table.data(), 1, table.size(), out) == table.size());
+
+	header.assign(LOG_MAGIC, sizeof(LOG_MAGIC));
+	PutUint64(header, size);
+	PutUint64(header, count);
+	PutUint64(header, filepos);
+	ok = ok && (fseek(out, 0, SEEK_SET) == 0) && (fwrite(header.data(), 1, header.size(), out) == header.size());
+	ok = (fclose(out) == 0) && ok;
+	if (!ok)
+		Utf8Remove(dst);
+	return ok;
+}
+
+bool CompressedLog::IsCompressed(const std::string& path)
+{
+	const size_t length = strlen(EXTENSION);
+	return (path.size() > length) && (path.compare(path.size() - length, length, EXTENSION) == 0);
+}
@@ -0,0 +1,70 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_COMPRESSEDLOG_H
+#define SPRINGLOBBY_HEADERGUARD_COMPRESSEDLOG_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "tailreader.h"
+
+/** @brief seekable, zlib compressed log file
+ *
+ * The text is split into blocks of whole lines of about BLOCK_SIZE bytes,
+ * each compressed on its own, so any position can be read by decompressing
+ * a single block. Offsets are positions in the uncompressed text, they stay
+ * the same as in the log the archive was made of.
+ */
+class CompressedLog
+{
+public:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+	//! file extension of compressed logs
+	static const char* EXTENSION;
+
+	//! @param path utf-8 encoded
+	explicit CompressedLog(const std::string& path);
+
+	bool IsOk() const
+	{
+		return m_ok;
+	}
+	//! size of the uncompressed text
+	uint64_t Size() const
+	{
+		return m_size;
+	}
+	size_t GetBlockCount() const
+	{
+		return m_count;
+	}
+	//! offset of the first byte of a block
+	uint64_t GetBlockOffset(size_t block) const;
+	//! the block containing offset, GetBlockCount() if it is past the end
+	size_t FindBlock(uint64_t offset) const;
+	//! decompresses a block, replacing data
+	bool ReadBlock(size_t block, std::string& data) const;
+
+	/** the last count non-empty lines, like FindTailLines
+	 * @return the lines in file order
+	 */
+	std::vector<std::string> ReadTailLines(size_t count) const;
+
+	/** compresses the log at src into a new file at dst
+	 * @return false if src can't be read or dst can't be written
+	 */
+	static bool Compress(const std::string& src, const std::string& dst);
+
+	//! true if path has the extension of compressed logs
+	static bool IsCompressed(const std::string& path);
+
+private:
+	MappedFile m_file;
+	bool m_ok;
+	uint64_t m_size;
+	size_t m_count;
+	const char* m_table;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_COMPRESSEDLOG_H
@@ -0,0 +1,206 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "demoheader.h"
+
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+
+#include "utf8file.h"
+
+const size_t DemoHeader::MAX_FIXED_SIZE;
+const int DemoHeader::MAX_HEADER_SIZE;
+const int DemoHeader::MAX_SCRIPT_SIZE;
+
+static const char DEMOFILE_MAGIC[] = "spring demofile";
+//! magic, version and header size
+static const size_t PREFIX_SIZE = 24;
+
+//! decodes the little endian fields of a header in order
+class FieldReader
+{
+public:
+	explicit FieldReader(const char* data)
+	    : m_data((const unsigned char*)data)
+	{
+	}
+	uint64_t GetUint(int bytes)
+	{
+		uint64_t value = 0;
+		for (int i = bytes - 1; i >= 0; i--) {
+			value = (value << 8) | m_data[i];
+		}
+		m_data += bytes;
+		return value;
+	}
+	int GetInt()
+	{
+		return (int32_t)(uint32_t)GetUint(4);
+	}
+	const unsigned char* GetBytes(size_t size)
+	{
+		m_data += size;
+		return m_data - size;
+	}
+
+private:
+	const unsigned char* m_data;
+};
+
+DemoHeader::DemoHeader()
+    : version(0)
+    , headerSize(0)
+    , unixTime(0)
+    , scriptSize(0)
+    , demoStreamSize(0)
+    , gameTime(0)
+    , wallclockTime(0)
+    , maxPlayerNum(0)
+    , numPlayers(0)
+    , playerStatSize(0)
+    , playerStatElemSize(0)
+    , numTeams(0)
+    , teamStatSize(0)
+    , teamStatElemSize(0)
+    , teamStatPeriod(0)
+    , winningAllyTeam(-1)
+{
+	memset(gameID, 0, sizeof(gameID));
+}
+
+size_t DemoHeader::GetFixedSize(int version)
+{
+	switch (version) {
+		case 4:
+			return MAX_FIXED_SIZE - 240; // 16 chars of versionString
+		case 5:
+			return MAX_FIXED_SIZE;
+		default:
+			return 0;
+	}
+}
+
+bool DemoHeader::Parse(const char* data, size_t size)
+{
+	if ((size < PREFIX_SIZE) || (memcmp(data, DEMOFILE_MAGIC, sizeof(DEMOFILE_MAGIC)) != 0))
+		return false;
+	FieldReader reader(data);
+	reader.GetBytes(16);
+	version = reader.GetInt();
+	headerSize = reader.GetInt();
+	const size_t fixed = GetFixedSize(version);
+	if ((fixed == 0) || (size < fixed) || (headerSize < (int)fixed) || (headerSize > MAX_HEADER_SIZE))
+		return false;
+
+	const size_t versionlen = (version < 5) ? 16 : 256;
+	const char* str = (const char*)reader.GetBytes(versionlen);
+	versionString.assign(str, std::find(str, str + versionlen, '\0'));
+	memcpy(gameID, reader.GetBytes(sizeof(gameID)), sizeof(gameID));
+	unixTime = reader.GetUint(8);
+	scriptSize = reader.GetInt();
+	demoStreamSize = reader.GetInt();
+	gameTime = reader.GetInt();
+	wallclockTime = reader.GetInt();
+	maxPlayerNum = reader.GetInt();
+	numPlayers = reader.GetInt();
+	playerStatSize = reader.GetInt();
+	playerStatElemSize = reader.GetInt();
+	numTeams = reader.GetInt();
+	teamStatSize = reader.GetInt();
+	teamStatElemSize = reader.GetInt();
+	teamStatPeriod = reader.GetInt();
+	winningAllyTeam = reader.GetInt();
+	// the stream size is 0 for demos of crashed games
+	return (scriptSize >= 0) && (scriptSize <= MAX_SCRIPT_SIZE) && (demoStreamSize >= 0) && (playerStatSize >= 0) && (teamStatSize >= 0);
+}
+
+std::string DemoHeader::GetGameId() const
+{
+	static const char hex[] = "0123456789abcdef";
+	std::string res;
+	res.reserve(2 * sizeof(gameID));
+	for (size_t i = 0; i < sizeof(gameID); i++) {
+		res += hex[gameID[i] >> 4];
+		res += hex[gameID[i] & 0xF];
+	}
+	return res;
+}
+
+static gzFile OpenDemo(const std::string& path)
+{
+#ifdef _WIN32
+	// gzopen() takes the ANSI code page, replays in a profile folder with non-ascii characters would fail
+	const std::wstring wpath = Utf8ToWide(path);
+	return wpath.empty() ? NULL : gzopen_w(wpath.c_str(), "rb");
+#else
+	return gzopen(path.c_str(), "rb");
+#endif
+}
+
+DemoReader::DemoReader(const std::string& path)
+    : m_file(OpenDemo(path))
+    , m_pos(0)
+{
+}
+
+DemoReader::~DemoReader()
+{
+	if (m_file != NULL) {
+		gzclose((gzFile)m_file);
+	}
+}
+
+bool DemoReader::Read(void* data, size_t size)
+{
+	if (m_file == NULL)
+		return false;
+	char* dest = (char*)data;
+	while (size > 0) {
+		const unsigned chunk = (unsigned)std::min<size_t>(size, 1024 * 1024 * 1024);
+		const int res = gzread((gzFile)m_file, dest, chunk);
+		if (res <= 0)
+			return false;
+		m_pos += res;
+		dest += res;
+		size -= res;
+	}
+	return true;
+}
+
+bool DemoReader::SkipTo(uint64_t offset)
+{
+	if (offset < m_pos)
+		return false;
+	char buffer[4096];
+	while (m_pos < offset) {
+		if (!Read(buffer, std::min<uint64_t>(sizeof(buffer), offset - m_pos)))
+			return false;
+	}
+	return true;
+}
+
+bool DemoReader::ReadHeader(DemoHeader& header)
+{
+	if (m_pos != 0)
+		return false;
+	char data[DemoHeader::MAX_FIXED_SIZE];
+	if (!Read(data, PREFIX_SIZE))
+		return false;
+	const size_t fixed = DemoHeader::GetFixedSize(FieldReader(data + 16).GetInt());
+	if ((fixed == 0) || !Read(data + PREFIX_SIZE, fixed - PREFIX_SIZE))
+		return false;
+	return header.Parse(data, fixed);
+}
+
+bool DemoReader::ReadScript(const DemoHeader& header, std::string& script)
+{
+	script.clear();
+	if (!SkipTo(header.GetScriptOffset()))
+		return false;
+	script.resize(header.scriptSize);
+	if ((header.scriptSize > 0) && !Read(&script[0], script.size())) {
+		script.clear();
+		return false;
+	}
+	return true;
+}
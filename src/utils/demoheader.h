@@ -0,0 +1,139 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_DEMOHEADER_H
+#define SPRINGLOBBY_HEADERGUARD_DEMOHEADER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+/*
+copied from spring sources for reference
+struct DemoFileHeader {
+	char magic[16];         ///< DEMOFILE_MAGIC
+	int version;            ///< DEMOFILE_VERSION
+	int headerSize;         ///< Size of the DemoFileHeader, minor version number.
+	char versionString[256];///< Spring version string, e.g. "0.75b2", "0.75b2+svn4123", 16 chars before version 5
+	Uint8 gameID[16];       ///< Unique game identifier. Identical for each player of the game.
+	Uint64 unixTime;        ///< Unix time when game was started.
+	int scriptSize;         ///< Size of startscript.
+	int demoStreamSize;     ///< Size of the demo stream.
+	int gameTime;           ///< Total number of seconds game time.
+	int wallclockTime;      ///< Total number of seconds wallclock time.
+	int maxPlayerNum;       ///< Maximum player number which was used in this game.
+	int numPlayers;         ///< Number of players for which stats are saved.
+	int playerStatSize;     ///< Size of the entire player statistics chunk.
+	int playerStatElemSize; ///< sizeof(CPlayer::Statistics)
+	int numTeams;           ///< Number of teams for which stats are saved.
+	int teamStatSize;       ///< Size of the entire team statistics chunk.
+	int teamStatElemSize;   ///< sizeof(CTeam::Statistics)
+	int teamStatPeriod;     ///< Interval (in seconds) between team stats.
+	int winningAllyTeam;    ///< The ally team that won the game, -1 if unknown.
+};
+The file continues with the script, the demo stream, the player statistics
+and the team statistics.
+*/
+
+//! the decoded DemoFileHeader of a spring demo
+struct DemoHeader {
+	DemoHeader();
+
+	//! bytes of the header of the newest known version
+	static const size_t MAX_FIXED_SIZE = 356;
+	//! larger headers or scripts are treated as broken files
+	static const int MAX_HEADER_SIZE = 64 * 1024;
+	static const int MAX_SCRIPT_SIZE = 16 * 1024 * 1024;
+
+	int version;
+	int headerSize;
+	std::string versionString;
+	unsigned char gameID[16];
+	uint64_t unixTime;
+	int scriptSize;
+	int demoStreamSize;
+	int gameTime;      //!< in seconds
+	int wallclockTime; //!< in seconds
+	int maxPlayerNum;
+	int numPlayers;
+	int playerStatSize;
+	int playerStatElemSize;
+	int numTeams;
+	int teamStatSize;
+	int teamStatElemSize;
+	int teamStatPeriod;
+	int winningAllyTeam;
+
+	//! the game id as hex string, like the engine writes it to infolog.txt
+	std::string GetGameId() const;
+
+	//! offsets in the uncompressed demo
+	uint64_t GetScriptOffset() const
+	{
+		return headerSize;
+	}
+	uint64_t GetDemoStreamOffset() const
+	{
+		return GetScriptOffset() + scriptSize;
+	}
+	uint64_t GetPlayerStatOffset() const
+	{
+		return GetDemoStreamOffset() + demoStreamSize;
+	}
+	uint64_t GetTeamStatOffset() const
+	{
+		return GetPlayerStatOffset() + playerStatSize;
+	}
+
+	/** decodes the first bytes of a demo
+	 *
+	 * @param size at least GetFixedSize(version) bytes
+	 * @return false if it isn't a demo or the sizes are invalid
+	 */
+	bool Parse(const char* data, size_t size);
+
+	//! bytes of the header fields of a demo version, 0 if it is unknown
+	static size_t GetFixedSize(int version);
+};
+
+/** @brief reads a demo front to back
+ *
+ * .sdfz demos are decompressed while reading, uncompressed ones are read as
+ * they are. The reader never seeks backwards, which would start decompressing
+ * from the beginning of the file again.
+ */
+class DemoReader
+{
+public:
+	//! @param path utf-8 encoded
+	explicit DemoReader(const std::string& path);
+	~DemoReader();
+
+	bool IsOk() const
+	{
+		return m_file != NULL;
+	}
+
+	//! reads the header, call first
+	bool ReadHeader(DemoHeader& header);
+	//! reads the script following the header
+	bool ReadScript(const DemoHeader& header, std::string& script);
+
+	//! reads exactly size bytes
+	bool Read(void* data, size_t size);
+	//! skips forward to offset in the uncompressed demo
+	bool SkipTo(uint64_t offset);
+	//! offset in the uncompressed demo
+	uint64_t Tell() const
+	{
+		return m_pos;
+	}
+
+private:
+	DemoReader(const DemoReader&);
+	DemoReader& operator=(const DemoReader&);
+
+	void* m_file; //!< gzFile
+	uint64_t m_pos;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_DEMOHEADER_H
@@ -0,0 +1,119 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "demoscanner.h"
+
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+#include "demoheader.h"
+
+const size_t DemoSummary::MAX_CHAT_MESSAGES;
+const size_t DemoSummary::MAX_CHAT_LENGTH;
+const int DemoSummary::MAX_PLAYERS;
+const size_t DemoScanner::MAX_PACKET_SIZE;
+
+//! precedes each packet in the stream, see DemoStreamChunkHeader in spring
+static const size_t CHUNK_HEADER_SIZE = 8;
+//! size of the known part of CPlayer::Statistics
+static const size_t PLAYER_STATS_SIZE = 20;
+
+static uint32_t GetUint32(const unsigned char* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+//! a 0 terminated string in a packet, which might lack the terminator
+static std::string GetString(const unsigned char* data, size_t size)
+{
+	const unsigned char* end = std::find(data, data + size, '\0');
+	return std::string((const char*)data, end - data);
+}
+
+DemoSummary::DemoSummary()
+    : scanned(false)
+    , gameover(false)
+{
+}
+
+bool DemoScanner::Scan(DemoReader& reader, const DemoHeader& header, DemoSummary& summary)
+{
+	summary = DemoSummary();
+	summary.scanned = true;
+	if (!reader.SkipTo(header.GetDemoStreamOffset()))
+		return false;
+
+	// the stream size is only written when the game ended, read to the end otherwise
+	const bool complete = header.demoStreamSize > 0;
+	const uint64_t end = header.GetPlayerStatOffset();
+	std::map<int, std::string> names;
+	std::vector<unsigned char> packet;
+	packet.reserve(1024);
+	unsigned char chunk[CHUNK_HEADER_SIZE];
+	while (!complete || (reader.Tell() < end)) {
+		if (!reader.Read(chunk, sizeof(chunk)))
+			return !complete;
+		float time;
+		const uint32_t timebits = GetUint32(chunk);
+		memcpy(&time, &timebits, sizeof(time));
+		const uint32_t length = GetUint32(chunk + 4);
+		if (complete && (reader.Tell() + length > end))
+			return false;
+		if ((length < 3) || (length > MAX_PACKET_SIZE)) {
+			if (!reader.SkipTo(reader.Tell() + length))
+				return false;
+			continue;
+		}
+		packet.resize(length);
+		if (!reader.Read(&packet[0], length))
+			return false;
+
+		const unsigned char* data = &packet[0];
+		switch (data[0]) {
+			case NETMSG_PLAYERNAME: // id, size, player, name
+				names[data[2]] = GetString(data + 3, length - 3);
+				break;
+			case NETMSG_CHAT: { // id, size, from, dest, text
+				if ((length < 4) || (summary.chat.size() >= DemoSummary::MAX_CHAT_MESSAGES))
+					break;
+				DemoSummary::ChatMessage message;
+				message.time = (int)time;
+				message.from = data[2];
+				message.dest = data[3];
+				message.text = GetString(data + 4, length - 4).substr(0, DemoSummary::MAX_CHAT_LENGTH);
+				const std::map<int, std::string>::const_iterator name = names.find(message.from);
+				if (name != names.end()) {
+					message.from_name = name->second;
+				}
+				summary.chat.push_back(message);
+				break;
+			}
+			case NETMSG_GAMEOVER: // id, size, player, winning ally teams
+				summary.gameover = true;
+				summary.winners.assign(data + 3, data + length);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// followed by numPlayers CPlayer::Statistics
+	const int players = std::min(header.numPlayers, DemoSummary::MAX_PLAYERS);
+	if ((header.playerStatElemSize < (int)PLAYER_STATS_SIZE) || (header.playerStatSize < players * header.playerStatElemSize))
+		return true;
+	std::vector<unsigned char> stats(header.playerStatElemSize);
+	std::vector<DemoSummary::PlayerStats> parsed;
+	for (int i = 0; i < players; i++) {
+		if (!reader.Read(&stats[0], stats.size()))
+			return false;
+		DemoSummary::PlayerStats player;
+		player.mousePixels = GetUint32(&stats[0]);
+		player.mouseClicks = GetUint32(&stats[4]);
+		player.keyPresses = GetUint32(&stats[8]);
+		player.numCommands = GetUint32(&stats[12]);
+		player.unitCommands = GetUint32(&stats[16]);
+		parsed.push_back(player);
+	}
+	summary.players.swap(parsed);
+	return true;
+}
@@ -0,0 +1,84 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_DEMOSCANNER_H
+#define SPRINGLOBBY_HEADERGUARD_DEMOSCANNER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct DemoHeader;
+class DemoReader;
+
+//! what happened in a game, read from the demo stream without the engine
+struct DemoSummary {
+	DemoSummary();
+
+	//! longer games keep the first messages only
+	static const size_t MAX_CHAT_MESSAGES = 200;
+	static const size_t MAX_CHAT_LENGTH = 256;
+	//! the statistics of more players are dropped
+	static const int MAX_PLAYERS = 256;
+
+	//! destinations and senders of chat messages, see spring's ChatMessage.h
+	enum {
+		TO_ALLIES = 252,
+		TO_SPECTATORS = 253,
+		TO_EVERYONE = 254,
+		FROM_SERVER = 255
+	};
+
+	struct ChatMessage {
+		int time; //!< game time in seconds
+		int from; //!< player number or FROM_SERVER
+		int dest; //!< player number or one of the TO_* values
+		std::string from_name;
+		std::string text;
+	};
+
+	//! see CPlayer::Statistics in spring
+	struct PlayerStats {
+		int32_t mousePixels;
+		int32_t mouseClicks;
+		int32_t keyPresses;
+		int32_t numCommands;
+		int32_t unitCommands;
+	};
+
+	bool scanned;  //!< false if the stream wasn't read yet
+	bool gameover; //!< the game ended regularly
+	std::vector<int> winners; //!< ally teams which won, empty for a draw
+	std::vector<ChatMessage> chat;
+	std::vector<PlayerStats> players; //!< by player number
+};
+
+/** @brief reads the packets of a demo stream in one pass
+ *
+ * Each packet is read into a buffer of at most MAX_PACKET_SIZE bytes, only
+ * chat, player names and the game over message are decoded, everything else
+ * is skipped. The player statistics following the stream are read too.
+ */
+class DemoScanner
+{
+public:
+	//! larger packets are skipped without being buffered
+	static const size_t MAX_PACKET_SIZE = 64 * 1024;
+
+	//! ids of the decoded NETMSGs, see spring's BaseNetProtocol.h
+	enum {
+		NETMSG_PLAYERNAME = 6,
+		NETMSG_CHAT = 7,
+		NETMSG_GAMEOVER = 30
+	};
+
+	/** fills summary from the stream
+	 *
+	 * @pre reader is positioned at or before header.GetDemoStreamOffset(),
+	 * e.g. after reading the script
+	 * @return false if the demo is truncated, what was read is kept
+	 */
+	static bool Scan(DemoReader& reader, const DemoHeader& header, DemoSummary& summary);
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_DEMOSCANNER_H
@@ -0,0 +1,319 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "dirwatcher.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include "utf8file.h"
+
+#ifdef _WIN32
+static const char SEPARATOR = '\\';
+#else
+static const char SEPARATOR = '/';
+#endif
+
+#ifdef __linux__
+//! files are reported when they're complete or moved, not on every write
+static const uint32_t WATCH_MASK = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+static bool EndsWithNoCase(const std::string& str, const std::string& suffix)
+{
+	if (str.size() <= suffix.size()) {
+		return false;
+	}
+	const size_t offset = str.size() - suffix.size();
+	for (size_t i = 0; i < suffix.size(); i++) {
+		if (tolower((unsigned char)str[offset + i]) != tolower((unsigned char)suffix[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//! false for directories and missing files
+static bool GetFileState(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+#ifdef _WIN32
+	const std::wstring wpath = Utf8ToWide(path);
+	struct _stat64 st;
+	if (wpath.empty() || (_wstat64(wpath.c_str(), &st) != 0) || ((st.st_mode & _S_IFREG) == 0))
+		return false;
+#else
+	struct stat st;
+	if ((stat(path.c_str(), &st) != 0) || !S_ISREG(st.st_mode))
+		return false;
+#endif
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
+DirWatcher::DirWatcher(const std::vector<std::string>& dirs, const std::vector<std::string>& extensions, bool native)
+    : m_extensions(extensions)
+    , m_inotify(-1)
+{
+#ifdef __linux__
+	if (native) {
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	}
+#else
+	(void)native;
+#endif
+	for (size_t i = 0; i < dirs.size(); i++) {
+		Dir dir;
+		dir.path = dirs[i];
+		if (!dir.path.empty() && (dir.path[dir.path.size() - 1] != '/') && (dir.path[dir.path.size() - 1] != SEPARATOR)) {
+			dir.path += SEPARATOR;
+		}
+		dir.wd = -1;
+		// watch before listing, so nothing gets lost in between
+		AddWatch(dir);
+		Scan(dir, m_files);
+		m_dirs.push_back(dir);
+	}
+}
+
+DirWatcher::~DirWatcher()
+{
+#ifdef __linux__
+	if (m_inotify >= 0) {
+		close(m_inotify);
+	}
+#endif
+}
+
+DirWatcher::FileState DirWatcher::Missing()
+{
+	FileState state;
+	state.size = static_cast<uint64_t>(-1);
+	state.mtime = 0;
+	return state;
+}
+
+bool DirWatcher::IsMissing(const FileState& state)
+{
+	return state.size == static_cast<uint64_t>(-1);
+}
+
+bool DirWatcher::Matches(const std::string& name) const
+{
+	for (size_t i = 0; i < m_extensions.size(); i++) {
+		if (EndsWithNoCase(name, m_extensions[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void DirWatcher::Scan(const Dir& dir, FileMap& files) const
+{
+	std::vector<std::string> names;
+#ifdef _WIN32
+	const std::wstring wpattern = Utf8ToWide(dir.path + "*");
+	if (wpattern.empty()) {
+		return;
+	}
+	WIN32_FIND_DATAW data;
+	HANDLE handle = FindFirstFileW(wpattern.c_str(), &data);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+			continue;
+		}
+		char name[MAX_PATH * 4];
+		if (WideCharToMultiByte(CP_UTF8, 0, data.cFileName, -1, name, sizeof(name), NULL, NULL) > 0) {
+			names.push_back(name);
+		}
+	} while (FindNextFileW(handle, &data));
+	FindClose(handle);
+#else
+	DIR* handle = opendir(dir.path.c_str());
+	if (handle == NULL) {
+		return;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(handle)) != NULL) {
+		names.push_back(entry->d_name);
+	}
+	closedir(handle);
+#endif
+	for (size_t i = 0; i < names.size(); i++) {
+		if (!Matches(names[i])) {
+			continue;
+		}
+		FileState state;
+		const std::string path = dir.path + names[i];
+		if (GetFileState(path, state.size, state.mtime)) {
+			files[path] = state;
+		}
+	}
+}
+
+void DirWatcher::Rescan(const Dir& dir, FileMap& before)
+{
+	FileMap current;
+	Scan(dir, current);
+	FileMap::iterator it = m_files.lower_bound(dir.path);
+	while ((it != m_files.end()) && (it->first.compare(0, dir.path.size(), dir.path) == 0)) {
+		// skip the files of a watched subdirectory
+		if (it->first.find_first_of("/\\", dir.path.size()) != std::string::npos) {
+			++it;
+			continue;
+		}
+		before.insert(*it);
+		m_files.erase(it++);
+	}
+	for (FileMap::const_iterator cur = current.begin(); cur != current.end(); ++cur) {
+		// unchanged files are filtered in Poll()
+		before.insert(std::make_pair(cur->first, Missing()));
+		m_files.insert(*cur);
+	}
+}
+
+void DirWatcher::Update(const std::string& path, FileMap& before, std::set<std::string>& touched)
+{
+	const FileMap::iterator it = m_files.find(path);
+	if (touched.insert(path).second && (it != m_files.end())) {
+		before.insert(*it);
+	}
+	FileState state;
+	if (GetFileState(path, state.size, state.mtime)) {
+		m_files[path] = state;
+	} else if (it != m_files.end()) {
+		m_files.erase(it);
+	}
+}
+
+void DirWatcher::AddWatch(Dir& dir)
+{
+#ifdef __linux__
+	if ((m_inotify < 0) || (dir.wd >= 0)) {
+		return;
+	}
+	dir.wd = inotify_add_watch(m_inotify, dir.path.c_str(), WATCH_MASK);
+#else
+	(void)dir;
+#endif
+}
+
+bool DirWatcher::ReadEvents(FileMap& before, std::set<std::string>& touched)
+{
+#ifdef __linux__
+	bool overflow = false;
+	char buf[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+	for (;;) {
+		const ssize_t len = read(m_inotify, buf, sizeof(buf));
+		if (len <= 0) {
+			if ((len < 0) && (errno == EINTR)) {
+				continue;
+			}
+			break;
+		}
+		for (ssize_t pos = 0; pos < len;) {
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buf + pos);
+			pos += sizeof(struct inotify_event) + event->len;
+			if ((event->mask & IN_Q_OVERFLOW) != 0) {
+				overflow = true;
+				continue;
+			}
+			for (size_t i = 0; i < m_dirs.size(); i++) {
+				Dir& dir = m_dirs[i];
+				if (dir.wd != event->wd) {
+					continue;
+				}
+				if ((event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) != 0) {
+					// the directory is gone, it's watched again once it exists
+					if ((event->mask & IN_IGNORED) == 0) {
+						inotify_rm_watch(m_inotify, dir.wd);
+					}
+					dir.wd = -1;
+					Rescan(dir, before);
+				} else if ((event->len > 0) && ((event->mask & IN_ISDIR) == 0) && Matches(event->name)) {
+					Update(dir.path + event->name, before, touched);
+				}
+			}
+		}
+	}
+	return !overflow;
+#else
+	(void)before;
+	(void)touched;
+	return false;
+#endif
+}
+
+std::vector<DirWatcher::Change> DirWatcher::Poll()
+{
+	// the state before the changes of all possibly changed files,
+	// Missing() if the file didn't exist
+	FileMap before;
+	std::set<std::string> touched;
+	if (IsNative()) {
+		bool rescan = !ReadEvents(before, touched);
+		for (size_t i = 0; i < m_dirs.size(); i++) {
+			if (m_dirs[i].wd < 0) {
+				AddWatch(m_dirs[i]);
+				// created since the last poll
+				if (m_dirs[i].wd >= 0) {
+					Rescan(m_dirs[i], before);
+				}
+			} else if (rescan) {
+				Rescan(m_dirs[i], before);
+			}
+		}
+	} else {
+		for (size_t i = 0; i < m_dirs.size(); i++) {
+			Rescan(m_dirs[i], before);
+		}
+	}
+	for (std::set<std::string>::const_iterator it = touched.begin(); it != touched.end(); ++it) {
+		// created and deleted in between
+		before.insert(std::make_pair(*it, Missing()));
+	}
+
+	std::vector<Change> changes;
+	for (FileMap::const_iterator it = before.begin(); it != before.end(); ++it) {
+		const FileMap::const_iterator cur = m_files.find(it->first);
+		const bool existed = !IsMissing(it->second);
+		Change change;
+		change.path = it->first;
+		if (cur == m_files.end()) {
+			if (!existed) {
+				continue;
+			}
+			change.type = REMOVED;
+		} else if (!existed) {
+			change.type = ADDED;
+		} else if ((touched.count(it->first) > 0) || (cur->second != it->second)) {
+			change.type = MODIFIED;
+		} else {
+			continue;
+		}
+		changes.push_back(change);
+	}
+	return changes;
+}
+
+std::set<std::string> DirWatcher::GetFiles() const
+{
+	std::set<std::string> files;
+	for (FileMap::const_iterator it = m_files.begin(); it != m_files.end(); ++it) {
+		files.insert(files.end(), it->first);
+	}
+	return files;
+}
@@ -0,0 +1,97 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_DIRWATCHER_H
+#define SPRINGLOBBY_HEADERGUARD_DIRWATCHER_H
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/** @brief tracks the files with some extensions in a few directories
+ *
+ * On Linux the directories are watched with inotify, so Poll() only looks at
+ * the files which changed. Elsewhere, or if inotify isn't available, Poll()
+ * lists the directories again and compares the sizes and modification times.
+ * Directories which don't exist yet are picked up once they're created.
+ * Subdirectories aren't watched.
+ */
+class DirWatcher
+{
+public:
+	enum ChangeType {
+		ADDED,
+		MODIFIED,
+		REMOVED
+	};
+
+	struct Change {
+		ChangeType type;
+		std::string path;
+	};
+
+	/** lists the files in dirs, without reporting them as added
+	 *
+	 * @param dirs utf-8 encoded
+	 * @param extensions like ".sdfz", compared case insensitive
+	 * @param native false to always use polling
+	 */
+	DirWatcher(const std::vector<std::string>& dirs, const std::vector<std::string>& extensions, bool native = true);
+	~DirWatcher();
+
+	//! true if inotify is used, false when polling
+	bool IsNative() const
+	{
+		return m_inotify >= 0;
+	}
+
+	/** the changes since the last call or the constructor, doesn't block
+	 *
+	 * A file which was created and written since is reported as added once.
+	 */
+	std::vector<Change> Poll();
+
+	//! the watched files, as of the last Poll()
+	std::set<std::string> GetFiles() const;
+
+private:
+	DirWatcher(const DirWatcher&);
+	DirWatcher& operator=(const DirWatcher&);
+
+	struct FileState {
+		uint64_t size;
+		int64_t mtime;
+		bool operator!=(const FileState& other) const
+		{
+			return (size != other.size) || (mtime != other.mtime);
+		}
+	};
+	typedef std::map<std::string, FileState> FileMap;
+
+	struct Dir {
+		std::string path; //!< with trailing separator
+		int wd;		  //!< inotify watch or -1
+	};
+
+	//! marks files which didn't exist before a change
+	static FileState Missing();
+	static bool IsMissing(const FileState& state);
+
+	bool Matches(const std::string& name) const;
+	//! lists the matching files of a directory into files
+	void Scan(const Dir& dir, FileMap& files) const;
+	//! replaces the files of dir by a new listing, remembering the previous states
+	void Rescan(const Dir& dir, FileMap& before);
+	//! stats path and updates m_files, remembering the previous state
+	void Update(const std::string& path, FileMap& before, std::set<std::string>& touched);
+	void AddWatch(Dir& dir);
+	bool ReadEvents(FileMap& before, std::set<std::string>& touched);
+
+	std::vector<Dir> m_dirs;
+	std::vector<std::string> m_extensions;
+	FileMap m_files;
+	int m_inotify;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_DIRWATCHER_H
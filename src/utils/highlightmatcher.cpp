@@ -0,0 +1,163 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "highlightmatcher.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <queue>
+
+HighlightMatcher::HighlightMatcher()
+    : m_nodes(1)
+    , m_ignorecase(false)
+    , m_wholewords(false)
+{
+}
+
+wchar_t HighlightMatcher::Normalize(wchar_t c) const
+{
+	return m_ignorecase ? (wchar_t)std::towlower(c) : c;
+}
+
+size_t HighlightMatcher::Child(size_t node, wchar_t c) const
+{
+	const std::vector<Edge>& edges = m_nodes[node].edges;
+	const std::vector<Edge>::const_iterator it = std::lower_bound(edges.begin(), edges.end(), Edge(c, 0));
+	if ((it == edges.end()) || (it->c != c))
+		return NONE;
+	return it->node;
+}
+
+size_t HighlightMatcher::Step(size_t node, wchar_t c) const
+{
+	while (true) {
+		const size_t next = Child(node, c);
+		if (next != NONE)
+			return next;
+		if (node == 0)
+			return 0;
+		node = m_nodes[node].fail;
+	}
+}
+
+void HighlightMatcher::SetWords(const std::vector<std::wstring>& words, bool ignorecase, bool wholewords)
+{
+	m_ignorecase = ignorecase;
+	m_wholewords = wholewords;
+	m_nodes.clear();
+	m_nodes.resize(1);
+	m_lengths.clear();
+
+	// build the trie
+	for (size_t w = 0; w < words.size(); w++) {
+		const std::wstring& word = words[w];
+		m_lengths.push_back(word.size());
+		if (word.empty())
+			continue;
+		size_t node = 0;
+		for (size_t i = 0; i < word.size(); i++) {
+			const wchar_t c = Normalize(word[i]);
+			size_t next = Child(node, c);
+			if (next == NONE) {
+				next = m_nodes.size();
+				m_nodes.push_back(Node());
+				std::vector<Edge>& edges = m_nodes[node].edges;
+				edges.insert(std::upper_bound(edges.begin(), edges.end(), Edge(c, 0)), Edge(c, next));
+			}
+			node = next;
+		}
+		if (m_nodes[node].word == NONE) { // keep the first of duplicate words
+			m_nodes[node].word = w;
+		}
+	}
+
+	// breadth first to compute fail and output links
+	std::queue<size_t> pending;
+	for (size_t i = 0; i < m_nodes[0].edges.size(); i++) {
+		pending.push(m_nodes[0].edges[i].node);
+	}
+	while (!pending.empty()) {
+		const size_t node = pending.front();
+		pending.pop();
+		for (size_t i = 0; i < m_nodes[node].edges.size(); i++) {
+			const Edge edge = m_nodes[node].edges[i];
+			const size_t fail = (node == 0) ? 0 : Step(m_nodes[node].fail, edge.c);
+			Node& child = m_nodes[edge.node];
+			child.fail = (fail == edge.node) ? 0 : fail;
+			child.output = (m_nodes[child.fail].word != NONE) ? child.fail : m_nodes[child.fail].output;
+			pending.push(edge.node);
+		}
+	}
+}
+
+bool HighlightMatcher::IsEmpty() const
+{
+	return m_nodes.size() <= 1;
+}
+
+bool HighlightMatcher::IsWholeWord(const wchar_t* str, size_t len, size_t offset, size_t length) const
+{
+	if ((offset > 0) && (std::iswalnum(str[offset - 1]) || (str[offset - 1] == L'_')))
+		return false;
+	const size_t end = offset + length;
+	if ((end < len) && (std::iswalnum(str[end]) || (str[end] == L'_')))
+		return false;
+	return true;
+}
+
+template <typename Callback>
+bool HighlightMatcher::Scan(const wchar_t* str, size_t len, Callback& callback) const
+{
+	if (IsEmpty())
+		return false;
+	size_t node = 0;
+	for (size_t pos = 0; pos < len; pos++) {
+		node = Step(node, Normalize(str[pos]));
+		for (size_t out = (m_nodes[node].word != NONE) ? node : m_nodes[node].output; out != NONE; out = m_nodes[out].output) {
+			const size_t word = m_nodes[out].word;
+			const size_t length = m_lengths[word];
+			const size_t offset = pos + 1 - length;
+			if (m_wholewords && !IsWholeWord(str, len, offset, length))
+				continue;
+			if (callback(Match(offset, length, word)))
+				return true;
+		}
+	}
+	return false;
+}
+
+namespace
+{
+struct FirstMatch {
+	bool operator()(const HighlightMatcher::Match&)
+	{
+		return true;
+	}
+};
+
+struct CollectMatches {
+	explicit CollectMatches(std::vector<HighlightMatcher::Match>& _matches)
+	    : matches(_matches)
+	{
+	}
+	bool operator()(const HighlightMatcher::Match& match)
+	{
+		matches.push_back(match);
+		return false;
+	}
+	std::vector<HighlightMatcher::Match>& matches;
+};
+}
+
+bool HighlightMatcher::Contains(const wchar_t* str, size_t len) const
+{
+	FirstMatch callback;
+	return Scan(str, len, callback);
+}
+
+size_t HighlightMatcher::FindAll(const wchar_t* str, size_t len, std::vector<Match>& matches) const
+{
+	const size_t count = matches.size();
+	CollectMatches callback(matches);
+	Scan(str, len, callback);
+	return matches.size() - count;
+}
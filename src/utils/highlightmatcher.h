@@ -0,0 +1,91 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_HIGHLIGHTMATCHER_H
+#define SPRINGLOBBY_HEADERGUARD_HIGHLIGHTMATCHER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/** @brief finds any of a set of words in a text with a single scan
+ *
+ * Aho-Corasick automaton, built once by SetWords() and then matched against
+ * each chat line in time linear to the line length, independent of the
+ * number of words.
+ */
+class HighlightMatcher
+{
+public:
+	struct Match {
+		Match(size_t _offset, size_t _length, size_t _word)
+		    : offset(_offset)
+		    , length(_length)
+		    , word(_word)
+		{
+		}
+		size_t offset;
+		size_t length;
+		size_t word; //!< index into the words passed to SetWords()
+	};
+
+	HighlightMatcher();
+
+	/** rebuilds the automaton
+	 * @param ignorecase match case insensitive
+	 * @param wholewords only match words which aren't part of a longer word
+	 */
+	void SetWords(const std::vector<std::wstring>& words, bool ignorecase, bool wholewords);
+	bool IsEmpty() const;
+
+	//! @returns true if str contains at least one word
+	bool Contains(const wchar_t* str, size_t len) const;
+	/** appends all (possibly overlapping) matches, ordered by end position
+	 * @returns the number of matches appended
+	 */
+	size_t FindAll(const wchar_t* str, size_t len, std::vector<Match>& matches) const;
+
+private:
+	struct Edge {
+		Edge(wchar_t _c, size_t _node)
+		    : c(_c)
+		    , node(_node)
+		{
+		}
+		bool operator<(const Edge& other) const
+		{
+			return c < other.c;
+		}
+		wchar_t c;
+		size_t node;
+	};
+
+	struct Node {
+		Node()
+		    : fail(0)
+		    , output(NONE)
+		    , word(NONE)
+		{
+		}
+		std::vector<Edge> edges; //!< sorted by char
+		size_t fail;		 //!< longest proper suffix which is in the trie
+		size_t output;		 //!< next node on the fail chain which ends a word
+		size_t word;		 //!< index of the word ending here
+	};
+
+	static const size_t NONE = (size_t)-1;
+
+	wchar_t Normalize(wchar_t c) const;
+	size_t Child(size_t node, wchar_t c) const;
+	size_t Step(size_t node, wchar_t c) const;
+	bool IsWholeWord(const wchar_t* str, size_t len, size_t offset, size_t length) const;
+
+	template <typename Callback>
+	bool Scan(const wchar_t* str, size_t len, Callback& callback) const;
+
+	std::vector<Node> m_nodes;
+	std::vector<size_t> m_lengths;
+	bool m_ignorecase;
+	bool m_wholewords;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_HIGHLIGHTMATCHER_H
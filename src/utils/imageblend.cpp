@@ -0,0 +1,168 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "imageblend.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define IMAGEBLEND_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IMAGEBLEND_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ImageBlend
+{
+
+//! exact t / 255 for t <= 255 * 255 + 128, written with shifts only
+static inline unsigned int Div255(unsigned int t)
+{
+	return (t + 1 + (t >> 8)) >> 8;
+}
+
+static inline unsigned char BlendScalar(unsigned char fg, unsigned char bg, unsigned char alpha)
+{
+	return Div255(fg * alpha + bg * (255 - alpha) + 128);
+}
+
+static inline unsigned char BlendPremultipliedScalar(unsigned char fg, unsigned char bg, unsigned char alpha)
+{
+	return std::min(255u, fg + Div255(bg * (255 - alpha) + 128));
+}
+
+#if defined(IMAGEBLEND_SSE2)
+
+// the 16 bit lanes can't overflow: 255 * 255 + 128 + 1 + 254 < 65536
+static inline __m128i Div255Epu16(__m128i t)
+{
+	const __m128i one = _mm_set1_epi16(1);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(t, one), _mm_srli_epi16(t, 8)), 8);
+}
+
+//! div255(x * a + y * (255 - a) + 128) for 8 lanes of 16 bit
+static inline __m128i BlendEpu16(__m128i x, __m128i y, __m128i a)
+{
+	const __m128i full = _mm_set1_epi16(255);
+	const __m128i half = _mm_set1_epi16(128);
+	const __m128i t = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(x, a), _mm_mullo_epi16(y, _mm_sub_epi16(full, a))), half);
+	return Div255Epu16(t);
+}
+
+static size_t BlendSimd(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+		const __m128i a = _mm_loadu_si128((const __m128i*)(alpha + i));
+		const __m128i lo = BlendEpu16(_mm_unpacklo_epi8(f, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(a, zero));
+		const __m128i hi = BlendEpu16(_mm_unpackhi_epi8(f, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(a, zero));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+	}
+	return i;
+}
+
+static size_t BlendPremultipliedSimd(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i f = _mm_loadu_si128((const __m128i*)(fg + i));
+		const __m128i b = _mm_loadu_si128((const __m128i*)(bg + i));
+		const __m128i a = _mm_loadu_si128((const __m128i*)(alpha + i));
+		// blending with a zero foreground leaves the scaled background
+		const __m128i lo = BlendEpu16(zero, _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(a, zero));
+		const __m128i hi = BlendEpu16(zero, _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(a, zero));
+		_mm_storeu_si128((__m128i*)(out + i), _mm_adds_epu8(f, _mm_packus_epi16(lo, hi)));
+	}
+	return i;
+}
+
+#elif defined(IMAGEBLEND_NEON)
+
+static inline uint8x8_t Div255U16(uint16x8_t t)
+{
+	return vshrn_n_u16(vsraq_n_u16(vaddq_u16(t, vdupq_n_u16(1)), t, 8), 8);
+}
+
+static size_t BlendSimd(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count)
+{
+	const uint16x8_t half = vdupq_n_u16(128);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const uint8x8_t a = vld1_u8(alpha + i);
+		uint16x8_t t = vmlal_u8(half, vld1_u8(fg + i), a);
+		t = vmlal_u8(t, vld1_u8(bg + i), vmvn_u8(a));
+		vst1_u8(out + i, Div255U16(t));
+	}
+	return i;
+}
+
+static size_t BlendPremultipliedSimd(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count)
+{
+	const uint16x8_t half = vdupq_n_u16(128);
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const uint16x8_t t = vmlal_u8(half, vld1_u8(bg + i), vmvn_u8(vld1_u8(alpha + i)));
+		vst1_u8(out + i, vqadd_u8(vld1_u8(fg + i), Div255U16(t)));
+	}
+	return i;
+}
+
+#else
+
+static size_t BlendSimd(const unsigned char*, const unsigned char*, const unsigned char*, unsigned char*, size_t)
+{
+	return 0;
+}
+
+static size_t BlendPremultipliedSimd(const unsigned char*, const unsigned char*, const unsigned char*, unsigned char*, size_t)
+{
+	return 0;
+}
+
+#endif
+
+void Blend(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count)
+{
+	for (size_t i = BlendSimd(fg, bg, alpha, out, count); i < count; i++) {
+		out[i] = BlendScalar(fg[i], bg[i], alpha[i]);
+	}
+}
+
+void BlendPremultiplied(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count)
+{
+	for (size_t i = BlendPremultipliedSimd(fg, bg, alpha, out, count); i < count; i++) {
+		out[i] = BlendPremultipliedScalar(fg[i], bg[i], alpha[i]);
+	}
+}
+
+typedef void (*BlendFunc)(const unsigned char*, const unsigned char*, const unsigned char*, unsigned char*, size_t);
+
+//! spreads the alpha plane to rgb in small chunks, so the byte kernels can run over the rgb data
+static void BlendRGBChunked(BlendFunc blend, const unsigned char* fg, const unsigned char* fgalpha, const unsigned char* bg, unsigned char* out, size_t pixels)
+{
+	static const size_t CHUNK = 256;
+	unsigned char alpha3[3 * CHUNK];
+	for (size_t pos = 0; pos < pixels; pos += CHUNK) {
+		const size_t n = std::min(CHUNK, pixels - pos);
+		for (size_t i = 0; i < n; i++) {
+			alpha3[3 * i] = alpha3[3 * i + 1] = alpha3[3 * i + 2] = fgalpha[pos + i];
+		}
+		blend(fg + 3 * pos, bg + 3 * pos, alpha3, out + 3 * pos, 3 * n);
+	}
+}
+
+void BlendRGB(const unsigned char* fg, const unsigned char* fgalpha, const unsigned char* bg, unsigned char* out, size_t pixels)
+{
+	BlendRGBChunked(Blend, fg, fgalpha, bg, out, pixels);
+}
+
+void BlendRGBPremultiplied(const unsigned char* fg, const unsigned char* fgalpha, const unsigned char* bg, unsigned char* out, size_t pixels)
+{
+	BlendRGBChunked(BlendPremultiplied, fg, fgalpha, bg, out, pixels);
+}
+
+} // namespace ImageBlend
@@ -0,0 +1,31 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_IMAGEBLEND_H
+#define SPRINGLOBBY_HEADERGUARD_IMAGEBLEND_H
+
+#include <cstddef>
+
+/** @brief integer alpha compositing of 8 bit channels
+ *
+ * All functions round like (x * a + y * (255 - a) + 128) / 255 and give the
+ * same result on every platform: SSE2 and NEON are used when the compiler
+ * targets them, otherwise a scalar loop. out may be the same buffer as bg.
+ */
+namespace ImageBlend
+{
+
+//! out[i] = (fg[i] * alpha[i] + bg[i] * (255 - alpha[i]) + 128) / 255
+void Blend(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count);
+
+//! out[i] = min(255, fg[i] + (bg[i] * (255 - alpha[i]) + 128) / 255), fg is premultiplied by alpha
+void BlendPremultiplied(const unsigned char* fg, const unsigned char* bg, const unsigned char* alpha, unsigned char* out, size_t count);
+
+/** blends interleaved rgb pixels with a separate alpha plane (the layout of wxImage)
+ * @param pixels number of pixels, the rgb buffers hold 3 * pixels bytes
+ */
+void BlendRGB(const unsigned char* fg, const unsigned char* fgalpha, const unsigned char* bg, unsigned char* out, size_t pixels);
+void BlendRGBPremultiplied(const unsigned char* fg, const unsigned char* fgalpha, const unsigned char* bg, unsigned char* out, size_t pixels);
+
+} // namespace ImageBlend
+
+#endif // SPRINGLOBBY_HEADERGUARD_IMAGEBLEND_H
@@ -0,0 +1,113 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "ircformat.h"
+
+namespace IrcFormat
+{
+
+template <typename CharT>
+static inline bool IsDigit(CharT c)
+{
+	return (c >= '0') && (c <= '9');
+}
+
+template <typename CharT>
+static inline bool IsControlCode(CharT c)
+{
+	switch (c) {
+		case CODE_BOLD:
+		case CODE_COLOR:
+		case CODE_RESET:
+		case CODE_REVERSE:
+		case CODE_ITALIC:
+		case CODE_UNDERLINE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+//! parses up to two digits at str[pos], returns COLOR_DEFAULT if there are none
+template <typename CharT>
+static inline int ParseColor(const CharT* str, size_t len, size_t& pos)
+{
+	if ((pos >= len) || !IsDigit(str[pos]))
+		return COLOR_DEFAULT;
+	int color = str[pos] - '0';
+	pos++;
+	if ((pos < len) && IsDigit(str[pos])) {
+		color = color * 10 + (str[pos] - '0');
+		pos++;
+	}
+	return color;
+}
+
+template <typename CharT>
+static size_t DoTokenize(const CharT* str, size_t len, std::vector<Span>& spans)
+{
+	const size_t count = spans.size();
+	int fg = COLOR_DEFAULT;
+	int bg = COLOR_DEFAULT;
+	unsigned int flags = 0;
+
+	size_t pos = 0;
+	while (pos < len) {
+		const size_t start = pos;
+		while ((pos < len) && !IsControlCode(str[pos])) {
+			pos++;
+		}
+		if (pos > start) {
+			spans.push_back(Span(start, pos - start, fg, bg, flags));
+		}
+		if (pos >= len)
+			break;
+
+		switch (str[pos++]) {
+			case CODE_BOLD:
+				flags ^= FLAG_BOLD;
+				break;
+			case CODE_ITALIC:
+				flags ^= FLAG_ITALIC;
+				break;
+			case CODE_UNDERLINE:
+				flags ^= FLAG_UNDERLINE;
+				break;
+			case CODE_REVERSE:
+				flags ^= FLAG_REVERSE;
+				break;
+			case CODE_RESET:
+				flags = 0;
+				fg = COLOR_DEFAULT;
+				bg = COLOR_DEFAULT;
+				break;
+			case CODE_COLOR: {
+				// ^C resets, ^Cfg keeps the background, ^Cfg,bg sets both
+				const int newfg = ParseColor(str, len, pos);
+				if (newfg == COLOR_DEFAULT) {
+					fg = COLOR_DEFAULT;
+					bg = COLOR_DEFAULT;
+					break;
+				}
+				fg = newfg;
+				if ((pos + 1 < len) && (str[pos] == ',') && IsDigit(str[pos + 1])) {
+					pos++;
+					bg = ParseColor(str, len, pos);
+				}
+				break;
+			}
+		}
+	}
+	return spans.size() - count;
+}
+
+size_t Tokenize(const char* str, size_t len, std::vector<Span>& spans)
+{
+	return DoTokenize(str, len, spans);
+}
+
+size_t Tokenize(const wchar_t* str, size_t len, std::vector<Span>& spans)
+{
+	return DoTokenize(str, len, spans);
+}
+
+} // namespace IrcFormat
@@ -0,0 +1,63 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_IRCFORMAT_H
+#define SPRINGLOBBY_HEADERGUARD_IRCFORMAT_H
+
+#include <cstddef>
+#include <vector>
+
+/** @brief tokenizer for irc formatting codes
+ *
+ * see http://en.wikichip.org/wiki/irc/colors for the codes
+ */
+namespace IrcFormat
+{
+
+enum ControlCode {
+	CODE_BOLD = 0x02,
+	CODE_COLOR = 0x03,
+	CODE_RESET = 0x0F,
+	CODE_REVERSE = 0x16,
+	CODE_ITALIC = 0x1D,
+	CODE_UNDERLINE = 0x1F
+};
+
+enum Flags {
+	FLAG_BOLD = 1,
+	FLAG_ITALIC = 2,
+	FLAG_UNDERLINE = 4,
+	FLAG_REVERSE = 8
+};
+
+//! no color set, use the default one
+static const int COLOR_DEFAULT = -1;
+
+//! run of printable text with the same formatting
+struct Span {
+	Span(size_t _offset, size_t _length, int _fg, int _bg, unsigned int _flags)
+	    : offset(_offset)
+	    , length(_length)
+	    , fg(_fg)
+	    , bg(_bg)
+	    , flags(_flags)
+	{
+	}
+	size_t offset; //!< offset into the tokenized string
+	size_t length;
+	int fg; //!< irc color index (0-98) or COLOR_DEFAULT
+	int bg; //!< irc color index (0-98) or COLOR_DEFAULT
+	unsigned int flags;
+};
+
+/** scans str once and appends a span for each run of equally formatted text
+ *
+ * Control codes (and color parameters) are not part of any span, so
+ * concatenating the spans gives the line with the formatting stripped.
+ * @returns the number of spans appended
+ */
+size_t Tokenize(const char* str, size_t len, std::vector<Span>& spans);
+size_t Tokenize(const wchar_t* str, size_t len, std::vector<Span>& spans);
+
+} // namespace IrcFormat
+
+#endif // SPRINGLOBBY_HEADERGUARD_IRCFORMAT_H
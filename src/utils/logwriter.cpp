@@ -0,0 +1,240 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "logwriter.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <vector>
+
+#include "utf8file.h"
+
+const size_t LogWriter::FLUSH_SIZE;
+const int LogWriter::FLUSH_INTERVAL_MS;
+const size_t LogWriter::MAX_PENDING;
+
+LogWriter* LogWriter::m_Instance = NULL;
+
+LogWriter* LogWriter::Instance()
+{
+	if (m_Instance == NULL) {
+		m_Instance = new LogWriter();
+	}
+	return m_Instance;
+}
+
+void LogWriter::Release()
+{
+	if (m_Instance != NULL) {
+		delete m_Instance;
+		m_Instance = NULL;
+	}
+}
+
+LogWriter::LogWriter()
+    : m_pending(0)
+    , m_closes(0)
+    , m_flush_requests(0)
+    , m_flushed(0)
+    , m_stop(false)
+    , m_thread(&LogWriter::Run, this)
+{
+}
+
+LogWriter::~LogWriter()
+{
+	{
+		boost::lock_guard<boost::mutex> lock(m_mutex);
+		m_stop = true;
+		m_wake.notify_one();
+	}
+	m_thread.join();
+}
+
+bool LogWriter::Append(const std::string& path, const std::string& text)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	// back-pressure: don't let a stalled disk eat all memory
+	while ((m_pending > 0) && (m_pending + text.size() > MAX_PENDING)) {
+		m_wake.notify_one();
+		m_written.wait(lock);
+	}
+	File& file = m_files[path];
+	if (file.failed) {
+		return false;
+	}
+	if ((m_pending == 0) && (m_closes == 0)) {
+		m_deadline = boost::get_system_time() + boost::posix_time::milliseconds(FLUSH_INTERVAL_MS);
+	}
+	file.buffer += text;
+	m_pending += text.size();
+	if (m_pending >= FLUSH_SIZE) {
+		m_wake.notify_one();
+	}
+	return true;
+}
+
+void LogWriter::Close(const std::string& path)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+	std::map<std::string, File>::iterator it = m_files.find(path);
+	if ((it == m_files.end()) || it->second.close) {
+		return;
+	}
+	if ((m_pending == 0) && (m_closes == 0)) {
+		m_deadline = boost::get_system_time() + boost::posix_time::milliseconds(FLUSH_INTERVAL_MS);
+	}
+	it->second.close = true;
+	m_closes++;
+}
+
+void LogWriter::Flush()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	const uint64_t request = ++m_flush_requests;
+	m_wake.notify_one();
+	while (m_flushed < request) {
+		m_written.wait(lock);
+	}
+}
+
+void LogWriter::Flush(const std::string& path)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	std::map<std::string, File>::const_iterator it = m_files.find(path);
+	if (it == m_files.end()) {
+		return;
+	}
+	if (!it->second.buffer.empty()) {
+		// the commit takes all buffers, this file's among them
+		const uint64_t request = ++m_flush_requests;
+		m_wake.notify_one();
+		while (m_flushed < request) {
+			m_written.wait(lock);
+		}
+		return;
+	}
+	// files are erased from m_files after their last commit, look it up again
+	while (((it = m_files.find(path)) != m_files.end()) && it->second.writing) {
+		m_written.wait(lock);
+	}
+}
+
+void LogWriter::Post(const std::function<void()>& task)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+	m_tasks.push_back(task);
+	m_wake.notify_one();
+}
+
+void LogWriter::SetCommitHook(const CommitHook& hook)
+{
+	boost::lock_guard<boost::mutex> lock(m_mutex);
+	m_hook = hook;
+}
+
+bool LogWriter::CommitDue() const
+{
+	if (m_stop || (m_flush_requests > m_flushed) || !m_tasks.empty()) {
+		return true;
+	}
+	if ((m_pending == 0) && (m_closes == 0)) {
+		return false;
+	}
+	return (m_pending >= FLUSH_SIZE) || (boost::get_system_time() >= m_deadline);
+}
+
+void LogWriter::Run()
+{
+	struct Job {
+		std::string path;
+		std::string data;
+		FILE* fp;
+		bool close;
+		bool failed;
+	};
+
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while (true) {
+		while (!CommitDue()) {
+			if ((m_pending == 0) && (m_closes == 0)) {
+				m_wake.wait(lock);
+			} else {
+				m_wake.timed_wait(lock, m_deadline);
+			}
+		}
+
+		// take all buffers, so appending can go on while writing
+		const uint64_t requests = m_flush_requests;
+		std::vector<Job> jobs;
+		for (std::map<std::string, File>::iterator it = m_files.begin(); it != m_files.end(); ++it) {
+			File& file = it->second;
+			if (file.buffer.empty() && !file.close && !(m_stop && (file.fp != NULL))) {
+				continue;
+			}
+			Job job;
+			job.path = it->first;
+			job.data.swap(file.buffer);
+			job.fp = file.fp;
+			job.close = file.close || m_stop;
+			job.failed = file.failed;
+			file.close = false;
+			file.writing = true;
+			jobs.push_back(job);
+		}
+		m_pending = 0;
+		m_closes = 0;
+		std::vector<std::function<void()> > tasks;
+		tasks.swap(m_tasks);
+		const bool stop = m_stop;
+		const CommitHook hook = m_hook;
+		lock.unlock();
+
+		for (size_t i = 0; i < jobs.size(); i++) {
+			Job& job = jobs[i];
+			if (!job.data.empty() && !job.failed) {
+				if (job.fp == NULL) {
+					job.fp = Utf8Open(job.path, "ab");
+				}
+				int64_t offset = -1;
+				if ((job.fp != NULL) && hook && (fseek(job.fp, 0, SEEK_END) == 0)) {
+					offset = Utf8Tell(job.fp);
+				}
+				// one write per file and commit, flushed so a crash can't lose it
+				if ((job.fp == NULL) || (fwrite(job.data.data(), 1, job.data.size(), job.fp) != job.data.size()) || (fflush(job.fp) != 0)) {
+					job.failed = true;
+				} else if (offset >= 0) {
+					hook(job.path, offset, job.data);
+				}
+			}
+			if (job.close && (job.fp != NULL)) {
+				fclose(job.fp);
+				job.fp = NULL;
+			}
+		}
+
+		lock.lock();
+		for (size_t i = 0; i < jobs.size(); i++) {
+			const Job& job = jobs[i];
+			File& file = m_files[job.path];
+			file.fp = job.fp;
+			file.writing = false;
+			// a closed file gets another chance when it's opened again
+			file.failed = job.failed && !job.close;
+			if ((file.fp == NULL) && file.buffer.empty() && !file.close && !file.failed) {
+				m_files.erase(job.path);
+			}
+		}
+		m_flushed = requests;
+		m_written.notify_all();
+		// after signaling, so Flush() doesn't wait for a slow task
+		if (!tasks.empty()) {
+			lock.unlock();
+			for (size_t i = 0; i < tasks.size(); i++) {
+				tasks[i]();
+			}
+			lock.lock();
+		}
+		if (stop && (m_pending == 0) && m_tasks.empty()) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,104 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_LOGWRITER_H
+#define SPRINGLOBBY_HEADERGUARD_LOGWRITER_H
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <stdint.h>
+#include <stdio.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @brief appends text to files from a background thread
+ *
+ * Appended text is collected in a buffer per file. The writer thread commits
+ * all buffers at once when FLUSH_SIZE bytes are pending or the oldest pending
+ * text is FLUSH_INTERVAL_MS old, so each file gets one write per commit
+ * instead of one per line. If MAX_PENDING bytes are waiting, Append() blocks
+ * until the writer caught up. Files stay open until Close() and every commit
+ * is flushed to the OS, so a crash loses at most the last interval.
+ */
+class LogWriter
+{
+private:
+	LogWriter();
+	~LogWriter();
+
+public:
+	static LogWriter* Instance();
+	//! writes everything pending and stops the writer thread
+	static void Release();
+
+	static const size_t FLUSH_SIZE = 64 * 1024;
+	static const int FLUSH_INTERVAL_MS = 1000;
+	static const size_t MAX_PENDING = 4 * 1024 * 1024;
+
+	/** queues text to be appended to the file at path
+	 * @return false if an earlier write to this file failed
+	 */
+	bool Append(const std::string& path, const std::string& text);
+	//! closes the file after its pending text was written
+	void Close(const std::string& path);
+	//! blocks until everything appended so far was written
+	void Flush();
+	/** blocks until the text appended to path so far was written
+	 *
+	 * Returns right away if none of it is pending, other files aren't waited
+	 * for.
+	 */
+	void Flush(const std::string& path);
+	/** runs task on the writer thread once the text appended so far was written
+	 *
+	 * For slow file work that has to follow the pending writes, like
+	 * compressing a rotated log. Flush() doesn't wait for tasks.
+	 */
+	void Post(const std::function<void()>& task);
+
+	/** called from the writer thread after text was written to a file
+	 * @param offset file position the text was written to
+	 */
+	typedef std::function<void(const std::string& path, uint64_t offset, const std::string& text)> CommitHook;
+	void SetCommitHook(const CommitHook& hook);
+
+private:
+	struct File {
+		File()
+		    : fp(NULL)
+		    , close(false)
+		    , failed(false)
+		    , writing(false)
+		{
+		}
+		std::string buffer;
+		FILE* fp; //!< only used by the writer thread
+		bool close;
+		bool failed;
+		bool writing; //!< the writer thread took text of it and didn't finish yet
+	};
+
+	bool CommitDue() const;
+	void Run();
+
+	static LogWriter* m_Instance;
+
+	std::map<std::string, File> m_files;
+	size_t m_pending; //!< bytes in all buffers
+	size_t m_closes;  //!< files waiting to be closed
+	std::vector<std::function<void()> > m_tasks;
+	boost::system_time m_deadline; //!< commit time of the oldest pending text
+	uint64_t m_flush_requests;
+	uint64_t m_flushed;
+	bool m_stop;
+	CommitHook m_hook;
+
+	boost::mutex m_mutex;
+	boost::condition_variable m_wake;    //!< wakes the writer
+	boost::condition_variable m_written; //!< signaled after each commit
+	boost::thread m_thread;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_LOGWRITER_H
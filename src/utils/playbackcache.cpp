@@ -0,0 +1,290 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "playbackcache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "utf8file.h"
+
+const uint32_t PlaybackCache::VERSION;
+
+static const char CACHE_MAGIC[8] = {'S', 'L', 'P', 'B', 'C', 'A', 'C', 'H'};
+
+//! little endian writer of the cache file
+class CacheWriter
+{
+public:
+	void PutUint(uint64_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++) {
+			m_data += (char)((value >> (8 * i)) & 0xFF);
+		}
+	}
+	void PutString(const std::string& str)
+	{
+		PutUint(str.size(), 4);
+		m_data += str;
+	}
+	const std::string& Data() const
+	{
+		return m_data;
+	}
+
+private:
+	std::string m_data;
+};
+
+//! reader of the cache file, fails on the first read past the end
+class CacheReader
+{
+public:
+	CacheReader(const char* data, size_t size)
+	    : m_data(data)
+	    , m_size(size)
+	    , m_pos(0)
+	    , m_ok(true)
+	{
+	}
+	uint64_t GetUint(int bytes)
+	{
+		if (!m_ok || (m_size - m_pos < (size_t)bytes)) {
+			m_ok = false;
+			return 0;
+		}
+		uint64_t value = 0;
+		for (int i = bytes - 1; i >= 0; i--) {
+			value = (value << 8) | (unsigned char)m_data[m_pos + i];
+		}
+		m_pos += bytes;
+		return value;
+	}
+	std::string GetString()
+	{
+		const uint64_t length = GetUint(4);
+		if (!m_ok || (m_size - m_pos < length)) {
+			m_ok = false;
+			return std::string();
+		}
+		m_pos += length;
+		return std::string(m_data + m_pos - length, length);
+	}
+	bool IsOk() const
+	{
+		return m_ok;
+	}
+	bool AtEnd() const
+	{
+		return m_pos == m_size;
+	}
+
+private:
+	const char* m_data;
+	size_t m_size;
+	size_t m_pos;
+	bool m_ok;
+};
+
+static void WriteSummary(CacheWriter& writer, const DemoSummary& demo)
+{
+	writer.PutUint(demo.scanned ? 1 : 0, 1);
+	writer.PutUint(demo.gameover ? 1 : 0, 1);
+	writer.PutUint(demo.winners.size(), 1);
+	for (size_t i = 0; i < demo.winners.size(); i++) {
+		writer.PutUint(demo.winners[i], 1);
+	}
+	writer.PutUint(demo.chat.size(), 4);
+	for (size_t i = 0; i < demo.chat.size(); i++) {
+		const DemoSummary::ChatMessage& message = demo.chat[i];
+		writer.PutUint(message.time, 4);
+		writer.PutUint(message.from, 1);
+		writer.PutUint(message.dest, 1);
+		writer.PutString(message.from_name);
+		writer.PutString(message.text);
+	}
+	writer.PutUint(demo.players.size(), 4);
+	for (size_t i = 0; i < demo.players.size(); i++) {
+		const DemoSummary::PlayerStats& player = demo.players[i];
+		writer.PutUint((uint32_t)player.mousePixels, 4);
+		writer.PutUint((uint32_t)player.mouseClicks, 4);
+		writer.PutUint((uint32_t)player.keyPresses, 4);
+		writer.PutUint((uint32_t)player.numCommands, 4);
+		writer.PutUint((uint32_t)player.unitCommands, 4);
+	}
+}
+
+static bool ReadSummary(CacheReader& reader, DemoSummary& demo)
+{
+	demo.scanned = reader.GetUint(1) != 0;
+	demo.gameover = reader.GetUint(1) != 0;
+	const uint64_t winners = reader.GetUint(1);
+	for (uint64_t i = 0; (i < winners) && reader.IsOk(); i++) {
+		demo.winners.push_back(reader.GetUint(1));
+	}
+	const uint64_t chat = reader.GetUint(4);
+	if (chat > DemoSummary::MAX_CHAT_MESSAGES)
+		return false;
+	demo.chat.resize(chat);
+	for (uint64_t i = 0; (i < chat) && reader.IsOk(); i++) {
+		DemoSummary::ChatMessage& message = demo.chat[i];
+		message.time = (int)(int32_t)reader.GetUint(4);
+		message.from = reader.GetUint(1);
+		message.dest = reader.GetUint(1);
+		message.from_name = reader.GetString();
+		message.text = reader.GetString();
+	}
+	const uint64_t players = reader.GetUint(4);
+	if (players > (uint64_t)DemoSummary::MAX_PLAYERS)
+		return false;
+	demo.players.resize(players);
+	for (uint64_t i = 0; (i < players) && reader.IsOk(); i++) {
+		DemoSummary::PlayerStats& player = demo.players[i];
+		player.mousePixels = (int32_t)reader.GetUint(4);
+		player.mouseClicks = (int32_t)reader.GetUint(4);
+		player.keyPresses = (int32_t)reader.GetUint(4);
+		player.numCommands = (int32_t)reader.GetUint(4);
+		player.unitCommands = (int32_t)reader.GetUint(4);
+	}
+	return reader.IsOk();
+}
+
+PlaybackCache::PlaybackCache(const std::string& path)
+    : m_path(path)
+    , m_changed(false)
+{
+}
+
+bool PlaybackCache::Load()
+{
+	m_entries.clear();
+	m_changed = true; // rewritten unless it loads fine
+	FILE* file = Utf8Open(m_path, "rb");
+	if (file == NULL)
+		return false;
+	std::string data;
+	char buffer[64 * 1024];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		data.append(buffer, read);
+	}
+	fclose(file);
+
+	CacheReader reader(data.data(), data.size());
+	if ((data.size() < sizeof(CACHE_MAGIC)) || (memcmp(data.data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0))
+		return false;
+	reader.GetUint(sizeof(CACHE_MAGIC));
+	if (reader.GetUint(4) != VERSION)
+		return false;
+	const uint64_t count = reader.GetUint(4);
+	bool ok = true;
+	for (uint64_t i = 0; ok && (i < count) && reader.IsOk(); i++) {
+		const std::string path = reader.GetString();
+		Item& item = m_entries[path];
+		Entry& entry = item.entry;
+		item.used = false;
+		entry.size = reader.GetUint(8);
+		entry.mtime = (int64_t)reader.GetUint(8);
+		entry.ok = reader.GetUint(1) != 0;
+		entry.battletype = (int32_t)reader.GetUint(4);
+		entry.duration = (int32_t)reader.GetUint(4);
+		entry.wallclock_duration = (int32_t)reader.GetUint(4);
+		entry.date = (int64_t)reader.GetUint(8);
+		entry.players = (int32_t)reader.GetUint(4);
+		entry.date_string = reader.GetString();
+		entry.gameid = reader.GetString();
+		entry.map_name = reader.GetString();
+		entry.map_hash = reader.GetString();
+		entry.game_name = reader.GetString();
+		entry.game_hash = reader.GetString();
+		entry.engine_name = reader.GetString();
+		entry.engine_version = reader.GetString();
+		ok = ReadSummary(reader, entry.demo);
+	}
+	if (!ok || !reader.IsOk() || !reader.AtEnd()) {
+		m_entries.clear();
+		return false;
+	}
+	m_changed = false;
+	return true;
+}
+
+bool PlaybackCache::Save(bool prune)
+{
+	for (std::unordered_map<std::string, Item>::iterator it = m_entries.begin(); it != m_entries.end();) {
+		if (it->second.used || !prune) {
+			++it;
+		} else {
+			it = m_entries.erase(it);
+			m_changed = true;
+		}
+	}
+	if (!m_changed)
+		return true;
+
+	CacheWriter writer;
+	std::string data(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	writer.PutUint(VERSION, 4);
+	writer.PutUint(m_entries.size(), 4);
+	for (std::unordered_map<std::string, Item>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+		const Entry& entry = it->second.entry;
+		writer.PutString(it->first);
+		writer.PutUint(entry.size, 8);
+		writer.PutUint(entry.mtime, 8);
+		writer.PutUint(entry.ok ? 1 : 0, 1);
+		writer.PutUint(entry.battletype, 4);
+		writer.PutUint(entry.duration, 4);
+		writer.PutUint(entry.wallclock_duration, 4);
+		writer.PutUint(entry.date, 8);
+		writer.PutUint(entry.players, 4);
+		writer.PutString(entry.date_string);
+		writer.PutString(entry.gameid);
+		writer.PutString(entry.map_name);
+		writer.PutString(entry.map_hash);
+		writer.PutString(entry.game_name);
+		writer.PutString(entry.game_hash);
+		writer.PutString(entry.engine_name);
+		writer.PutString(entry.engine_version);
+		WriteSummary(writer, entry.demo);
+	}
+	data += writer.Data();
+
+	// written to a temporary file first, a crash mustn't leave half a cache
+	const std::string tmp = m_path + ".tmp";
+	FILE* file = Utf8Open(tmp, "wb");
+	if (file == NULL)
+		return false;
+	bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	ok = (fclose(file) == 0) && ok;
+	ok = ok && Utf8Rename(tmp, m_path);
+	if (!ok) {
+		Utf8Remove(tmp);
+		return false;
+	}
+	m_changed = false;
+	return true;
+}
+
+const PlaybackCache::Entry* PlaybackCache::Find(const std::string& path, uint64_t size, int64_t mtime)
+{
+	std::unordered_map<std::string, Item>::iterator it = m_entries.find(path);
+	if ((it == m_entries.end()) || (it->second.entry.size != size) || (it->second.entry.mtime != mtime))
+		return NULL;
+	it->second.used = true;
+	return &it->second.entry;
+}
+
+void PlaybackCache::Store(const std::string& path, const Entry& entry)
+{
+	Item& item = m_entries[path];
+	item.entry = entry;
+	item.used = true;
+	m_changed = true;
+}
+
+void PlaybackCache::Keep(const std::string& path)
+{
+	std::unordered_map<std::string, Item>::iterator it = m_entries.find(path);
+	if (it != m_entries.end()) {
+		it->second.used = true;
+	}
+}
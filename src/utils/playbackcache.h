@@ -0,0 +1,91 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_PLAYBACKCACHE_H
+#define SPRINGLOBBY_HEADERGUARD_PLAYBACKCACHE_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+#include "demoscanner.h"
+
+/** @brief on disk cache of the metadata of replays
+ *
+ * Entries are keyed by path and only valid while the size and modification
+ * time of the file match. The cache is a flat binary file, stamped with
+ * VERSION: bump it whenever the parsing of replays changes and all replays
+ * are parsed again. Save() drops the entries of files that weren't looked up
+ * or stored since Load(), e.g. deleted replays, unless prune is false.
+ */
+class PlaybackCache
+{
+public:
+	static const uint32_t VERSION = 3;
+
+	struct Entry {
+		Entry()
+		    : size(0)
+		    , mtime(0)
+		    , ok(false)
+		    , battletype(0)
+		    , duration(0)
+		    , wallclock_duration(0)
+		    , date(0)
+		    , players(0)
+		{
+		}
+		uint64_t size;
+		int64_t mtime;
+		bool ok; //!< false for broken replays, they aren't parsed again either
+		int32_t battletype;
+		int32_t duration;
+		int32_t wallclock_duration;
+		int64_t date;
+		int32_t players; //!< without spectators
+		std::string date_string;
+		std::string gameid;
+		std::string map_name;
+		std::string map_hash;
+		std::string game_name;
+		std::string game_hash;
+		std::string engine_name;
+		std::string engine_version;
+		DemoSummary demo;
+	};
+
+	//! @param path utf-8 encoded
+	explicit PlaybackCache(const std::string& path);
+
+	//! @return false if there is no cache or it is outdated or broken
+	bool Load();
+	/** writes the cache, if it changed
+	 *
+	 * @param prune false when only some files were looked up
+	 */
+	bool Save(bool prune = true);
+
+	/** @return the entry of the file or NULL if it isn't cached or was
+	 * modified since
+	 */
+	const Entry* Find(const std::string& path, uint64_t size, int64_t mtime);
+	void Store(const std::string& path, const Entry& entry);
+	//! keeps the entry of a file which wasn't looked up on the next Save()
+	void Keep(const std::string& path);
+
+	size_t GetCount() const
+	{
+		return m_entries.size();
+	}
+
+private:
+	struct Item {
+		Entry entry;
+		bool used;
+	};
+
+	std::string m_path;
+	std::unordered_map<std::string, Item> m_entries;
+	bool m_changed;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_PLAYBACKCACHE_H
@@ -0,0 +1,402 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_PLAYBACKLIST_H
+#define SPRINGLOBBY_HEADERGUARD_PLAYBACKLIST_H
+
+#include <assert.h>
+#include <boost/thread/mutex.hpp>
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "playbackcache.h"
+#include "utf8file.h"
+#include "workerpool.h"
+
+/** @brief the playbacks of the demo or savegame directory, by id and filename
+ *
+ * Playback needs the members id and cached, see StoredGame. Parsing the
+ * files and converting them from and to cache entries is left to the
+ * subclass, see IPlaybackList. Nothing here needs wx or unitsync, so the
+ * list can be tested with a stub playback.
+ */
+template <class Playback>
+class PlaybackList
+{
+public:
+	PlaybackList()
+	    : m_next_id(0)
+	{
+	}
+	virtual ~PlaybackList()
+	{
+	}
+
+	//! playbacks which were read, they aren't listed before InsertPlaybacks()
+	typedef std::function<void(std::vector<Playback>& playbacks)> LoadedHandler;
+
+	/** reads the playbacks of the files which aren't listed
+	 *
+	 * The metadata of playbacks which didn't change since the last call is
+	 * read from the cache file, they are only parsed by LoadDetails. The
+	 * others are parsed on a WorkerPool. All are reported to loaded in
+	 * batches, from the calling thread.
+	 *
+	 * The list itself is only read until the first batch is reported, so
+	 * this can run on another thread while the list isn't modified. Remove
+	 * the missing playbacks first, RemoveAll() to read all again. The cache
+	 * entries of files which aren't in filenames are dropped.
+	 */
+	void LoadPlaybacks(const std::set<std::string>& filenames, const LoadedHandler& loaded);
+	/** reads playbacks which were created since, like LoadPlaybacks
+	 *
+	 * Known filenames are skipped, remove modified playbacks first. The
+	 * cache entries of other files are kept.
+	 */
+	void AddPlaybacks(const std::set<std::string>& filenames, const LoadedHandler& loaded);
+	/** lists playbacks reported to the LoadedHandler, on the thread which
+	 * owns the list
+	 *
+	 * Filenames which are listed already are skipped.
+	 * @return ids of the playbacks which were added
+	 */
+	std::vector<size_t> InsertPlaybacks(std::vector<Playback>& playbacks);
+	//! parses a cached playback fully, for the users and the script
+	bool LoadDetails(Playback& playback);
+	/** reads the demo stream for the summary and stores it in the cache
+	 *
+	 * Reading the stream takes up to a few hundred ms, so it's left out when
+	 * parsing and has to be called from a worker thread, see PlaybackTab.
+	 * The playback itself isn't modified. The summaries are written to the
+	 * cache file SCAN_SAVE_BATCH at a time, by the next LoadPlaybacks() or
+	 * AddPlaybacks(), or by SaveScans().
+	 * @return false if the playback has no stream or it couldn't be read
+	 */
+	bool ScanDemo(const std::string& filename, DemoSummary& demo) const;
+	//! writes the summaries ScanDemo() collected to the cache file
+	void SaveScans() const;
+
+	Playback& AddPlayback(const std::string& filename);
+	//! @return false if no playback with this id is listed
+	bool RemovePlayback(unsigned int const id);
+	//! @return the id of the playback or -1 if it isn't listed
+	int FindPlayback(const std::string& filename) const;
+
+	Playback& GetPlaybackById(unsigned int const id);
+
+	bool PlaybackExists(unsigned int const id) const;
+	size_t GetNumPlaybacks() const;
+
+	void RemoveAll();
+
+	const std::map<size_t, Playback>& GetPlaybacksMap() const;
+	virtual bool GetReplayInfos(const std::string& ReplayPath, Playback& ret) const = 0;
+
+protected:
+	//! utf-8 path of the metadata cache, none if empty
+	virtual std::string GetCacheFile() const
+	{
+		return std::string();
+	}
+	//! reads the demo stream of a playback, savegames don't have one
+	virtual bool ReadDemoSummary(const std::string& /*filename*/, DemoSummary& /*demo*/) const
+	{
+		return false;
+	}
+	//! called from the worker threads
+	virtual bool ParsePlayback(const std::string& filename, Playback& playback) const
+	{
+		const bool ok = GetReplayInfos(filename, playback);
+		playback.cached = false;
+		return ok;
+	}
+	//! the filename the playback was added with
+	virtual std::string GetFilename(const Playback& playback) const = 0;
+	virtual void ToCache(const Playback& playback, bool ok, PlaybackCache::Entry& entry) const = 0;
+	virtual void FromCache(const std::string& filename, const PlaybackCache::Entry& entry, Playback& playback) const = 0;
+	virtual void OnCacheError(const std::string& /*cachefile*/) const
+	{
+	}
+
+	std::map<size_t, Playback> m_replays;
+	std::map<const std::string, size_t> m_replays_filename_index;
+	std::vector<size_t> m_free_ids; //!< of removed playbacks, reused first
+	size_t m_next_id;
+
+private:
+	//! parsed playbacks are reported to the LoadedHandler in batches of this size
+	static const size_t PARSE_BATCH_SIZE = 100;
+	//! demo summaries collected before the cache file is rewritten
+	static const size_t SCAN_SAVE_BATCH = 20;
+
+	//! adds the unknown filenames, prune drops the cache entries of all others
+	void ParsePlaybacks(const std::set<std::string>& filenames, bool prune, const LoadedHandler& loaded);
+	/** stores the collected summaries in the loaded cache, m_cache_mutex is held
+	 * @param filenames if not NULL, the summaries of other files are dropped
+	 */
+	void ApplyScans(PlaybackCache& cache, const std::set<std::string>* filenames) const;
+	void SaveScansLocked() const;
+
+	struct Scan {
+		uint64_t size;
+		int64_t mtime;
+		DemoSummary demo;
+	};
+	//! by filename, not yet in the cache file
+	mutable std::map<std::string, Scan> m_scans;
+	//! held from loading to saving the cache file and for m_scans, it's written from several threads
+	mutable boost::mutex m_cache_mutex;
+};
+
+template <class Playback>
+int PlaybackList<Playback>::FindPlayback(const std::string& filename) const
+{
+	auto playbackId = m_replays_filename_index.find(filename);
+
+	if (playbackId != m_replays_filename_index.end()) {
+		return playbackId->second;
+	}
+
+	return -1;
+}
+
+template <class Playback>
+void PlaybackList<Playback>::LoadPlaybacks(const std::set<std::string>& filenames, const LoadedHandler& loaded)
+{
+	ParsePlaybacks(filenames, true, loaded);
+}
+
+template <class Playback>
+void PlaybackList<Playback>::AddPlaybacks(const std::set<std::string>& filenames, const LoadedHandler& loaded)
+{
+	ParsePlaybacks(filenames, false, loaded);
+}
+
+template <class Playback>
+void PlaybackList<Playback>::ParsePlaybacks(const std::set<std::string>& filenames, bool prune, const LoadedHandler& loaded)
+{
+	const std::string cachefile = GetCacheFile();
+	boost::mutex::scoped_lock lock(m_cache_mutex);
+	PlaybackCache cache(cachefile);
+	if (!cachefile.empty()) {
+		cache.Load();
+		// not kept when pruning, like the rest of a deleted replay's entry
+		ApplyScans(cache, prune ? &filenames : NULL);
+	}
+
+	struct Pending {
+		Playback playback;
+		std::string filename;
+		PlaybackCache::Entry entry;
+		bool cacheable; //!< entry has the size and mtime of the file
+		bool ok;
+	};
+	std::vector<Pending> pending;
+	std::vector<Playback> batch;
+	for (const std::string& filename : filenames) { //read replays which aren't listed yet
+		const int pos = FindPlayback(filename);
+		if (pos != -1) {
+			cache.Keep(filename);
+			continue;
+		}
+		Pending parse;
+		parse.filename = filename;
+		parse.ok = false;
+		parse.cacheable = !cachefile.empty() && Utf8Stat(filename, parse.entry.size, parse.entry.mtime);
+		if (parse.cacheable) {
+			const PlaybackCache::Entry* cached = cache.Find(filename, parse.entry.size, parse.entry.mtime);
+			if (cached != NULL) {
+				FromCache(filename, *cached, parse.playback);
+				batch.push_back(std::move(parse.playback));
+				continue;
+			}
+		}
+		pending.push_back(std::move(parse));
+	}
+	// the list is inserted into from here on, it isn't read anymore
+	if (!batch.empty()) {
+		loaded(batch);
+	}
+
+	// each worker fills its own playback
+	WorkerPool::Run(pending.size(), WorkerPool::GetDefaultThreadCount(), PARSE_BATCH_SIZE,
+			[this, &pending](size_t index) {
+				pending[index].ok = ParsePlayback(pending[index].filename, pending[index].playback);
+			},
+			[&](const std::vector<size_t>& done) {
+				batch.clear();
+				for (size_t index : done) {
+					Pending& parsed = pending[index];
+					// broken playbacks are stored too, they aren't parsed on every load
+					if (parsed.cacheable) {
+						ToCache(parsed.playback, parsed.ok, parsed.entry);
+						cache.Store(parsed.filename, parsed.entry);
+					}
+					batch.push_back(std::move(parsed.playback));
+				}
+				loaded(batch);
+			});
+
+	if (!cachefile.empty() && !cache.Save(prune)) {
+		OnCacheError(cachefile);
+	}
+}
+
+template <class Playback>
+bool PlaybackList<Playback>::LoadDetails(Playback& playback)
+{
+	if (!playback.cached)
+		return true;
+	return ParsePlayback(GetFilename(playback), playback);
+}
+
+template <class Playback>
+bool PlaybackList<Playback>::ScanDemo(const std::string& filename, DemoSummary& demo) const
+{
+	if (!ReadDemoSummary(filename, demo))
+		return false;
+	Scan scan;
+	if (GetCacheFile().empty() || !Utf8Stat(filename, scan.size, scan.mtime))
+		return true;
+	scan.demo = demo;
+
+	// rewriting the whole cache for every selected replay adds up
+	boost::mutex::scoped_lock lock(m_cache_mutex);
+	m_scans[filename] = scan;
+	if (m_scans.size() >= SCAN_SAVE_BATCH) {
+		SaveScansLocked();
+	}
+	return true;
+}
+
+template <class Playback>
+void PlaybackList<Playback>::SaveScans() const
+{
+	boost::mutex::scoped_lock lock(m_cache_mutex);
+	SaveScansLocked();
+}
+
+template <class Playback>
+void PlaybackList<Playback>::SaveScansLocked() const
+{
+	const std::string cachefile = GetCacheFile();
+	if (m_scans.empty() || cachefile.empty())
+		return;
+	PlaybackCache cache(cachefile);
+	if (!cache.Load()) {
+		// the next LoadPlaybacks() writes a new one
+		return;
+	}
+	ApplyScans(cache, NULL);
+	if (!cache.Save(false)) {
+		OnCacheError(cachefile);
+	}
+}
+
+template <class Playback>
+void PlaybackList<Playback>::ApplyScans(PlaybackCache& cache, const std::set<std::string>* filenames) const
+{
+	for (typename std::map<std::string, Scan>::const_iterator it = m_scans.begin(); it != m_scans.end(); ++it) {
+		if ((filenames != NULL) && (filenames->find(it->first) == filenames->end()))
+			continue;
+		// only while the replay wasn't modified since
+		const PlaybackCache::Entry* cached = cache.Find(it->first, it->second.size, it->second.mtime);
+		if (cached != NULL) {
+			PlaybackCache::Entry entry = *cached;
+			entry.demo = it->second.demo;
+			cache.Store(it->first, entry);
+		}
+	}
+	m_scans.clear();
+}
+
+template <class Playback>
+std::vector<size_t> PlaybackList<Playback>::InsertPlaybacks(std::vector<Playback>& playbacks)
+{
+	std::vector<size_t> ids;
+	ids.reserve(playbacks.size());
+	for (Playback& loaded : playbacks) {
+		const std::string filename = GetFilename(loaded);
+		if (FindPlayback(filename) != -1)
+			continue;
+		Playback& playback = AddPlayback(filename);
+		const size_t id = playback.id;
+		playback = std::move(loaded);
+		playback.id = id;
+		ids.push_back(id);
+	}
+	return ids;
+}
+
+template <class Playback>
+Playback& PlaybackList<Playback>::AddPlayback(const std::string& filename)
+{
+	size_t id = m_next_id;
+	if (m_free_ids.empty()) {
+		m_next_id++;
+	} else { //item was deleted, reuse its id
+		id = m_free_ids.back();
+		m_free_ids.pop_back();
+	}
+	assert(!PlaybackExists(id));
+	Playback& playback = m_replays[id];
+	playback.id = id;
+	m_replays_filename_index[filename] = id;
+	return playback;
+}
+
+template <class Playback>
+bool PlaybackList<Playback>::RemovePlayback(unsigned int const id)
+{
+	auto it = m_replays.find(id);
+	if (it == m_replays.end())
+		return false;
+	m_replays_filename_index.erase(GetFilename(it->second));
+	m_replays.erase(it);
+	// an id may only be freed once, or two playbacks would get it
+	m_free_ids.push_back(id);
+	return true;
+}
+
+template <class Playback>
+size_t PlaybackList<Playback>::GetNumPlaybacks() const
+{
+	return m_replays.size();
+}
+
+template <class Playback>
+Playback& PlaybackList<Playback>::GetPlaybackById(unsigned int const id)
+{
+	auto b = m_replays.find(id);
+	if (b == m_replays.end())
+		throw std::runtime_error("PlaybackList_Iter::GetPlayback(): no such replay");
+
+	return b->second;
+}
+
+template <class Playback>
+bool PlaybackList<Playback>::PlaybackExists(unsigned int const id) const
+{
+	return m_replays.find(id) != m_replays.end();
+}
+
+template <class Playback>
+void PlaybackList<Playback>::RemoveAll()
+{
+	m_replays_filename_index.clear();
+	m_replays.clear();
+	m_free_ids.clear();
+	m_next_id = 0;
+}
+
+template <class Playback>
+const std::map<size_t, Playback>& PlaybackList<Playback>::GetPlaybacksMap() const
+{
+	return m_replays;
+}
+
+#endif // SPRINGLOBBY_HEADERGUARD_PLAYBACKLIST_H
@@ -0,0 +1,131 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_RINGBUFFER_H
+#define SPRINGLOBBY_HEADERGUARD_RINGBUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/** @brief FIFO container with O(1) append and O(1) removal of the oldest element
+ *
+ * With a capacity > 0 the buffer never holds more than capacity elements,
+ * appending to a full buffer overwrites the oldest one. A capacity of 0 means
+ * unbounded, storage then grows geometrically.
+ * Index 0 always refers to the oldest element.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+	explicit RingBuffer(size_t capacity = 0)
+	    : m_head(0)
+	    , m_count(0)
+	    , m_capacity(capacity)
+	{
+	}
+
+	size_t size() const
+	{
+		return m_count;
+	}
+	bool empty() const
+	{
+		return m_count == 0;
+	}
+	size_t GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	T& operator[](size_t index)
+	{
+		return m_items[Slot(index)];
+	}
+	const T& operator[](size_t index) const
+	{
+		return m_items[Slot(index)];
+	}
+	T& front()
+	{
+		return m_items[m_head];
+	}
+	T& back()
+	{
+		return m_items[Slot(m_count - 1)];
+	}
+
+	//! @returns true if the oldest element was dropped to make room
+	bool push_back(T item)
+	{
+		if ((m_capacity > 0) && (m_count == m_capacity)) {
+			m_items[m_head] = std::move(item);
+			m_head = (m_head + 1) % m_items.size();
+			return true;
+		}
+		if (m_count == m_items.size()) {
+			size_t slots = std::max<size_t>(16, m_items.size() * 2);
+			if ((m_capacity > 0) && (slots > m_capacity)) {
+				slots = m_capacity;
+			}
+			Reallocate(slots);
+		}
+		m_items[Slot(m_count)] = std::move(item);
+		m_count++;
+		return false;
+	}
+
+	void pop_front()
+	{
+		if (m_count == 0)
+			return;
+		m_items[m_head] = T();
+		m_head = (m_head + 1) % m_items.size();
+		m_count--;
+	}
+
+	void clear()
+	{
+		m_items.clear();
+		m_head = 0;
+		m_count = 0;
+	}
+
+	//! changes the maximum number of elements, oldest elements are dropped if needed
+	void SetCapacity(size_t capacity)
+	{
+		m_capacity = capacity;
+		if (capacity == 0)
+			return;
+		while (m_count > capacity) {
+			pop_front();
+		}
+		if (m_items.size() > capacity) {
+			Reallocate(capacity);
+		}
+	}
+
+private:
+	size_t Slot(size_t index) const
+	{
+		return (m_head + index) % m_items.size();
+	}
+
+	void Reallocate(size_t slots)
+	{
+		std::vector<T> items(slots);
+		for (size_t i = 0; i < m_count; i++) {
+			items[i] = std::move(m_items[Slot(i)]);
+		}
+		m_items.swap(items);
+		m_head = 0;
+	}
+
+	std::vector<T> m_items;
+	size_t m_head;
+	size_t m_count;
+	size_t m_capacity;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_RINGBUFFER_H
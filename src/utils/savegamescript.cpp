@@ -0,0 +1,38 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "savegamescript.h"
+
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "utf8file.h"
+
+bool ReadSavegameScript(const std::string& path, std::string& script)
+{
+	script.clear();
+#ifdef _WIN32
+	// gzopen() takes the ANSI code page
+	const std::wstring wpath = Utf8ToWide(path);
+	gzFile file = wpath.empty() ? NULL : gzopen_w(wpath.c_str(), "rb");
+#else
+	gzFile file = gzopen(path.c_str(), "rb");
+#endif
+	if (file == NULL)
+		return false;
+	std::vector<char> buffer(SAVEGAME_CHUNK_SIZE);
+	script.reserve(SAVEGAME_CHUNK_SIZE);
+	bool found = false;
+	int read = 0;
+	while (!found && (script.size() < SAVEGAME_MAX_SCRIPT_SIZE)) {
+		read = gzread(file, &buffer[0], std::min(buffer.size(), SAVEGAME_MAX_SCRIPT_SIZE - script.size()));
+		if (read <= 0)
+			break;
+		const char* end = (const char*)memchr(&buffer[0], '\0', read);
+		found = end != NULL;
+		script.append(&buffer[0], found ? (size_t)(end - &buffer[0]) : (size_t)read);
+	}
+	gzclose(file);
+	return read >= 0;
+}
@@ -0,0 +1,24 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_SAVEGAMESCRIPT_H
+#define SPRINGLOBBY_HEADERGUARD_SAVEGAMESCRIPT_H
+
+#include <cstddef>
+#include <string>
+
+//! savegames are read in chunks of this size
+static const size_t SAVEGAME_CHUNK_SIZE = 64 * 1024;
+//! reading stops after this many bytes, so a damaged savegame isn't read completely
+static const size_t SAVEGAME_MAX_SCRIPT_SIZE = 16 * 1024 * 1024;
+
+/** reads the start script a spring savegame begins with, up to the first NUL
+ *
+ * gzip compressed savegames are decompressed while reading, others are read
+ * as they are. Without terminator the script is what was read up to the end
+ * of the file or SAVEGAME_MAX_SCRIPT_SIZE bytes.
+ * @param path utf-8 encoded
+ * @return false if the file can't be read
+ */
+bool ReadSavegameScript(const std::string& path, std::string& script);
+
+#endif // SPRINGLOBBY_HEADERGUARD_SAVEGAMESCRIPT_H
@@ -0,0 +1,81 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_SIDECACHE_H
+#define SPRINGLOBBY_HEADERGUARD_SIDECACHE_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** @brief side names and side icons of games, fetched once per game
+ *
+ * Painting a battle room asks for the side icon of every player, the side
+ * list of the game and each icon are only fetched on the first request.
+ * Games which are not available are cached as having no sides, Clear() has to
+ * be called when the available games change.
+ */
+template <typename Icon>
+class SideCache
+{
+public:
+	typedef std::vector<std::string> Sides;
+	//! returns the side names of a game, empty if it isn't available
+	typedef std::function<Sides(const std::string& game)> SidesLoader;
+	typedef std::function<Icon(const std::string& game, const std::string& side)> IconLoader;
+
+	SideCache(const SidesLoader& sidesloader, const IconLoader& iconloader)
+	    : m_sidesloader(sidesloader)
+	    , m_iconloader(iconloader)
+	{
+	}
+
+	const Sides& GetSides(const std::string& game)
+	{
+		return GetGame(game).sides;
+	}
+
+	//! returns nullptr if the game or side doesn't exist
+	Icon* GetIcon(const std::string& game, size_t side)
+	{
+		Game& entry = GetGame(game);
+		if (side >= entry.sides.size())
+			return nullptr;
+		if (!entry.loaded[side]) {
+			// failed loads are cached, too
+			entry.loaded[side] = true;
+			entry.icons[side] = m_iconloader(game, entry.sides[side]);
+		}
+		return &entry.icons[side];
+	}
+
+	void Clear()
+	{
+		m_games.clear();
+	}
+
+private:
+	struct Game {
+		Sides sides;
+		std::vector<Icon> icons;
+		std::vector<bool> loaded;
+	};
+
+	Game& GetGame(const std::string& game)
+	{
+		typename std::unordered_map<std::string, Game>::iterator it = m_games.find(game);
+		if (it != m_games.end())
+			return it->second;
+		Game& entry = m_games[game];
+		entry.sides = m_sidesloader(game);
+		entry.icons.resize(entry.sides.size());
+		entry.loaded.resize(entry.sides.size(), false);
+		return entry;
+	}
+
+	SidesLoader m_sidesloader;
+	IconLoader m_iconloader;
+	std::unordered_map<std::string, Game> m_games;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_SIDECACHE_H
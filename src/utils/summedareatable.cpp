@@ -0,0 +1,64 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "summedareatable.h"
+
+#include <algorithm>
+
+SummedAreaTable::SummedAreaTable()
+    : m_width(0)
+    , m_height(0)
+{
+}
+
+void SummedAreaTable::Clear()
+{
+	m_table.clear();
+	m_width = 0;
+	m_height = 0;
+}
+
+void SummedAreaTable::Build(const unsigned char* data, int width, int height, int channels)
+{
+	Clear();
+	if ((data == NULL) || (width <= 0) || (height <= 0) || (channels <= 0))
+		return;
+
+	m_width = width;
+	m_height = height;
+	const size_t stride = width + 1;
+	m_table.assign(stride * (height + 1), 0);
+
+	// walk the image row-major: a running sum along the row plus the row
+	// above, so both the source and the table are read sequentially
+	for (int y = 0; y < height; ++y) {
+		const uint32_t* prev = &m_table[y * stride];
+		uint32_t* curr = &m_table[(y + 1) * stride];
+		uint32_t rowsum = 0;
+		for (int x = 0; x < width; ++x) {
+			for (int c = 0; c < channels; ++c) {
+				rowsum += *data++;
+			}
+			curr[x + 1] = prev[x + 1] + rowsum;
+		}
+	}
+}
+
+uint32_t SummedAreaTable::Sum(int x1, int y1, int x2, int y2) const
+{
+	if (!IsOk())
+		return 0;
+	x1 = std::max(0, std::min(m_width, x1));
+	x2 = std::max(0, std::min(m_width, x2));
+	y1 = std::max(0, std::min(m_height, y1));
+	y2 = std::max(0, std::min(m_height, y2));
+	if ((x2 <= x1) || (y2 <= y1))
+		return 0;
+	return At(x2, y2) + At(x1, y1) - At(x1, y2) - At(x2, y1);
+}
+
+uint32_t SummedAreaTable::Total() const
+{
+	if (!IsOk())
+		return 0;
+	return At(m_width, m_height);
+}
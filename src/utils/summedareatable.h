@@ -0,0 +1,57 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_SUMMEDAREATABLE_H
+#define SPRINGLOBBY_HEADERGUARD_SUMMEDAREATABLE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+/** @brief 2d prefix sums of an image for O(1) rectangle sums
+ *
+ * The table has one padding row and column of zeroes, so the entry at (x, y)
+ * is the sum of all pixels left of x and above y. Each pixel contributes the
+ * sum of its channels, so images of up to 2^32 / (255 * channels) pixels
+ * (5.6M for rgb) can't overflow.
+ */
+class SummedAreaTable
+{
+public:
+	SummedAreaTable();
+
+	/** builds the table row by row
+	 * @param data interleaved 8 bit pixel data, rows without padding
+	 * @param channels number of bytes per pixel which are summed up
+	 */
+	void Build(const unsigned char* data, int width, int height, int channels = 3);
+	void Clear();
+	bool IsOk() const
+	{
+		return !m_table.empty();
+	}
+
+	int GetWidth() const
+	{
+		return m_width;
+	}
+	int GetHeight() const
+	{
+		return m_height;
+	}
+
+	//! sum of the pixels in [x1, x2) x [y1, y2), coordinates are clamped to the image
+	uint32_t Sum(int x1, int y1, int x2, int y2) const;
+	uint32_t Total() const;
+
+private:
+	uint32_t At(int x, int y) const
+	{
+		return m_table[(size_t)y * (m_width + 1) + x];
+	}
+
+	std::vector<uint32_t> m_table;
+	int m_width;
+	int m_height;
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_SUMMEDAREATABLE_H
@@ -0,0 +1,124 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "tailreader.h"
+
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+    : m_ok(false)
+    , m_data(NULL)
+    , m_size(0)
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(NULL)
+{
+	const int len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+	if (len <= 0)
+		return;
+	std::vector<wchar_t> wpath(len);
+	MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wpath[0], len);
+	m_file = CreateFileW(&wpath[0], GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size))
+		return;
+	m_size = (size_t)size.QuadPart;
+	if (m_size == 0) {
+		m_ok = true;
+		return;
+	}
+	m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping == NULL)
+		return;
+	m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	m_ok = (m_data != NULL);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_data != NULL)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != NULL)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+    : m_ok(false)
+    , m_data(NULL)
+    , m_size(0)
+    , m_fd(open(path.c_str(), O_RDONLY))
+{
+	if (m_fd < 0)
+		return;
+	struct stat st;
+	if (fstat(m_fd, &st) != 0)
+		return;
+	m_size = (size_t)st.st_size;
+	if (m_size == 0) {
+		m_ok = true;
+		return;
+	}
+	void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (data == MAP_FAILED)
+		return;
+	m_data = (const char*)data;
+	m_ok = true;
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_data != NULL)
+		munmap((void*)m_data, m_size);
+	if (m_fd >= 0)
+		close(m_fd);
+}
+
+#endif
+
+std::vector<LineSpan> FindTailLines(const char* data, size_t size, size_t count)
+{
+	std::vector<LineSpan> lines;
+	if ((data == NULL) || (size == 0) || (count == 0))
+		return lines;
+
+	// everything after the last line feed is an incomplete line
+	const char* nl = FindLast(data, size, '\n');
+	if (nl == NULL)
+		return lines;
+	size_t end = nl - data;
+	lines.reserve(std::min<size_t>(count, 1024));
+	while (lines.size() < count) {
+		nl = FindLast(data, end, '\n');
+		const size_t begin = (nl == NULL) ? 0 : (nl - data) + 1;
+		size_t length = end - begin;
+		if ((length > 0) && (data[begin + length - 1] == '\r'))
+			length--;
+		if (length > 0) {
+			LineSpan line;
+			line.offset = begin;
+			line.length = length;
+			lines.push_back(line);
+		}
+		if (nl == NULL)
+			break;
+		end = nl - data;
+	}
+	std::reverse(lines.begin(), lines.end());
+	return lines;
+}
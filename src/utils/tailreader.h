@@ -0,0 +1,78 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_TAILREADER_H
+#define SPRINGLOBBY_HEADERGUARD_TAILREADER_H
+
+#include <string.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/** @brief read only memory mapping of a whole file
+ *
+ * An empty file is mapped successfully, with Data() returning NULL.
+ */
+class MappedFile
+{
+public:
+	//! @param path utf-8 encoded
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	bool IsOk() const
+	{
+		return m_ok;
+	}
+	const char* Data() const
+	{
+		return m_data;
+	}
+	size_t Size() const
+	{
+		return m_size;
+	}
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	bool m_ok;
+	const char* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_fd;
+#endif
+};
+
+//! position of a line in a buffer, without its line ending
+struct LineSpan {
+	size_t offset;
+	size_t length;
+};
+
+//! last occurrence of c in [data, data + size) or NULL
+inline const char* FindLast(const char* data, size_t size, char c)
+{
+#if defined(__GLIBC__)
+	return (const char*)memrchr(data, c, size);
+#else
+	for (const char* p = data + size; p != data;) {
+		if (*--p == c)
+			return p;
+	}
+	return NULL;
+#endif
+}
+
+/** finds the last count non-empty lines, scanning backwards from the end
+ *
+ * Lines end with LF or CRLF. A trailing line without line ending is
+ * incomplete and skipped.
+ * @return the lines in file order
+ */
+std::vector<LineSpan> FindTailLines(const char* data, size_t size, size_t count);
+
+#endif // SPRINGLOBBY_HEADERGUARD_TAILREADER_H
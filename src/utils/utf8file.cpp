@@ -0,0 +1,101 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "utf8file.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <vector>
+
+std::wstring Utf8ToWide(const std::string& str)
+{
+	const int len = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, NULL, 0);
+	if (len <= 0)
+		return std::wstring();
+	std::vector<wchar_t> wstr(len);
+	MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &wstr[0], len);
+	return std::wstring(&wstr[0]);
+}
+
+FILE* Utf8Open(const std::string& path, const char* mode)
+{
+	const std::wstring wpath = Utf8ToWide(path);
+	const std::wstring wmode = Utf8ToWide(mode);
+	if (wpath.empty() || wmode.empty())
+		return NULL;
+	return _wfopen(wpath.c_str(), wmode.c_str());
+}
+
+bool Utf8Remove(const std::string& path)
+{
+	const std::wstring wpath = Utf8ToWide(path);
+	return !wpath.empty() && (_wremove(wpath.c_str()) == 0);
+}
+
+bool Utf8Rename(const std::string& from, const std::string& to)
+{
+	const std::wstring wfrom = Utf8ToWide(from);
+	const std::wstring wto = Utf8ToWide(to);
+	return !wfrom.empty() && !wto.empty() && MoveFileExW(wfrom.c_str(), wto.c_str(), MOVEFILE_REPLACE_EXISTING);
+}
+
+int64_t Utf8Tell(FILE* file)
+{
+	return _ftelli64(file);
+}
+
+bool Utf8Stat(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+	const std::wstring wpath = Utf8ToWide(path);
+	struct _stat64 st;
+	if (wpath.empty() || (_wstat64(wpath.c_str(), &st) != 0))
+		return false;
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
+#else
+
+FILE* Utf8Open(const std::string& path, const char* mode)
+{
+	return fopen(path.c_str(), mode);
+}
+
+bool Utf8Remove(const std::string& path)
+{
+	return remove(path.c_str()) == 0;
+}
+
+bool Utf8Rename(const std::string& from, const std::string& to)
+{
+	return rename(from.c_str(), to.c_str()) == 0;
+}
+
+int64_t Utf8Tell(FILE* file)
+{
+	return ftello(file);
+}
+
+bool Utf8Stat(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return false;
+	size = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
+#endif
+
+int64_t Utf8ModTime(const std::string& path)
+{
+	uint64_t size;
+	int64_t mtime;
+	if (!Utf8Stat(path, size, mtime))
+		return -1;
+	return mtime;
+}
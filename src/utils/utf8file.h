@@ -0,0 +1,30 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_UTF8FILE_H
+#define SPRINGLOBBY_HEADERGUARD_UTF8FILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+/* C stdio for utf-8 encoded paths. The narrow functions take the ANSI code
+ * page on Windows, so these convert the path and use the wide ones there.
+ */
+
+FILE* Utf8Open(const std::string& path, const char* mode);
+bool Utf8Remove(const std::string& path);
+//! replaces an existing file at to, like rename() does on posix
+bool Utf8Rename(const std::string& from, const std::string& to);
+//! ftell() returns a long, which is 32 bit on Windows, -1 on errors
+int64_t Utf8Tell(FILE* file);
+//! modification time in seconds since the epoch, -1 on errors
+int64_t Utf8ModTime(const std::string& path);
+//! size and modification time of a file in one stat()
+bool Utf8Stat(const std::string& path, uint64_t& size, int64_t& mtime);
+
+#ifdef _WIN32
+//! for other wide api like gzopen_w(), empty if str isn't valid utf-8
+std::wstring Utf8ToWide(const std::string& str);
+#endif
+
+#endif // SPRINGLOBBY_HEADERGUARD_UTF8FILE_H
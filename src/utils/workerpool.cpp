@@ -0,0 +1,93 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#include "workerpool.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+
+const size_t WorkerPool::MAX_THREADS;
+const int WorkerPool::BATCH_INTERVAL_MS;
+
+namespace
+{
+//! shared by the workers and the collecting thread of one Run()
+struct PoolState {
+	PoolState(size_t count, size_t batchsize, const WorkerPool::Job& job)
+	    : count(count)
+	    , batchsize(batchsize)
+	    , job(job)
+	    , next(0)
+	    , finished(0)
+	{
+	}
+
+	void Work()
+	{
+		boost::unique_lock<boost::mutex> lock(mutex);
+		while (next < count) {
+			const size_t index = next++;
+			lock.unlock();
+			job(index);
+			lock.lock();
+			done.push_back(index);
+			finished++;
+			if ((done.size() >= batchsize) || (finished == count)) {
+				wake.notify_one();
+			}
+		}
+	}
+
+	const size_t count;
+	const size_t batchsize;
+	const WorkerPool::Job& job;
+
+	boost::mutex mutex;
+	boost::condition_variable wake;
+	size_t next;
+	size_t finished;
+	std::vector<size_t> done;
+};
+}
+
+size_t WorkerPool::GetDefaultThreadCount()
+{
+	const size_t cores = boost::thread::hardware_concurrency();
+	return std::max<size_t>(1, std::min(cores, MAX_THREADS));
+}
+
+void WorkerPool::Run(size_t count, size_t threads, size_t batchsize, const Job& job, const BatchHandler& handler)
+{
+	if (count == 0)
+		return;
+	threads = std::max<size_t>(1, std::min(threads, count));
+	batchsize = std::max<size_t>(1, batchsize);
+
+	PoolState state(count, batchsize, job);
+	boost::thread_group workers;
+	for (size_t i = 0; i < threads; i++) {
+		workers.create_thread([&state]() { state.Work(); });
+	}
+
+	std::vector<size_t> batch;
+	bool complete = false;
+	while (!complete) {
+		{
+			boost::unique_lock<boost::mutex> lock(state.mutex);
+			const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(BATCH_INTERVAL_MS);
+			while ((state.done.size() < batchsize) && (state.finished < count)) {
+				if (!state.wake.timed_wait(lock, deadline))
+					break;
+			}
+			batch.swap(state.done);
+			complete = state.finished == count;
+		}
+		if (!batch.empty() && handler) {
+			handler(batch);
+		}
+		batch.clear();
+	}
+	workers.join_all();
+}
@@ -0,0 +1,40 @@
+/* This file is part of the Springlobby (GPL v2 or later), see COPYING */
+
+#ifndef SPRINGLOBBY_HEADERGUARD_WORKERPOOL_H
+#define SPRINGLOBBY_HEADERGUARD_WORKERPOOL_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/** @brief runs independent jobs on a bounded number of threads
+ *
+ * The jobs are numbered 0 .. count - 1 and picked up by the threads in that
+ * order. The indexes of finished jobs are handed to the caller in batches
+ * while the others are still running, so results can be shown early.
+ */
+class WorkerPool
+{
+public:
+	//! called from the worker threads, must not throw
+	typedef std::function<void(size_t index)> Job;
+	//! called from the thread which called Run()
+	typedef std::function<void(const std::vector<size_t>& indexes)> BatchHandler;
+
+	static const size_t MAX_THREADS = 8;
+	//! a batch is handed over at least this often, if jobs finished
+	static const int BATCH_INTERVAL_MS = 250;
+
+	//! number of cores, at most MAX_THREADS
+	static size_t GetDefaultThreadCount();
+
+	/** runs job(i) for all i < count, blocks until all are done
+	 *
+	 * @param threads number of threads, the calling thread only collects
+	 * @param batchsize the handler is called when this many jobs finished,
+	 * after BATCH_INTERVAL_MS and with the remaining ones at the end
+	 */
+	static void Run(size_t count, size_t threads, size_t batchsize, const Job& job, const BatchHandler& handler);
+};
+
+#endif // SPRINGLOBBY_HEADERGUARD_WORKERPOOL_H